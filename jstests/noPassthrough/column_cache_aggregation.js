@@ -0,0 +1,77 @@
+/**
+ * Tests that aggregations answered from the column cache return the same results as a collection
+ * scan, including on the reads that directly follow a write, and that pipelines an index could
+ * narrow down are left to the query planner.
+ */
+(function() {
+"use strict";
+
+load("jstests/libs/analyze_plan.js");  // For aggPlanHasStage.
+
+const conn = MongoRunner.runMongod();
+assert.neq(null, conn, "mongod was unable to start up");
+const db = conn.getDB("test");
+const coll = db.column_cache_aggregation;
+coll.drop();
+
+const bulk = coll.initializeUnorderedBulkOp();
+for (let i = 0; i < 100; i++) {
+    bulk.insert({_id: i, k: i % 5, v: i, other: "other " + i});
+}
+assert.commandWorked(bulk.execute());
+
+assert.commandWorked(
+    db.adminCommand({setParameter: 1, columnCacheCollections: {[coll.getFullName()]: ["k", "v"]}}));
+
+const groupPipeline =
+    [{$group: {_id: "$k", total: {$sum: "$v"}, count: {$sum: 1}}}, {$sort: {_id: 1}}];
+
+function usesColumnCache(pipeline) {
+    return aggPlanHasStage(coll.explain().aggregate(pipeline), "$columnCacheScan");
+}
+
+// Hinting a collection scan keeps the pipeline away from the column cache.
+function assertSameResultsAsCollectionScan(pipeline) {
+    assert.eq(coll.aggregate(pipeline, {hint: {$natural: 1}}).toArray(),
+              coll.aggregate(pipeline).toArray());
+}
+
+// The first aggregation schedules a build of the cached columns and reads the collection until the
+// build completes.
+assertSameResultsAsCollectionScan(groupPipeline);
+assert.soon(() => usesColumnCache(groupPipeline));
+assert(!aggPlanHasStage(coll.explain().aggregate(groupPipeline, {hint: {$natural: 1}}),
+                        "$columnCacheScan"));
+assertSameResultsAsCollectionScan(groupPipeline);
+
+// Writes drop the cached columns. The reads that follow must reflect them, whether or not the
+// columns have been rebuilt yet.
+assert.commandWorked(coll.insert({_id: 100, k: 0, v: 1000}));
+assertSameResultsAsCollectionScan(groupPipeline);
+assert.commandWorked(coll.update({_id: 1}, {$set: {v: -1}}));
+assertSameResultsAsCollectionScan(groupPipeline);
+assert.commandWorked(coll.remove({_id: 2}));
+assertSameResultsAsCollectionScan(groupPipeline);
+assert.eq(100, coll.aggregate([{$group: {_id: null, n: {$sum: 1}}}]).toArray()[0].n);
+
+assert.soon(() => usesColumnCache(groupPipeline));
+assertSameResultsAsCollectionScan(groupPipeline);
+
+// A pipeline that depends on a field outside of the cache reads the collection.
+assert(!usesColumnCache([{$group: {_id: "$other", n: {$sum: 1}}}]));
+
+// So does a pipeline whose initial $match or $sort an index can answer.
+const matchPipeline = [{$match: {k: 3}}, {$group: {_id: null, total: {$sum: "$v"}}}];
+const sortPipeline = [{$sort: {v: -1}}, {$limit: 3}, {$project: {_id: 0, v: 1}}];
+assert(usesColumnCache(matchPipeline));
+assert(usesColumnCache(sortPipeline));
+assert.commandWorked(coll.createIndex({k: 1}));
+assert.commandWorked(coll.createIndex({v: 1}));
+assert.soon(() => usesColumnCache(groupPipeline));
+assert(!usesColumnCache(matchPipeline));
+assert(!usesColumnCache(sortPipeline));
+assertSameResultsAsCollectionScan(matchPipeline);
+assertSameResultsAsCollectionScan(sortPipeline);
+
+MongoRunner.stopMongod(conn);
+}());
@@ -0,0 +1,41 @@
+/**
+ * Tests that find and getMore return every document when the plan hands out results in batches
+ * larger than the batch size the client asked for. The collection scan reaches EOF partway through
+ * the first batch, and the cursor must stay open until the buffered results have been returned.
+ */
+(function() {
+"use strict";
+
+const conn = MongoRunner.runMongod();
+const db = conn.getDB("query_exec_batch_size_getmore");
+const coll = db.getCollection("query_exec_batch_size_getmore");
+coll.drop();
+
+const nDocs = 10;
+for (let i = 0; i < nDocs; i++) {
+    assert.commandWorked(coll.insert({_id: i, a: i % 2}));
+}
+
+assert.commandWorked(db.adminCommand({setParameter: 1, internalQueryExecBatchSize: 64}));
+
+function runFindAndGetMores(filter, expectedIds) {
+    let res =
+        assert.commandWorked(db.runCommand({find: coll.getName(), filter: filter, batchSize: 2}));
+    let docs = res.cursor.firstBatch;
+    assert.eq(docs.length, 2, tojson(res));
+    assert.neq(0, res.cursor.id, tojson(res));
+
+    while (res.cursor.id != 0) {
+        res = assert.commandWorked(
+            db.runCommand({getMore: res.cursor.id, collection: coll.getName(), batchSize: 2}));
+        docs = docs.concat(res.cursor.nextBatch);
+    }
+
+    assert.eq(docs.map(doc => doc._id).sort((x, y) => x - y), expectedIds, tojson(docs));
+}
+
+runFindAndGetMores({}, [0, 1, 2, 3, 4, 5, 6, 7, 8, 9]);
+runFindAndGetMores({a: 0}, [0, 2, 4, 6, 8]);
+
+MongoRunner.stopMongod(conn);
+}());
@@ -31,6 +31,7 @@
 
 #include <benchmark/benchmark.h>
 
+#include "mongo/bson/bson_validate.h"
 #include "mongo/bson/bsonobjbuilder.h"
 
 namespace mongo {
@@ -63,7 +64,55 @@ void BM_arrayLookup(benchmark::State& state) {
     state.SetItemsProcessed(totalLen);
 }
 
+/**
+ * Builds a document like the ones an insert-heavy workload sends: a handful of fixed-size values
+ * and short strings under short field names, with a nested subdocument.
+ */
+BSONObj buildValidateDocument(int numFields) {
+    BSONObjBuilder builder;
+    builder.append("_id", OID::gen());
+    for (int i = 0; i < numFields; i++) {
+        const auto name = "field" + std::to_string(i);
+        switch (i % 4) {
+            case 0:
+                builder.append(name, i);
+                break;
+            case 1:
+                builder.append(name, static_cast<double>(i));
+                break;
+            case 2:
+                builder.append(name, "value" + std::to_string(i));
+                break;
+            case 3:
+                builder.append(name, BSON("nestedInt" << i << "nestedDate" << Date_t()));
+                break;
+        }
+    }
+    return builder.obj();
+}
+
+void BM_validate(benchmark::State& state) {
+    BSONObj obj = buildValidateDocument(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(validateBSON(obj.objdata(), obj.objsize(), BSONVersion::kLatest));
+    }
+    state.SetBytesProcessed(state.iterations() * obj.objsize());
+}
+
+void BM_validateLongFieldNames(benchmark::State& state) {
+    BSONObjBuilder builder;
+    for (auto j = 0; j < 100; j++)
+        builder.append(std::string(state.range(0), 'a') + std::to_string(j), j);
+    BSONObj obj = builder.obj();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(validateBSON(obj.objdata(), obj.objsize(), BSONVersion::kLatest));
+    }
+    state.SetBytesProcessed(state.iterations() * obj.objsize());
+}
+
 BENCHMARK(BM_arrayBuilder)->Ranges({{{1}, {100'000}}});
 BENCHMARK(BM_arrayLookup)->Ranges({{{1}, {100'000}}});
+BENCHMARK(BM_validate)->Ranges({{{1}, {1'000}}});
+BENCHMARK(BM_validateLongFieldNames)->Arg(4)->Arg(14)->Arg(30)->Arg(100);
 
 }  // namespace mongo
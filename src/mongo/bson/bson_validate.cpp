@@ -27,6 +27,7 @@
  *    it in the license file.
  */
 
+#include <array>
 #include <cstring>
 #include <limits>
 #include <vector>
@@ -36,12 +37,56 @@
 #include "mongo/bson/bson_validate.h"
 #include "mongo/bson/oid.h"
 #include "mongo/db/jsobj.h"
+#include "mongo/platform/byte_mask.h"
 #include "mongo/platform/decimal128.h"
 
 namespace mongo {
 
 namespace {
 
+/**
+ * Looks for the NUL byte which terminates the c-string at 'ptr' within a single vector, and writes
+ * the length of the string to 'len' if it finds one. Returns false when the vector path doesn't
+ * apply, in which case the caller falls back to memchr. 'available' is how many bytes from 'ptr'
+ * on are within the buffer.
+ *
+ * Field names are almost always shorter than a vector, so this finds their terminator with a
+ * single load, where memchr would first have to work out how to handle the alignment of 'ptr'.
+ */
+inline bool findCStringEndFast(const char* ptr, uint64_t available, uint64_t* len) {
+#ifdef MONGO_HAVE_VECTOR_BYTE_MASK
+    if (available < byte_mask::kVectorSize)
+        return false;
+
+    const uint64_t mask = byte_mask::zero(ptr);
+    if (mask == 0)
+        return false;
+    *len = byte_mask::firstByte(mask);
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Value sizes of the types whose values are a fixed number of bytes with no further structure to
+ * check, indexed by type byte. Every other type, including the invalid ones, maps to -1.
+ */
+const auto kFixedValueSizes = [] {
+    std::array<int8_t, 256> sizes;
+    sizes.fill(-1);
+    for (auto type : {MinKey, MaxKey, jstNULL, Undefined}) {
+        sizes[static_cast<uint8_t>(type)] = 0;
+    }
+    sizes[static_cast<uint8_t>(NumberInt)] = sizeof(int32_t);
+    for (auto type : {NumberDouble, NumberLong, bsonTimestamp, Date}) {
+        sizes[static_cast<uint8_t>(type)] = sizeof(int64_t);
+    }
+    sizes[static_cast<uint8_t>(jstOID)] = OID::kOIDSize;
+    sizes[static_cast<uint8_t>(NumberDecimal)] = sizeof(Decimal128::Value);
+    return sizes;
+}();
+
 /**
  * Creates a status with InvalidBSON code and adds information about _id if available.
  * WARNING: only pass in a non-EOO idElem if it has been fully validated already!
@@ -90,10 +135,13 @@ public:
      * reading, if it exists. Otherwise, it should be empty.
      */
     Status readCString(StringData elemName, StringData* out) {
-        const void* x = memchr(_buffer + _position, 0, _maxLength - _position);
-        if (!x)
-            return makeError("no end of c-string", _idElem, elemName);
-        uint64_t len = static_cast<uint64_t>(static_cast<const char*>(x) - (_buffer + _position));
+        uint64_t len;
+        if (!findCStringEndFast(_buffer + _position, _maxLength - _position, &len)) {
+            const void* x = memchr(_buffer + _position, 0, _maxLength - _position);
+            if (!x)
+                return makeError("no end of c-string", _idElem, elemName);
+            len = static_cast<uint64_t>(static_cast<const char*>(x) - (_buffer + _position));
+        }
 
         StringData data(_buffer + _position, len);
         _position += len + 1;
@@ -220,23 +268,14 @@ Status validateElementInfo(Buffer* buffer,
     if (!status.isOK())
         return status;
 
-    switch (type) {
-        case MinKey:
-        case MaxKey:
-        case jstNULL:
-        case Undefined:
-            return Status::OK();
-
-        case jstOID:
-            if (!buffer->skip(OID::kOIDSize))
-                return makeError("invalid bson", idElem, *elemName);
-            return Status::OK();
-
-        case NumberInt:
-            if (!buffer->skip(sizeof(int32_t)))
-                return makeError("invalid bson", idElem, *elemName);
-            return Status::OK();
+    // Most elements in practice have a fixed size value, which only needs a bounds check.
+    if (const auto size = kFixedValueSizes[static_cast<uint8_t>(type)]; size >= 0) {
+        if (size > 0 && !buffer->skip(size))
+            return makeError("invalid bson", idElem, *elemName);
+        return Status::OK();
+    }
 
+    switch (type) {
         case Bool:
             uint8_t val;
             if (!buffer->readNumber(&val))
@@ -245,19 +284,6 @@ Status validateElementInfo(Buffer* buffer,
                 return makeError("invalid boolean value", idElem, *elemName);
             return Status::OK();
 
-        case NumberDouble:
-        case NumberLong:
-        case bsonTimestamp:
-        case Date:
-            if (!buffer->skip(sizeof(int64_t)))
-                return makeError("invalid bson", idElem, *elemName);
-            return Status::OK();
-
-        case NumberDecimal:
-            if (!buffer->skip(sizeof(Decimal128::Value)))
-                return makeError("Invalid bson", idElem, *elemName);
-            return Status::OK();
-
         case DBRef:
             status = buffer->readUTF8String(*elemName, nullptr);
             if (!status.isOK())
@@ -359,5 +359,32 @@ TEST(BSONValidateFast, InvalidType) {
     ASSERT_THROWS_CODE(obj.woCompare(BSON("A" << 1)), DBException, 10320);
 }
 
+TEST(BSONValidateFast, FieldNamesOfEveryLength) {
+    // Field names are scanned a vector at a time, so cover names which end on either side of a
+    // vector boundary, and elements which end right at the end of the buffer.
+    for (size_t len = 1; len < 70; ++len) {
+        const std::string name(len, 'a');
+        BSONObj obj = BSON(name << 1 << "b" << MINKEY);
+        ASSERT_OK(validateBSON(obj.objdata(), obj.objsize(), BSONVersion::kLatest));
+
+        // Drop the terminator of the last field name, along with the object's.
+        BufBuilder bb;
+        bb.appendNum(0);
+        bb.appendChar(MinKey);
+        bb.appendStr(name, /*withNUL*/ false);
+        DataView(bb.buf()).write(tagLittleEndian(bb.len()));
+        ASSERT_EQ(validateBSON(bb.buf(), bb.len(), BSONVersion::kLatest), ErrorCodes::InvalidBSON);
+    }
+}
+
+TEST(BSONValidateFast, FixedSizeValuesPastTheEnd) {
+    BSONObj obj = BSON("a" << 1.5 << "b" << OID::gen() << "c" << Decimal128(1));
+    ASSERT_OK(validateBSON(obj.objdata(), obj.objsize(), BSONVersion::kLatest));
+
+    // Every truncation cuts a value short, or leaves off the terminating EOO.
+    for (int len = 5; len < obj.objsize(); ++len) {
+        ASSERT_NOT_OK(validateBSON(obj.objdata(), len, BSONVersion::kLatest));
+    }
+}
 
 }  // namespace
@@ -33,6 +33,7 @@
 
 #include "mongo/db/commands.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -694,6 +695,22 @@ std::unique_ptr<CommandInvocation> BasicCommand::parse(OperationContext* opCtx,
     return std::make_unique<Invocation>(opCtx, request, this);
 }
 
+void Command::recordReplySize(std::size_t bytes) const {
+    // Replies larger than this are rare enough that reserving for them up front would mostly waste
+    // memory.
+    constexpr std::size_t kMaxReplySizeEstimateBytes = 1024 * 1024;
+    bytes = std::min(bytes, kMaxReplySizeEstimateBytes);
+
+    // Weighs the latest reply at 1/8. The store is skipped when it would barely move the estimate,
+    // so that a frequently run command doesn't write to a shared cache line on every reply.
+    const auto estimate = _replySizeEstimate.load();
+    const auto newEstimate = estimate - estimate / 8 + bytes / 8;
+    const auto delta = newEstimate > estimate ? newEstimate - estimate : estimate - newEstimate;
+    if (delta > estimate / 64) {
+        _replySizeEstimate.store(newEstimate);
+    }
+}
+
 Command::Command(StringData name, StringData oldName)
     : _name(name.toString()),
       _commandsExecutedMetric("commands." + _name + ".total", &_commandsExecuted),
@@ -48,6 +48,7 @@
 #include "mongo/db/read_concern_support_result.h"
 #include "mongo/db/repl/read_concern_args.h"
 #include "mongo/db/write_concern.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/rpc/op_msg.h"
 #include "mongo/rpc/reply_builder_interface.h"
 #include "mongo/util/fail_point.h"
@@ -292,6 +293,22 @@ public:
         return 0u;
     }
 
+    /**
+     * Returns a running estimate of the size of this command's replies, as recorded by
+     * recordReplySize(). The rpc system reserves at least this much space for a reply, so that
+     * commands which don't override reserveBytesForReply() still build their replies without
+     * repeatedly regrowing the buffer.
+     */
+    std::size_t getReplySizeEstimate() const {
+        return _replySizeEstimate.load();
+    }
+
+    /**
+     * Folds the size of a reply to this command into the estimate returned by
+     * getReplySizeEstimate().
+     */
+    void recordReplySize(std::size_t bytes) const;
+
     /**
      * Return true if only the admin ns has privileges to run this command.
      */
@@ -435,6 +452,10 @@ private:
     // Counters for how many times this command has been executed and failed
     mutable Counter64 _commandsExecuted;
     mutable Counter64 _commandsFailed;
+
+    // Moving average of the size of this command's replies.
+    mutable AtomicWord<std::size_t> _replySizeEstimate{0};
+
     // Pointers to hold the metrics tree references
     ServerStatusMetricField<Counter64> _commandsExecutedMetric;
     ServerStatusMetricField<Counter64> _commandsFailedMetric;
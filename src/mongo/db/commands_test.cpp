@@ -331,6 +331,29 @@ ExampleMinimalCommand exampleMinimalCommand;
 ExampleVoidCommand exampleVoidCommand;
 CmdT<decltype(throwFn)> throwStatusCommand("throwsStatus", throwFn);
 
+auto noopFn = [] {};
+CmdT<decltype(noopFn)> replySizeCommand("replySize", noopFn);
+
+TEST(Commands, ReplySizeEstimateTracksRecentReplies) {
+    ASSERT_EQ(0U, replySizeCommand.getReplySizeEstimate());
+
+    for (int i = 0; i < 100; ++i) {
+        replySizeCommand.recordReplySize(8000);
+    }
+    ASSERT_GTE(replySizeCommand.getReplySizeEstimate(), 7000U);
+    ASSERT_LTE(replySizeCommand.getReplySizeEstimate(), 8000U);
+
+    for (int i = 0; i < 100; ++i) {
+        replySizeCommand.recordReplySize(800);
+    }
+    ASSERT_GTE(replySizeCommand.getReplySizeEstimate(), 800U);
+    ASSERT_LTE(replySizeCommand.getReplySizeEstimate(), 950U);
+
+    // A single huge reply is capped before it is folded in.
+    replySizeCommand.recordReplySize(64 * 1024 * 1024);
+    ASSERT_LTE(replySizeCommand.getReplySizeEstimate(), 950U + 1024 * 1024 / 8);
+}
+
 class TypedCommandTest : public ServiceContextTest {
 protected:
     template <typename T>
@@ -0,0 +1,204 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/batch_filter.h"
+
+#include <algorithm>
+
+#include "mongo/db/exec/filter.h"
+#include "mongo/db/matcher/expression_leaf.h"
+
+namespace mongo {
+
+namespace {
+
+/**
+ * Returns true if 'expr' is a comparison which the columnar path knows how to evaluate.
+ */
+bool isColumnarLeaf(const MatchExpression* expr) {
+    if (!ComparisonMatchExpression::isComparisonMatchExpression(expr)) {
+        return false;
+    }
+
+    auto comparison = static_cast<const ComparisonMatchExpression*>(expr);
+    if (comparison->getCollator()) {
+        return false;
+    }
+
+    // Only top-level fields can be extracted with a single getField() call.
+    const auto path = comparison->path();
+    return !path.empty() && path.find('.') == std::string::npos;
+}
+
+}  // namespace
+
+BatchFilter::BatchFilter(const MatchExpression* filter) : _filter(filter) {
+    if (!canUseColumnarPath(filter)) {
+        return;
+    }
+
+    if (filter->matchType() == MatchExpression::AND) {
+        for (size_t i = 0; i < filter->numChildren(); ++i) {
+            _leaves.push_back(static_cast<const ComparisonMatchExpression*>(filter->getChild(i)));
+        }
+    } else {
+        _leaves.push_back(static_cast<const ComparisonMatchExpression*>(filter));
+    }
+}
+
+bool BatchFilter::canUseColumnarPath(const MatchExpression* filter) {
+    if (!filter) {
+        return false;
+    }
+
+    if (filter->matchType() == MatchExpression::AND) {
+        if (filter->numChildren() == 0) {
+            return false;
+        }
+        for (size_t i = 0; i < filter->numChildren(); ++i) {
+            if (!isColumnarLeaf(filter->getChild(i))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    return isColumnarLeaf(filter);
+}
+
+bool BatchFilter::_leafPasses(const ComparisonMatchExpression* leaf, const BSONObj& obj) {
+    BSONElement elem = obj.getField(leaf->path());
+
+    // Arrays need the full element iteration semantics of the MatchExpression, which matches
+    // against each array element as well as the array as a whole.
+    if (elem.type() == BSONType::Array) {
+        return leaf->matchesBSON(obj);
+    }
+
+    // A missing field is presented to the comparison as an EOO element, which is what the
+    // ElementIterator-based path does as well.
+    return leaf->matchesSingleElement(elem);
+}
+
+bool BatchFilter::passes(WorkingSetMember* member) const {
+    auto obj = usesColumnarPath() && member->hasObj()
+        ? member->doc.value().toBsonIfTriviallyConvertible()
+        : boost::none;
+    if (!obj) {
+        return Filter::passes(member, _filter);
+    }
+
+    for (auto&& leaf : _leaves) {
+        if (!_leafPasses(leaf, *obj)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t BatchFilter::filter(WorkingSet* ws, std::vector<WorkingSetID>* ids, size_t first) const {
+    invariant(first <= ids->size());
+    const size_t examined = ids->size() - first;
+    if (!_filter) {
+        return examined;
+    }
+
+    if (!usesColumnarPath()) {
+        auto newEnd = std::remove_if(ids->begin() + first, ids->end(), [&](WorkingSetID id) {
+            if (Filter::passes(ws->get(id), _filter)) {
+                return false;
+            }
+            ws->free(id);
+            return true;
+        });
+        ids->erase(newEnd, ids->end());
+        return examined;
+    }
+
+    // Gather the BSON backing each member. Members which aren't backed by unmodified BSON (e.g.
+    // index key data or computed documents) can't be evaluated column-wise, so they are evaluated
+    // against the full filter up front and get a null entry.
+    _rows.clear();
+    size_t kept = first;
+    for (size_t i = first; i < ids->size(); ++i) {
+        const WorkingSetID id = (*ids)[i];
+        WorkingSetMember* member = ws->get(id);
+        auto obj = member->hasObj() ? member->doc.value().toBsonIfTriviallyConvertible()
+                                    : boost::none;
+        if (!obj && !Filter::passes(member, _filter)) {
+            ws->free(id);
+            continue;
+        }
+        (*ids)[kept++] = id;
+        _rows.push_back(obj ? obj->objdata() : nullptr);
+    }
+    ids->resize(kept);
+
+    // Evaluate one predicate at a time across the whole batch, narrowing the batch as we go so
+    // that later predicates only look at members which passed the earlier ones.
+    for (auto&& leaf : _leaves) {
+        if (_rows.empty()) {
+            break;
+        }
+
+        const auto fieldName = leaf->path();
+        _column.clear();
+        for (auto&& row : _rows) {
+            _column.push_back(row ? BSONObj(row).getField(fieldName) : BSONElement());
+        }
+
+        kept = 0;
+        for (size_t i = 0; i < _rows.size(); ++i) {
+            const WorkingSetID id = (*ids)[first + i];
+            bool matched;
+            if (!_rows[i]) {
+                matched = true;
+            } else if (_column[i].type() == BSONType::Array) {
+                matched = leaf->matchesBSON(BSONObj(_rows[i]));
+            } else {
+                matched = leaf->matchesSingleElement(_column[i]);
+            }
+
+            if (matched) {
+                _rows[kept] = _rows[i];
+                (*ids)[first + kept++] = id;
+            } else {
+                ws->free(id);
+            }
+        }
+        _rows.resize(kept);
+        ids->resize(first + kept);
+    }
+
+    return examined;
+}
+
+}  // namespace mongo
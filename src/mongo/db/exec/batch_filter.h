@@ -0,0 +1,101 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <vector>
+
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/matcher/expression.h"
+
+namespace mongo {
+
+class ComparisonMatchExpression;
+
+/**
+ * Evaluates a MatchExpression over a batch of WorkingSetMembers at a time. Used by stages which
+ * implement PlanStage::doWorkBatch().
+ *
+ * Filters which are a single comparison ($eq, $lt, $lte, $gt, $gte) on a top-level field, or an
+ * $and of such comparisons, are evaluated column by column: for each predicate, the field is
+ * extracted from every member still in the batch and compared directly against the constant,
+ * without going through the MatchableDocument / ElementIterator machinery. Members for which the
+ * fast path can't produce an answer (for instance, because the field holds an array or the member
+ * is made of index keys) are evaluated with the full MatchExpression instead. Any other filter is
+ * always evaluated one member at a time via Filter::passes().
+ */
+class BatchFilter {
+public:
+    /**
+     * 'filter' may be null, in which case every member passes. The filter is not owned and must
+     * outlive this object.
+     */
+    explicit BatchFilter(const MatchExpression* filter);
+
+    /**
+     * Returns true if 'filter' is shaped such that it can take the columnar path.
+     */
+    static bool canUseColumnarPath(const MatchExpression* filter);
+
+    bool usesColumnarPath() const {
+        return !_leaves.empty();
+    }
+
+    /**
+     * Returns true if 'member' satisfies the filter.
+     */
+    bool passes(WorkingSetMember* member) const;
+
+    /**
+     * Removes from 'ids' each member at or after position 'first' which does not satisfy the
+     * filter, freeing it from 'ws'. The relative order of the surviving ids is preserved. Returns
+     * the number of members examined.
+     */
+    size_t filter(WorkingSet* ws, std::vector<WorkingSetID>* ids, size_t first = 0) const;
+
+private:
+    /**
+     * Returns true if 'obj' satisfies the comparison 'leaf'.
+     */
+    static bool _leafPasses(const ComparisonMatchExpression* leaf, const BSONObj& obj);
+
+    const MatchExpression* _filter;
+
+    // The comparisons making up '_filter' if it is eligible for the columnar path, otherwise
+    // empty.
+    std::vector<const ComparisonMatchExpression*> _leaves;
+
+    // Scratch space for filter(): the BSON backing each member of the batch, or null if the member
+    // was already evaluated against the full filter, and the column of values extracted for the
+    // predicate being evaluated.
+    mutable std::vector<const char*> _rows;
+    mutable std::vector<BSONElement> _column;
+};
+
+}  // namespace mongo
@@ -0,0 +1,164 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/batch_filter.h"
+
+#include "mongo/db/exec/filter.h"
+#include "mongo/db/json.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+class BatchFilterTest : public unittest::Test {
+protected:
+    std::unique_ptr<MatchExpression> parse(const BSONObj& filter) {
+        auto statusWithMatcher = MatchExpressionParser::parse(filter, _expCtx);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        return std::move(statusWithMatcher.getValue());
+    }
+
+    /**
+     * Adds one member to '_ws' for each document in 'docs' and returns their ids.
+     */
+    std::vector<WorkingSetID> makeBatch(const std::vector<BSONObj>& docs) {
+        std::vector<WorkingSetID> ids;
+        for (auto&& doc : docs) {
+            auto id = _ws.allocate();
+            auto member = _ws.get(id);
+            member->doc = {SnapshotId(), Document{doc}};
+            _ws.transitionToOwnedObj(id);
+            ids.push_back(id);
+        }
+        return ids;
+    }
+
+    /**
+     * Runs 'filter' over 'docs' through both BatchFilter::filter() and Filter::passes(), checks
+     * that they agree and returns the surviving documents.
+     */
+    std::vector<BSONObj> runFilter(const BSONObj& filter, const std::vector<BSONObj>& docs) {
+        auto expr = parse(filter);
+        BatchFilter batchFilter(expr.get());
+
+        auto ids = makeBatch(docs);
+        ASSERT_EQ(docs.size(), batchFilter.filter(&_ws, &ids));
+
+        std::vector<BSONObj> expected;
+        for (auto&& doc : docs) {
+            if (expr->matchesBSON(doc)) {
+                expected.push_back(doc);
+            }
+        }
+
+        std::vector<BSONObj> result;
+        for (auto&& id : ids) {
+            ASSERT_TRUE(batchFilter.passes(_ws.get(id)));
+            result.push_back(_ws.get(id)->doc.value().toBson());
+            _ws.free(id);
+        }
+
+        ASSERT_EQ(expected.size(), result.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            ASSERT_BSONOBJ_EQ(expected[i], result[i]);
+        }
+        return result;
+    }
+
+    boost::intrusive_ptr<ExpressionContextForTest> _expCtx{new ExpressionContextForTest()};
+    WorkingSet _ws;
+};
+
+TEST_F(BatchFilterTest, ColumnarPathEligibility) {
+    ASSERT_TRUE(BatchFilter::canUseColumnarPath(parse(fromjson("{a: 1}")).get()));
+    ASSERT_TRUE(BatchFilter::canUseColumnarPath(parse(fromjson("{a: {$gt: 1}, b: 'x'}")).get()));
+    ASSERT_FALSE(BatchFilter::canUseColumnarPath(parse(fromjson("{'a.b': 1}")).get()));
+    ASSERT_FALSE(BatchFilter::canUseColumnarPath(parse(fromjson("{a: {$in: [1, 2]}}")).get()));
+    ASSERT_FALSE(BatchFilter::canUseColumnarPath(parse(fromjson("{$or: [{a: 1}, {b: 1}]}")).get()));
+    ASSERT_FALSE(BatchFilter::canUseColumnarPath(nullptr));
+}
+
+TEST_F(BatchFilterTest, NullFilterPassesEverything) {
+    BatchFilter batchFilter(nullptr);
+    auto ids = makeBatch({BSON("a" << 1), BSON("a" << 2)});
+    ASSERT_EQ(2U, batchFilter.filter(&_ws, &ids));
+    ASSERT_EQ(2U, ids.size());
+}
+
+TEST_F(BatchFilterTest, SingleComparison) {
+    auto result = runFilter(fromjson("{a: {$lt: 3}}"),
+                            {BSON("a" << 1), BSON("a" << 5), BSON("a" << 2.5), BSON("b" << 1)});
+    ASSERT_EQ(2U, result.size());
+}
+
+TEST_F(BatchFilterTest, ConjunctionPreservesOrder) {
+    auto result = runFilter(fromjson("{a: {$gte: 2}, b: 'x'}"),
+                            {BSON("a" << 3 << "b"
+                                      << "x"),
+                             BSON("a" << 1 << "b"
+                                      << "x"),
+                             BSON("a" << 2 << "b"
+                                      << "y"),
+                             BSON("b"
+                                  << "x"
+                                  << "a" << 2)});
+    ASSERT_EQ(2U, result.size());
+    ASSERT_EQ(3, result[0]["a"].numberInt());
+    ASSERT_EQ(2, result[1]["a"].numberInt());
+}
+
+TEST_F(BatchFilterTest, ArrayAndMissingFieldsMatchLikeMatchExpression) {
+    runFilter(fromjson("{a: 2}"),
+              {fromjson("{a: [1, 2, 3]}"),
+               fromjson("{a: [[2]]}"),
+               fromjson("{a: null}"),
+               fromjson("{b: 2}"),
+               fromjson("{a: 2}")});
+    runFilter(fromjson("{a: null}"),
+              {fromjson("{b: 1}"), fromjson("{a: null}"), fromjson("{a: 0}")});
+    runFilter(fromjson("{a: [1, 2]}"), {fromjson("{a: [1, 2]}"), fromjson("{a: [[1, 2]]}")});
+}
+
+TEST_F(BatchFilterTest, FilterOnlyConsidersIdsFromFirst) {
+    auto expr = parse(fromjson("{a: 1}"));
+    BatchFilter batchFilter(expr.get());
+
+    auto ids = makeBatch({BSON("a" << 2), BSON("a" << 1), BSON("a" << 2)});
+    ASSERT_EQ(2U, batchFilter.filter(&_ws, &ids, 1));
+    ASSERT_EQ(2U, ids.size());
+    ASSERT_EQ(2, _ws.get(ids[0])->doc.value()["a"].getInt());
+    ASSERT_EQ(1, _ws.get(ids[1])->doc.value()["a"].getInt());
+}
+
+}  // namespace
+}  // namespace mongo
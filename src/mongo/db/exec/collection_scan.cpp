@@ -64,6 +64,7 @@ CollectionScan::CollectionScan(OperationContext* opCtx,
     : RequiresCollectionStage(kStageType, opCtx, collection),
       _workingSet(workingSet),
       _filter(filter),
+      _batchFilter(filter),
       _params(params) {
     // Explain reports the direction of the collection scan.
     _specificStats.direction = params.direction;
@@ -85,6 +86,15 @@ CollectionScan::CollectionScan(OperationContext* opCtx,
         invariant(params.direction == CollectionScanParams::FORWARD);
     }
 
+    if (params.minRecord || params.maxRecord) {
+        // Range-bounded scans are used to partition a collection between several scans, which we
+        // only support in the forward direction.
+        invariant(params.direction == CollectionScanParams::FORWARD);
+        invariant(!params.tailable);
+        invariant(!params.resumeAfterRecordId);
+        invariant(!params.minTs && !params.maxTs);
+    }
+
     // Set early stop condition.
     if (params.maxTs) {
         _endConditionBSON = BSON("$gte"_sd << *(params.maxTs));
@@ -179,6 +189,14 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
             }
         }
 
+        if (_lastSeenId.isNull() && _params.minRecord) {
+            record = _cursor->seekAtOrAfter(*_params.minRecord);
+            if (!record) {
+                _commonStats.isEOF = true;
+                return PlanStage::IS_EOF;
+            }
+        }
+
         if (!record) {
             record = _cursor->next();
         }
@@ -203,6 +221,11 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
         return PlanStage::IS_EOF;
     }
 
+    if (_params.maxRecord && record->id >= *_params.maxRecord) {
+        _commonStats.isEOF = true;
+        return PlanStage::IS_EOF;
+    }
+
     _lastSeenId = record->id;
     if (_params.shouldTrackLatestOplogTimestamp) {
         auto status = setLatestOplogEntryTimestamp(*record);
@@ -222,6 +245,62 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
     return returnIfMatches(member, id, out);
 }
 
+PlanStage::StageState CollectionScan::doWorkBatch(size_t maxResults, WorkBatch* out) {
+    // Only plain scans over an established cursor take the batched path. Cursor creation and the
+    // initial seek, tailable and oplog scans, resumable scans and the first-match optimization are
+    // all handled one record at a time.
+    if (!_cursor || _lastSeenId.isNull() || _params.tailable || _params.minTs || _params.maxTs ||
+        _params.shouldTrackLatestOplogTimestamp || _params.stopApplyingFilterAfterFirstMatch ||
+        _params.requestResumeToken) {
+        return PlanStage::doWorkBatch(maxResults, out);
+    }
+
+    if (_commonStats.isEOF) {
+        return PlanStage::IS_EOF;
+    }
+
+    const auto snapshotId = getOpCtx()->recoveryUnit()->getSnapshotId();
+
+    // Examine at most 'maxResults' records, so that a selective filter can't turn a single call
+    // into a scan of the whole collection without giving the caller a chance to yield.
+    for (size_t examined = 0; examined < maxResults; ++examined) {
+        boost::optional<Record> record;
+        try {
+            record = _cursor->next();
+        } catch (const WriteConflictException&) {
+            // The results gathered so far own their data, so they may be held across the yield.
+            out->statusId = WorkingSet::INVALID_ID;
+            return PlanStage::NEED_YIELD;
+        }
+
+        if (!record || (_params.maxRecord && record->id >= *_params.maxRecord)) {
+            _commonStats.isEOF = true;
+            return out->ids.empty() ? PlanStage::IS_EOF : PlanStage::ADVANCED;
+        }
+
+        _lastSeenId = record->id;
+
+        WorkingSetID id = _workingSet->allocate();
+        WorkingSetMember* member = _workingSet->get(id);
+        member->recordId = record->id;
+        member->resetDocument(snapshotId, record->data.releaseToBson());
+        _workingSet->transitionToRecordIdAndObj(id);
+
+        ++_specificStats.docsTested;
+        if (!_batchFilter.passes(member)) {
+            _workingSet->free(id);
+            continue;
+        }
+
+        // The cursor may reuse the memory backing this record once it is advanced, but the caller
+        // holds on to every result in the batch.
+        member->makeObjOwnedIfNeeded();
+        out->ids.push_back(id);
+    }
+
+    return out->ids.empty() ? PlanStage::NEED_TIME : PlanStage::ADVANCED;
+}
+
 Status CollectionScan::setLatestOplogEntryTimestamp(const Record& record) {
     auto tsElem = record.data.toBson()[repl::OpTime::kTimestampFieldName];
     if (tsElem.type() != BSONType::bsonTimestamp) {
@@ -31,6 +31,7 @@
 
 #include <memory>
 
+#include "mongo/db/exec/batch_filter.h"
 #include "mongo/db/exec/collection_scan_common.h"
 #include "mongo/db/exec/requires_collection_stage.h"
 #include "mongo/db/matcher/expression_leaf.h"
@@ -60,6 +61,7 @@ public:
                    const MatchExpression* filter);
 
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(size_t maxResults, WorkBatch* out) final;
     bool isEOF() final;
 
     void doDetachFromOperationContext() final;
@@ -106,6 +108,9 @@ private:
     // The filter is not owned by us.
     const MatchExpression* _filter;
 
+    // Evaluates '_filter' on the batched execution path.
+    BatchFilter _batchFilter;
+
     // If a document does not pass '_filter' but passes '_endCondition', stop scanning and return
     // IS_EOF.
     BSONObj _endConditionBSON;
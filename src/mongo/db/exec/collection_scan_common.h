@@ -61,6 +61,17 @@ struct CollectionScanParams {
     // This field cannot be used in conjunction with 'minTs' or 'maxTs'.
     boost::optional<RecordId> resumeAfterRecordId;
 
+    // If present, the collection scan will seek directly to the first record whose RecordId is
+    // greater than or equal to 'minRecord'. Must only be set on forward collection scans.
+    // This field cannot be used in conjunction with 'resumeAfterRecordId', 'minTs' or 'maxTs'.
+    boost::optional<RecordId> minRecord;
+
+    // If present, the collection scan will return EOF upon reaching the first record whose
+    // RecordId is greater than or equal to 'maxRecord'. Must only be set on forward collection
+    // scans. Together with 'minRecord', this restricts the scan to the range [minRecord,
+    // maxRecord).
+    boost::optional<RecordId> maxRecord;
+
     Direction direction = FORWARD;
 
     // Do we want the scan to be 'tailable'?  Only meaningful if the collection is capped.
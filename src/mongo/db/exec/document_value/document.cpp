@@ -170,6 +170,51 @@ Position DocumentStorage::findField(StringData requested, LookupPolicy policy) c
     return Position();
 }
 
+Position DocumentStorage::findFieldAndRemember(StringData requested,
+                                               FieldPositionCache* cache) const {
+    // Loading the field from the BSON changes the shape, so remember the one it had beforehand:
+    // that is what the next document of the stream will have when we get to it.
+    const auto shape = _shape;
+    if (auto pos = findFieldInCache(requested); pos.found()) {
+        cache->_store(shape, pos, FieldPositionCache::kNotFromBson);
+        return pos;
+    }
+
+    unsigned bsonIndex = 0;
+    for (auto&& bsonElement : _bson) {
+        if (requested == bsonElement.fieldNameStringData()) {
+            cache->_store(shape, Position(), bsonIndex);
+            return const_cast<DocumentStorage*>(this)->constructInCache(bsonElement);
+        }
+        ++bsonIndex;
+    }
+
+    // if we got here, there's no such field
+    return Position();
+}
+
+Position DocumentStorage::findFieldInBsonAt(StringData requested, unsigned bsonIndex) const {
+    // The shape is a fingerprint, so make sure the field isn't in the cache already.
+    if (_numFields != 0 && findFieldInCache(requested).found()) {
+        return Position();
+    }
+
+    unsigned index = 0;
+    for (auto&& bsonElement : _bson) {
+        const bool nameMatches = requested == bsonElement.fieldNameStringData();
+        if (index == bsonIndex) {
+            return nameMatches ? const_cast<DocumentStorage*>(this)->constructInCache(bsonElement)
+                               : Position();
+        }
+        if (nameMatches) {
+            // A repeated field name, which the regular lookup resolves to its first occurrence.
+            return Position();
+        }
+        ++index;
+    }
+    return Position();
+}
+
 Position DocumentStorage::constructInCache(const BSONElement& elem) {
     auto savedModified = _modified;
     auto pos = getNextPosition();
@@ -211,6 +256,7 @@ Value& DocumentStorage::appendField(StringData name, ValueElement::Kind kind) {
     fassert(16486, getField(pos).next()->ptr() == _cache + _usedBytes);
 
     _numFields++;
+    _shape = extendShape(_shape, name);
 
     if (_numFields > HASH_TAB_MIN) {
         addFieldToHashTable(pos);
@@ -304,6 +350,7 @@ intrusive_ptr<DocumentStorage> DocumentStorage::clone() const {
         out->_hashTabMask = _hashTabMask;
         out->_usedBytes = _usedBytes;
         out->_numFields = _numFields;
+        out->_shape = _shape;
 
         dassert(out->allocatedBytes() == bufferBytes);
 
@@ -350,6 +397,7 @@ void DocumentStorage::reset(const BSONObj& bson, bool stripMetadata) {
     _usedBytes = 0;
     _numFields = 0;
     _hashTabMask = 0;
+    _shape = kEmptyShape;
 
     // Clean metadata.
     _metadataFields = DocumentMetadataFields{};
@@ -136,6 +136,15 @@ public:
         return storage().getField(key);
     }
 
+    /**
+     * Same as getField(key), but first looks where 'cache' last found 'key'. Meant for callers that
+     * look up the same field in many documents, most of which share a shape. See
+     * FieldPositionCache.
+     */
+    const Value getField(StringData key, FieldPositionCache* cache) const {
+        return storage().getField(key, cache);
+    }
+
     /// Look up a field by Position. See positionOf and getNestedField.
     const Value operator[](Position pos) const {
         return getField(pos);
@@ -37,6 +37,7 @@
 #include "mongo/base/static_assert.h"
 #include "mongo/db/exec/document_value/document_metadata_fields.h"
 #include "mongo/db/exec/document_value/value.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/intrusive_counter.h"
 
 namespace mongo {
@@ -72,6 +73,94 @@ private:
     friend class DocumentStorage;
     friend class DocumentStorageIterator;
     friend class DocumentStorageCacheIterator;
+    friend class FieldPositionCache;
+};
+
+/**
+ * Remembers where a field was found in the last document that had it, together with the shape
+ * that document had before the lookup. Two DocumentStorages with the same shape had the same field
+ * names appended to their cache in the same order, so each field sits at the same Position in
+ * both. A field which was not in the cache yet is remembered by its index in the underlying BSON
+ * instead, since documents read from the same collection mostly share their layout. A caller that
+ * looks up the same name in every document of a stream, such as an ExpressionFieldPath, can keep one
+ * of these to skip hashing and comparing the name whenever the shape repeats.
+ *
+ * The same expression may be evaluated by several threads at once (a collection validator is), so
+ * the full shape and the position are published under a version counter: a writer which finds
+ * another one already at work skips remembering, and a reader which sees the counter move ignores
+ * what it read.
+ */
+class FieldPositionCache {
+public:
+    FieldPositionCache() = default;
+    FieldPositionCache(const FieldPositionCache& other) {
+        *this = other;
+    }
+    FieldPositionCache& operator=(const FieldPositionCache& other) {
+        uint64_t shape;
+        Position pos;
+        unsigned bsonIndex;
+        if (other._load(&shape, &pos, &bsonIndex)) {
+            _store(shape, pos, bsonIndex);
+        }
+        return *this;
+    }
+
+    /** The shape fingerprint of the document the position was found in. */
+    uint64_t shape() const {
+        return _shape.loadRelaxed();
+    }
+
+    /** The position of the field in the cache, or Position() if it was loaded from the BSON. */
+    Position position() const {
+        return Position(_index.loadRelaxed());
+    }
+
+    /** How many times a position was remembered. Lookups that hit the cache don't change it. */
+    uint64_t timesRemembered() const {
+        return _version.loadRelaxed() / 2;
+    }
+
+private:
+    friend class DocumentStorage;
+
+    static constexpr unsigned kNotFromBson = static_cast<unsigned>(-1);
+
+    /**
+     * Reads the remembered shape, position and BSON index. Returns false if they were being
+     * written at the time, in which case they may not belong together.
+     */
+    bool _load(uint64_t* shape, Position* pos, unsigned* bsonIndex) const {
+        const uint64_t version = _version.load();
+        if (version & 1) {
+            return false;
+        }
+        *shape = _shape.load();
+        *pos = Position(_index.load());
+        *bsonIndex = _bsonIndex.load();
+        return _version.load() == version;
+    }
+
+    /**
+     * Remembers 'shape', 'pos' and 'bsonIndex', unless another thread is remembering something at
+     * the same time.
+     */
+    void _store(uint64_t shape, Position pos, unsigned bsonIndex) {
+        uint64_t version = _version.load();
+        if ((version & 1) || !_version.compareAndSwap(&version, version + 1)) {
+            return;
+        }
+        _shape.store(shape);
+        _index.store(pos.index);
+        _bsonIndex.store(bsonIndex);
+        _version.store(version + 2);
+    }
+
+    // Odd while a writer is updating the fields below.
+    AtomicWord<uint64_t> _version{0};
+    AtomicWord<uint64_t> _shape{0};
+    AtomicWord<unsigned> _index{Position().index};
+    AtomicWord<unsigned> _bsonIndex{kNotFromBson};
 };
 
 #pragma pack(1)
@@ -314,6 +403,30 @@ public:
     /// Returns the position of the named field or Position()
     Position findField(StringData name, LookupPolicy policy) const;
 
+    /**
+     * Same as findField(name, LookupPolicy::kCacheAndBSON), but tries the position remembered in
+     * 'cache' first and remembers the position at which the field was found otherwise.
+     */
+    Position findField(StringData name, FieldPositionCache* cache) const {
+        uint64_t shape;
+        Position pos;
+        unsigned bsonIndex;
+        if (cache->_load(&shape, &pos, &bsonIndex) && shape == _shape) {
+            if (pos.found() && pos.index + sizeof(ValueElement) <= _usedBytes) {
+                // The shape is a fingerprint, so make sure the field really is the one we want.
+                const ValueElement& elem = getField(pos);
+                if (elem.nameSD() == name) {
+                    return pos;
+                }
+            } else if (bsonIndex != FieldPositionCache::kNotFromBson) {
+                if (auto fromBson = findFieldInBsonAt(name, bsonIndex); fromBson.found()) {
+                    return fromBson;
+                }
+            }
+        }
+        return findFieldAndRemember(name, cache);
+    }
+
     // Document uses these
     const ValueElement& getField(Position pos) const {
         verify(pos.found());
@@ -325,6 +438,12 @@ public:
             return Value();
         return getField(pos).val;
     }
+    Value getField(StringData name, FieldPositionCache* cache) const {
+        Position pos = findField(name, cache);
+        if (!pos.found())
+            return Value();
+        return getField(pos).val;
+    }
 
     // MutableDocument uses these
     ValueElement& getField(Position pos) {
@@ -459,10 +578,40 @@ public:
         return _bson;
     }
 
+    /**
+     * Returns a fingerprint of the sequence of field names in the cache. Storages with the same
+     * shape store each of their fields at the same Position.
+     */
+    uint64_t shape() const {
+        return _shape;
+    }
+
 private:
+    // FNV-1a offset basis and prime, the fingerprint of a storage with an empty cache and the
+    // multiplier used to extend it.
+    static constexpr uint64_t kEmptyShape = 14695981039346656037ULL;
+    static constexpr uint64_t kShapePrime = 1099511628211ULL;
+
+    static uint64_t extendShape(uint64_t shape, StringData name) {
+        for (char c : name) {
+            shape = (shape ^ static_cast<unsigned char>(c)) * kShapePrime;
+        }
+        // Field names can't contain a NUL, so it separates "ab","c" from "a","bc".
+        return shape * kShapePrime;
+    }
+
     /// Returns the position of the named field in the cache or Position()
     Position findFieldInCache(StringData name) const;
 
+    /// Slow path of findField(name, cache).
+    Position findFieldAndRemember(StringData name, FieldPositionCache* cache) const;
+
+    /**
+     * Loads the field at index 'bsonIndex' of the underlying BSON into the cache if it is named
+     * 'name' and the cache doesn't hold 'name' yet. Returns Position() otherwise.
+     */
+    Position findFieldInBsonAt(StringData name, unsigned bsonIndex) const;
+
     /// Allocates space in _cache. Copies existing data if there is any.
     void alloc(unsigned newSize);
 
@@ -530,6 +679,8 @@ private:
     unsigned _numFields;    // this includes removed fields
     unsigned _hashTabMask;  // equal to hashTabBuckets()-1 but used more often
 
+    uint64_t _shape = kEmptyShape;  // see shape()
+
     BSONObj _bson;
 
     // If '_stripMetadata' is true, tracks whether or not the metadata has been lazy-loaded from the
@@ -172,6 +172,92 @@ TEST(DocumentSerialization, CannotSerializeDocumentThatExceedsDepthLimit) {
     throwaway.abandon();
 }
 
+TEST(DocumentFieldPositionCache, ReusesPositionForDocumentsOfTheSameShape) {
+    mongo::FieldPositionCache cache;
+    auto first = Document{{"a", 1}, {"b", 2}, {"c", 3}, {"d", 4}, {"e", 5}};
+    ASSERT_VALUE_EQ(first.getField("d", &cache), mongo::Value(4));
+    ASSERT_TRUE(cache.position().found());
+    const auto cached = cache;
+
+    auto second = Document{{"a", 10}, {"b", 20}, {"c", 30}, {"d", 40}, {"e", 50}};
+    ASSERT_VALUE_EQ(second.getField("d", &cache), mongo::Value(40));
+    ASSERT_EQ(cache.shape(), cached.shape());
+    ASSERT_EQ(cache.position(), cached.position());
+}
+
+TEST(DocumentFieldPositionCache, FallsBackToLookupForOtherShapes) {
+    mongo::FieldPositionCache cache;
+    ASSERT_VALUE_EQ((Document{{"a", 1}, {"b", 2}}).getField("b", &cache), mongo::Value(2));
+    const auto cached = cache;
+
+    // Same field names in another order, and a name that only differs in where it is split.
+    ASSERT_VALUE_EQ((Document{{"b", 3}, {"a", 4}}).getField("b", &cache), mongo::Value(3));
+    ASSERT_NE(cache.shape(), cached.shape());
+    ASSERT_VALUE_EQ((Document{{"ab", 5}, {"b", 6}}).getField("b", &cache), mongo::Value(6));
+    ASSERT_VALUE_EQ((Document{{"a", 7}, {"bb", 8}}).getField("b", &cache), mongo::Value());
+    ASSERT_VALUE_EQ((Document{{"a", 9}, {"b", 10}}).getField("b", &cache), mongo::Value(10));
+}
+
+TEST(DocumentFieldPositionCache, SeesModificationsAndRemovals) {
+    mongo::FieldPositionCache cache;
+    auto original = Document{{"a", 1}, {"b", 2}};
+    ASSERT_VALUE_EQ(original.getField("b", &cache), mongo::Value(2));
+
+    MutableDocument modified(original);
+    modified.setField("b", mongo::Value(3));
+    ASSERT_VALUE_EQ(modified.peek().getField("b", &cache), mongo::Value(3));
+    modified.remove("b");
+    ASSERT_VALUE_EQ(modified.peek().getField("b", &cache), mongo::Value());
+}
+
+TEST(DocumentFieldPositionCache, WorksWithLazilyLoadedBson) {
+    mongo::FieldPositionCache cache;
+    for (int i = 0; i < 3; ++i) {
+        auto document = fromBson(BSON("a" << i << "b" << i * 2 << "c" << i * 3));
+        ASSERT_VALUE_EQ(document.getField("b", &cache), mongo::Value(i * 2));
+
+        // Only the first document misses, the others find 'b' where the first one had it.
+        ASSERT_EQ(cache.timesRemembered(), 1U);
+        ASSERT_FALSE(cache.position().found());
+
+        ASSERT_VALUE_EQ(document.getField("c"), mongo::Value(i * 3));
+        ASSERT_VALUE_EQ(document.getField("b"), mongo::Value(i * 2));
+    }
+}
+
+TEST(DocumentFieldPositionCache, HitsForFieldsAlreadyLoadedFromBson) {
+    mongo::FieldPositionCache cache;
+    for (int i = 0; i < 3; ++i) {
+        auto document = fromBson(BSON("a" << i << "b" << i * 2));
+        ASSERT_VALUE_EQ(document.getField("a"), mongo::Value(i));
+        ASSERT_VALUE_EQ(document.getField("b"), mongo::Value(i * 2));
+        ASSERT_VALUE_EQ(document.getField("b", &cache), mongo::Value(i * 2));
+        ASSERT_EQ(cache.timesRemembered(), 1U);
+        ASSERT_TRUE(cache.position().found());
+    }
+}
+
+TEST(DocumentFieldPositionCache, FallsBackToLookupForOtherBsonLayouts) {
+    mongo::FieldPositionCache cache;
+    ASSERT_VALUE_EQ(fromBson(BSON("a" << 1 << "b" << 2)).getField("b", &cache), mongo::Value(2));
+    ASSERT_VALUE_EQ(fromBson(BSON("b" << 3 << "a" << 4)).getField("b", &cache), mongo::Value(3));
+    ASSERT_VALUE_EQ(fromBson(BSON("a" << 5)).getField("b", &cache), mongo::Value());
+    ASSERT_VALUE_EQ(fromBson(BSON("a" << 6 << "bb" << 7)).getField("b", &cache), mongo::Value());
+    ASSERT_VALUE_EQ(fromBson(BSON("x" << 8 << "b" << 9)).getField("b", &cache), mongo::Value(9));
+
+    // The remembered index holds the name again, but so does an earlier field.
+    ASSERT_VALUE_EQ(fromBson(BSON("b" << 10 << "b" << 11)).getField("b", &cache),
+                    mongo::Value(10));
+}
+
+TEST(DocumentFieldPositionCache, ReturnsFirstOfDuplicateFields) {
+    mongo::FieldPositionCache cache;
+    for (int i = 0; i < 2; ++i) {
+        auto document = Document{{"a", i}, {"a", i + 10}};
+        ASSERT_VALUE_EQ(document.getField("a", &cache), mongo::Value(i));
+    }
+}
+
 /** Add Document fields. */
 class AddField {
 public:
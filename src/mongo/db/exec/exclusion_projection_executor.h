@@ -55,7 +55,7 @@ public:
         // We may have expression dependencies though, as $meta expression can be used with
         // exclusion.
         for (auto&& expressionPair : _expressions) {
-            expressionPair.second->addDependencies(deps);
+            expressionPair.second.expression->addDependencies(deps);
         }
 
         for (auto&& childPair : _children) {
@@ -57,6 +57,7 @@ FetchStage::FetchStage(OperationContext* opCtx,
     : RequiresCollectionStage(kStageType, opCtx, collection),
       _ws(ws),
       _filter(filter),
+      _batchFilter(filter),
       _idRetrying(WorkingSet::INVALID_ID) {
     _children.emplace_back(std::move(child));
 }
@@ -69,6 +70,11 @@ bool FetchStage::isEOF() {
         return false;
     }
 
+    if (!_pendingIds.empty()) {
+        // We have working set members left over from an interrupted batch.
+        return false;
+    }
+
     return child()->isEOF();
 }
 
@@ -81,7 +87,13 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
     WorkingSetID id;
     StageState status;
     if (_idRetrying == WorkingSet::INVALID_ID) {
-        status = child()->work(&id);
+        if (_pendingIds.empty()) {
+            status = child()->work(&id);
+        } else {
+            status = ADVANCED;
+            id = _pendingIds.front();
+            _pendingIds.erase(_pendingIds.begin());
+        }
     } else {
         status = ADVANCED;
         id = _idRetrying;
@@ -131,6 +143,89 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState FetchStage::doWorkBatch(size_t maxResults, WorkBatch* out) {
+    if (WorkingSet::INVALID_ID != _idRetrying) {
+        // Retry the member which hit a write conflict on its own.
+        return PlanStage::doWorkBatch(maxResults, out);
+    }
+
+    if (isEOF()) {
+        return PlanStage::IS_EOF;
+    }
+
+    const size_t firstResult = out->ids.size();
+    StageState status;
+    if (_pendingIds.empty()) {
+        status = child()->workBatch(maxResults, out);
+    } else {
+        out->ids.insert(out->ids.end(), _pendingIds.begin(), _pendingIds.end());
+        _pendingIds.clear();
+        status = PlanStage::NEED_TIME;
+    }
+
+    if (PlanStage::FAILURE == status) {
+        // The stage which produces a failure is responsible for allocating a working set member
+        // with error details. The query is going to stop, so don't bother fetching anything.
+        invariant(WorkingSet::INVALID_ID != out->statusId);
+        for (size_t i = firstResult; i < out->ids.size(); ++i) {
+            _ws->free(out->ids[i]);
+        }
+        out->ids.resize(firstResult);
+        return status;
+    }
+
+    bool hitWriteConflict = false;
+    size_t kept = firstResult;
+    for (size_t i = firstResult; i < out->ids.size(); ++i) {
+        const WorkingSetID id = out->ids[i];
+        WorkingSetMember* member = _ws->get(id);
+
+        if (member->hasObj()) {
+            ++_specificStats.alreadyHasObj;
+        } else {
+            verify(WorkingSetMember::RID_AND_IDX == member->getState());
+            verify(member->hasRecordId());
+
+            try {
+                if (!_cursor)
+                    _cursor = collection()->getCursor(getOpCtx());
+
+                if (!WorkingSetCommon::fetch(getOpCtx(), _ws, id, _cursor)) {
+                    _ws->free(id);
+                    continue;
+                }
+
+                // The cursor may reuse the memory backing this document on the next fetch, but
+                // the caller holds on to every result in the batch.
+                member->makeObjOwnedIfNeeded();
+            } catch (const WriteConflictException&) {
+                member->makeObjOwnedIfNeeded();
+                _idRetrying = id;
+                _pendingIds.assign(out->ids.begin() + i + 1, out->ids.end());
+                hitWriteConflict = true;
+                break;
+            }
+        }
+
+        out->ids[kept++] = id;
+    }
+    out->ids.resize(kept);
+
+    // See returnIfMatches() for what counts as an examined document.
+    _specificStats.docsExamined += _batchFilter.filter(_ws, &out->ids, firstResult);
+
+    if (hitWriteConflict) {
+        out->statusId = WorkingSet::INVALID_ID;
+        return PlanStage::NEED_YIELD;
+    }
+
+    if (PlanStage::ADVANCED == status || PlanStage::NEED_TIME == status) {
+        return out->ids.size() > firstResult ? PlanStage::ADVANCED : PlanStage::NEED_TIME;
+    }
+
+    return status;
+}
+
 void FetchStage::doSaveStateRequiresCollection() {
     if (_cursor) {
         _cursor->saveUnpositioned();
@@ -30,7 +30,9 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
+#include "mongo/db/exec/batch_filter.h"
 #include "mongo/db/exec/requires_collection_stage.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
@@ -60,6 +62,7 @@ public:
 
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(size_t maxResults, WorkBatch* out) final;
 
     void doDetachFromOperationContext() final;
     void doReattachToOperationContext() final;
@@ -95,9 +98,16 @@ private:
     // The filter is not owned by us.
     const MatchExpression* _filter;
 
+    // Evaluates '_filter' on the batched execution path.
+    BatchFilter _batchFilter;
+
     // If not Null, we use this rather than asking our child what to do next.
     WorkingSetID _idRetrying;
 
+    // Members of a batch which were not yet fetched when a write conflict interrupted the batch.
+    // These are consumed after '_idRetrying' and before asking our child for more.
+    std::vector<WorkingSetID> _pendingIds;
+
     // Stats
     FetchStats _specificStats;
 };
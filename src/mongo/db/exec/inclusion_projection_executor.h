@@ -63,7 +63,7 @@ public:
         }
 
         for (auto&& expressionPair : _expressions) {
-            expressionPair.second->addDependencies(deps);
+            expressionPair.second.expression->addDependencies(deps);
         }
 
         for (auto&& childPair : _children) {
@@ -0,0 +1,437 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/parallel_collection_scan.h"
+
+#include <algorithm>
+
+#include "mongo/db/catalog_raii.h"
+#include "mongo/db/client.h"
+#include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/exec/working_set_common.h"
+#include "mongo/db/matcher/expression.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+namespace {
+
+// The number of random records sampled per partition when choosing partition boundaries.
+const size_t kSamplesPerPartition = 16;
+
+// The number of matching documents a worker gathers before publishing them to the consumer.
+const size_t kPublishBatchSize = 64;
+
+// How long the consumer waits for a worker before returning NEED_TIME. The consumer holds this
+// operation's locks while it waits, so it must not block for long: a worker may be queued behind
+// a conflicting lock request which cannot be granted until this operation yields.
+const Milliseconds kConsumerWaitTime(10);
+
+// How long a worker waits for its collection lock before checking whether it should stop.
+const Milliseconds kWorkerLockTimeout(100);
+
+}  // namespace
+
+// static
+const char* ParallelCollectionScan::kStageType = "PARALLEL_COLLSCAN";
+
+ParallelCollectionScan::ParallelCollectionScan(OperationContext* opCtx,
+                                               const Collection* collection,
+                                               const ParallelCollectionScanParams& params,
+                                               WorkingSet* workingSet,
+                                               const MatchExpression* filter)
+    : RequiresCollectionStage(kStageType, opCtx, collection),
+      _workingSet(workingSet),
+      _filter(filter),
+      _params(params),
+      _dbName(collection->ns().db().toString()) {
+    invariant(_params.partitions > 0);
+    invariant(_params.bufferSizeBytes > 0);
+    invariant(canUseFilter(_filter));
+    _specificStats.preserveOrder = _params.preserveOrder;
+}
+
+ParallelCollectionScan::~ParallelCollectionScan() {
+    _stopWorkers();
+}
+
+// static
+bool ParallelCollectionScan::canUseFilter(const MatchExpression* filter) {
+    if (!filter) {
+        return true;
+    }
+
+    switch (filter->matchType()) {
+        case MatchExpression::EXPRESSION:
+        case MatchExpression::WHERE:
+        case MatchExpression::TEXT:
+        case MatchExpression::GEO_NEAR:
+            return false;
+        default:
+            break;
+    }
+
+    for (size_t i = 0; i < filter->numChildren(); ++i) {
+        if (!canUseFilter(filter->getChild(i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// static
+std::vector<RecordId> ParallelCollectionScan::choosePartitionBoundaries(
+    OperationContext* opCtx, const Collection* collection, size_t partitions) {
+    if (partitions <= 1) {
+        return {};
+    }
+
+    auto cursor = collection->getRecordStore()->getRandomCursor(opCtx);
+    if (!cursor) {
+        return {};
+    }
+
+    std::vector<RecordId> sample;
+    const size_t sampleSize = partitions * kSamplesPerPartition;
+    sample.reserve(sampleSize);
+    while (sample.size() < sampleSize) {
+        auto record = cursor->next();
+        if (!record) {
+            break;
+        }
+        sample.push_back(record->id);
+    }
+
+    // A random cursor may return the same record more than once.
+    std::sort(sample.begin(), sample.end());
+    sample.erase(std::unique(sample.begin(), sample.end()), sample.end());
+
+    std::vector<RecordId> boundaries;
+    for (size_t i = 1; i < partitions && !sample.empty(); ++i) {
+        const RecordId& boundary = sample[i * sample.size() / partitions];
+        if (boundaries.empty() || boundaries.back() < boundary) {
+            boundaries.push_back(boundary);
+        }
+    }
+    return boundaries;
+}
+
+PlanStage::StageState ParallelCollectionScan::doWork(WorkingSetID* out) {
+    if (_commonStats.isEOF) {
+        return PlanStage::IS_EOF;
+    }
+
+    if (!_started) {
+        try {
+            _startWorkers();
+        } catch (const WriteConflictException&) {
+            // Sampling the partition boundaries conflicted with a write. Try again after yielding.
+            *out = WorkingSet::INVALID_ID;
+            return PlanStage::NEED_YIELD;
+        }
+        return PlanStage::NEED_TIME;
+    }
+
+    _specificStats.docsTested = _docsTested.load();
+
+    stdx::unique_lock<Latch> lk(_mutex);
+    boost::optional<size_t> ready;
+    _producedCV.wait_for(lk, kConsumerWaitTime.toSystemDuration(), [&] {
+        return !_workerStatus.isOK() || (ready = _readyPartition(lk));
+    });
+
+    if (!_workerStatus.isOK()) {
+        Status status = _workerStatus;
+        lk.unlock();
+        _stopWorkers();
+        *out = WorkingSetCommon::allocateStatusMember(_workingSet, status);
+        return PlanStage::FAILURE;
+    }
+
+    if (!ready) {
+        return PlanStage::NEED_TIME;
+    }
+
+    if (*ready == _partitions.size()) {
+        lk.unlock();
+        _stopWorkers();
+        _specificStats.docsTested = _docsTested.load();
+        _commonStats.isEOF = true;
+        return PlanStage::IS_EOF;
+    }
+
+    auto& partition = _partitions[*ready];
+    auto [recordId, obj] = std::move(partition.buffer.front());
+    partition.buffer.pop_front();
+    partition.bufferedBytes -= obj.objsize();
+    lk.unlock();
+    _consumedCV.notify_all();
+
+    WorkingSetID id = _workingSet->allocate();
+    WorkingSetMember* member = _workingSet->get(id);
+    member->recordId = recordId;
+    member->resetDocument(getOpCtx()->recoveryUnit()->getSnapshotId(), obj);
+    _workingSet->transitionToRecordIdAndObj(id);
+
+    *out = id;
+    return PlanStage::ADVANCED;
+}
+
+bool ParallelCollectionScan::isEOF() {
+    return _commonStats.isEOF;
+}
+
+void ParallelCollectionScan::doDispose() {
+    _stopWorkers();
+}
+
+boost::optional<size_t> ParallelCollectionScan::_readyPartition(WithLock) {
+    if (_params.preserveOrder) {
+        while (_nextPartition < _partitions.size()) {
+            const auto& partition = _partitions[_nextPartition];
+            if (!partition.buffer.empty()) {
+                return _nextPartition;
+            }
+            if (!partition.exhausted) {
+                return boost::none;
+            }
+            ++_nextPartition;
+        }
+        return _partitions.size();
+    }
+
+    bool allExhausted = true;
+    for (size_t i = 0; i < _partitions.size(); ++i) {
+        if (!_partitions[i].buffer.empty()) {
+            return i;
+        }
+        allExhausted = allExhausted && _partitions[i].exhausted;
+    }
+    return allExhausted ? boost::make_optional(_partitions.size()) : boost::none;
+}
+
+void ParallelCollectionScan::_startWorkers() {
+    invariant(!_started);
+
+    const auto boundaries = choosePartitionBoundaries(getOpCtx(), collection(), _params.partitions);
+
+    // Workers read from the same point in time as this operation, if it has one.
+    const auto readTimestamp = getOpCtx()->recoveryUnit()->getPointInTimeReadTimestamp();
+
+    _partitions.resize(boundaries.size() + 1);
+    for (size_t i = 0; i < _partitions.size(); ++i) {
+        if (i > 0) {
+            _partitions[i].minRecord = boundaries[i - 1];
+        }
+        if (i < boundaries.size()) {
+            _partitions[i].maxRecord = boundaries[i];
+        }
+    }
+    _specificStats.partitions = _partitions.size();
+
+    LOG(3) << "Starting parallel collection scan of " << collection()->ns() << " with "
+           << _partitions.size() << " partitions";
+
+    _workers.reserve(_partitions.size());
+    for (size_t i = 0; i < _partitions.size(); ++i) {
+        _workers.emplace_back([this, i, readTimestamp] {
+            Client::initThread("ParallelCollectionScan");
+            _runWorker(i, readTimestamp);
+        });
+    }
+    _started = true;
+}
+
+void ParallelCollectionScan::_stopWorkers() {
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _stopping = true;
+    }
+    _consumedCV.notify_all();
+
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+    _workers.clear();
+}
+
+void ParallelCollectionScan::_runWorker(size_t partitionIndex,
+                                        boost::optional<Timestamp> readTimestamp) {
+    auto opCtx = cc().makeOperationContext();
+    if (readTimestamp) {
+        opCtx->recoveryUnit()->setTimestampReadSource(RecoveryUnit::ReadSource::kProvided,
+                                                      readTimestamp);
+    }
+
+    CollectionScanParams scanParams;
+    scanParams.minRecord = _partitions[partitionIndex].minRecord;
+    scanParams.maxRecord = _partitions[partitionIndex].maxRecord;
+
+    WorkingSet ws;
+    std::unique_ptr<MatchExpression> filter = _filter ? _filter->shallowClone() : nullptr;
+    std::unique_ptr<CollectionScan> scan;
+
+    Status status = Status::OK();
+    try {
+        bool done = false;
+        while (!done) {
+            try {
+                AutoGetCollection autoColl(opCtx.get(),
+                                           NamespaceStringOrUUID(_dbName, uuid()),
+                                           MODE_IS,
+                                           AutoGetCollection::kViewsForbidden,
+                                           Date_t::now() + kWorkerLockTimeout);
+                const Collection* coll = autoColl.getCollection();
+                uassert(ErrorCodes::QueryPlanKilled,
+                        "collection dropped during parallel collection scan",
+                        coll);
+
+                if (!scan) {
+                    scan = std::make_unique<CollectionScan>(
+                        opCtx.get(), coll, scanParams, &ws, filter.get());
+                } else {
+                    scan->restoreState();
+                }
+
+                const long long docsTestedBefore =
+                    static_cast<const CollectionScanStats*>(scan->getSpecificStats())->docsTested;
+                done = _produce(partitionIndex, scan.get(), &ws);
+                _docsTested.fetchAndAdd(
+                    static_cast<const CollectionScanStats*>(scan->getSpecificStats())->docsTested -
+                    docsTestedBefore);
+
+                scan->saveState();
+            } catch (const ExceptionFor<ErrorCodes::LockTimeout>&) {
+                // Fall through to check whether we have been asked to stop, then try again.
+            }
+            opCtx->recoveryUnit()->abandonSnapshot();
+            if (done) {
+                break;
+            }
+
+            // Wait outside of the collection lock until the consumer makes room for more documents.
+            stdx::unique_lock<Latch> lk(_mutex);
+            _consumedCV.wait(lk, [&] {
+                return _stopping ||
+                    _partitions[partitionIndex].bufferedBytes < _params.bufferSizeBytes;
+            });
+            if (_stopping) {
+                break;
+            }
+        }
+    } catch (const DBException& ex) {
+        status = ex.toStatus();
+    }
+
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _partitions[partitionIndex].exhausted = true;
+        if (!status.isOK() && _workerStatus.isOK()) {
+            _workerStatus = status.withContext("parallel collection scan worker failed");
+        }
+    }
+    _producedCV.notify_all();
+}
+
+bool ParallelCollectionScan::_produce(size_t partitionIndex, PlanStage* scan, WorkingSet* ws) {
+    auto& partition = _partitions[partitionIndex];
+
+    std::vector<std::pair<RecordId, BSONObj>> pending;
+    size_t pendingBytes = 0;
+    auto publish = [&] {
+        stdx::lock_guard<Latch> lk(_mutex);
+        for (auto& result : pending) {
+            partition.buffer.push_back(std::move(result));
+        }
+        partition.bufferedBytes += pendingBytes;
+        pending.clear();
+        pendingBytes = 0;
+        return !_stopping && partition.bufferedBytes < _params.bufferSizeBytes;
+    };
+
+    // Release the collection lock and snapshot periodically, as a yielding scan would.
+    const int maxWorks = internalQueryExecYieldIterations.load();
+    for (int works = 0; works < maxWorks; ++works) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        const auto state = scan->work(&id);
+
+        if (state == PlanStage::ADVANCED) {
+            WorkingSetMember* member = ws->get(id);
+            BSONObj obj = member->doc.value().toBson().getOwned();
+            pendingBytes += obj.objsize();
+            pending.emplace_back(member->recordId, std::move(obj));
+            ws->free(id);
+
+            if (pending.size() >= kPublishBatchSize && !publish()) {
+                return false;
+            }
+        } else if (state == PlanStage::IS_EOF) {
+            publish();
+            return true;
+        } else if (state == PlanStage::FAILURE) {
+            publish();
+            uassertStatusOK(WorkingSetCommon::getMemberStatus(*ws->get(id)));
+        } else if (state == PlanStage::NEED_YIELD) {
+            break;
+        }
+    }
+
+    publish();
+    return false;
+}
+
+std::unique_ptr<PlanStageStats> ParallelCollectionScan::getStats() {
+    _specificStats.docsTested = _docsTested.load();
+
+    // Add a BSON representation of the filter to the stats tree, if there is one.
+    if (_filter) {
+        BSONObjBuilder bob;
+        _filter->serialize(&bob);
+        _commonStats.filter = bob.obj();
+    }
+
+    auto ret = std::make_unique<PlanStageStats>(_commonStats, STAGE_PARALLEL_COLLSCAN);
+    ret->specific = std::make_unique<ParallelCollectionScanStats>(_specificStats);
+    return ret;
+}
+
+const SpecificStats* ParallelCollectionScan::getSpecificStats() const {
+    return &_specificStats;
+}
+
+}  // namespace mongo
@@ -0,0 +1,210 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "mongo/bson/timestamp.h"
+#include "mongo/db/exec/plan_stats.h"
+#include "mongo/db/exec/requires_collection_stage.h"
+#include "mongo/db/record_id.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/util/concurrency/with_lock.h"
+
+namespace mongo {
+
+class MatchExpression;
+class WorkingSet;
+
+struct ParallelCollectionScanParams {
+    // The number of RecordId ranges to split the collection into. Each range is scanned by its own
+    // worker thread. Fewer ranges may be used if the collection is too small to be split evenly.
+    size_t partitions = 2;
+
+    // The number of bytes of matching documents each worker may buffer ahead of the consumer.
+    size_t bufferSizeBytes = 4 * 1024 * 1024;
+
+    // If true, documents are returned in the order of a single-threaded forward scan. Otherwise
+    // they are returned as soon as any worker produces them.
+    bool preserveOrder = true;
+};
+
+/**
+ * Scans a collection in the forward direction by splitting its RecordId space into ranges and
+ * scanning each range with a CollectionScan on a separate worker thread. Each worker applies the
+ * filter and buffers owned copies of the matching documents, which this stage hands out as
+ * RID_AND_OBJ working set members.
+ *
+ * Workers run under their own Client and OperationContext. If the operation which owns this stage
+ * reads from a point in time, the workers read at that same timestamp; otherwise they read the
+ * latest data, releasing and reacquiring their snapshot and locks just as a yielding
+ * CollectionScan does.
+ *
+ * Only filters which can be evaluated without the owning operation's state may be pushed down to
+ * the workers; see canUseFilter().
+ */
+class ParallelCollectionScan final : public RequiresCollectionStage {
+public:
+    static const char* kStageType;
+
+    ParallelCollectionScan(OperationContext* opCtx,
+                           const Collection* collection,
+                           const ParallelCollectionScanParams& params,
+                           WorkingSet* workingSet,
+                           const MatchExpression* filter);
+
+    ~ParallelCollectionScan();
+
+    StageState doWork(WorkingSetID* out) final;
+    bool isEOF() final;
+
+    StageType stageType() const final {
+        return STAGE_PARALLEL_COLLSCAN;
+    }
+
+    std::unique_ptr<PlanStageStats> getStats() final;
+
+    const SpecificStats* getSpecificStats() const final;
+
+    /**
+     * Returns true if 'filter' may be evaluated by the worker threads. Expressions which depend on
+     * the owning operation, such as $expr, $where and $text, are not eligible.
+     */
+    static bool canUseFilter(const MatchExpression* filter);
+
+    /**
+     * Chooses up to 'partitions' - 1 RecordIds which split 'collection' into ranges holding roughly
+     * equal numbers of records, by sampling the collection through a random cursor. Returns the
+     * boundaries in increasing order. Fewer boundaries are returned if the record store does not
+     * support random cursors or if the sample is too small to tell the ranges apart.
+     */
+    static std::vector<RecordId> choosePartitionBoundaries(OperationContext* opCtx,
+                                                           const Collection* collection,
+                                                           size_t partitions);
+
+protected:
+    void doSaveStateRequiresCollection() final {}
+
+    void doRestoreStateRequiresCollection() final {}
+
+    void doDispose() final;
+
+private:
+    struct Partition {
+        // The range [minRecord, maxRecord) scanned by this partition's worker. An unset bound
+        // means the range is open on that side.
+        boost::optional<RecordId> minRecord;
+        boost::optional<RecordId> maxRecord;
+
+        // Matching documents which have not yet been handed out by this stage.
+        std::deque<std::pair<RecordId, BSONObj>> buffer;
+        size_t bufferedBytes = 0;
+
+        // Set once the worker has finished, successfully or not.
+        bool exhausted = false;
+    };
+
+    /**
+     * Splits the collection into partitions and starts one worker per partition.
+     */
+    void _startWorkers();
+
+    /**
+     * Asks the workers to stop and waits for them to exit. Safe to call more than once.
+     */
+    void _stopWorkers();
+
+    /**
+     * The body of a worker thread, which scans the range of the partition at 'partitionIndex'.
+     */
+    void _runWorker(size_t partitionIndex, boost::optional<Timestamp> readTimestamp);
+
+    /**
+     * Works 'scan' while this operation's locks are held, moving matching documents into the
+     * partition's buffer. Returns true once 'scan' has reached EOF, or false if the worker should
+     * release its locks and snapshot before continuing.
+     */
+    bool _produce(size_t partitionIndex, PlanStage* scan, WorkingSet* ws);
+
+    /**
+     * Returns the index of a partition with a buffered document, '_partitions.size()' if every
+     * partition has been exhausted and drained, or boost::none if the consumer must wait.
+     */
+    boost::optional<size_t> _readyPartition(WithLock);
+
+    // The WorkingSet is not owned by us.
+    WorkingSet* _workingSet;
+
+    // The filter is not owned by us. Each worker evaluates its own clone of it.
+    const MatchExpression* _filter;
+
+    const ParallelCollectionScanParams _params;
+
+    const std::string _dbName;
+
+    // Protects all of the members below which are shared with the workers.
+    Mutex _mutex = MONGO_MAKE_LATCH("ParallelCollectionScan::_mutex");
+
+    // Signalled when a worker buffers documents, finishes or fails.
+    stdx::condition_variable _producedCV;
+
+    // Signalled when the consumer frees buffer space or the workers are asked to stop.
+    stdx::condition_variable _consumedCV;
+
+    std::vector<Partition> _partitions;
+
+    // When preserving order, the partition currently being drained.
+    size_t _nextPartition = 0;
+
+    // The first error encountered by any worker.
+    Status _workerStatus = Status::OK();
+
+    bool _stopping = false;
+
+    std::vector<stdx::thread> _workers;
+
+    // The number of documents the workers have checked against the filter. Copied into
+    // '_specificStats' by the consumer.
+    AtomicWord<long long> _docsTested{0};
+
+    // Accessed only by the consumer.
+    bool _started = false;
+
+    ParallelCollectionScanStats _specificStats;
+};
+
+}  // namespace mongo
@@ -59,6 +59,40 @@ PlanStage::StageState PlanStage::work(WorkingSetID* out) {
     return workResult;
 }
 
+PlanStage::StageState PlanStage::workBatch(size_t maxResults, WorkBatch* out) {
+    invariant(_opCtx);
+    invariant(maxResults > 0);
+    ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
+    ++_commonStats.works;
+
+    const size_t resultsBefore = out->ids.size();
+    StageState workResult = doWorkBatch(maxResults, out);
+    _commonStats.advanced += out->ids.size() - resultsBefore;
+
+    if (StageState::NEED_TIME == workResult) {
+        ++_commonStats.needTime;
+    } else if (StageState::NEED_YIELD == workResult) {
+        ++_commonStats.needYield;
+    } else if (StageState::FAILURE == workResult) {
+        _commonStats.failed = true;
+    }
+
+    return workResult;
+}
+
+PlanStage::StageState PlanStage::doWorkBatch(size_t maxResults, WorkBatch* out) {
+    WorkingSetID id = WorkingSet::INVALID_ID;
+    StageState workResult = doWork(&id);
+
+    if (StageState::ADVANCED == workResult) {
+        out->ids.push_back(id);
+    } else if (StageState::NEED_YIELD == workResult || StageState::FAILURE == workResult) {
+        out->statusId = id;
+    }
+
+    return workResult;
+}
+
 void PlanStage::saveState() {
     ++_commonStats.yields;
     for (auto&& child : _children) {
@@ -193,6 +193,40 @@ public:
      */
     StageState work(WorkingSetID* out);
 
+    /**
+     * Holds the output of a call to workBatch().
+     *
+     * Every id in 'ids' refers to a result which the caller must free from the working set when
+     * done with it, exactly as if it had been returned by a call to work() which returned ADVANCED.
+     * If workBatch() returns NEED_YIELD or FAILURE, 'statusId' is populated in the same way as the
+     * out parameter of work() would have been.
+     */
+    struct WorkBatch {
+        void clear() {
+            ids.clear();
+            statusId = WorkingSet::INVALID_ID;
+        }
+
+        std::vector<WorkingSetID> ids;
+        WorkingSetID statusId = WorkingSet::INVALID_ID;
+    };
+
+    /**
+     * Asks the stage to produce up to 'maxResults' units of output at once, appending them to
+     * 'out->ids'. This amortizes the cost of dispatching through the stage tree over many results.
+     *
+     * Returns ADVANCED if at least one result was produced and the stage has no other state to
+     * report. Otherwise returns the StageState which stopped the batch, which may be accompanied
+     * by results: callers must consume everything in 'out->ids' before acting on the returned
+     * state.
+     *
+     * Stages which have not been converted to batched execution perform a single unit of work, so
+     * their batches hold at most one result. Converted stages must only put results into a batch
+     * of more than one element if they are safe to hold simultaneously, which in practice means
+     * that any RID_AND_OBJ members must own their BSON.
+     */
+    StageState workBatch(size_t maxResults, WorkBatch* out);
+
     /**
      * Returns true if no more work can be done on the query / out of results.
      */
@@ -341,6 +375,14 @@ protected:
      */
     virtual StageState doWork(WorkingSetID* out) = 0;
 
+    /**
+     * Produces a batch of results.  See comment at workBatch() above.
+     *
+     * The default implementation falls back to a single call to doWork(). Stages which override
+     * this are expected to pull batches from their children via workBatch().
+     */
+    virtual StageState doWorkBatch(size_t maxResults, WorkBatch* out);
+
     /**
      * Saves any stage-specific state required to resume where it was if the underlying data
      * changes.
@@ -0,0 +1,193 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/db/exec/batch_filter.h"
+#include "mongo/db/exec/filter.h"
+#include "mongo/db/exec/projection.h"
+#include "mongo/db/exec/queued_data_stage.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/query/projection_parser.h"
+#include "mongo/db/query/query_test_service_context.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Stands in for the filtering half of a FETCH stage, which can't be built without a collection.
+ * Applies 'filter' one result at a time from doWork() and a batch at a time from doWorkBatch().
+ */
+class FilterStage final : public PlanStage {
+public:
+    FilterStage(OperationContext* opCtx,
+                WorkingSet* ws,
+                const MatchExpression* filter,
+                std::unique_ptr<PlanStage> child)
+        : PlanStage(opCtx, std::move(child), "FILTER"),
+          _ws(ws),
+          _filter(filter),
+          _batchFilter(filter) {}
+
+    bool isEOF() final {
+        return child()->isEOF();
+    }
+
+    StageType stageType() const final {
+        return STAGE_FETCH;
+    }
+
+    std::unique_ptr<PlanStageStats> getStats() final {
+        return std::make_unique<PlanStageStats>(_commonStats, stageType());
+    }
+
+    const SpecificStats* getSpecificStats() const final {
+        return nullptr;
+    }
+
+protected:
+    StageState doWork(WorkingSetID* out) final {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        StageState state = child()->work(&id);
+        if (PlanStage::ADVANCED == state && !Filter::passes(_ws->get(id), _filter)) {
+            _ws->free(id);
+            return PlanStage::NEED_TIME;
+        }
+        *out = id;
+        return state;
+    }
+
+    StageState doWorkBatch(size_t maxResults, WorkBatch* out) final {
+        const size_t firstResult = out->ids.size();
+        StageState state = child()->workBatch(maxResults, out);
+        _batchFilter.filter(_ws, &out->ids, firstResult);
+        if (PlanStage::ADVANCED == state && out->ids.size() == firstResult) {
+            return PlanStage::NEED_TIME;
+        }
+        return state;
+    }
+
+private:
+    WorkingSet* _ws;
+    const MatchExpression* _filter;
+    BatchFilter _batchFilter;
+};
+
+/**
+ * Builds a QUEUED_DATA -> FILTER -> PROJECTION_SIMPLE plan over 'numDocs' documents of roughly
+ * the shape an analytics collection scan would see, and drains it either via work() (when
+ * 'batchSize' is 1) or via workBatch().
+ */
+void runScanFilterProject(benchmark::State& state, const BSONObj& filterObj) {
+    const size_t batchSize = state.range(0);
+    const int numDocs = 10 * 1000;
+
+    QueryTestServiceContext serviceContext;
+    auto opCtx = serviceContext.makeOperationContext();
+    boost::intrusive_ptr<ExpressionContext> expCtx(new ExpressionContext(opCtx.get(), nullptr));
+
+    auto filter = uassertStatusOK(MatchExpressionParser::parse(filterObj, expCtx));
+    const BSONObj projObj = BSON("a" << 1 << "c" << 1);
+    auto projection =
+        projection_ast::parse(expCtx, projObj, ProjectionPolicies::findProjectionPolicies());
+
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < numDocs; ++i) {
+        docs.push_back(BSON("_id" << i << "a" << i % 100 << "b"
+                                  << "some string payload"
+                                  << "c" << static_cast<double>(i) << "d" << BSON("e" << i)));
+    }
+
+    size_t results = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        WorkingSet ws;
+        auto scan = std::make_unique<QueuedDataStage>(opCtx.get(), &ws);
+        for (auto&& doc : docs) {
+            auto id = ws.allocate();
+            ws.get(id)->doc = {SnapshotId(), Document{doc}};
+            ws.transitionToOwnedObj(id);
+            scan->pushBack(id);
+        }
+        auto filterStage =
+            std::make_unique<FilterStage>(opCtx.get(), &ws, filter.get(), std::move(scan));
+        auto root = std::make_unique<ProjectionStageSimple>(
+            expCtx, projObj, &projection, &ws, std::move(filterStage));
+        state.ResumeTiming();
+
+        results = 0;
+        if (batchSize == 1) {
+            while (!root->isEOF()) {
+                WorkingSetID id = WorkingSet::INVALID_ID;
+                if (PlanStage::ADVANCED == root->work(&id)) {
+                    benchmark::DoNotOptimize(ws.get(id)->doc.value());
+                    ws.free(id);
+                    ++results;
+                }
+            }
+        } else {
+            PlanStage::WorkBatch batch;
+            while (!root->isEOF()) {
+                batch.clear();
+                root->workBatch(batchSize, &batch);
+                for (auto&& id : batch.ids) {
+                    benchmark::DoNotOptimize(ws.get(id)->doc.value());
+                    ws.free(id);
+                    ++results;
+                }
+            }
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * numDocs);
+    state.counters["results"] = results;
+}
+
+void BM_ScanFilterProjectSelective(benchmark::State& state) {
+    runScanFilterProject(state, BSON("a" << BSON("$lt" << 10)));
+}
+
+void BM_ScanFilterProjectConjunction(benchmark::State& state) {
+    runScanFilterProject(state, BSON("a" << BSON("$gte" << 10) << "c" << BSON("$lt" << 5000.0)));
+}
+
+void BM_ScanFilterProjectNonColumnar(benchmark::State& state) {
+    runScanFilterProject(state, BSON("d.e" << BSON("$lt" << 5000)));
+}
+
+// A batch size of 1 uses the one-result-at-a-time work() interface.
+BENCHMARK(BM_ScanFilterProjectSelective)->Arg(1)->Arg(16)->Arg(128)->Arg(1024);
+BENCHMARK(BM_ScanFilterProjectConjunction)->Arg(1)->Arg(16)->Arg(128)->Arg(1024);
+BENCHMARK(BM_ScanFilterProjectNonColumnar)->Arg(1)->Arg(128);
+
+}  // namespace
+}  // namespace mongo
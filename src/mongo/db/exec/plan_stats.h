@@ -245,6 +245,26 @@ struct CollectionScanStats : public SpecificStats {
     boost::optional<Timestamp> maxTs;
 };
 
+struct ParallelCollectionScanStats : public SpecificStats {
+    SpecificStats* clone() const final {
+        return new ParallelCollectionScanStats(*this);
+    }
+
+    uint64_t estimateObjectSizeInBytes() const {
+        return sizeof(*this);
+    }
+
+    // How many documents did the workers check against the filter?
+    size_t docsTested = 0;
+
+    // The number of RecordId ranges the collection was split into. Each range is scanned by its
+    // own worker.
+    size_t partitions = 0;
+
+    // Whether documents are returned in the order of a single-threaded forward scan.
+    bool preserveOrder = true;
+};
+
 struct CountStats : public SpecificStats {
     CountStats() : nCounted(0), nSkipped(0) {}
 
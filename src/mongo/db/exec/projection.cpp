@@ -155,6 +155,32 @@ PlanStage::StageState ProjectionStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState ProjectionStage::doWorkBatch(size_t maxResults, WorkBatch* out) {
+    const size_t firstResult = out->ids.size();
+    StageState status = child()->workBatch(maxResults, out);
+
+    if (PlanStage::FAILURE == status) {
+        // The stage which produces a failure is responsible for allocating a working set member
+        // with error details.
+        invariant(WorkingSet::INVALID_ID != out->statusId);
+    }
+
+    for (size_t i = firstResult; i < out->ids.size(); ++i) {
+        Status projStatus = transform(_ws.get(out->ids[i]));
+        if (!projStatus.isOK()) {
+            warning() << "Couldn't execute projection, status = " << redact(projStatus);
+            for (size_t j = firstResult; j < out->ids.size(); ++j) {
+                _ws.free(out->ids[j]);
+            }
+            out->ids.resize(firstResult);
+            out->statusId = WorkingSetCommon::allocateStatusMember(&_ws, projStatus);
+            return PlanStage::FAILURE;
+        }
+    }
+
+    return status;
+}
+
 std::unique_ptr<PlanStageStats> ProjectionStage::getStats() {
     _commonStats.isEOF = isEOF();
     auto ret = std::make_unique<PlanStageStats>(_commonStats, stageType());
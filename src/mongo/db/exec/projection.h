@@ -52,6 +52,7 @@ protected:
 public:
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(size_t maxResults, WorkBatch* out) final;
 
     std::unique_ptr<PlanStageStats> getStats() final;
 
@@ -54,7 +54,7 @@ void ProjectionNode::addExpressionForPath(const FieldPath& path,
     invariant(_policies.computedFieldsPolicy == ComputedFieldsPolicy::kAllowComputedFields);
     if (path.getPathLength() == 1) {
         auto fieldName = path.fullPath();
-        _expressions[fieldName] = expr;
+        _expressions[fieldName] = {expr, nullptr};
         _orderToProcessAdditionsAndChildren.push_back(fieldName);
         return;
     }
@@ -65,7 +65,7 @@ void ProjectionNode::addExpressionForPath(const FieldPath& path,
 boost::intrusive_ptr<Expression> ProjectionNode::getExpressionForPath(const FieldPath& path) const {
     if (path.getPathLength() == 1) {
         if (_expressions.find(path.getFieldName(0)) != _expressions.end()) {
-            return _expressions.at(path.getFieldName(0));
+            return _expressions.at(path.getFieldName(0)).expression;
         }
         return nullptr;
     }
@@ -169,10 +169,12 @@ void ProjectionNode::applyExpressions(const Document& root, MutableDocument* out
         } else {
             auto expressionIt = _expressions.find(field);
             invariant(expressionIt != _expressions.end());
-            outputDoc->setField(
-                field,
-                expressionIt->second->evaluate(
-                    root, &expressionIt->second->getExpressionContext()->variables));
+            const auto& computedField = expressionIt->second;
+            auto* variables = &computedField.expression->getExpressionContext()->variables;
+            outputDoc->setField(field,
+                                computedField.compiled
+                                    ? computedField.compiled->evaluate(root, variables)
+                                    : computedField.expression->evaluate(root, variables));
         }
     }
 }
@@ -225,7 +227,7 @@ void ProjectionNode::reportComputedPaths(std::set<std::string>* computedPaths,
         // The expression's path is the concatenation of the path to this node, plus the field name
         // associated with the expression.
         auto exprPath = FieldPath::getFullyQualifiedPath(_pathToNode, computedPair.first);
-        auto exprComputedPaths = computedPair.second->getComputedPaths(exprPath);
+        auto exprComputedPaths = computedPair.second.expression->getComputedPaths(exprPath);
         computedPaths->insert(exprComputedPaths.paths.begin(), exprComputedPaths.paths.end());
 
         for (auto&& rename : exprComputedPaths.renames) {
@@ -239,7 +241,9 @@ void ProjectionNode::reportComputedPaths(std::set<std::string>* computedPaths,
 
 void ProjectionNode::optimize() {
     for (auto&& expressionIt : _expressions) {
-        _expressions[expressionIt.first] = expressionIt.second->optimize();
+        auto& computedField = expressionIt.second;
+        computedField.expression = computedField.expression->optimize();
+        computedField.compiled = CompiledExpression::compile(computedField.expression);
     }
     for (auto&& childPair : _children) {
         childPair.second->optimize();
@@ -278,7 +282,8 @@ void ProjectionNode::serialize(boost::optional<ExplainOptions::Verbosity> explai
             invariant(_policies.computedFieldsPolicy == ComputedFieldsPolicy::kAllowComputedFields);
             auto expressionIt = _expressions.find(field);
             invariant(expressionIt != _expressions.end());
-            output->addField(field, expressionIt->second->serialize(static_cast<bool>(explain)));
+            output->addField(field,
+                             expressionIt->second.expression->serialize(static_cast<bool>(explain)));
         }
     }
 }
@@ -31,6 +31,7 @@
 
 #include "mongo/db/exec/projection_executor.h"
 
+#include "mongo/db/pipeline/expression_bytecode.h"
 #include "mongo/db/query/projection_policies.h"
 
 namespace mongo::projection_executor {
@@ -154,7 +155,14 @@ protected:
     stdx::unordered_map<std::string, std::unique_ptr<ProjectionNode>> _children;
     stdx::unordered_map<size_t, std::unique_ptr<ProjectionNode>> _arrayBranches;
 
-    StringMap<boost::intrusive_ptr<Expression>> _expressions;
+    // A computed field's expression, along with the bytecode it compiled to when it was last
+    // optimized, if it could be compiled.
+    struct ComputedField {
+        boost::intrusive_ptr<Expression> expression;
+        std::unique_ptr<CompiledExpression> compiled;
+    };
+
+    StringMap<ComputedField> _expressions;
     stdx::unordered_set<std::string> _projectedFields;
 
     ProjectionPolicies _policies;
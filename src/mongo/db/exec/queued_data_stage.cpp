@@ -70,6 +70,23 @@ PlanStage::StageState QueuedDataStage::doWork(WorkingSetID* out) {
     return state;
 }
 
+PlanStage::StageState QueuedDataStage::doWorkBatch(size_t maxResults, WorkBatch* out) {
+    // Queued members were all allocated up front, so any run of consecutive results can be handed
+    // out together. Other states are returned one at a time, exactly as doWork() would.
+    size_t produced = 0;
+    while (produced < maxResults && !isEOF() && PlanStage::ADVANCED == _results.front()) {
+        _results.pop();
+        out->ids.push_back(_members.front());
+        _members.pop();
+        ++produced;
+    }
+
+    if (produced > 0) {
+        return PlanStage::ADVANCED;
+    }
+    return PlanStage::doWorkBatch(maxResults, out);
+}
+
 bool QueuedDataStage::isEOF() {
     return _results.empty();
 }
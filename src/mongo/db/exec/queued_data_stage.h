@@ -51,6 +51,7 @@ public:
     QueuedDataStage(OperationContext* opCtx, WorkingSet* ws);
 
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(size_t maxResults, WorkBatch* out) final;
 
     bool isEOF() final;
 
@@ -123,4 +123,49 @@ TEST_F(QueuedDataStageTest, validateStats) {
     unique_ptr<PlanStageStats> allStats(mock->getStats());
     ASSERT_TRUE(stats->isEOF);
 }
+
+//
+// Test that consecutive results are handed out together by workBatch(), and that other states
+// are still reported one at a time.
+//
+TEST_F(QueuedDataStageTest, workBatch) {
+    WorkingSet ws;
+    auto mock = std::make_unique<QueuedDataStage>(getOpCtx(), &ws);
+
+    std::vector<WorkingSetID> ids;
+    for (int i = 0; i < 5; ++i) {
+        ids.push_back(ws.allocate());
+    }
+    mock->pushBack(ids[0]);
+    mock->pushBack(ids[1]);
+    mock->pushBack(ids[2]);
+    mock->pushBack(PlanStage::NEED_TIME);
+    mock->pushBack(ids[3]);
+    mock->pushBack(ids[4]);
+
+    PlanStage::WorkBatch batch;
+    ASSERT_EQUALS(PlanStage::ADVANCED, mock->workBatch(2, &batch));
+    ASSERT(std::vector<WorkingSetID>({ids[0], ids[1]}) == batch.ids);
+
+    batch.clear();
+    ASSERT_EQUALS(PlanStage::ADVANCED, mock->workBatch(10, &batch));
+    ASSERT(std::vector<WorkingSetID>({ids[2]}) == batch.ids);
+
+    batch.clear();
+    ASSERT_EQUALS(PlanStage::NEED_TIME, mock->workBatch(10, &batch));
+    ASSERT_TRUE(batch.ids.empty());
+
+    batch.clear();
+    ASSERT_EQUALS(PlanStage::ADVANCED, mock->workBatch(10, &batch));
+    ASSERT(std::vector<WorkingSetID>({ids[3], ids[4]}) == batch.ids);
+
+    batch.clear();
+    ASSERT_EQUALS(PlanStage::IS_EOF, mock->workBatch(10, &batch));
+    ASSERT_TRUE(batch.ids.empty());
+
+    const CommonStats* stats = mock->getCommonStats();
+    ASSERT_EQUALS(stats->works, 5U);
+    ASSERT_EQUALS(stats->advanced, 5U);
+    ASSERT_EQUALS(stats->needTime, 1U);
+}
 }  // namespace
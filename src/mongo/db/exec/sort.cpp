@@ -107,6 +107,67 @@ PlanStage::StageState SortStage::doWork(WorkingSetID* out) {
     return PlanStage::ADVANCED;
 }
 
+PlanStage::StageState SortStage::doWorkBatch(size_t maxResults, WorkBatch* out) {
+    if (isEOF()) {
+        return PlanStage::IS_EOF;
+    }
+
+    if (!_populated) {
+        // Feed a whole batch from our child into the sort executor. The results we were handed are
+        // consumed, so nothing is left in 'out->ids' for our caller.
+        const size_t firstResult = out->ids.size();
+        const StageState code = child()->workBatch(maxResults, out);
+
+        for (size_t i = firstResult; i < out->ids.size(); ++i) {
+            const WorkingSetID id = out->ids[i];
+            invariant(_ws->get(id)->metadata().hasSortKey());
+
+            auto&& extractedMember = _ws->extract(id);
+            try {
+                auto sortKey = extractedMember.metadata().getSortKey();
+                _sortExecutor.add(std::move(sortKey), std::move(extractedMember));
+            } catch (const AssertionException&) {
+                for (size_t j = i + 1; j < out->ids.size(); ++j) {
+                    _ws->free(out->ids[j]);
+                }
+                out->ids.resize(firstResult);
+                out->statusId = WorkingSetCommon::allocateStatusMember(_ws, exceptionToStatus());
+                return PlanStage::FAILURE;
+            }
+        }
+        out->ids.resize(firstResult);
+
+        if (code == PlanStage::IS_EOF) {
+            _populated = true;
+
+            try {
+                _sortExecutor.loadingDone();
+            } catch (const AssertionException&) {
+                out->statusId = WorkingSetCommon::allocateStatusMember(_ws, exceptionToStatus());
+                return PlanStage::FAILURE;
+            }
+
+            return PlanStage::NEED_TIME;
+        } else if (code == PlanStage::ADVANCED) {
+            return PlanStage::NEED_TIME;
+        }
+
+        return code;
+    }
+
+    // The sort executor hands back owned members, so the whole batch may be held at once.
+    const size_t firstResult = out->ids.size();
+    while (out->ids.size() - firstResult < maxResults) {
+        auto nextWsm = _sortExecutor.getNext();
+        if (!nextWsm) {
+            break;
+        }
+        out->ids.push_back(_ws->emplace(std::move(*nextWsm)));
+    }
+
+    return out->ids.size() > firstResult ? PlanStage::ADVANCED : PlanStage::IS_EOF;
+}
+
 std::unique_ptr<PlanStageStats> SortStage::getStats() {
     _commonStats.isEOF = isEOF();
     std::unique_ptr<PlanStageStats> ret =
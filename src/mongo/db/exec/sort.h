@@ -65,6 +65,7 @@ public:
     }
 
     StageState doWork(WorkingSetID* out) final;
+    StageState doWorkBatch(size_t maxResults, WorkBatch* out) final;
 
     StageType stageType() const final {
         return STAGE_SORT;
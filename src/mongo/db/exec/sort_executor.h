@@ -177,6 +177,7 @@ private:
         if (_diskUseAllowed) {
             opts.extSortAllowed = true;
             opts.tempDir = _tempDir;
+            opts.parallelExtSort = sorter::useParallelExtSort();
         }
 
         return opts;
@@ -489,7 +489,8 @@ AbstractIndexAccessMethod::BulkBuilderImpl::BulkBuilderImpl(const IndexAccessMet
     : _sorter(Sorter::make(SortOptions()
                                .TempDir(storageGlobalParams.dbpath + "/_tmp")
                                .ExtSortAllowed()
-                               .MaxMemoryUsageBytes(maxMemoryUsageBytes),
+                               .MaxMemoryUsageBytes(maxMemoryUsageBytes)
+                               .ParallelExtSort(sorter::useParallelExtSort()),
                            BtreeExternalSortComparison(),
                            std::pair<KeyString::Value::SorterDeserializeSettings,
                                      mongo::NullValue::SorterDeserializeSettings>(
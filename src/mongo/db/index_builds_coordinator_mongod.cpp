@@ -184,6 +184,7 @@ IndexBuildsCoordinatorMongod::startIndexBuild(OperationContext* opCtx,
 
         auto opCtx = Client::getCurrent()->makeOperationContext();
         opCtx->setDeadlineByDate(deadline, timeoutError);
+        opCtx->setAdmissionPriority(AdmissionPriority::kBackground);
 
         {
             stdx::unique_lock<Client> lk(*opCtx->getClient());
@@ -59,7 +59,8 @@ bool ExprMatchExpression::matches(const MatchableDocument* doc, MatchDetails* de
     // 'Variables' object per-caller.
     Variables variables = _expCtx->variables;
     try {
-        auto value = _expression->evaluate(document, &variables);
+        auto value = _compiledExpression ? _compiledExpression->evaluate(document, &variables)
+                                         : _expression->evaluate(document, &variables);
         return value.coerceToBool();
     } catch (const DBException&) {
         if (MONGO_unlikely(ExprMatchExpressionMatchesReturnsFalseOnException.shouldFail())) {
@@ -108,6 +109,10 @@ std::unique_ptr<MatchExpression> ExprMatchExpression::shallowClone() const {
         Expression::parseOperand(_expCtx, bob.obj().firstElement(), _expCtx->variablesParseState);
 
     auto clone = std::make_unique<ExprMatchExpression>(std::move(clonedExpr), _expCtx);
+    if (_compiledExpression) {
+        // The clone was parsed from the optimized expression, so it needs no optimizing first.
+        clone->_compiledExpression = CompiledExpression::compile(clone->_expression);
+    }
     if (_rewriteResult) {
         clone->_rewriteResult = _rewriteResult->clone();
     }
@@ -127,6 +132,7 @@ MatchExpression::ExpressionOptimizerFunc ExprMatchExpression::getOptimizer() con
         }
 
         exprMatchExpr._expression = exprMatchExpr._expression->optimize();
+        exprMatchExpr._compiledExpression = CompiledExpression::compile(exprMatchExpr._expression);
         exprMatchExpr._rewriteResult =
             RewriteExpr::rewrite(exprMatchExpr._expression, exprMatchExpr._expCtx->getCollator());
 
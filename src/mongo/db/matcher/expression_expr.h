@@ -35,6 +35,7 @@
 #include "mongo/db/matcher/expression_tree.h"
 #include "mongo/db/matcher/rewrite_expr.h"
 #include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/expression_bytecode.h"
 #include "mongo/db/pipeline/expression_context.h"
 
 namespace mongo {
@@ -106,6 +107,9 @@ private:
 
     boost::intrusive_ptr<Expression> _expression;
 
+    // '_expression' lowered to bytecode once it has been optimized, if it compiles.
+    std::unique_ptr<CompiledExpression> _compiledExpression;
+
     boost::optional<RewriteExpr::RewriteResult> _rewriteResult;
 };
 
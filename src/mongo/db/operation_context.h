@@ -63,6 +63,23 @@ namespace repl {
 class UnreplicatedWritesBlock;
 }  // namespace repl
 
+/**
+ * The order in which operations queued for a ticket to run against the storage engine are admitted.
+ * Operations of a higher priority go first, though never so often that lower priority ones starve.
+ * See TicketHolder.
+ */
+enum class AdmissionPriority {
+    // Internal maintenance work whose latency nobody waits on, such as TTL deletes, index builds
+    // and range deletion.
+    kBackground,
+
+    // The default for every operation.
+    kNormal,
+
+    // Operations which should jump ahead of normal work when the storage engine is saturated.
+    kLatencySensitive,
+};
+
 /**
  * This class encompasses the state required by an operation and lives from the time a network
  * operation is dispatched until its execution is finished. Note that each "getmore" on a cursor
@@ -90,6 +107,14 @@ public:
         _shouldParticipateInFlowControl = target;
     }
 
+    AdmissionPriority getAdmissionPriority() const {
+        return _admissionPriority;
+    }
+
+    void setAdmissionPriority(AdmissionPriority priority) {
+        _admissionPriority = priority;
+    }
+
     /**
      * Interface for durability.  Caller DOES NOT own pointer.
      */
@@ -522,6 +547,7 @@ private:
 
     bool _writesAreReplicated = true;
     bool _shouldParticipateInFlowControl = true;
+    AdmissionPriority _admissionPriority = AdmissionPriority::kNormal;
     bool _inMultiDocumentTransaction = false;
     bool _isStartingMultiDocumentTransaction = false;
 
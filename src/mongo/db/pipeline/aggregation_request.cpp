@@ -177,6 +177,12 @@ StatusWith<AggregationRequest> AggregationRequest::parseFromBSON(
             } catch (const DBException& ex) {
                 return ex.toStatus();
             }
+            // The hash policy is only built by mongos for its own merging stages.
+            if (request.getExchangeSpec()->getPolicy() == ExchangePolicyEnum::kHash) {
+                return {ErrorCodes::BadValue,
+                        str::stream() << "The 'hash' policy of the '" << kExchangeName
+                                      << "' option is for internal use only"};
+            }
         } else if (bypassDocumentValidationCommandOption() == fieldName) {
             request.setBypassDocumentValidation(elem.trueValue());
         } else if (WriteConcernOptions::kWriteConcernField == fieldName) {
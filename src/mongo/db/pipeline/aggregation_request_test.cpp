@@ -482,6 +482,14 @@ TEST(AggregationRequestTest, ShouldRejectExchangeInvalidSpec) {
     ASSERT_NOT_OK(AggregationRequest::parseFromBSON(nss, inputBson).getStatus());
 }
 
+TEST(AggregationRequestTest, ShouldRejectExchangeHashPolicy) {
+    NamespaceString nss("a.collection");
+    const BSONObj inputBson = fromjson(
+        "{pipeline: [], cursor: {}, exchange: {policy: 'hash', consumers: NumberInt(2), key: {a: "
+        "1}}}");
+    ASSERT_EQ(AggregationRequest::parseFromBSON(nss, inputBson).getStatus(), ErrorCodes::BadValue);
+}
+
 TEST(AggregationRequestTest, ShouldRejectInvalidWriteConcern) {
     NamespaceString nss("a.collection");
     const BSONObj inputBson =
@@ -0,0 +1,643 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/column_cache.h"
+
+#include <algorithm>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/bson/json.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog_raii.h"
+#include "mongo/db/client.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/db/pipeline/column_cache_gen.h"
+#include "mongo/db/storage/record_store.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace {
+
+// How many records are scanned between interrupt and size checks while building a snapshot.
+constexpr size_t kBuildCheckInterval = 1024;
+
+}  // namespace
+
+ColumnVector::Encoding ColumnVector::_encodingFor(BSONType type) {
+    switch (type) {
+        case NumberInt:
+            return Encoding::kInt32;
+        case NumberLong:
+            return Encoding::kInt64;
+        case NumberDouble:
+            return Encoding::kDouble;
+        case Date:
+            return Encoding::kDate;
+        case Bool:
+            return Encoding::kBool;
+        case String:
+            return Encoding::kDictionary;
+        default:
+            return Encoding::kGeneric;
+    }
+}
+
+void ColumnVector::_setEncoding(Encoding encoding) {
+    invariant(_encoding == Encoding::kEmpty);
+    _encoding = encoding;
+
+    // Every row appended so far is missing, give each of them a placeholder.
+    switch (_encoding) {
+        case Encoding::kEmpty:
+            MONGO_UNREACHABLE;
+        case Encoding::kInt32:
+            _int32s.resize(_size);
+            break;
+        case Encoding::kInt64:
+        case Encoding::kDate:
+            _int64s.resize(_size);
+            break;
+        case Encoding::kDouble:
+            _doubles.resize(_size);
+            break;
+        case Encoding::kBool:
+            _bools.resize(_size);
+            break;
+        case Encoding::kDictionary:
+            _codes.resize(_size);
+            break;
+        case Encoding::kGeneric:
+            _values.resize(_size);
+            break;
+    }
+}
+
+void ColumnVector::_convertToGeneric() {
+    std::vector<Value> values;
+    values.reserve(_size + 1);
+    for (size_t row = 0; row < _size; ++row) {
+        values.push_back(at(row));
+    }
+
+    for (auto&& value : _dictionary) {
+        if (value.getType() == String) {
+            _variableBytes -= value.getStringData().size();
+        }
+    }
+    for (auto&& value : values) {
+        if (value.getType() == String) {
+            _variableBytes += value.getStringData().size();
+        }
+    }
+
+    _int32s = {};
+    _int64s = {};
+    _doubles = {};
+    _bools = {};
+    _codes = {};
+    _dictionary = {};
+    _dictionaryCodes = {};
+
+    _values = std::move(values);
+    _encoding = Encoding::kGeneric;
+}
+
+void ColumnVector::append(const BSONElement& elem) {
+    const auto encoding = _encodingFor(elem.type());
+    if (_encoding == Encoding::kEmpty) {
+        _setEncoding(encoding);
+    } else if (_encoding != encoding && _encoding != Encoding::kGeneric) {
+        _convertToGeneric();
+    }
+
+    switch (_encoding) {
+        case Encoding::kEmpty:
+            MONGO_UNREACHABLE;
+        case Encoding::kInt32:
+            _int32s.push_back(elem._numberInt());
+            break;
+        case Encoding::kInt64:
+            _int64s.push_back(elem._numberLong());
+            break;
+        case Encoding::kDate:
+            _int64s.push_back(elem.date().toMillisSinceEpoch());
+            break;
+        case Encoding::kDouble:
+            _doubles.push_back(elem._numberDouble());
+            break;
+        case Encoding::kBool:
+            _bools.push_back(elem.boolean());
+            break;
+        case Encoding::kDictionary: {
+            const auto str = elem.valueStringData();
+            auto it = _dictionaryCodes.find(str);
+            if (it == _dictionaryCodes.end()) {
+                if (_dictionary.size() < kMaxDictionarySize) {
+                    it = _dictionaryCodes.emplace(str.toString(), _dictionary.size()).first;
+                    _dictionary.push_back(Value(str));
+                    _variableBytes += str.size();
+                } else {
+                    _convertToGeneric();
+                    _values.push_back(Value(elem));
+                    _variableBytes += str.size();
+                    break;
+                }
+            }
+            _codes.push_back(it->second);
+            break;
+        }
+        case Encoding::kGeneric:
+            _values.push_back(Value(elem));
+            _variableBytes += elem.valuesize();
+            break;
+    }
+    ++_size;
+}
+
+void ColumnVector::appendMissing() {
+    switch (_encoding) {
+        case Encoding::kEmpty:
+            break;
+        case Encoding::kInt32:
+            _int32s.emplace_back();
+            break;
+        case Encoding::kInt64:
+        case Encoding::kDate:
+            _int64s.emplace_back();
+            break;
+        case Encoding::kDouble:
+            _doubles.emplace_back();
+            break;
+        case Encoding::kBool:
+            _bools.emplace_back();
+            break;
+        case Encoding::kDictionary:
+            _codes.emplace_back();
+            break;
+        case Encoding::kGeneric:
+            _values.emplace_back();
+            break;
+    }
+    ++_size;
+}
+
+void ColumnVector::finishBuilding() {
+    _dictionaryCodes = {};
+    _int32s.shrink_to_fit();
+    _int64s.shrink_to_fit();
+    _doubles.shrink_to_fit();
+    _bools.shrink_to_fit();
+    _codes.shrink_to_fit();
+    _dictionary.shrink_to_fit();
+    _values.shrink_to_fit();
+}
+
+Value ColumnVector::at(size_t row) const {
+    dassert(row < _size);
+    switch (_encoding) {
+        case Encoding::kEmpty:
+            return Value();
+        case Encoding::kInt32:
+            return Value(_int32s[row]);
+        case Encoding::kInt64:
+            return Value(static_cast<long long>(_int64s[row]));
+        case Encoding::kDate:
+            return Value(Date_t::fromMillisSinceEpoch(_int64s[row]));
+        case Encoding::kDouble:
+            return Value(_doubles[row]);
+        case Encoding::kBool:
+            return Value(static_cast<bool>(_bools[row]));
+        case Encoding::kDictionary:
+            return _dictionary[_codes[row]];
+        case Encoding::kGeneric:
+            return _values[row];
+    }
+    MONGO_UNREACHABLE;
+}
+
+size_t ColumnVector::approximateBytes() const {
+    return sizeof(*this) + _int32s.capacity() * sizeof(int32_t) +
+        _int64s.capacity() * sizeof(int64_t) + _doubles.capacity() * sizeof(double) +
+        _bools.capacity() / 8 + _codes.capacity() * sizeof(uint32_t) +
+        (_dictionary.capacity() + _values.capacity()) * sizeof(Value) + _variableBytes;
+}
+
+ColumnCacheSnapshot::ColumnCacheSnapshot(UUID uuid, std::vector<std::string> fieldNames)
+    : _uuid(std::move(uuid)), _fieldNames(std::move(fieldNames)), _columns(_fieldNames.size()) {}
+
+Document ColumnCacheSnapshot::getDocument(size_t record) const {
+    const auto& shape = _shapes[_shapeOfRecord[record]];
+    MutableDocument doc(shape.size());
+    for (auto field : shape) {
+        doc.addField(_fieldNames[field], _columns[field].at(record));
+    }
+    return doc.freeze();
+}
+
+size_t ColumnCacheSnapshot::approximateBytes() const {
+    size_t bytes = sizeof(*this) + _shapeOfRecord.capacity() * sizeof(uint32_t);
+    for (auto&& column : _columns) {
+        bytes += column.approximateBytes();
+    }
+    for (auto&& shape : _shapes) {
+        bytes += sizeof(shape) + shape.capacity();
+    }
+    return bytes;
+}
+
+ColumnCacheSnapshot::Builder::Builder(UUID uuid, std::vector<std::string> fieldNames)
+    : _snapshot(new ColumnCacheSnapshot(std::move(uuid), std::move(fieldNames))) {
+    invariant(_snapshot->_fieldNames.size() <= ColumnCache::kMaxFieldsPerCollection);
+    for (size_t i = 0; i < _snapshot->_fieldNames.size(); ++i) {
+        _fieldIndexes.emplace(_snapshot->_fieldNames[i], i);
+    }
+}
+
+void ColumnCacheSnapshot::Builder::append(const BSONObj& record) {
+    const size_t numFields = _snapshot->_fieldNames.size();
+    uint64_t seen = 0;
+
+    _shape.clear();
+    for (auto&& elem : record) {
+        auto it = _fieldIndexes.find(elem.fieldNameStringData());
+        if (it == _fieldIndexes.end()) {
+            continue;
+        }
+
+        const uint64_t bit = uint64_t{1} << it->second;
+        if (seen & bit) {
+            continue;
+        }
+        seen |= bit;
+
+        _snapshot->_columns[it->second].append(elem);
+        _shape.push_back(it->second);
+        if (_shape.size() == numFields) {
+            break;
+        }
+    }
+
+    for (size_t i = 0; i < numFields; ++i) {
+        if (!(seen & (uint64_t{1} << i))) {
+            _snapshot->_columns[i].appendMissing();
+        }
+    }
+
+    // Consecutive records nearly always share their shape, so check the previous one first.
+    auto& shapeOfRecord = _snapshot->_shapeOfRecord;
+    if (!shapeOfRecord.empty() && _snapshot->_shapes[shapeOfRecord.back()] == _shape) {
+        shapeOfRecord.push_back(shapeOfRecord.back());
+        return;
+    }
+
+    auto [it, inserted] = _shapeCodes.emplace(_shape, _snapshot->_shapes.size());
+    if (inserted) {
+        _snapshot->_shapes.push_back(_shape);
+    }
+    shapeOfRecord.push_back(it->second);
+}
+
+size_t ColumnCacheSnapshot::Builder::approximateBytes() const {
+    return _snapshot->approximateBytes();
+}
+
+std::shared_ptr<const ColumnCacheSnapshot> ColumnCacheSnapshot::Builder::done() {
+    for (auto&& column : _snapshot->_columns) {
+        column.finishBuilding();
+    }
+    _snapshot->_shapeOfRecord.shrink_to_fit();
+    return std::shared_ptr<const ColumnCacheSnapshot>(_snapshot.release());
+}
+
+ColumnCache& ColumnCache::get() {
+    static ColumnCache cache;
+    return cache;
+}
+
+StatusWith<std::map<NamespaceString, std::vector<std::string>>> ColumnCache::parseConfiguration(
+    const BSONObj& config) {
+    std::map<NamespaceString, std::vector<std::string>> parsed;
+    for (auto&& collElem : config) {
+        NamespaceString nss(collElem.fieldNameStringData());
+        if (!nss.isValid() || nss.coll().empty()) {
+            return {ErrorCodes::InvalidNamespace,
+                    str::stream() << "Invalid namespace in column cache configuration: "
+                                  << collElem.fieldNameStringData()};
+        }
+        if (nss.isSystem() || nss.isOplog()) {
+            return {ErrorCodes::InvalidNamespace,
+                    str::stream() << "Cannot cache the columns of " << nss};
+        }
+        if (collElem.type() != Array) {
+            return {ErrorCodes::TypeMismatch,
+                    str::stream() << "Cached fields of " << nss << " must be an array"};
+        }
+
+        std::vector<std::string> fields;
+        for (auto&& fieldElem : collElem.Obj()) {
+            if (fieldElem.type() != String) {
+                return {ErrorCodes::TypeMismatch,
+                        str::stream() << "Cached field names of " << nss << " must be strings"};
+            }
+            auto field = fieldElem.valueStringData();
+            if (field.empty() || field[0] == '$' || field.find('.') != std::string::npos) {
+                return {ErrorCodes::BadValue,
+                        str::stream() << "Cached field '" << field << "' of " << nss
+                                      << " must be a non-empty top-level field name"};
+            }
+            if (std::find(fields.begin(), fields.end(), field) != fields.end()) {
+                return {ErrorCodes::BadValue,
+                        str::stream() << "Field '" << field << "' of " << nss
+                                      << " is listed more than once"};
+            }
+            fields.push_back(field.toString());
+        }
+
+        if (fields.empty() || fields.size() > kMaxFieldsPerCollection) {
+            return {ErrorCodes::BadValue,
+                    str::stream() << "Between 1 and " << kMaxFieldsPerCollection
+                                  << " fields of " << nss << " can be cached"};
+        }
+        if (!parsed.emplace(nss, std::move(fields)).second) {
+            return {ErrorCodes::BadValue,
+                    str::stream() << nss << " is listed more than once"};
+        }
+    }
+    return parsed;
+}
+
+void ColumnCache::setConfiguration(std::map<NamespaceString, std::vector<std::string>> config) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    for (auto it = _entries.begin(); it != _entries.end();) {
+        auto newFields = config.find(it->first);
+        if (newFields == config.end()) {
+            it = _entries.erase(it);
+            continue;
+        }
+        if (newFields->second != it->second.fields) {
+            it->second.fields = std::move(newFields->second);
+            _invalidate(lk, &it->second);
+        }
+        config.erase(newFields);
+        ++it;
+    }
+
+    for (auto&& [nss, fields] : config) {
+        auto& entry = _entries[nss];
+        entry.fields = std::move(fields);
+        entry.generation = ++_lastGeneration;
+    }
+    _hasEntries.store(!_entries.empty());
+}
+
+BSONObj ColumnCache::getConfiguration() const {
+    BSONObjBuilder builder;
+    stdx::lock_guard<Latch> lk(_mutex);
+    for (auto&& [nss, entry] : _entries) {
+        builder.append(nss.ns(), entry.fields);
+    }
+    return builder.obj();
+}
+
+std::vector<std::string> ColumnCache::getFields(const NamespaceString& nss) const {
+    if (!_hasEntries.load()) {
+        return {};
+    }
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    auto it = _entries.find(nss);
+    return it == _entries.end() ? std::vector<std::string>{} : it->second.fields;
+}
+
+std::shared_ptr<const ColumnCacheSnapshot> ColumnCache::getSnapshot(
+    const Collection* collection) {
+    if (!_hasEntries.load()) {
+        return nullptr;
+    }
+
+    const auto& nss = collection->ns();
+    std::vector<std::string> fields;
+    uint64_t generation;
+    ThreadPool* buildPool;
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        auto it = _entries.find(nss);
+        if (it == _entries.end()) {
+            return nullptr;
+        }
+
+        auto& entry = it->second;
+        if (entry.snapshot && entry.snapshot->uuid() == collection->uuid()) {
+            return entry.snapshot;
+        }
+        if (entry.tooLargeAtGeneration == entry.generation || entry.buildInProgress) {
+            return nullptr;
+        }
+
+        if (!_buildPool) {
+            ThreadPool::Options options;
+            options.poolName = "ColumnCacheBuilder";
+            options.minThreads = 0;
+            options.maxThreads = 1;
+            options.onCreateThread = [](const std::string& threadName) {
+                Client::initThread(threadName.c_str());
+            };
+            _buildPool = std::make_unique<ThreadPool>(std::move(options));
+            _buildPool->startup();
+        }
+
+        entry.buildInProgress = true;
+        fields = entry.fields;
+        generation = entry.generation;
+        buildPool = _buildPool.get();
+    }
+
+    // The build opens its storage snapshot after the generation was read, so it sees at least every
+    // write the generation accounts for.
+    buildPool->schedule([ this, nss, fields = std::move(fields), generation ](auto status) mutable {
+        if (!status.isOK()) {
+            stdx::lock_guard<Latch> lk(_mutex);
+            auto it = _entries.find(nss);
+            if (it != _entries.end()) {
+                it->second.buildInProgress = false;
+            }
+            return;
+        }
+        _build(nss, std::move(fields), generation);
+    });
+    return nullptr;
+}
+
+void ColumnCache::waitForBuilds() {
+    ThreadPool* buildPool;
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        buildPool = _buildPool.get();
+    }
+    if (buildPool) {
+        buildPool->waitForIdle();
+    }
+}
+
+void ColumnCache::_build(const NamespaceString& nss,
+                         std::vector<std::string> fields,
+                         uint64_t generation) {
+    auto opCtx = cc().makeOperationContext();
+    std::shared_ptr<const ColumnCacheSnapshot> snapshot;
+    bool tooLarge = false;
+    try {
+        AutoGetCollection autoColl(opCtx.get(), nss, MODE_IS);
+        if (auto collection = autoColl.getCollection()) {
+            const size_t maxBytes =
+                static_cast<size_t>(gColumnCacheMaxSizeMB.load()) * 1024 * 1024;
+            ColumnCacheSnapshot::Builder builder(collection->uuid(), std::move(fields));
+            auto cursor = collection->getCursor(opCtx.get());
+            size_t numRecords = 0;
+            while (auto record = cursor->next()) {
+                builder.append(record->data.toBson());
+                if (++numRecords % kBuildCheckInterval == 0) {
+                    opCtx->checkForInterrupt();
+                    if (builder.approximateBytes() > maxBytes) {
+                        tooLarge = true;
+                        break;
+                    }
+                }
+            }
+            tooLarge = tooLarge || builder.approximateBytes() > maxBytes;
+            if (!tooLarge) {
+                snapshot = builder.done();
+            }
+        }
+    } catch (const DBException& ex) {
+        LOG(1) << "Failed to build the column cache snapshot of " << nss << causedBy(ex);
+    }
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    auto it = _entries.find(nss);
+    if (it == _entries.end()) {
+        return;
+    }
+    auto& entry = it->second;
+    entry.buildInProgress = false;
+
+    // The collection changed while we were scanning it, the next aggregation over it schedules
+    // another build.
+    if (entry.generation != generation) {
+        return;
+    }
+
+    if (tooLarge) {
+        LOG(1) << "Not caching the columns of " << nss << ", they exceed "
+               << gColumnCacheMaxSizeMB.load() << "MB";
+        entry.tooLargeAtGeneration = generation;
+        return;
+    }
+    if (snapshot) {
+        LOG(1) << "Cached " << snapshot->fieldNames().size() << " columns of " << nss << " ("
+               << snapshot->numRecords() << " records, " << snapshot->approximateBytes()
+               << " bytes)";
+        entry.snapshot = std::move(snapshot);
+    }
+}
+
+void ColumnCache::_invalidate(WithLock, Entry* entry) {
+    entry->generation = ++_lastGeneration;
+    entry->snapshot.reset();
+    entry->tooLargeAtGeneration = boost::none;
+}
+
+bool ColumnCache::invalidate(const NamespaceString& nss) {
+    if (!_hasEntries.load()) {
+        return false;
+    }
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    auto it = _entries.find(nss);
+    if (it == _entries.end()) {
+        return false;
+    }
+    _invalidate(lk, &it->second);
+    return true;
+}
+
+void ColumnCache::invalidateDatabase(StringData dbName) {
+    if (!_hasEntries.load()) {
+        return;
+    }
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    for (auto&& [nss, entry] : _entries) {
+        if (nss.db() == dbName) {
+            _invalidate(lk, &entry);
+        }
+    }
+}
+
+void ColumnCache::invalidateAll() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    for (auto&& [nss, entry] : _entries) {
+        _invalidate(lk, &entry);
+    }
+}
+
+void ColumnCacheCollectionsServerParameter::append(OperationContext*,
+                                                   BSONObjBuilder& builder,
+                                                   const std::string& name) {
+    builder.append(name, ColumnCache::get().getConfiguration());
+}
+
+Status ColumnCacheCollectionsServerParameter::set(const BSONElement& newValueElement) {
+    if (newValueElement.type() != Object) {
+        return {ErrorCodes::TypeMismatch,
+                str::stream() << "columnCacheCollections must be an object, not "
+                              << typeName(newValueElement.type())};
+    }
+
+    auto config = ColumnCache::parseConfiguration(newValueElement.Obj());
+    if (!config.isOK()) {
+        return config.getStatus();
+    }
+    ColumnCache::get().setConfiguration(std::move(config.getValue()));
+    return Status::OK();
+}
+
+Status ColumnCacheCollectionsServerParameter::setFromString(const std::string& str) try {
+    BSONObj obj = fromjson(str);
+    return set(BSON("" << obj).firstElement());
+} catch (const DBException& ex) {
+    return ex.toStatus();
+}
+
+}  // namespace mongo
@@ -0,0 +1,283 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/status_with.h"
+#include "mongo/bson/bsonelement.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/exec/document_value/document.h"
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/namespace_string.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/string_map.h"
+#include "mongo/util/uuid.h"
+
+namespace mongo {
+
+class Collection;
+class OperationContext;
+
+/**
+ * The values of one top-level field across the records of a collection, in RecordId order.
+ *
+ * A column starts out in the narrowest typed encoding that holds the first value appended to it
+ * and falls back to a vector of Values once a value of a different type shows up. Strings are
+ * dictionary encoded for as long as the number of distinct strings stays below
+ * 'kMaxDictionarySize'. Rows in which the field is missing hold an unspecified placeholder; the
+ * owning ColumnCacheSnapshot knows which fields each record has.
+ */
+class ColumnVector {
+public:
+    enum class Encoding { kEmpty, kInt32, kInt64, kDouble, kDate, kBool, kDictionary, kGeneric };
+
+    static constexpr size_t kMaxDictionarySize = 1 << 16;
+
+    void append(const BSONElement& elem);
+    void appendMissing();
+
+    /**
+     * Releases the memory only needed while appending. No more values may be appended afterwards.
+     */
+    void finishBuilding();
+
+    /**
+     * Returns the value in row 'row'. The result is unspecified for a row appended with
+     * appendMissing().
+     */
+    Value at(size_t row) const;
+
+    Encoding encoding() const {
+        return _encoding;
+    }
+
+    size_t size() const {
+        return _size;
+    }
+
+    size_t approximateBytes() const;
+
+private:
+    static Encoding _encodingFor(BSONType type);
+
+    void _setEncoding(Encoding encoding);
+    void _convertToGeneric();
+
+    Encoding _encoding = Encoding::kEmpty;
+    size_t _size = 0;
+
+    std::vector<int32_t> _int32s;
+    // Holds both kInt64 and kDate columns, dates as milliseconds since the epoch.
+    std::vector<int64_t> _int64s;
+    std::vector<double> _doubles;
+    std::vector<bool> _bools;
+
+    // kDictionary columns store an index into '_dictionary' per row. '_dictionaryCodes' maps each
+    // distinct string back to its index while the column is being built.
+    std::vector<uint32_t> _codes;
+    std::vector<Value> _dictionary;
+    StringMap<uint32_t> _dictionaryCodes;
+
+    std::vector<Value> _values;
+
+    // Bytes held outside of the vectors above, such as string and subdocument contents.
+    size_t _variableBytes = 0;
+};
+
+/**
+ * An immutable copy of the cached fields of every record in a collection, as of a single point in
+ * time.
+ */
+class ColumnCacheSnapshot {
+public:
+    class Builder {
+    public:
+        Builder(UUID uuid, std::vector<std::string> fieldNames);
+
+        /**
+         * Appends the cached fields of 'record'. If a field appears more than once only the first
+         * occurrence is kept, as Document::getField() would.
+         */
+        void append(const BSONObj& record);
+
+        size_t approximateBytes() const;
+
+        std::shared_ptr<const ColumnCacheSnapshot> done();
+
+    private:
+        std::unique_ptr<ColumnCacheSnapshot> _snapshot;
+        StringMap<uint8_t> _fieldIndexes;
+        std::map<std::vector<uint8_t>, uint32_t> _shapeCodes;
+        std::vector<uint8_t> _shape;
+    };
+
+    const UUID& uuid() const {
+        return _uuid;
+    }
+
+    const std::vector<std::string>& fieldNames() const {
+        return _fieldNames;
+    }
+
+    size_t numRecords() const {
+        return _shapeOfRecord.size();
+    }
+
+    /**
+     * Returns a document holding the cached fields of record 'record', in the order in which they
+     * appear in the original record.
+     */
+    Document getDocument(size_t record) const;
+
+    const ColumnVector& getColumn(size_t field) const {
+        return _columns[field];
+    }
+
+    size_t approximateBytes() const;
+
+private:
+    ColumnCacheSnapshot(UUID uuid, std::vector<std::string> fieldNames);
+
+    UUID _uuid;
+    std::vector<std::string> _fieldNames;
+    std::vector<ColumnVector> _columns;
+
+    // Each distinct sequence of cached fields found in the records, as indexes into '_fieldNames',
+    // and for every record the index of its sequence in '_shapes'. Most collections have a single
+    // shape, so this costs little more than a missing-value bitmap while also preserving the
+    // original field order.
+    std::vector<std::vector<uint8_t>> _shapes;
+    std::vector<uint32_t> _shapeOfRecord;
+};
+
+/**
+ * Process-wide cache of selected fields of selected collections, configured through the
+ * 'columnCacheCollections' server parameter. Snapshots are dropped by ColumnCacheOpObserver
+ * whenever the collection is written to, so a cached snapshot always reflects the latest committed
+ * state of its collection. The first aggregation to find the snapshot missing schedules a rebuild
+ * on a background thread and reads the collection itself in the meantime.
+ */
+class ColumnCache {
+    ColumnCache(const ColumnCache&) = delete;
+    ColumnCache& operator=(const ColumnCache&) = delete;
+
+public:
+    static constexpr size_t kMaxFieldsPerCollection = 64;
+
+    ColumnCache() = default;
+
+    static ColumnCache& get();
+
+    /**
+     * Parses and validates a configuration of the form {"<db>.<coll>": [<field>, ...], ...}.
+     */
+    static StatusWith<std::map<NamespaceString, std::vector<std::string>>> parseConfiguration(
+        const BSONObj& config);
+
+    /**
+     * Replaces the set of cached collections. Cached snapshots of collections whose fields did not
+     * change are kept.
+     */
+    void setConfiguration(std::map<NamespaceString, std::vector<std::string>> config);
+    BSONObj getConfiguration() const;
+
+    /**
+     * Returns the fields cached for 'nss', or an empty vector if 'nss' is not cached.
+     */
+    std::vector<std::string> getFields(const NamespaceString& nss) const;
+
+    /**
+     * Returns a snapshot of the cached fields of 'collection' that includes every write committed
+     * before the call. Returns nullptr if the collection isn't configured, if its columns would
+     * exceed 'columnCacheMaxSizeMB', or if no up to date snapshot is cached. In the last case a
+     * build of the snapshot is scheduled, unless one is already in progress.
+     */
+    std::shared_ptr<const ColumnCacheSnapshot> getSnapshot(const Collection* collection);
+
+    /**
+     * Blocks until no snapshot builds are scheduled or running. For testing.
+     */
+    void waitForBuilds();
+
+    /**
+     * Drops the snapshot of 'nss' and prevents snapshots whose build is in progress from being
+     * cached. Returns false, without taking the cache mutex, if 'nss' is not configured.
+     */
+    bool invalidate(const NamespaceString& nss);
+    void invalidateDatabase(StringData dbName);
+    void invalidateAll();
+
+private:
+    struct Entry {
+        std::vector<std::string> fields;
+
+        // Changes on every invalidation, a snapshot is only cached if the entry still has the
+        // generation observed before its build started.
+        uint64_t generation = 0;
+        std::shared_ptr<const ColumnCacheSnapshot> snapshot;
+
+        // Set when a build at this generation exceeded the size limit, to avoid rescanning the
+        // collection until it changes.
+        boost::optional<uint64_t> tooLargeAtGeneration;
+
+        // Whether a build of the snapshot is scheduled or running.
+        bool buildInProgress = false;
+    };
+
+    void _invalidate(WithLock, Entry* entry);
+
+    /**
+     * Scans 'nss' in a new operation and caches the resulting snapshot if the entry of 'nss' is
+     * still at 'generation'. Runs on '_buildPool'.
+     */
+    void _build(const NamespaceString& nss, std::vector<std::string> fields, uint64_t generation);
+
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("ColumnCache::_mutex");
+    std::map<NamespaceString, Entry> _entries;
+    uint64_t _lastGeneration = 0;
+
+    // Lets the write path skip the mutex entirely while nothing is configured.
+    AtomicWord<bool> _hasEntries{false};
+
+    // Builds snapshots one at a time, off the path of the aggregations that need them. Started by
+    // the first build.
+    std::unique_ptr<ThreadPool> _buildPool;
+};
+
+}  // namespace mongo
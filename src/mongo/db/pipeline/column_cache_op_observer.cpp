@@ -0,0 +1,122 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/column_cache_op_observer.h"
+
+#include "mongo/db/operation_context.h"
+#include "mongo/db/pipeline/column_cache.h"
+
+namespace mongo {
+namespace {
+
+void invalidateOnWrite(OperationContext* opCtx, const NamespaceString& nss) {
+    if (!ColumnCache::get().invalidate(nss)) {
+        return;
+    }
+
+    opCtx->recoveryUnit()->onCommit(
+        [nss](boost::optional<Timestamp>) { ColumnCache::get().invalidate(nss); });
+}
+
+}  // namespace
+
+ColumnCacheOpObserver::ColumnCacheOpObserver() = default;
+
+ColumnCacheOpObserver::~ColumnCacheOpObserver() = default;
+
+void ColumnCacheOpObserver::onInserts(OperationContext* opCtx,
+                                      const NamespaceString& nss,
+                                      OptionalCollectionUUID uuid,
+                                      std::vector<InsertStatement>::const_iterator begin,
+                                      std::vector<InsertStatement>::const_iterator end,
+                                      bool fromMigrate) {
+    invalidateOnWrite(opCtx, nss);
+}
+
+void ColumnCacheOpObserver::onUpdate(OperationContext* opCtx, const OplogUpdateEntryArgs& args) {
+    invalidateOnWrite(opCtx, args.nss);
+}
+
+void ColumnCacheOpObserver::onDelete(OperationContext* opCtx,
+                                     const NamespaceString& nss,
+                                     OptionalCollectionUUID uuid,
+                                     StmtId stmtId,
+                                     bool fromMigrate,
+                                     const boost::optional<BSONObj>& deletedDoc) {
+    invalidateOnWrite(opCtx, nss);
+}
+
+void ColumnCacheOpObserver::onDropDatabase(OperationContext* opCtx, const std::string& dbName) {
+    ColumnCache::get().invalidateDatabase(dbName);
+}
+
+repl::OpTime ColumnCacheOpObserver::onDropCollection(OperationContext* opCtx,
+                                                     const NamespaceString& collectionName,
+                                                     OptionalCollectionUUID uuid,
+                                                     std::uint64_t numRecords,
+                                                     const CollectionDropType dropType) {
+    ColumnCache::get().invalidate(collectionName);
+    return {};
+}
+
+void ColumnCacheOpObserver::onRenameCollection(OperationContext* opCtx,
+                                               const NamespaceString& fromCollection,
+                                               const NamespaceString& toCollection,
+                                               OptionalCollectionUUID uuid,
+                                               OptionalCollectionUUID dropTargetUUID,
+                                               std::uint64_t numRecords,
+                                               bool stayTemp) {
+    ColumnCache::get().invalidate(fromCollection);
+    ColumnCache::get().invalidate(toCollection);
+}
+
+void ColumnCacheOpObserver::postRenameCollection(OperationContext* opCtx,
+                                                 const NamespaceString& fromCollection,
+                                                 const NamespaceString& toCollection,
+                                                 OptionalCollectionUUID uuid,
+                                                 OptionalCollectionUUID dropTargetUUID,
+                                                 bool stayTemp) {
+    ColumnCache::get().invalidate(fromCollection);
+    ColumnCache::get().invalidate(toCollection);
+}
+
+void ColumnCacheOpObserver::onEmptyCapped(OperationContext* opCtx,
+                                          const NamespaceString& collectionName,
+                                          OptionalCollectionUUID uuid) {
+    ColumnCache::get().invalidate(collectionName);
+}
+
+void ColumnCacheOpObserver::onReplicationRollback(OperationContext* opCtx,
+                                                  const RollbackObserverInfo& rbInfo) {
+    ColumnCache::get().invalidateAll();
+}
+
+}  // namespace mongo
@@ -0,0 +1,253 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bsonmisc.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/exec/document_value/document_value_test_util.h"
+#include "mongo/db/pipeline/aggregation_context_fixture.h"
+#include "mongo/db/pipeline/column_cache.h"
+#include "mongo/db/pipeline/document_source_column_cache_scan.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+using Encoding = ColumnVector::Encoding;
+
+ColumnVector makeColumn(const std::vector<BSONObj>& values) {
+    ColumnVector column;
+    for (auto&& value : values) {
+        if (value.isEmpty()) {
+            column.appendMissing();
+        } else {
+            column.append(value.firstElement());
+        }
+    }
+    column.finishBuilding();
+    return column;
+}
+
+TEST(ColumnVectorTest, UsesTypedEncodingForUniformTypes) {
+    ASSERT(makeColumn({BSON("" << 1), BSON("" << 2)}).encoding() == Encoding::kInt32);
+    ASSERT(makeColumn({BSON("" << 1LL), BSON("" << 2LL)}).encoding() == Encoding::kInt64);
+    ASSERT(makeColumn({BSON("" << 1.5), BSON("" << 2.5)}).encoding() == Encoding::kDouble);
+    ASSERT(makeColumn({BSON("" << true), BSON("" << false)}).encoding() == Encoding::kBool);
+    ASSERT(makeColumn({BSON("" << Date_t::fromMillisSinceEpoch(1))}).encoding() ==
+           Encoding::kDate);
+    ASSERT(makeColumn({BSON("" << "a"), BSON("" << "b")}).encoding() == Encoding::kDictionary);
+    ASSERT(makeColumn({BSON("" << BSON("a" << 1))}).encoding() == Encoding::kGeneric);
+    ASSERT(makeColumn({BSONObj(), BSONObj()}).encoding() == Encoding::kEmpty);
+}
+
+TEST(ColumnVectorTest, ReturnsValuesOfTheirOriginalType) {
+    auto date = Date_t::fromMillisSinceEpoch(1234567);
+    ASSERT_VALUE_EQ(makeColumn({BSON("" << 7)}).at(0), Value(7));
+    ASSERT_EQ(makeColumn({BSON("" << 7)}).at(0).getType(), NumberInt);
+    ASSERT_EQ(makeColumn({BSON("" << 7LL)}).at(0).getType(), NumberLong);
+    ASSERT_VALUE_EQ(makeColumn({BSON("" << 2.5)}).at(0), Value(2.5));
+    ASSERT_VALUE_EQ(makeColumn({BSON("" << true)}).at(0), Value(true));
+    ASSERT_VALUE_EQ(makeColumn({BSON("" << date)}).at(0), Value(date));
+    ASSERT_VALUE_EQ(makeColumn({BSON("" << "str")}).at(0), Value("str"_sd));
+}
+
+TEST(ColumnVectorTest, MissingValuesBeforeTheFirstValueKeepRowsAligned) {
+    auto column = makeColumn({BSONObj(), BSONObj(), BSON("" << 3), BSONObj(), BSON("" << 5)});
+    ASSERT(column.encoding() == Encoding::kInt32);
+    ASSERT_EQ(column.size(), 5U);
+    ASSERT_VALUE_EQ(column.at(2), Value(3));
+    ASSERT_VALUE_EQ(column.at(4), Value(5));
+}
+
+TEST(ColumnVectorTest, MixedTypesFallBackToGeneric) {
+    auto column = makeColumn({BSON("" << 1), BSONObj(), BSON("" << "a"), BSON("" << 2LL)});
+    ASSERT(column.encoding() == Encoding::kGeneric);
+    ASSERT_EQ(column.at(0).getType(), NumberInt);
+    ASSERT_VALUE_EQ(column.at(0), Value(1));
+    ASSERT_VALUE_EQ(column.at(2), Value("a"_sd));
+    ASSERT_EQ(column.at(3).getType(), NumberLong);
+}
+
+TEST(ColumnVectorTest, DictionaryEncodesRepeatedStrings) {
+    ColumnVector column;
+    for (int i = 0; i < 1000; ++i) {
+        column.append(BSON("" << (i % 2 ? "odd" : "even")).firstElement());
+    }
+    column.finishBuilding();
+    ASSERT(column.encoding() == Encoding::kDictionary);
+    ASSERT_VALUE_EQ(column.at(0), Value("even"_sd));
+    ASSERT_VALUE_EQ(column.at(999), Value("odd"_sd));
+    ASSERT_LT(column.approximateBytes(), 1000 * sizeof(Value));
+}
+
+TEST(ColumnVectorTest, DictionaryFallsBackToGenericPastItsMaximumSize) {
+    ColumnVector column;
+    const size_t numValues = ColumnVector::kMaxDictionarySize + 1;
+    for (size_t i = 0; i < numValues; ++i) {
+        column.append(BSON("" << std::to_string(i)).firstElement());
+    }
+    column.finishBuilding();
+    ASSERT(column.encoding() == Encoding::kGeneric);
+    ASSERT_EQ(column.size(), numValues);
+    ASSERT_VALUE_EQ(column.at(0), Value("0"_sd));
+    ASSERT_VALUE_EQ(column.at(numValues - 1), Value(std::to_string(numValues - 1)));
+}
+
+std::shared_ptr<const ColumnCacheSnapshot> makeSnapshot(std::vector<std::string> fields,
+                                                        const std::vector<BSONObj>& records) {
+    ColumnCacheSnapshot::Builder builder(UUID::gen(), std::move(fields));
+    for (auto&& record : records) {
+        builder.append(record);
+    }
+    return builder.done();
+}
+
+TEST(ColumnCacheSnapshotTest, KeepsOnlyCachedFieldsInTheirOriginalOrder) {
+    auto snapshot = makeSnapshot({"a", "b"},
+                                 {BSON("_id" << 0 << "a" << 1 << "c" << 2 << "b" << 3),
+                                  BSON("b" << 4 << "a" << 5),
+                                  BSON("_id" << 2 << "b" << "x"),
+                                  BSON("_id" << 3)});
+    ASSERT_EQ(snapshot->numRecords(), 4U);
+    ASSERT_DOCUMENT_EQ(snapshot->getDocument(0), (Document{{"a", 1}, {"b", 3}}));
+    ASSERT_DOCUMENT_EQ(snapshot->getDocument(1), (Document{{"b", 4}, {"a", 5}}));
+    ASSERT_DOCUMENT_EQ(snapshot->getDocument(2), (Document{{"b", "x"_sd}}));
+    ASSERT_DOCUMENT_EQ(snapshot->getDocument(3), Document());
+}
+
+TEST(ColumnCacheSnapshotTest, KeepsFirstOccurrenceOfDuplicateFields) {
+    auto snapshot = makeSnapshot({"a"}, {BSON("a" << 1 << "a" << 2)});
+    ASSERT_DOCUMENT_EQ(snapshot->getDocument(0), (Document{{"a", 1}}));
+}
+
+TEST(ColumnCacheSnapshotTest, CachesWholeSubdocumentsAndArrays) {
+    auto snapshot = makeSnapshot({"a"}, {BSON("a" << BSON("b" << 1 << "c" << BSON_ARRAY(1 << 2)))});
+    ASSERT_DOCUMENT_EQ(snapshot->getDocument(0),
+                       (Document{{"a", Document{{"b", 1}, {"c", Value{BSON_ARRAY(1 << 2)}}}}}));
+}
+
+TEST(ColumnCacheTest, ParseConfigurationAcceptsValidConfiguration) {
+    auto config = ColumnCache::parseConfiguration(
+        BSON("test.a" << BSON_ARRAY("x"
+                                    << "y")
+                      << "test.b" << BSON_ARRAY("_id")));
+    ASSERT_OK(config.getStatus());
+    ASSERT_EQ(config.getValue().size(), 2U);
+    ASSERT_EQ(config.getValue().at(NamespaceString("test.a")).size(), 2U);
+}
+
+TEST(ColumnCacheTest, ParseConfigurationRejectsInvalidConfigurations) {
+    ASSERT_NOT_OK(ColumnCache::parseConfiguration(BSON("test" << BSON_ARRAY("x"))).getStatus());
+    ASSERT_NOT_OK(
+        ColumnCache::parseConfiguration(BSON("local.oplog.rs" << BSON_ARRAY("x"))).getStatus());
+    ASSERT_NOT_OK(ColumnCache::parseConfiguration(BSON("test.a"
+                                                       << "x"))
+                      .getStatus());
+    ASSERT_NOT_OK(ColumnCache::parseConfiguration(BSON("test.a" << BSONArray())).getStatus());
+    ASSERT_NOT_OK(ColumnCache::parseConfiguration(BSON("test.a" << BSON_ARRAY(1))).getStatus());
+    ASSERT_NOT_OK(
+        ColumnCache::parseConfiguration(BSON("test.a" << BSON_ARRAY("x.y"))).getStatus());
+    ASSERT_NOT_OK(
+        ColumnCache::parseConfiguration(BSON("test.a" << BSON_ARRAY("$x"))).getStatus());
+    ASSERT_NOT_OK(ColumnCache::parseConfiguration(BSON("test.a" << BSON_ARRAY("x"
+                                                                               << "x")))
+                      .getStatus());
+
+    BSONArrayBuilder tooManyFields;
+    for (size_t i = 0; i <= ColumnCache::kMaxFieldsPerCollection; ++i) {
+        tooManyFields.append("f" + std::to_string(i));
+    }
+    ASSERT_NOT_OK(
+        ColumnCache::parseConfiguration(BSON("test.a" << tooManyFields.arr())).getStatus());
+}
+
+TEST(ColumnCacheTest, OnlyConfiguredCollectionsAreInvalidated) {
+    ColumnCache cache;
+    NamespaceString cached("test.cached");
+    NamespaceString other("test.other");
+    ASSERT_FALSE(cache.invalidate(cached));
+
+    cache.setConfiguration({{cached, {"a", "b"}}});
+    ASSERT_TRUE(cache.invalidate(cached));
+    ASSERT_FALSE(cache.invalidate(other));
+    ASSERT_EQ(cache.getFields(cached).size(), 2U);
+    ASSERT(cache.getFields(other).empty());
+    ASSERT_BSONOBJ_EQ(cache.getConfiguration(),
+                      BSON("test.cached" << BSON_ARRAY("a"
+                                                       << "b")));
+
+    cache.setConfiguration({});
+    ASSERT_FALSE(cache.invalidate(cached));
+    ASSERT(cache.getFields(cached).empty());
+}
+
+using DocumentSourceColumnCacheScanTest = AggregationContextFixture;
+
+TEST_F(DocumentSourceColumnCacheScanTest, ReturnsEveryRecordInOrder) {
+    auto snapshot = makeSnapshot({"a"}, {BSON("a" << 1), BSON("b" << 2), BSON("a" << 3)});
+    auto scan = DocumentSourceColumnCacheScan::create(getExpCtx(), snapshot, false);
+
+    auto next = scan->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(), (Document{{"a", 1}}));
+    next = scan->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(), Document());
+    next = scan->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(), (Document{{"a", 3}}));
+    ASSERT_TRUE(scan->getNext().isEOF());
+    ASSERT_TRUE(scan->getNext().isEOF());
+}
+
+TEST_F(DocumentSourceColumnCacheScanTest, CanProduceEmptyDocuments) {
+    auto snapshot = makeSnapshot({"a"}, {BSON("a" << 1), BSON("a" << 2)});
+    auto scan = DocumentSourceColumnCacheScan::create(getExpCtx(), snapshot, true);
+
+    for (int i = 0; i < 2; ++i) {
+        auto next = scan->getNext();
+        ASSERT_TRUE(next.isAdvanced());
+        ASSERT_DOCUMENT_EQ(next.releaseDocument(), Document());
+    }
+    ASSERT_TRUE(scan->getNext().isEOF());
+}
+
+TEST_F(DocumentSourceColumnCacheScanTest, SerializesCachedFieldsAndRecordCount) {
+    auto snapshot = makeSnapshot({"a", "b"}, {BSON("a" << 1), BSON("a" << 2)});
+    auto scan = DocumentSourceColumnCacheScan::create(getExpCtx(), snapshot, false);
+    ASSERT_VALUE_EQ(
+        scan->serialize(ExplainOptions::Verbosity::kQueryPlanner),
+        Value(DOC("$columnCacheScan" << DOC("fields" << DOC_ARRAY("a"_sd
+                                                                    << "b"_sd)
+                                                     << "nRecords" << 2LL))));
+}
+
+}  // namespace
+}  // namespace mongo
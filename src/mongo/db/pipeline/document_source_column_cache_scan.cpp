@@ -0,0 +1,84 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_source_column_cache_scan.h"
+
+#include "mongo/db/exec/document_value/document.h"
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/pipeline/expression_context.h"
+
+namespace mongo {
+using boost::intrusive_ptr;
+
+DocumentSourceColumnCacheScan::DocumentSourceColumnCacheScan(
+    const intrusive_ptr<ExpressionContext>& expCtx,
+    std::shared_ptr<const ColumnCacheSnapshot> snapshot,
+    bool shouldProduceEmptyDocs)
+    : DocumentSource(kStageName, expCtx),
+      _snapshot(std::move(snapshot)),
+      _shouldProduceEmptyDocs(shouldProduceEmptyDocs) {}
+
+const char* DocumentSourceColumnCacheScan::getSourceName() const {
+    return kStageName.rawData();
+}
+
+DocumentSource::GetNextResult DocumentSourceColumnCacheScan::doGetNext() {
+    if (_nextRecord == _snapshot->numRecords()) {
+        return GetNextResult::makeEOF();
+    }
+
+    pExpCtx->checkForInterrupt();
+
+    const auto record = _nextRecord++;
+    return _shouldProduceEmptyDocs ? Document() : _snapshot->getDocument(record);
+}
+
+Value DocumentSourceColumnCacheScan::serialize(
+    boost::optional<ExplainOptions::Verbosity> explain) const {
+    std::vector<Value> fields;
+    for (auto&& field : _snapshot->fieldNames()) {
+        fields.emplace_back(field);
+    }
+    return Value(DOC(getSourceName() << DOC("fields" << fields << "nRecords"
+                                                     << static_cast<long long>(
+                                                            _snapshot->numRecords()))));
+}
+
+intrusive_ptr<DocumentSourceColumnCacheScan> DocumentSourceColumnCacheScan::create(
+    const intrusive_ptr<ExpressionContext>& expCtx,
+    std::shared_ptr<const ColumnCacheSnapshot> snapshot,
+    bool shouldProduceEmptyDocs) {
+    intrusive_ptr<DocumentSourceColumnCacheScan> source(
+        new DocumentSourceColumnCacheScan(expCtx, std::move(snapshot), shouldProduceEmptyDocs));
+    return source;
+}
+
+}  // namespace mongo
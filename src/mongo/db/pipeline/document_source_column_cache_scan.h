@@ -0,0 +1,90 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+
+#include "mongo/db/pipeline/column_cache.h"
+#include "mongo/db/pipeline/document_source.h"
+
+namespace mongo {
+
+/**
+ * This class is not a registered stage. It replaces the $cursor stage of a pipeline that only
+ * depends on fields held in the ColumnCache, producing documents made of the cached fields of each
+ * record, in RecordId order.
+ */
+class DocumentSourceColumnCacheScan final : public DocumentSource {
+public:
+    static constexpr StringData kStageName = "$columnCacheScan"_sd;
+
+    const char* getSourceName() const final;
+    Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
+
+    StageConstraints constraints(Pipeline::SplitState pipeState) const final {
+        StageConstraints constraints(StreamType::kStreaming,
+                                     PositionRequirement::kFirst,
+                                     HostTypeRequirement::kAnyShard,
+                                     DiskUseRequirement::kNoDiskUse,
+                                     FacetRequirement::kNotAllowed,
+                                     TransactionRequirement::kAllowed,
+                                     LookupRequirement::kAllowed);
+
+        constraints.requiresInputDocSource = false;
+        return constraints;
+    }
+
+    boost::optional<DistributedPlanLogic> distributedPlanLogic() final {
+        return boost::none;
+    }
+
+    /**
+     * Creates a stage that returns the records of 'snapshot'. If 'shouldProduceEmptyDocs' is true,
+     * as when the rest of the pipeline depends on no fields at all, it returns one empty document
+     * per record instead.
+     */
+    static boost::intrusive_ptr<DocumentSourceColumnCacheScan> create(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx,
+        std::shared_ptr<const ColumnCacheSnapshot> snapshot,
+        bool shouldProduceEmptyDocs);
+
+private:
+    DocumentSourceColumnCacheScan(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                  std::shared_ptr<const ColumnCacheSnapshot> snapshot,
+                                  bool shouldProduceEmptyDocs);
+
+    GetNextResult doGetNext() final;
+
+    std::shared_ptr<const ColumnCacheSnapshot> _snapshot;
+    const bool _shouldProduceEmptyDocs;
+    size_t _nextRecord = 0;
+};
+
+}  // namespace mongo
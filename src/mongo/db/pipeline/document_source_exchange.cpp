@@ -86,6 +86,7 @@ public:
 
 constexpr size_t Exchange::kMaxBufferSize;
 constexpr size_t Exchange::kMaxNumberConsumers;
+constexpr size_t Exchange::kProducerBatchSize;
 
 const char* DocumentSourceExchange::getSourceName() const {
     return kStageName.rawData();
@@ -109,7 +110,9 @@ DocumentSource::GetNextResult DocumentSourceExchange::doGetNext() {
     return _exchange->getNext(pExpCtx->opCtx, _consumerId, _resourceYielder.get());
 }
 
-Exchange::Exchange(ExchangeSpec spec, std::unique_ptr<Pipeline, PipelineDeleter> pipeline)
+Exchange::Exchange(ExchangeSpec spec,
+                   std::unique_ptr<Pipeline, PipelineDeleter> pipeline,
+                   LoadingPolicy loadingPolicy)
     : _spec(std::move(spec)),
       _keyPattern(_spec.getKey().getOwned()),
       _ordering(extractOrdering(_keyPattern)),
@@ -119,7 +122,9 @@ Exchange::Exchange(ExchangeSpec spec, std::unique_ptr<Pipeline, PipelineDeleter>
       _policy(_spec.getPolicy()),
       _orderPreserving(_spec.getOrderPreserving()),
       _maxBufferSize(_spec.getBufferSize()),
-      _pipeline(std::move(pipeline)) {
+      _pipeline(std::move(pipeline)),
+      _valueComparator(_pipeline->getContext()->getValueComparator()),
+      _loadingPolicy(loadingPolicy) {
     uassert(50901, "Exchange must have at least one consumer", _spec.getConsumers() > 0);
 
     uassert(50951,
@@ -142,6 +147,16 @@ Exchange::Exchange(ExchangeSpec spec, std::unique_ptr<Pipeline, PipelineDeleter>
         uassert(50899, "Exchange boundaries must not be specified.", _boundaries.empty());
     }
 
+    if (_policy == ExchangePolicyEnum::kHash) {
+        uassert(4840012,
+                str::stream() << "The key pattern " << _keyPattern << " must have at least one key",
+                !_keyPaths.empty());
+    }
+
+    // A producer hands every document to exactly one consumer.
+    invariant(_loadingPolicy == LoadingPolicy::kConsumers ||
+              _policy != ExchangePolicyEnum::kBroadcast);
+
     // We will manually detach and reattach when iterating '_pipeline', we expect it to start in the
     // detached state.
     _pipeline->detachFromOperationContext();
@@ -300,8 +315,9 @@ DocumentSource::GetNextResult Exchange::getNext(OperationContext* opCtx,
             return doc;
         }
 
-        // There is not any document so try to load more from the source.
-        if (_loadingThreadId == kInvalidThreadId) {
+        // There is not any document so try to load more from the source, unless that is left to
+        // the producer.
+        if (_loadingPolicy == LoadingPolicy::kConsumers && _loadingThreadId == kInvalidThreadId) {
             LOG(3) << "A consumer " << consumerId << " begins loading";
 
             try {
@@ -339,10 +355,14 @@ DocumentSource::GetNextResult Exchange::getNext(OperationContext* opCtx,
                 throw;
             }
         } else {
-            // Some other consumer is already loading the buffers. There is nothing else we can do
-            // but wait.
+            // Some other consumer (or the producer) is already loading the buffers. There is
+            // nothing else we can do but wait, for as long as the operation is not interrupted.
             MutexAndResourceLock mutexAndResourceLock(opCtx, std::move(lk), resourceYielder);
-            _haveBufferSpace.wait(mutexAndResourceLock);
+            opCtx->waitForConditionOrInterrupt(_haveBufferSpace, mutexAndResourceLock, [&] {
+                return !_errorInLoadNextBatch.isOK() || !_consumers[consumerId]->isEmpty() ||
+                    (_loadingPolicy == LoadingPolicy::kConsumers &&
+                     _loadingThreadId == kInvalidThreadId);
+            });
             lk = mutexAndResourceLock.releaseLockOwnership();
         }
     }
@@ -375,7 +395,8 @@ size_t Exchange::loadNextBatch() {
                 if (_consumers[target]->appendDocument(std::move(input), _maxBufferSize))
                     return target;
             } break;
-            case ExchangePolicyEnum::kKeyRange: {
+            case ExchangePolicyEnum::kKeyRange:
+            case ExchangePolicyEnum::kHash: {
                 size_t target = getTargetConsumer(input.getDocument());
                 bool full = _consumers[target]->appendDocument(std::move(input), _maxBufferSize);
                 if (full && _orderPreserving) {
@@ -399,7 +420,81 @@ size_t Exchange::loadNextBatch() {
     return kInvalidThreadId;
 }
 
+bool Exchange::produceNextBatch(OperationContext* opCtx) {
+    invariant(_loadingPolicy == LoadingPolicy::kProducer);
+
+    // Read the input without holding the mutex. Only this thread ever touches the input and the
+    // round robin counter, so the targets can be computed here as well.
+    std::vector<std::pair<size_t, DocumentSource::GetNextResult>> batch;
+    batch.reserve(kProducerBatchSize);
+    bool exhausted = false;
+    try {
+        _pipeline->reattachToOperationContext(opCtx);
+        while (batch.size() < kProducerBatchSize) {
+            auto input = _pipeline->getSources().back()->getNext();
+            if (!input.isAdvanced()) {
+                invariant(input.isEOF());
+                exhausted = true;
+                break;
+            }
+
+            size_t target;
+            if (_policy == ExchangePolicyEnum::kRoundRobin) {
+                target = _roundRobinCounter;
+                _roundRobinCounter = (_roundRobinCounter + 1) % _consumers.size();
+            } else {
+                target = getTargetConsumer(input.getDocument());
+            }
+            batch.emplace_back(target, std::move(input));
+        }
+        _pipeline->detachFromOperationContext();
+    } catch (const DBException& ex) {
+        abort(ex.toStatus());
+        throw;
+    }
+
+    stdx::unique_lock<Latch> lk(_mutex);
+    for (auto&& [target, input] : batch) {
+        if (_loadingThreadId != kInvalidThreadId) {
+            // Let the consumers see what we have appended so far before waiting for the consumer
+            // with the full buffer to make room.
+            _haveBufferSpace.notify_all();
+            opCtx->waitForConditionOrInterrupt(_haveBufferSpace, lk, [&] {
+                return _loadingThreadId == kInvalidThreadId || !_errorInLoadNextBatch.isOK();
+            });
+        }
+        uassertStatusOK(_errorInLoadNextBatch);
+
+        if (_consumers[target]->appendDocument(std::move(input), _maxBufferSize)) {
+            _loadingThreadId = target;
+        }
+    }
+
+    if (exhausted) {
+        for (auto& c : _consumers) {
+            c->appendDocument(DocumentSource::GetNextResult::makeEOF(), _maxBufferSize);
+        }
+    }
+    _haveBufferSpace.notify_all();
+
+    return !exhausted;
+}
+
+void Exchange::abort(Status reason) {
+    invariant(!reason.isOK());
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (_errorInLoadNextBatch.isOK()) {
+        _errorInLoadNextBatch = std::move(reason);
+    }
+    _haveBufferSpace.notify_all();
+}
+
 size_t Exchange::getTargetConsumer(const Document& input) {
+    if (_policy == ExchangePolicyEnum::kHash) {
+        return getHashTargetConsumer(input);
+    }
+
     // Build the key.
     BSONObjBuilder kb;
     size_t counter = 0;
@@ -437,6 +532,22 @@ size_t Exchange::getTargetConsumer(const Document& input) {
     return cid;
 }
 
+size_t Exchange::getHashTargetConsumer(const Document& input) const {
+    size_t seed = 0;
+    for (const auto& path : _keyPaths) {
+        auto value = input.getNestedField(path);
+
+        // Unlike the range policy we must not single out documents with missing fields: $group
+        // puts them in the same group as null, so they have to reach the same consumer.
+        boost::hash_combine(seed, _valueComparator.hash(value.missing() ? Value(BSONNULL) : value));
+    }
+
+    size_t cid = _consumerIds[seed % _consumerIds.size()];
+    invariant(cid < _consumers.size());
+
+    return cid;
+}
+
 void Exchange::dispose(OperationContext* opCtx, size_t consumerId) {
     stdx::lock_guard<Latch> lk(_mutex);
 
@@ -445,8 +556,9 @@ void Exchange::dispose(OperationContext* opCtx, size_t consumerId) {
     ++_disposeRunDown;
 
     // If _errorInLoadNextBatch status is not OK then an exception was thrown. In that case the
-    // throwing thread will do the dispose.
-    if (!_errorInLoadNextBatch.isOK()) {
+    // throwing thread will do the dispose. A producer never disposes of the input itself, so then
+    // it is always left to the last consumer.
+    if (!_errorInLoadNextBatch.isOK() && _loadingPolicy == LoadingPolicy::kConsumers) {
         if (_loadingThreadId == consumerId) {
             _pipeline->dispose(opCtx);
         }
@@ -33,6 +33,7 @@
 #include <vector>
 
 #include "mongo/bson/ordering.h"
+#include "mongo/db/exec/document_value/value_comparator.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/exchange_spec_gen.h"
 #include "mongo/db/pipeline/field_path.h"
@@ -46,6 +47,9 @@ class Exchange : public RefCountable {
     static constexpr size_t kMaxBufferSize = 100 * 1024 * 1024;  // 100 MB
     static constexpr size_t kMaxNumberConsumers = 100;
 
+    // The number of documents a producer reads from the input before handing them out.
+    static constexpr size_t kProducerBatchSize = 256;
+
     /**
      * Convert the BSON representation of boundaries (as deserialized off the wire) to the internal
      * format (KeyString).
@@ -71,11 +75,22 @@ class Exchange : public RefCountable {
     static std::vector<FieldPath> extractKeyPaths(const BSONObj& keyPattern);
 
 public:
+    /**
+     * Who fills the consumer buffers. With kConsumers whichever consumer runs out of documents
+     * first loads the next batch from the input on its own thread. With kProducer the consumers
+     * only ever wait for documents, and a single thread drives the input by calling
+     * produceNextBatch(). The latter keeps all work on the input (e.g. remote cursors) on the
+     * thread which owns it.
+     */
+    enum class LoadingPolicy { kConsumers, kProducer };
+
     /**
      * Create an exchange. 'pipeline' represents the input to the exchange operator and must not be
      * nullptr.
      **/
-    Exchange(ExchangeSpec spec, std::unique_ptr<Pipeline, PipelineDeleter> pipeline);
+    Exchange(ExchangeSpec spec,
+             std::unique_ptr<Pipeline, PipelineDeleter> pipeline,
+             LoadingPolicy loadingPolicy = LoadingPolicy::kConsumers);
 
     /**
      * Interface for retrieving the next document. 'resourceYielder' is optional, and if provided,
@@ -93,8 +108,30 @@ public:
         return _spec;
     }
 
+    /**
+     * Returns the pipeline which feeds the exchange.
+     */
+    Pipeline* getInputPipeline() const {
+        return _pipeline.get();
+    }
+
     void dispose(OperationContext* opCtx, size_t consumerId);
 
+    /**
+     * Reads the next batch of documents from the input and hands them out to the consumers. The
+     * input is read without holding the mutex so that the consumers can drain their buffers in the
+     * meantime; appending to a full buffer waits until its consumer makes room. Returns false once
+     * the input is exhausted and every consumer has been sent EOF. May only be called on an
+     * exchange created with LoadingPolicy::kProducer.
+     */
+    bool produceNextBatch(OperationContext* opCtx);
+
+    /**
+     * Fails the exchange with 'reason'. Consumers waiting for documents wake up and throw, and so
+     * does the producer. Only the first reason is kept.
+     */
+    void abort(Status reason);
+
     /**
      * Unblocks the loading thread (a producer) if the loading is blocked by a consumer identified
      * by consumerId. Note that there is no such thing as being blocked by multiple consumers. It is
@@ -109,6 +146,8 @@ private:
 
     size_t getTargetConsumer(const Document& input);
 
+    size_t getHashTargetConsumer(const Document& input) const;
+
     class ExchangeBuffer {
     public:
         bool appendDocument(DocumentSource::GetNextResult input, size_t limit);
@@ -169,15 +208,22 @@ private:
     // An input to the exchange operator
     std::unique_ptr<Pipeline, PipelineDeleter> _pipeline;
 
+    // Used by the hash policy, so that keys which compare equal under the input's collation are
+    // sent to the same consumer.
+    const ValueComparator _valueComparator;
+
+    const LoadingPolicy _loadingPolicy;
+
     // Synchronization.
     Mutex _mutex = MONGO_MAKE_LATCH("Exchange::_mutex");
     stdx::condition_variable _haveBufferSpace;
 
-    // A thread that is currently loading the exchange buffers.
+    // A thread that is currently loading the exchange buffers. When the loading is blocked this is
+    // the consumer whose buffer is full, and with LoadingPolicy::kProducer it is only ever that.
     size_t _loadingThreadId{kInvalidThreadId};
 
-    // A status indicating that the exception was thrown during loadNextBatch(). Once in the failed
-    // state all other producing threads will fail too.
+    // A status indicating that the exception was thrown during loadNextBatch() or that the exchange
+    // was aborted. Once in the failed state all other producing threads will fail too.
     Status _errorInLoadNextBatch{Status::OK()};
 
     size_t _roundRobinCounter{0};
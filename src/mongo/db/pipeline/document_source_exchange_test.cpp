@@ -640,6 +640,177 @@ TEST_F(DocumentSourceExchangeTest, RangeRandomHashExchangeNConsumer) {
     ASSERT_EQ(nDocs, processedDocs.load());
 }
 
+TEST_F(DocumentSourceExchangeTest, HashExchangeNConsumer) {
+    const size_t nKeys = 50;
+    const size_t nConsumers = 4;
+
+    auto source = DocumentSourceMock::createForTest();
+    for (size_t i = 0; i < 10 * nKeys; ++i) {
+        source->emplace_back(Document{{"a", static_cast<int>(i % nKeys)}});
+    }
+    // A missing key must go where null goes, since $group treats them alike.
+    for (size_t i = 0; i < 10; ++i) {
+        source->emplace_back(i % 2 ? Document{{"a", BSONNULL}} : Document{{"b", 1}});
+    }
+    const size_t nDocs = 10 * nKeys + 10;
+
+    ExchangeSpec spec;
+    spec.setPolicy(ExchangePolicyEnum::kHash);
+    spec.setKey(BSON("a" << 1));
+    spec.setConsumers(nConsumers);
+    spec.setBufferSize(1024);
+
+    boost::intrusive_ptr<Exchange> ex =
+        new Exchange(std::move(spec), unittest::assertGet(Pipeline::create({source}, getExpCtx())));
+
+    std::vector<ThreadInfo> threads = createNProducers(nConsumers, ex);
+    std::vector<executor::TaskExecutor::CallbackHandle> handles;
+    std::vector<std::vector<Value>> keysSeen(nConsumers);
+
+    for (size_t id = 0; id < nConsumers; ++id) {
+        auto docSourceExchange = threads[id].documentSourceExchange.get();
+        auto keys = &keysSeen[id];
+        auto handle = _executor->scheduleWork(
+            [docSourceExchange, keys](const executor::TaskExecutor::CallbackArgs& cb) {
+                auto input = docSourceExchange->getNext();
+                for (; input.isAdvanced(); input = docSourceExchange->getNext()) {
+                    auto key = input.getDocument()["a"];
+                    keys->push_back(key.missing() ? Value(BSONNULL) : key);
+                }
+            });
+
+        handles.emplace_back(std::move(handle.getValue()));
+    }
+
+    for (auto& h : handles)
+        _executor->wait(h);
+
+    size_t processedDocs = 0;
+    std::map<int, size_t> consumerForKey;
+    for (size_t id = 0; id < nConsumers; ++id) {
+        processedDocs += keysSeen[id].size();
+        for (auto&& key : keysSeen[id]) {
+            const int k = key.nullish() ? -1 : key.getInt();
+            auto inserted = consumerForKey.emplace(k, id);
+            ASSERT_EQ(inserted.first->second, id);
+        }
+    }
+    ASSERT_EQ(processedDocs, nDocs);
+    ASSERT_EQ(consumerForKey.size(), nKeys + 1);
+}
+
+TEST_F(DocumentSourceExchangeTest, ProducerDrivenExchangeNConsumer) {
+    const size_t nDocs = 5000;
+    auto source = getMockSource(nDocs);
+
+    const size_t nConsumers = 5;
+
+    ExchangeSpec spec;
+    spec.setPolicy(ExchangePolicyEnum::kRoundRobin);
+    spec.setConsumers(nConsumers);
+    spec.setBufferSize(1024);
+
+    boost::intrusive_ptr<Exchange> ex =
+        new Exchange(std::move(spec),
+                     unittest::assertGet(Pipeline::create({source}, getExpCtx())),
+                     Exchange::LoadingPolicy::kProducer);
+
+    std::vector<ThreadInfo> threads = createNProducers(nConsumers, ex);
+    std::vector<executor::TaskExecutor::CallbackHandle> handles;
+    AtomicWord<size_t> processedDocs{0};
+
+    for (size_t id = 0; id < nConsumers; ++id) {
+        auto docSourceExchange = threads[id].documentSourceExchange.get();
+        auto handle = _executor->scheduleWork(
+            [docSourceExchange, nDocs, nConsumers, &processedDocs](
+                const executor::TaskExecutor::CallbackArgs& cb) {
+                auto input = docSourceExchange->getNext();
+
+                size_t docs = 0;
+                for (; input.isAdvanced(); input = docSourceExchange->getNext()) {
+                    ++docs;
+                }
+                ASSERT_EQ(docs, nDocs / nConsumers);
+                processedDocs.fetchAndAdd(docs);
+            });
+
+        handles.emplace_back(std::move(handle.getValue()));
+    }
+
+    // The buffers are much smaller than the input, so the producer has to wait for the consumers
+    // along the way.
+    while (ex->produceNextBatch(getExpCtx()->opCtx)) {
+    }
+
+    for (auto& h : handles)
+        _executor->wait(h);
+
+    ASSERT_EQ(nDocs, processedDocs.load());
+}
+
+TEST_F(DocumentSourceExchangeTest, AbortWakesUpWaitingConsumers) {
+    ExchangeSpec spec;
+    spec.setPolicy(ExchangePolicyEnum::kRoundRobin);
+    spec.setConsumers(2);
+
+    boost::intrusive_ptr<Exchange> ex =
+        new Exchange(std::move(spec),
+                     unittest::assertGet(Pipeline::create({getMockSource(10)}, getExpCtx())),
+                     Exchange::LoadingPolicy::kProducer);
+
+    std::vector<ThreadInfo> threads = createNProducers(2, ex);
+    std::vector<executor::TaskExecutor::CallbackHandle> handles;
+
+    for (size_t id = 0; id < 2; ++id) {
+        auto docSourceExchange = threads[id].documentSourceExchange.get();
+        auto handle = _executor->scheduleWork(
+            [docSourceExchange](const executor::TaskExecutor::CallbackArgs& cb) {
+                // Nothing has been produced, so this waits until the exchange is aborted.
+                ASSERT_THROWS_CODE(docSourceExchange->getNext(),
+                                   AssertionException,
+                                   ErrorCodes::ExchangePassthrough);
+            });
+
+        handles.emplace_back(std::move(handle.getValue()));
+    }
+
+    ex->abort({ErrorCodes::InternalError, "consumer failed"});
+
+    for (auto& h : handles)
+        _executor->wait(h);
+
+    ASSERT_THROWS_CODE(
+        ex->produceNextBatch(getExpCtx()->opCtx), AssertionException, ErrorCodes::InternalError);
+}
+
+TEST_F(DocumentSourceExchangeTest, KillingAWaitingConsumerInterruptsIt) {
+    ExchangeSpec spec;
+    spec.setPolicy(ExchangePolicyEnum::kRoundRobin);
+    spec.setConsumers(2);
+
+    boost::intrusive_ptr<Exchange> ex =
+        new Exchange(std::move(spec),
+                     unittest::assertGet(Pipeline::create({getMockSource(10)}, getExpCtx())),
+                     Exchange::LoadingPolicy::kProducer);
+
+    std::vector<ThreadInfo> threads = createNProducers(2, ex);
+    auto* opCtx = threads[0].opCtx.get();
+    auto docSourceExchange = threads[0].documentSourceExchange.get();
+    auto handle = _executor->scheduleWork(
+        [docSourceExchange](const executor::TaskExecutor::CallbackArgs& cb) {
+            // Nothing is ever produced, so only the kill ends the wait.
+            ASSERT_THROWS_CODE(
+                docSourceExchange->getNext(), AssertionException, ErrorCodes::Interrupted);
+        });
+
+    {
+        stdx::lock_guard<Client> clientLock(*opCtx->getClient());
+        getServiceContext()->killOperation(clientLock, opCtx, ErrorCodes::Interrupted);
+    }
+
+    _executor->wait(handle.getValue());
+}
+
 TEST_F(DocumentSourceExchangeTest, RejectNoConsumers) {
     BSONObj spec = BSON("policy"
                         << "broadcast"
@@ -740,6 +911,16 @@ TEST_F(DocumentSourceExchangeTest, RejectInvalidBoundariesAndConsumerIds) {
         50900);
 }
 
+TEST_F(DocumentSourceExchangeTest, RejectHashWithoutKey) {
+    BSONObj spec = BSON("policy"
+                        << "hash"
+                        << "consumers" << 2);
+    ASSERT_THROWS_CODE(
+        Exchange(parseSpec(spec), unittest::assertGet(Pipeline::create({}, getExpCtx()))),
+        AssertionException,
+        4840012);
+}
+
 TEST_F(DocumentSourceExchangeTest, RejectInvalidPolicyBoundaries) {
     BSONObj spec = BSON("policy"
                         << "roundrobin"
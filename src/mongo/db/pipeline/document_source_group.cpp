@@ -29,7 +29,7 @@
 
 #include "mongo/platform/basic.h"
 
-#include <boost/filesystem/operations.hpp>
+#include <cstdlib>
 #include <memory>
 
 #include "mongo/db/exec/document_value/document.h"
@@ -41,6 +41,7 @@
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/pipeline/lite_parsed_document_source.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/util/destructor_guard.h"
 
 namespace mongo {
@@ -61,6 +62,14 @@ std::string nextFileName() {
     return "extsort-doc-group." + std::to_string(documentSourceGroupFileCounter.fetchAndAdd(1));
 }
 
+// The number of times a hash partition which doesn't fit in memory may be split again. A partition
+// which still doesn't fit at this depth fails the aggregation rather than exceed the memory limit.
+const int kMaxHashSpillDepth = 4;
+
+// How far the memory usage of a copy of a $group made by clone() may drift from what it has added
+// to the usage shared with the other copies.
+const long long kSharedMemoryUsageReportBytes = 16 * 1024;
+
 }  // namespace
 
 using boost::intrusive_ptr;
@@ -144,7 +153,9 @@ DocumentSource::GetNextResult DocumentSourceGroup::doGetNext() {
         accum->reset();  // Prep accumulators for a new group.
     }
 
-    if (_spilled) {
+    if (_hashSpilled) {
+        return getNextHashSpilled();
+    } else if (_spilled) {
         return getNextSpilled();
     } else {
         return getNextStandard();
@@ -161,7 +172,7 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextSpilled() {
     while (pExpCtx->getValueComparator().evaluate(_currentId == _firstPartOfNextGroup.first)) {
         // Inside of this loop, _firstPartOfNextGroup is the current data being processed.
         // At loop exit, it is the first value to be processed in the next group.
-        switch (numAccumulators) {  // mirrors switch in spill()
+        switch (numAccumulators) {  // mirrors switch in serializeAccumulators()
             case 1:                 // Single accumulators serialize as a single Value.
                 _currentAccumulators[0]->process(_firstPartOfNextGroup.second, true);
             case 0:  // No accumulators so no Values.
@@ -185,6 +196,20 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextSpilled() {
     return makeDocument(_currentId, _currentAccumulators, pExpCtx->needsMerge);
 }
 
+DocumentSource::GetNextResult DocumentSourceGroup::getNextHashSpilled() {
+    // We aren't streaming, and we have spilled to hash partitions. Output each partition in turn.
+    while (groupsIterator == _groups->end()) {
+        if (!loadNextHashPartition()) {
+            dispose();
+            return GetNextResult::makeEOF();
+        }
+    }
+
+    Document out = makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->needsMerge);
+    ++groupsIterator;
+    return std::move(out);
+}
+
 DocumentSource::GetNextResult DocumentSourceGroup::getNextStandard() {
     // Not spilled, and not streaming.
     if (_groups->empty())
@@ -202,6 +227,8 @@ void DocumentSourceGroup::doDispose() {
     // Free our resources.
     _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
     _sorterIterator.reset();
+    _hashPartitionsBeingWritten.clear();
+    _pendingHashPartitions.clear();
 
     // Make us look done.
     groupsIterator = _groups->end();
@@ -332,6 +359,7 @@ DocumentSourceGroup::DocumentSourceGroup(const intrusive_ptr<ExpressionContext>&
       _initialized(false),
       _groups(pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>()),
       _spilled(false),
+      _numHashSpillPartitions(internalDocumentSourceGroupHashSpillPartitions.load()),
       _allowDiskUse(pExpCtx->allowDiskUse && !pExpCtx->inMongos) {
     if (!pExpCtx->inMongos && (pExpCtx->allowDiskUse || kDebugBuild)) {
         // We spill to disk in debug mode, regardless of allowDiskUse, to stress the system.
@@ -341,7 +369,7 @@ DocumentSourceGroup::DocumentSourceGroup(const intrusive_ptr<ExpressionContext>&
 
 DocumentSourceGroup::~DocumentSourceGroup() {
     if (_ownsFileDeletion) {
-        DESTRUCTOR_GUARD(boost::filesystem::remove(_fileName));
+        DESTRUCTOR_GUARD(sorter::removeSpillFile(_fileName));
     }
 }
 
@@ -430,6 +458,38 @@ intrusive_ptr<DocumentSource> DocumentSourceGroup::createFromBson(
     return pGroup;
 }
 
+intrusive_ptr<DocumentSourceGroup> DocumentSourceGroup::clone(
+    const intrusive_ptr<ExpressionContext>& expCtx,
+    size_t maxMemoryUsageBytes,
+    std::shared_ptr<AtomicWord<long long>> sharedMemoryUsageBytes) const {
+    // Round-trip through the serialized form so that every expression is re-parsed against the
+    // new ExpressionContext.
+    const auto spec = serialize().getDocument().toBson();
+    intrusive_ptr<DocumentSourceGroup> copy(
+        static_cast<DocumentSourceGroup*>(createFromBson(spec.firstElement(), expCtx).get()));
+    copy->_maxMemoryUsageBytes = maxMemoryUsageBytes;
+    copy->_sharedMemoryUsageBytes = std::move(sharedMemoryUsageBytes);
+    return copy;
+}
+
+bool DocumentSourceGroup::exceededMemoryLimit() {
+    if (!_sharedMemoryUsageBytes) {
+        return _memoryUsageBytes > _maxMemoryUsageBytes;
+    }
+
+    // Only touch the shared counter once the memory usage has moved by a fair amount, so that the
+    // copies running side by side don't all contend on it for every document.
+    const auto delta = static_cast<long long>(_memoryUsageBytes) -
+        static_cast<long long>(_sharedMemoryUsageBytesReported);
+    if (std::abs(delta) < kSharedMemoryUsageReportBytes &&
+        _memoryUsageBytes <= _maxMemoryUsageBytes) {
+        return false;
+    }
+    _sharedMemoryUsageBytesReported = _memoryUsageBytes;
+    return static_cast<size_t>(_sharedMemoryUsageBytes->addAndFetch(delta)) >
+        _maxMemoryUsageBytes;
+}
+
 namespace {
 
 using GroupsMap = DocumentSourceGroup::GroupsMap;
@@ -467,12 +527,16 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
     // Barring any pausing, this loop exhausts 'pSource' and populates '_groups'.
     GetNextResult input = pSource->getNext();
     for (; input.isAdvanced(); input = pSource->getNext()) {
-        if (_memoryUsageBytes > _maxMemoryUsageBytes) {
+        if (exceededMemoryLimit()) {
             uassert(16945,
                     "Exceeded memory limit for $group, but didn't allow external sort."
                     " Pass allowDiskUse:true to opt in.",
                     _allowDiskUse);
-            _sortedFiles.push_back(spill());
+            if (_numHashSpillPartitions > 0) {
+                spillToHashPartitions(0);
+            } else {
+                _sortedFiles.push_back(spill());
+            }
             _memoryUsageBytes = 0;
         }
 
@@ -481,27 +545,8 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
         auto rootDocument = input.releaseDocument();
         Value id = computeId(rootDocument);
 
-        // Look for the _id value in the map. If it's not there, add a new entry with a blank
-        // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
-        // looking it up in '_groups' multiple times.
-        const size_t oldSize = _groups->size();
-        vector<intrusive_ptr<Accumulator>>& group = (*_groups)[id];
-        const bool inserted = _groups->size() != oldSize;
-
-        if (inserted) {
-            _memoryUsageBytes += id.getApproximateSize();
-
-            // Add the accumulators
-            group.reserve(numAccumulators);
-            for (auto&& accumulatedField : _accumulatedFields) {
-                group.push_back(accumulatedField.makeAccumulator());
-            }
-        } else {
-            for (auto&& groupObj : group) {
-                // subtract old mem usage. New usage added back after processing.
-                _memoryUsageBytes -= groupObj->memUsageForSorter();
-            }
-        }
+        bool inserted;
+        Accumulators& group = lookupGroupForUpdate(id, &inserted);
 
         /* tickle all the accumulators for the group we found */
         dassert(numAccumulators == group.size());
@@ -535,7 +580,21 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
         }
         case DocumentSource::GetNextResult::ReturnStatus::kEOF: {
             // Do any final steps necessary to prepare to output results.
-            if (!_sortedFiles.empty()) {
+            if (!_hashPartitionsBeingWritten.empty()) {
+                // Spill whatever is left so that every partition is complete on disk, then output
+                // the partitions one at a time.
+                if (!_groups->empty()) {
+                    spillToHashPartitions(0);
+                }
+                for (auto&& partition : _hashPartitionsBeingWritten) {
+                    if (!partition.runs.empty()) {
+                        _pendingHashPartitions.push_back(std::move(partition));
+                    }
+                }
+                _hashPartitionsBeingWritten.clear();
+                _hashSpilled = true;
+                groupsIterator = _groups->end();
+            } else if (!_sortedFiles.empty()) {
                 _spilled = true;
                 if (!_groups->empty()) {
                     _sortedFiles.push_back(spill());
@@ -589,36 +648,187 @@ shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
 
     SortedFileWriter<Value, Value> writer(
         SortOptions().TempDir(pExpCtx->tempDir), _fileName, _nextSortedFileWriterOffset);
-    switch (_accumulatedFields.size()) {  // same as ptrs[i]->second.size() for all i.
-        case 0:                           // no values, essentially a distinct
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first, Value());
-            }
-            break;
+    for (size_t i = 0; i < ptrs.size(); i++) {
+        writer.addAlreadySorted(ptrs[i]->first, serializeAccumulators(ptrs[i]->second));
+    }
 
-        case 1:  // just one value, use optimized serialization as single Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first,
-                                        ptrs[i]->second[0]->getValue(/*toBeMerged=*/true));
-            }
-            break;
+    _groups->clear();
+
+    Sorter<Value, Value>::Iterator* iteratorPtr = writer.done();
+    _nextSortedFileWriterOffset = writer.getFileEndOffset();
+    return shared_ptr<Sorter<Value, Value>::Iterator>(iteratorPtr);
+}
+
+void DocumentSourceGroup::spillToHashPartitions(int depth) {
+    _usedDisk = true;
+    if (_hashPartitionsBeingWritten.empty()) {
+        _hashPartitionsBeingWritten.resize(_numHashSpillPartitions);
+        for (auto&& partition : _hashPartitionsBeingWritten) {
+            partition.depth = depth;
+        }
+    }
+
+    vector<vector<const GroupsMap::value_type*>> buckets(_numHashSpillPartitions);
+    for (GroupsMap::const_iterator it = _groups->begin(), end = _groups->end(); it != end; ++it) {
+        buckets[hashPartitionFor(it->first, depth)].push_back(&*it);
+    }
+
+    // Each non-empty bucket becomes a new run of its partition. The runs aren't sorted; the
+    // SortedFileWriter is only used for its spill file format.
+    for (size_t i = 0; i < buckets.size(); i++) {
+        if (buckets[i].empty()) {
+            continue;
+        }
+
+        SortedFileWriter<Value, Value> writer(
+            SortOptions().TempDir(pExpCtx->tempDir), _fileName, _nextSortedFileWriterOffset);
+        for (auto&& group : buckets[i]) {
+            writer.addAlreadySorted(group->first, serializeAccumulators(group->second));
+        }
+        _hashPartitionsBeingWritten[i].runs.emplace_back(writer.done());
+        _nextSortedFileWriterOffset = writer.getFileEndOffset();
+    }
 
-        default:  // multiple values, serialize as array-typed Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                vector<Value> accums;
-                for (size_t j = 0; j < ptrs[i]->second.size(); j++) {
-                    accums.push_back(ptrs[i]->second[j]->getValue(/*toBeMerged=*/true));
+    _groups->clear();
+    _memoryUsageBytes = 0;
+}
+
+bool DocumentSourceGroup::loadNextHashPartition() {
+    _groups->clear();
+    _memoryUsageBytes = 0;
+
+    while (!_pendingHashPartitions.empty()) {
+        HashSpillPartition partition = std::move(_pendingHashPartitions.front());
+        _pendingHashPartitions.pop_front();
+
+        const int childDepth = partition.depth + 1;
+        for (auto&& run : partition.runs) {
+            run->openSource();
+            while (run->more()) {
+                // Splitting the partition again can only help if it holds more than one group.
+                if (_memoryUsageBytes > _maxMemoryUsageBytes && _groups->size() > 1) {
+                    uassert(4840013,
+                            str::stream()
+                                << "Exceeded memory limit for $group: a spilled partition of the "
+                                   "groups still did not fit in memory after being split "
+                                << kMaxHashSpillDepth
+                                << " times. Setting "
+                                   "internalDocumentSourceGroupHashSpillPartitions to 0 makes "
+                                   "$group sort and merge its spilled groups instead.",
+                            childDepth <= kMaxHashSpillDepth);
+                    spillToHashPartitions(childDepth);
                 }
-                writer.addAlreadySorted(ptrs[i]->first, Value(std::move(accums)));
+                auto next = run->next();
+                mergeSpilledGroup(next.first, next.second);
+            }
+            run->closeSource();
+        }
+
+        if (_hashPartitionsBeingWritten.empty()) {
+            groupsIterator = _groups->begin();
+            return true;
+        }
+
+        // The partition didn't fit in memory and was split again. Finish writing its children and
+        // process them before any other pending partition, so that they are read back while
+        // still in the page cache.
+        if (!_groups->empty()) {
+            spillToHashPartitions(childDepth);
+        }
+        auto& children = _hashPartitionsBeingWritten;
+        ++_hashSpillStats.partitionsSplit;
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+            if (!it->runs.empty()) {
+                ++_hashSpillStats.childPartitions;
+                _pendingHashPartitions.push_front(std::move(*it));
             }
+        }
+        _hashPartitionsBeingWritten.clear();
+    }
+
+    return false;
+}
+
+size_t DocumentSourceGroup::hashPartitionFor(const Value& id, int depth) const {
+    // Combining the depth with the hash, e.g. with boost::hash_combine(), only shifts the low bits
+    // by a per-depth constant, so all the groups of a partition would go to the same child. Offset
+    // the hash by the depth and run it through the SplitMix64 finalizer instead, which makes every
+    // output bit depend on every input bit.
+    uint64_t h = static_cast<uint64_t>(pExpCtx->getValueComparator().hash(id)) +
+        static_cast<uint64_t>(depth + 1) * 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+    h ^= h >> 31;
+    return h % _numHashSpillPartitions;
+}
+
+DocumentSourceGroup::Accumulators& DocumentSourceGroup::lookupGroupForUpdate(const Value& id,
+                                                                             bool* inserted) {
+    // Look for the _id value in the map. If it's not there, add a new entry with a blank
+    // accumulator. This is done in a somewhat odd way in order to avoid hashing 'id' and
+    // looking it up in '_groups' multiple times.
+    const size_t oldSize = _groups->size();
+    Accumulators& group = (*_groups)[id];
+    *inserted = _groups->size() != oldSize;
+
+    if (*inserted) {
+        _memoryUsageBytes += id.getApproximateSize();
+
+        // Add the accumulators
+        group.reserve(_accumulatedFields.size());
+        for (auto&& accumulatedField : _accumulatedFields) {
+            group.push_back(accumulatedField.makeAccumulator());
+        }
+    } else {
+        for (auto&& groupObj : group) {
+            // subtract old mem usage. New usage added back after processing.
+            _memoryUsageBytes -= groupObj->memUsageForSorter();
+        }
+    }
+    return group;
+}
+
+void DocumentSourceGroup::mergeSpilledGroup(const Value& id, const Value& state) {
+    bool inserted;
+    Accumulators& group = lookupGroupForUpdate(id, &inserted);
+
+    const size_t numAccumulators = _accumulatedFields.size();
+    switch (numAccumulators) {  // mirrors switch in serializeAccumulators()
+        case 0:
             break;
+        case 1:
+            group[0]->process(state, true);
+            break;
+        default: {
+            const vector<Value>& accumulatorStates = state.getArray();
+            for (size_t i = 0; i < numAccumulators; i++) {
+                group[i]->process(accumulatorStates[i], true);
+            }
+        }
     }
 
-    _groups->clear();
+    for (auto&& accum : group) {
+        _memoryUsageBytes += accum->memUsageForSorter();
+    }
+}
 
-    Sorter<Value, Value>::Iterator* iteratorPtr = writer.done();
-    _nextSortedFileWriterOffset = writer.getFileEndOffset();
-    return shared_ptr<Sorter<Value, Value>::Iterator>(iteratorPtr);
+Value DocumentSourceGroup::serializeAccumulators(const Accumulators& accums) const {
+    switch (accums.size()) {  // same as _accumulatedFields.size()
+        case 0:               // no values, essentially a distinct
+            return Value();
+
+        case 1:  // just one value, use optimized serialization as single Value
+            return accums[0]->getValue(/*toBeMerged=*/true);
+
+        default: {  // multiple values, serialize as array-typed Value
+            vector<Value> values;
+            values.reserve(accums.size());
+            for (auto&& accum : accums) {
+                values.push_back(accum->getValue(/*toBeMerged=*/true));
+            }
+            return Value(std::move(values));
+        }
+    }
 }
 
 Value DocumentSourceGroup::computeId(const Document& root) {
@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <utility>
 
@@ -37,6 +38,7 @@
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/transformer_interface.h"
 #include "mongo/db/sorter/sorter.h"
+#include "mongo/platform/atomic_word.h"
 
 namespace mongo {
 
@@ -118,6 +120,20 @@ public:
     static boost::intrusive_ptr<DocumentSource> createFromBson(
         BSONElement elem, const boost::intrusive_ptr<ExpressionContext>& pExpCtx);
 
+    /**
+     * Returns a copy of this $group stage which is bound to 'expCtx'. Used to run partitions of a
+     * merging $group on separate threads. The copies which share 'sharedMemoryUsageBytes' count
+     * their memory usage there, and may use at most 'maxMemoryUsageBytes' between them.
+     */
+    boost::intrusive_ptr<DocumentSourceGroup> clone(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx,
+        size_t maxMemoryUsageBytes,
+        std::shared_ptr<AtomicWord<long long>> sharedMemoryUsageBytes) const;
+
+    size_t getMaxMemoryUsageBytes() const {
+        return _maxMemoryUsageBytes;
+    }
+
     StageConstraints constraints(Pipeline::SplitState pipeState) const final {
         StageConstraints constraints(StreamType::kBlocking,
                                      PositionRequirement::kNone,
@@ -160,6 +176,20 @@ public:
      */
     bool usedDisk() final;
 
+    /**
+     * Counts the hash partitions which did not fit in memory when read back and were split again.
+     */
+    struct HashSpillStats {
+        // Partitions which were split again.
+        long long partitionsSplit = 0;
+        // Non-empty partitions which those splits produced.
+        long long childPartitions = 0;
+    };
+
+    const HashSpillStats& getHashSpillStats() const {
+        return _hashSpillStats;
+    }
+
     boost::optional<DistributedPlanLogic> distributedPlanLogic() final;
     bool canRunInParallelBeforeWriteStage(
         const std::set<std::string>& nameOfShardKeyFieldsUponEntryToStage) const final;
@@ -192,6 +222,7 @@ private:
      * initialize() to have been called already.
      */
     GetNextResult getNextSpilled();
+    GetNextResult getNextHashSpilled();
     GetNextResult getNextStandard();
 
     /**
@@ -213,6 +244,51 @@ private:
      */
     std::shared_ptr<Sorter<Value, Value>::Iterator> spill();
 
+    /**
+     * Spills the groups map to disk by appending each group to the hash partition chosen by
+     * hashPartitionFor() at 'depth'. Unlike spill(), this doesn't sort the
+     * groups: each partition can later be re-aggregated in memory on its own.
+     */
+    void spillToHashPartitions(int depth);
+
+    /**
+     * Re-aggregates the next pending hash partition into the groups map and positions
+     * 'groupsIterator' at its first group. A partition which still doesn't fit in memory is split
+     * again using a different hash seed. Returns false once no partitions remain.
+     */
+    bool loadNextHashPartition();
+
+    /**
+     * Returns true if the groups take up more memory than allowed. For a copy made by clone(), this
+     * first adds the change in its memory usage to the total it shares with the other copies.
+     */
+    bool exceededMemoryLimit();
+
+    /**
+     * Returns the index of the hash partition which the group with key 'id' spills to at 'depth'.
+     * The partition at each depth is independent of the partitions at lower depths, so that a
+     * partition which is split again spreads its groups across all of its children.
+     */
+    size_t hashPartitionFor(const Value& id, int depth) const;
+
+    /**
+     * Returns the accumulators for the group with key 'id', creating them if this is a new group.
+     * The memory used by an existing group's accumulators is subtracted from '_memoryUsageBytes';
+     * the caller is expected to add it back once it has processed its input.
+     */
+    Accumulators& lookupGroupForUpdate(const Value& id, bool* inserted);
+
+    /**
+     * Merges 'state', a group's partial accumulator state as written by serializeAccumulators(),
+     * into the group with key 'id'.
+     */
+    void mergeSpilledGroup(const Value& id, const Value& state);
+
+    /**
+     * Returns the partial state of 'accums' in the form in which it is written to spill files.
+     */
+    Value serializeAccumulators(const Accumulators& accums) const;
+
     Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
 
     /**
@@ -237,6 +313,10 @@ private:
     bool _doingMerge;
     size_t _memoryUsageBytes = 0;
     size_t _maxMemoryUsageBytes;
+    // The memory usage of all the copies of a $group made by clone(), if this is one of them.
+    // '_sharedMemoryUsageBytesReported' is the part of '_memoryUsageBytes' which has been added in.
+    std::shared_ptr<AtomicWord<long long>> _sharedMemoryUsageBytes;
+    size_t _sharedMemoryUsageBytesReported = 0;
     std::string _fileName;
     std::streampos _nextSortedFileWriterOffset = 0;
     bool _ownsFileDeletion = true;  // unless a MergeIterator is made that takes over.
@@ -257,6 +337,30 @@ private:
     std::vector<std::shared_ptr<Sorter<Value, Value>::Iterator>> _sortedFiles;
     bool _spilled;
 
+    // The runs written to '_fileName' for one hash partition. A partition at 'depth' d was split
+    // off from a partition at depth d - 1 which did not fit in memory.
+    struct HashSpillPartition {
+        std::vector<std::shared_ptr<Sorter<Value, Value>::Iterator>> runs;
+        int depth = 0;
+    };
+
+    // The number of partitions a hash spill divides the groups between. If zero, the groups are
+    // sorted and spilled to '_sortedFiles' instead.
+    const size_t _numHashSpillPartitions;
+
+    // The partitions being written by spillToHashPartitions(); empty if nothing has been spilled
+    // at the current depth.
+    std::vector<HashSpillPartition> _hashPartitionsBeingWritten;
+
+    // Partitions which have been completely written but not yet re-aggregated.
+    std::deque<HashSpillPartition> _pendingHashPartitions;
+
+    // True if the groups were spilled to hash partitions. Output is then produced one partition
+    // at a time, through '_groups' and 'groupsIterator'.
+    bool _hashSpilled = false;
+
+    HashSpillStats _hashSpillStats;
+
     // Only used when '_spilled' is false.
     GroupsMap::iterator groupsIterator;
 
@@ -49,11 +49,13 @@
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_test_service_context.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/unordered_set.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -204,6 +206,129 @@ TEST_F(DocumentSourceGroupTest, ShouldCorrectlyTrackMemoryUsageBetweenPauses) {
     ASSERT_THROWS_CODE(group->getNext(), AssertionException, 16945);
 }
 
+/**
+ * Runs {$group: {_id: "$_id", total: {$sum: "$x"}, count: {$sum: 1}}} over 'numDocs' documents
+ * spread round-robin across 'numGroups' groups, with the given memory limit and number of hash
+ * spill partitions. Returns the output, keyed by group.
+ */
+std::map<int, std::pair<long long, long long>> runSpillingSumGroup(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx,
+    const std::string& tempDir,
+    int hashSpillPartitions,
+    int numDocs,
+    int numGroups,
+    size_t maxMemoryUsageBytes,
+    bool* usedDisk,
+    DocumentSourceGroup::HashSpillStats* hashSpillStats = nullptr) {
+    expCtx->tempDir = tempDir;
+    expCtx->allowDiskUse = true;
+
+    const int originalPartitions = internalDocumentSourceGroupHashSpillPartitions.load();
+    internalDocumentSourceGroupHashSpillPartitions.store(hashSpillPartitions);
+    ON_BLOCK_EXIT(
+        [&] { internalDocumentSourceGroupHashSpillPartitions.store(originalPartitions); });
+
+    auto&& parser = AccumulationStatement::getParser("$sum");
+    auto totalArg = BSON(""
+                         << "$x");
+    auto [totalExpr, totalFactory] =
+        parser(expCtx, totalArg.firstElement(), expCtx->variablesParseState);
+    auto countArg = BSON("" << 1);
+    auto [countExpr, countFactory] =
+        parser(expCtx, countArg.firstElement(), expCtx->variablesParseState);
+    auto groupByExpression =
+        ExpressionFieldPath::parse(expCtx, "$_id", expCtx->variablesParseState);
+    auto group = DocumentSourceGroup::create(expCtx,
+                                             groupByExpression,
+                                             {{"total", totalExpr, totalFactory},
+                                              {"count", countExpr, countFactory}},
+                                             maxMemoryUsageBytes);
+
+    std::deque<DocumentSource::GetNextResult> inputs;
+    for (int i = 0; i < numDocs; ++i) {
+        inputs.emplace_back(Document{{"_id", i % numGroups}, {"x", i}});
+    }
+    auto mock = DocumentSourceMock::createForTest(std::move(inputs));
+    group->setSource(mock.get());
+
+    std::map<int, std::pair<long long, long long>> out;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        const int id = doc["_id"].coerceToInt();
+        ASSERT_EQ(out.count(id), 0UL);
+        out[id] = {doc["total"].coerceToLong(), doc["count"].coerceToLong()};
+    }
+    ASSERT_TRUE(group->getNext().isEOF());
+    *usedDisk = group->usedDisk();
+    if (hashSpillStats) {
+        *hashSpillStats = group->getHashSpillStats();
+    }
+    return out;
+}
+
+void assertSumGroupResults(const std::map<int, std::pair<long long, long long>>& results,
+                           int numDocs,
+                           int numGroups) {
+    ASSERT_EQ(results.size(), static_cast<size_t>(numGroups));
+    for (int id = 0; id < numGroups; ++id) {
+        long long expectedTotal = 0;
+        long long expectedCount = 0;
+        for (int i = id; i < numDocs; i += numGroups) {
+            expectedTotal += i;
+            ++expectedCount;
+        }
+        auto it = results.find(id);
+        ASSERT(it != results.end());
+        ASSERT_EQ(it->second.first, expectedTotal);
+        ASSERT_EQ(it->second.second, expectedCount);
+    }
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldProduceCorrectResultsWhenSpillingToHashPartitions) {
+    TempDir tempDir("DocumentSourceGroupTest");
+    bool usedDisk = false;
+    auto results = runSpillingSumGroup(getExpCtx(), tempDir.path(), 4, 2000, 200, 4000, &usedDisk);
+    ASSERT_TRUE(usedDisk);
+    assertSumGroupResults(results, 2000, 200);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldSplitHashPartitionsWhichDoNotFitInMemory) {
+    // With only two partitions, each one holds far more groups than fit within the memory limit,
+    // so every partition has to be split again when it is read back.
+    TempDir tempDir("DocumentSourceGroupTest");
+    bool usedDisk = false;
+    DocumentSourceGroup::HashSpillStats stats;
+    auto results = runSpillingSumGroup(
+        getExpCtx(), tempDir.path(), 2, 3000, 500, 2000, &usedDisk, &stats);
+    ASSERT_TRUE(usedDisk);
+    assertSumGroupResults(results, 3000, 500);
+
+    // If the groups of a partition all went to the same child, each split would produce exactly
+    // one child partition.
+    ASSERT_GT(stats.partitionsSplit, 0);
+    ASSERT_GT(stats.childPartitions, stats.partitionsSplit);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldFailWhenHashPartitionStillDoesNotFitAtMaxDepth) {
+    // Two partitions split four times over still leave hundreds of groups in each partition, far
+    // more than fit within the memory limit.
+    TempDir tempDir("DocumentSourceGroupTest");
+    bool usedDisk = false;
+    ASSERT_THROWS_CODE(
+        runSpillingSumGroup(getExpCtx(), tempDir.path(), 2, 20000, 20000, 1000, &usedDisk),
+        AssertionException,
+        4840013);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldProduceCorrectResultsWhenSpillingSortedRuns) {
+    // Disabling hash partitioning falls back to sorting and merging the spilled groups.
+    TempDir tempDir("DocumentSourceGroupTest");
+    bool usedDisk = false;
+    auto results = runSpillingSumGroup(getExpCtx(), tempDir.path(), 0, 2000, 200, 4000, &usedDisk);
+    ASSERT_TRUE(usedDisk);
+    assertSumGroupResults(results, 2000, 200);
+}
+
 TEST_F(DocumentSourceGroupTest, ShouldReportSingleFieldGroupKeyAsARename) {
     auto expCtx = getExpCtx();
     VariablesParseState vps = expCtx->variablesParseState;
@@ -0,0 +1,247 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_source_parallel_merge.h"
+
+#include "mongo/db/client.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+constexpr size_t DocumentSourceParallelMerge::kMaxBufferedBytes;
+
+boost::intrusive_ptr<DocumentSourceParallelMerge> DocumentSourceParallelMerge::create(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx,
+    boost::intrusive_ptr<Exchange> exchange,
+    std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> consumers) {
+    return new DocumentSourceParallelMerge(expCtx, std::move(exchange), std::move(consumers));
+}
+
+DocumentSourceParallelMerge::DocumentSourceParallelMerge(
+    const boost::intrusive_ptr<ExpressionContext>& expCtx,
+    boost::intrusive_ptr<Exchange> exchange,
+    std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> consumers)
+    : DocumentSource(kStageName, expCtx),
+      _exchange(std::move(exchange)),
+      _consumers(std::move(consumers)),
+      _consumerOpCtxs(_consumers.size(), nullptr) {
+    invariant(_consumers.size() == _exchange->getConsumers());
+}
+
+DocumentSourceParallelMerge::~DocumentSourceParallelMerge() {
+    // We are normally disposed of before being destroyed, but the threads must not outlive us.
+    stopConsumers();
+}
+
+const char* DocumentSourceParallelMerge::getSourceName() const {
+    return kStageName.rawData();
+}
+
+Value DocumentSourceParallelMerge::serialize(
+    boost::optional<ExplainOptions::Verbosity> explain) const {
+    // All consumers run the same pipeline, so only the first one is shown.
+    return Value(DOC(getSourceName() << DOC("exchange" << _exchange->getSpec().toBSON()
+                                                       << "consumer"
+                                                       << Value(_consumers.front()->serialize()))));
+}
+
+DocumentSource::GetNextResult DocumentSourceParallelMerge::doGetNext() {
+    auto* opCtx = pExpCtx->opCtx;
+
+    if (_threads.empty() && !_stopping) {
+        auto* serviceContext = opCtx->getServiceContext();
+        const auto deadline = opCtx->getDeadline();
+        const auto timeoutError = opCtx->getTimeoutError();
+        for (size_t consumerId = 0; consumerId < _consumers.size(); ++consumerId) {
+            _threads.emplace_back([this, serviceContext, consumerId, deadline, timeoutError] {
+                runConsumer(serviceContext, consumerId, deadline, timeoutError);
+            });
+        }
+    }
+
+    stdx::unique_lock<Latch> lk(_mutex, stdx::defer_lock);
+    try {
+        // Drive the input of the exchange. This returns only once the whole input has been handed
+        // out to the consumers, which produce nothing until then.
+        for (bool producing = true; producing;) {
+            {
+                stdx::lock_guard<Latch> producingLock(_mutex);
+                if (!_producing) {
+                    break;
+                }
+                uassertStatusOK(_consumerStatus);
+            }
+
+            producing = _exchange->produceNextBatch(opCtx);
+            if (!producing) {
+                stdx::lock_guard<Latch> producingLock(_mutex);
+                _producing = false;
+                _haveBufferSpace.notify_all();
+            }
+        }
+
+        lk.lock();
+        opCtx->waitForConditionOrInterrupt(_haveResults, lk, [&] {
+            return !_results.empty() || !_consumerStatus.isOK() ||
+                _finishedConsumers == _consumers.size();
+        });
+    } catch (const ExceptionForCat<ErrorCategory::Interruption>& ex) {
+        // The consumers run on OperationContexts of their own, which killOp does not reach.
+        if (lk.owns_lock()) {
+            lk.unlock();
+        }
+        interruptConsumers(ex.code());
+        throw;
+    }
+    uassertStatusOK(_consumerStatus);
+
+    if (_results.empty()) {
+        return GetNextResult::makeEOF();
+    }
+
+    auto result = std::move(_results.front());
+    _results.pop_front();
+    _bufferedBytes -= result.getApproximateSize();
+    _haveBufferSpace.notify_all();
+
+    return result;
+}
+
+void DocumentSourceParallelMerge::runConsumer(ServiceContext* serviceContext,
+                                              size_t consumerId,
+                                              Date_t deadline,
+                                              ErrorCodes::Error timeoutError) {
+    ThreadClient tc(str::stream() << "parallelMerge-" << consumerId, serviceContext);
+    auto opCtx = tc->makeOperationContext();
+    opCtx->setDeadlineByDate(deadline, timeoutError);
+
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _consumerOpCtxs[consumerId] = opCtx.get();
+        if (_killCode != ErrorCodes::OK) {
+            stdx::lock_guard<Client> clientLock(*tc.get());
+            serviceContext->killOperation(clientLock, opCtx.get(), _killCode);
+        }
+    }
+
+    auto& pipeline = _consumers[consumerId];
+    try {
+        // The consumer pipeline has an ExpressionContext of its own, which no other thread uses
+        // while we are running, and none of its stages holds on to the OperationContext.
+        pipeline->getContext()->opCtx = opCtx.get();
+
+        for (auto next = pipeline->getNext(); next; next = pipeline->getNext()) {
+            opCtx->checkForInterrupt();
+            const auto size = next->getApproximateSize();
+
+            stdx::unique_lock<Latch> lk(_mutex);
+            opCtx->waitForConditionOrInterrupt(_haveBufferSpace, lk, [&] {
+                return _stopping || _producing || _bufferedBytes < kMaxBufferedBytes;
+            });
+            if (_stopping) {
+                break;
+            }
+
+            _bufferedBytes += size;
+            _results.emplace_back(std::move(*next));
+            _haveResults.notify_one();
+        }
+    } catch (const DBException& ex) {
+        LOG(1) << "Consumer " << consumerId << " of " << kStageName
+               << " failed: " << redact(ex.toStatus());
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            if (_consumerStatus.isOK()) {
+                _consumerStatus = ex.toStatus();
+            }
+        }
+
+        // Wake up the producer and the other consumers, which may be waiting on this one.
+        _exchange->abort(ex.toStatus());
+    }
+
+    pipeline->getContext()->opCtx = nullptr;
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    _consumerOpCtxs[consumerId] = nullptr;
+    ++_finishedConsumers;
+    _haveResults.notify_all();
+}
+
+void DocumentSourceParallelMerge::interruptConsumers(ErrorCodes::Error killCode) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (_killCode != ErrorCodes::OK) {
+        return;
+    }
+    _killCode = killCode;
+
+    for (auto* consumerOpCtx : _consumerOpCtxs) {
+        if (consumerOpCtx) {
+            stdx::lock_guard<Client> clientLock(*consumerOpCtx->getClient());
+            consumerOpCtx->getServiceContext()->killOperation(clientLock, consumerOpCtx, killCode);
+        }
+    }
+}
+
+void DocumentSourceParallelMerge::stopConsumers() {
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _stopping = true;
+        _haveBufferSpace.notify_all();
+    }
+
+    if (_threads.empty()) {
+        return;
+    }
+
+    _exchange->abort(
+        Status(ErrorCodes::QueryPlanKilled, str::stream() << kStageName << " was disposed"));
+
+    for (auto& thread : _threads) {
+        thread.join();
+    }
+    _threads.clear();
+}
+
+void DocumentSourceParallelMerge::doDispose() {
+    stopConsumers();
+
+    // With the threads gone the consumer pipelines can be disposed of here. The last one to go
+    // disposes of the input of the exchange.
+    for (auto& consumer : _consumers) {
+        consumer->dispose(pExpCtx->opCtx);
+        consumer.get_deleter().dismissDisposal();
+    }
+}
+
+}  // namespace mongo
@@ -0,0 +1,166 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <vector>
+
+#include "mongo/db/pipeline/document_source.h"
+#include "mongo/db/pipeline/document_source_exchange.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/thread.h"
+
+namespace mongo {
+
+/**
+ * Runs several consumer pipelines of an Exchange side by side, each on a thread of its own, and
+ * returns the union of their results in no particular order.
+ *
+ * The Exchange must use Exchange::LoadingPolicy::kProducer: the thread calling getNext() drives
+ * the input of the exchange, so anything the input does on behalf of the operation (such as
+ * talking to the shards) stays on that thread, and the consumer threads only do the CPU work of
+ * their pipelines. Every consumer pipeline must begin with the DocumentSourceExchange for its
+ * consumer id and is expected to be blocking (e.g. a $group), since the input is read in full the
+ * first time getNext() is called.
+ */
+class DocumentSourceParallelMerge final : public DocumentSource {
+public:
+    static constexpr StringData kStageName = "$_internalParallelMerge"_sd;
+
+    // How much output the consumers may buffer ahead of the caller.
+    static constexpr size_t kMaxBufferedBytes = 16 * 1024 * 1024;
+
+    static boost::intrusive_ptr<DocumentSourceParallelMerge> create(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx,
+        boost::intrusive_ptr<Exchange> exchange,
+        std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> consumers);
+
+    ~DocumentSourceParallelMerge();
+
+    StageConstraints constraints(Pipeline::SplitState pipeState) const final {
+        StageConstraints constraints(StreamType::kBlocking,
+                                     PositionRequirement::kFirst,
+                                     HostTypeRequirement::kNone,
+                                     DiskUseRequirement::kNoDiskUse,
+                                     FacetRequirement::kNotAllowed,
+                                     TransactionRequirement::kAllowed,
+                                     LookupRequirement::kNotAllowed);
+
+        constraints.requiresInputDocSource = false;
+        return constraints;
+    }
+
+    boost::optional<DistributedPlanLogic> distributedPlanLogic() final {
+        return boost::none;
+    }
+
+    const char* getSourceName() const final;
+
+    Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
+
+    size_t getConsumers() const {
+        return _consumers.size();
+    }
+
+    /**
+     * Returns the first stage of the pipeline which feeds the exchange.
+     */
+    DocumentSource* getInputSource() const {
+        return _exchange->getInputPipeline()->getSources().front().get();
+    }
+
+protected:
+    GetNextResult doGetNext() final;
+    void doDispose() final;
+
+private:
+    DocumentSourceParallelMerge(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                                boost::intrusive_ptr<Exchange> exchange,
+                                std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> consumers);
+
+    /**
+     * The body of the thread which runs the pipeline of consumer 'consumerId'. The consumer's
+     * OperationContext inherits the deadline of the operation which started it.
+     */
+    void runConsumer(ServiceContext* serviceContext,
+                     size_t consumerId,
+                     Date_t deadline,
+                     ErrorCodes::Error timeoutError);
+
+    /**
+     * Kills the OperationContexts of the consumers, including those which have yet to make one,
+     * with 'killCode'. Used when the operation driving this stage is interrupted, so that the
+     * consumers stop without waiting for the stage to be disposed of.
+     */
+    void interruptConsumers(ErrorCodes::Error killCode);
+
+    /**
+     * Fails the exchange so that no consumer stays blocked on it, then waits for the consumer
+     * threads to exit.
+     */
+    void stopConsumers();
+
+    boost::intrusive_ptr<Exchange> _exchange;
+
+    std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> _consumers;
+
+    std::vector<stdx::thread> _threads;
+
+    // Protects the members below. The consumer threads push their results here and the caller of
+    // getNext() pops them.
+    Mutex _mutex = MONGO_MAKE_LATCH("DocumentSourceParallelMerge::_mutex");
+    stdx::condition_variable _haveResults;
+    stdx::condition_variable _haveBufferSpace;
+
+    std::deque<Document> _results;
+    size_t _bufferedBytes = 0;
+
+    // Whether the input of the exchange is still being read. Until it is exhausted the consumers
+    // may buffer any amount of output, as the producer could otherwise end up waiting for a
+    // consumer which is itself waiting for the producer to drain its results.
+    bool _producing = true;
+
+    // The number of consumer threads which have run to completion or failed.
+    size_t _finishedConsumers = 0;
+
+    // The first error raised by a consumer.
+    Status _consumerStatus = Status::OK();
+
+    // The OperationContext of each running consumer, or null if it has none.
+    std::vector<OperationContext*> _consumerOpCtxs;
+
+    // Set by interruptConsumers().
+    ErrorCodes::Error _killCode = ErrorCodes::OK;
+
+    bool _stopping = false;
+};
+
+}  // namespace mongo
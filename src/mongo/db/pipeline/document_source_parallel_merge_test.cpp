@@ -0,0 +1,195 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <map>
+
+#include "mongo/db/pipeline/aggregation_context_fixture.h"
+#include "mongo/db/pipeline/document_source_exchange.h"
+#include "mongo/db/pipeline/document_source_group.h"
+#include "mongo/db/pipeline/document_source_mock.h"
+#include "mongo/db/pipeline/document_source_parallel_merge.h"
+#include "mongo/db/pipeline/stub_mongo_process_interface.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * The exchange attaches its input to the OperationContext of the producer between batches, which
+ * the default stub does not allow.
+ */
+class StubMongoProcessOkWithOpCtxChanges : public StubMongoProcessInterface {
+public:
+    void setOperationContext(OperationContext* opCtx) final {}
+};
+
+class DocumentSourceParallelMergeTest : public AggregationContextFixture {
+protected:
+    void setUp() override {
+        getExpCtx()->mongoProcessInterface = std::make_shared<StubMongoProcessOkWithOpCtxChanges>();
+    }
+
+    /**
+     * Builds a stage which runs 'groupSpec', grouping 'input' on 'a', in 'nConsumers' consumers
+     * which may use up to 'maxMemoryUsageBytes' between them.
+     */
+    boost::intrusive_ptr<DocumentSourceParallelMerge> makeParallelGroup(
+        boost::intrusive_ptr<DocumentSourceMock> input,
+        int nConsumers,
+        size_t maxMemoryUsageBytes = 100 * 1024 * 1024,
+        const BSONObj& groupSpec = fromjson("{$group: {_id: '$a', total: {$sum: '$b'}}}")) {
+        auto expCtx = getExpCtx();
+        auto group = DocumentSourceGroup::createFromBson(groupSpec.firstElement(), expCtx);
+        auto sharedMemoryUsageBytes = std::make_shared<AtomicWord<long long>>(0);
+
+        ExchangeSpec spec;
+        spec.setPolicy(ExchangePolicyEnum::kHash);
+        spec.setKey(BSON("a" << 1));
+        spec.setConsumers(nConsumers);
+        spec.setBufferSize(1024);
+
+        auto inputPipeline =
+            unittest::assertGet(Pipeline::create({input}, expCtx->copyWith(expCtx->ns)));
+        boost::intrusive_ptr<Exchange> exchange = new Exchange(
+            std::move(spec), std::move(inputPipeline), Exchange::LoadingPolicy::kProducer);
+
+        std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> consumers;
+        for (int consumerId = 0; consumerId < nConsumers; ++consumerId) {
+            auto consumerExpCtx = expCtx->copyWith(expCtx->ns);
+            // Like mongos, never spill to disk.
+            consumerExpCtx->inMongos = true;
+            boost::intrusive_ptr<DocumentSource> consumer =
+                new DocumentSourceExchange(consumerExpCtx, exchange, consumerId, nullptr);
+            auto consumerGroup = static_cast<DocumentSourceGroup*>(group.get())
+                                     ->clone(consumerExpCtx,
+                                             maxMemoryUsageBytes,
+                                             sharedMemoryUsageBytes);
+            consumers.emplace_back(unittest::assertGet(
+                Pipeline::create({consumer, consumerGroup}, consumerExpCtx)));
+        }
+
+        return DocumentSourceParallelMerge::create(expCtx, exchange, std::move(consumers));
+    }
+
+    static boost::intrusive_ptr<DocumentSourceMock> makeInput(int nDocs, int nKeys) {
+        auto input = DocumentSourceMock::createForTest();
+        for (int i = 0; i < nDocs; ++i) {
+            input->emplace_back(Document{{"a", i % nKeys}, {"b", 1}});
+        }
+        return input;
+    }
+};
+
+TEST_F(DocumentSourceParallelMergeTest, ReturnsEveryGroupOnce) {
+    const int nDocs = 20000;
+    const int nKeys = 1000;
+    auto stage = makeParallelGroup(makeInput(nDocs, nKeys), 4);
+
+    std::map<int, int> totals;
+    auto next = stage->getNext();
+    for (; next.isAdvanced(); next = stage->getNext()) {
+        auto doc = next.releaseDocument();
+        ASSERT_TRUE(totals.emplace(doc["_id"].getInt(), doc["total"].coerceToInt()).second);
+    }
+    ASSERT_TRUE(next.isEOF());
+
+    ASSERT_EQ(totals.size(), static_cast<size_t>(nKeys));
+    for (auto&& total : totals) {
+        ASSERT_EQ(total.second, nDocs / nKeys);
+    }
+
+    stage->dispose();
+}
+
+TEST_F(DocumentSourceParallelMergeTest, ReportsConsumerError) {
+    // Too little memory for even a fraction of the groups.
+    auto stage = makeParallelGroup(makeInput(20000, 10000), 4, 1024);
+
+    ASSERT_THROWS_CODE(stage->getNext(), AssertionException, 16945);
+
+    stage->dispose();
+}
+
+TEST_F(DocumentSourceParallelMergeTest, ConsumersShareTheMemoryLimit) {
+    // Every document has the same key, so one consumer holds the whole group: a $push of 20000
+    // values takes over 300KB, more than a quarter of the limit but well within the whole of it.
+    const int nDocs = 20000;
+    auto stage = makeParallelGroup(makeInput(nDocs, 1),
+                                   4,
+                                   1024 * 1024,
+                                   fromjson("{$group: {_id: '$a', values: {$push: '$b'}}}"));
+
+    auto next = stage->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_EQ(next.getDocument()["values"].getArrayLength(), static_cast<size_t>(nDocs));
+    ASSERT_TRUE(stage->getNext().isEOF());
+
+    stage->dispose();
+}
+
+TEST_F(DocumentSourceParallelMergeTest, CanBeDisposedBeforeReturningAllResults) {
+    auto stage = makeParallelGroup(makeInput(20000, 10000), 4);
+
+    ASSERT_TRUE(stage->getNext().isAdvanced());
+
+    stage->dispose();
+}
+
+TEST_F(DocumentSourceParallelMergeTest, CanBeDisposedBeforeRunning) {
+    auto stage = makeParallelGroup(makeInput(100, 10), 2);
+
+    stage->dispose();
+}
+
+TEST_F(DocumentSourceParallelMergeTest, StopsWhenTheOperationIsKilled) {
+    auto stage = makeParallelGroup(makeInput(20000, 10000), 4);
+
+    auto* opCtx = getExpCtx()->opCtx;
+    {
+        stdx::lock_guard<Client> clientLock(*opCtx->getClient());
+        getServiceContext()->killOperation(clientLock, opCtx, ErrorCodes::Interrupted);
+    }
+    ASSERT_THROWS_CODE(stage->getNext(), AssertionException, ErrorCodes::Interrupted);
+
+    stage->dispose();
+}
+
+TEST_F(DocumentSourceParallelMergeTest, StopsWhenTheOperationTimesOut) {
+    auto stage = makeParallelGroup(makeInput(20000, 10000), 4);
+
+    getExpCtx()->opCtx->setDeadlineByDate(Date_t::now(), ErrorCodes::MaxTimeMSExpired);
+    ASSERT_THROWS_CODE(stage->getNext(), AssertionException, ErrorCodes::MaxTimeMSExpired);
+
+    stage->dispose();
+}
+
+}  // namespace
+}  // namespace mongo
@@ -52,6 +52,7 @@
 #include "mongo/db/server_options.h"
 #include "mongo/util/intrusive_counter.h"
 #include "mongo/util/str.h"
+#include "mongo/util/summation.h"
 
 namespace mongo {
 
@@ -751,6 +752,26 @@ public:
 
 class ExpressionAdd final : public ExpressionVariadic<ExpressionAdd> {
 public:
+    /**
+     * Adds up the operands of an $add one at a time. add() returns false once the result is known
+     * to be null, so that the caller can stop evaluating operands, as evaluate() does.
+     */
+    class Sum {
+    public:
+        bool add(const Value& val);
+        Value getValue() const;
+
+    private:
+        // We'll try to return the narrowest possible result value while avoiding overflow, loss
+        // of precision due to intermediate rounding or implicit use of decimal types. To do that,
+        // compute a compensated sum for non-decimal values and a separate decimal sum for decimal
+        // values, and track the current narrowest type.
+        DoubleDoubleSummation _nonDecimalTotal;
+        Decimal128 _decimalTotal;
+        BSONType _totalType = NumberInt;
+        bool _haveDate = false;
+    };
+
     explicit ExpressionAdd(const boost::intrusive_ptr<ExpressionContext>& expCtx)
         : ExpressionVariadic<ExpressionAdd>(expCtx) {}
 
@@ -981,6 +1002,12 @@ public:
         return cmpOp;
     }
 
+    /**
+     * Compares 'lhs' to 'rhs' with this expression's operator, as evaluate() compares the values
+     * of its two operands.
+     */
+    Value apply(const Value& lhs, const Value& rhs) const;
+
     static boost::intrusive_ptr<Expression> parse(
         const boost::intrusive_ptr<ExpressionContext>& expCtx,
         BSONElement bsonExpr,
@@ -1300,6 +1327,11 @@ public:
     Value evaluate(const Document& root, Variables* variables) const final;
     const char* getOpName() const final;
 
+    /**
+     * Divides 'lhs' by 'rhs', as evaluate() does with the values of its two operands.
+     */
+    static Value apply(const Value& lhs, const Value& rhs);
+
     void acceptVisitor(ExpressionVisitor* visitor) final {
         return visitor->visit(this);
     }
@@ -1401,6 +1433,10 @@ private:
 
     const FieldPath _fieldPath;
     const Variables::Id _variable;
+
+    // Where each component of '_fieldPath' was last found, indexed like the path. Input documents
+    // nearly always share a shape, so this saves hashing the field names.
+    mutable std::vector<FieldPositionCache> _positionCaches;
 };
 
 
@@ -1764,6 +1800,26 @@ public:
 
 class ExpressionMultiply final : public ExpressionVariadic<ExpressionMultiply> {
 public:
+    /**
+     * Multiplies the operands of a $multiply one at a time. multiply() returns false once the
+     * result is known to be null, so that the caller can stop evaluating operands, as evaluate()
+     * does.
+     */
+    class Product {
+    public:
+        bool multiply(const Value& val);
+        Value getValue() const;
+
+    private:
+        // We'll try to return the narrowest possible result value. To do that without creating
+        // intermediate Values, do the arithmetic for double and integral types in parallel,
+        // tracking the current narrowest type.
+        double _doubleProduct = 1;
+        long long _longProduct = 1;
+        Decimal128 _decimalProduct;  // This will be initialized on encountering the first decimal.
+        BSONType _productType = NumberInt;
+    };
+
     explicit ExpressionMultiply(const boost::intrusive_ptr<ExpressionContext>& expCtx)
         : ExpressionVariadic<ExpressionMultiply>(expCtx) {}
 
@@ -2264,6 +2320,11 @@ public:
     Value evaluate(const Document& root, Variables* variables) const final;
     const char* getOpName() const final;
 
+    /**
+     * Subtracts 'rhs' from 'lhs', as evaluate() does with the values of its two operands.
+     */
+    static Value apply(const Value& lhs, const Value& rhs);
+
     void acceptVisitor(ExpressionVisitor* visitor) final {
         return visitor->visit(this);
     }
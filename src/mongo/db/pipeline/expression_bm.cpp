@@ -0,0 +1,147 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/json.h"
+#include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/expression_bytecode.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Evaluates the optimized expression 'json' over a batch of documents, as the tree when the
+ * benchmark argument is 0 and as compiled bytecode when it is 1. Callers fall back to the tree
+ * when an expression doesn't compile, and so does this.
+ */
+void runExpression(benchmark::State& state, const char* json) {
+    const int numDocs = 1000;
+
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto spec = fromjson(std::string("{expr: ") + json + "}");
+    auto expression =
+        Expression::parseOperand(expCtx, spec.firstElement(), expCtx->variablesParseState)
+            ->optimize();
+    auto compiled = state.range(0) ? CompiledExpression::compile(expression) : nullptr;
+
+    std::vector<Document> docs;
+    for (int i = 0; i < numDocs; ++i) {
+        docs.push_back(Document{BSON("_id" << i << "qty" << i % 50 << "price" << 1.25 * (i % 20)
+                                           << "discount" << static_cast<long long>(i % 7)
+                                           << "date" << Date_t::fromMillisSinceEpoch(i * 3600000LL)
+                                           << "status"
+                                           << "A")});
+    }
+
+    for (auto _ : state) {
+        for (auto&& doc : docs) {
+            benchmark::DoNotOptimize(compiled ? compiled->evaluate(doc, &expCtx->variables)
+                                              : expression->evaluate(doc, &expCtx->variables));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * numDocs);
+}
+
+void BM_Arithmetic(benchmark::State& state) {
+    runExpression(state,
+                  "{$subtract: [{$multiply: ['$qty', '$price']}, "
+                  "{$divide: [{$multiply: ['$qty', '$discount']}, 100]}]}");
+}
+
+void BM_ArithmeticWithConstants(benchmark::State& state) {
+    runExpression(state, "{$add: [{$multiply: ['$price', {$add: [1, 0.08]}]}, 5]}");
+}
+
+void BM_Cond(benchmark::State& state) {
+    runExpression(state,
+                  "{$cond: [{$and: [{$gte: ['$qty', 10]}, {$lt: ['$price', 20]}]}, "
+                  "{$multiply: ['$price', 0.9]}, '$price']}");
+}
+
+void BM_NestedCond(benchmark::State& state) {
+    runExpression(state,
+                  "{$cond: [{$gt: ['$qty', 40]}, 'high', "
+                  "{$cond: [{$gt: ['$qty', 20]}, 'medium', 'low']}]}");
+}
+
+void BM_DateToString(benchmark::State& state) {
+    runExpression(state, "{$dateToString: {format: '%Y-%m-%d', date: '$date'}}");
+}
+
+void BM_CondDateToString(benchmark::State& state) {
+    runExpression(state,
+                  "{$cond: [{$eq: ['$status', 'A']}, "
+                  "{$dateToString: {format: '%Y-%m-%dT%H', date: '$date'}}, null]}");
+}
+
+/**
+ * Evaluates the field path '$f<n>', where n is the benchmark argument, over documents that wrap a
+ * freshly read BSONObj of 20 fields, as a $cursor stage produces them. Every evaluation has to
+ * load the field from the BSON into the document's cache.
+ */
+void BM_FieldPathOverBson(benchmark::State& state) {
+    const int numDocs = 1000;
+    const int numFields = 20;
+
+    boost::intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto expression = ExpressionFieldPath::parse(
+        expCtx, "$f" + std::to_string(state.range(0)), expCtx->variablesParseState);
+
+    std::vector<BSONObj> objs;
+    for (int i = 0; i < numDocs; ++i) {
+        BSONObjBuilder builder;
+        for (int field = 0; field < numFields; ++field) {
+            builder.append("f" + std::to_string(field), i * numFields + field);
+        }
+        objs.push_back(builder.obj());
+    }
+
+    for (auto _ : state) {
+        for (auto&& obj : objs) {
+            benchmark::DoNotOptimize(expression->evaluate(Document(obj), &expCtx->variables));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * numDocs);
+}
+
+BENCHMARK(BM_Arithmetic)->Arg(0)->Arg(1);
+BENCHMARK(BM_ArithmeticWithConstants)->Arg(0)->Arg(1);
+BENCHMARK(BM_Cond)->Arg(0)->Arg(1);
+BENCHMARK(BM_NestedCond)->Arg(0)->Arg(1);
+BENCHMARK(BM_DateToString)->Arg(0)->Arg(1);
+BENCHMARK(BM_CondDateToString)->Arg(0)->Arg(1);
+BENCHMARK(BM_FieldPathOverBson)->Arg(0)->Arg(10)->Arg(19);
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,375 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/expression_bytecode.h"
+
+#include <boost/container/small_vector.hpp>
+#include <limits>
+
+#include "mongo/db/query/query_knobs_gen.h"
+
+namespace mongo {
+
+namespace {
+// Registers past this many are allocated on the heap for each evaluation.
+constexpr size_t kInlineRegisters = 16;
+
+bool isLogical(const Expression* expression) {
+    return (dynamic_cast<const ExpressionAnd*>(expression) ||
+            dynamic_cast<const ExpressionOr*>(expression)) &&
+        !expression->getChildren().empty();
+}
+
+const ExpressionCompare* asBooleanCompare(const Expression* expression) {
+    auto compare = dynamic_cast<const ExpressionCompare*>(expression);
+    return compare && compare->getOp() != ExpressionCompare::CMP ? compare : nullptr;
+}
+}  // namespace
+
+/**
+ * Lowers an Expression tree into the program it was constructed with. Registers are never reused,
+ * and all jumps go forward, so every instruction runs at most once per evaluation.
+ */
+class CompiledExpression::Compiler {
+public:
+    explicit Compiler(CompiledExpression* program) : _program(program) {}
+
+    /**
+     * Returns true if 'expression' compiles to more than a call to its evaluate().
+     */
+    static bool isCompilable(const Expression* expression) {
+        return dynamic_cast<const ExpressionAdd*>(expression) ||
+            dynamic_cast<const ExpressionMultiply*>(expression) ||
+            dynamic_cast<const ExpressionSubtract*>(expression) ||
+            dynamic_cast<const ExpressionDivide*>(expression) ||
+            dynamic_cast<const ExpressionCompare*>(expression) ||
+            dynamic_cast<const ExpressionCond*>(expression) ||
+            dynamic_cast<const ExpressionNot*>(expression) ||
+            dynamic_cast<const ExpressionCoerceToBool*>(expression) || isLogical(expression);
+    }
+
+    /**
+     * Emits code computing the value of 'expression' and returns the operand holding it. If 'dst'
+     * is given, the value is left in that register.
+     */
+    Operand compile(const Expression* expression, boost::optional<Operand> dst = boost::none);
+
+    /**
+     * Returns true if the program needs more registers or constants than an Operand can name.
+     */
+    bool tooLarge() const {
+        return _tooLarge;
+    }
+
+private:
+    using JumpList = std::vector<size_t>;
+
+    /**
+     * Emits code that jumps if the value of 'expression' coerces to 'jumpIf' and falls through
+     * otherwise. The jumps are added to 'jumps', for the caller to point at their destination.
+     */
+    void compileBranch(const Expression* expression, bool jumpIf, JumpList* jumps);
+
+    size_t emit(OpCode op,
+                Operand dst = 0,
+                Operand lhs = 0,
+                Operand rhs = 0,
+                uint32_t node = 0) {
+        _program->_code.push_back({op, dst, lhs, rhs, node, 0});
+        return _program->_code.size() - 1;
+    }
+
+    void patch(const JumpList& jumps) {
+        for (auto jump : jumps) {
+            _program->_code[jump].target = _program->_code.size();
+        }
+    }
+
+    Operand newRegister() {
+        if (_program->_numRegisters == kConstantBit) {
+            _tooLarge = true;
+            return 0;
+        }
+        return _program->_numRegisters++;
+    }
+
+    Operand newConstant(const Value& value) {
+        if (_program->_constants.size() == kConstantBit) {
+            _tooLarge = true;
+            return kConstantBit;
+        }
+        _program->_constants.push_back(value);
+        return kConstantBit | (_program->_constants.size() - 1);
+    }
+
+    uint32_t newNode(const Expression* expression) {
+        _program->_nodes.push_back(expression);
+        return _program->_nodes.size() - 1;
+    }
+
+    uint32_t newAccumulator(uint16_t* count) {
+        if (*count == std::numeric_limits<uint16_t>::max()) {
+            _tooLarge = true;
+            return 0;
+        }
+        return (*count)++;
+    }
+
+    CompiledExpression* _program;
+    bool _tooLarge = false;
+};
+
+CompiledExpression::Operand CompiledExpression::Compiler::compile(const Expression* expression,
+                                                                  boost::optional<Operand> dst) {
+    if (auto constant = dynamic_cast<const ExpressionConstant*>(expression)) {
+        const Operand value = newConstant(constant->getValue());
+        if (!dst) {
+            return value;
+        }
+        emit(OpCode::kMove, *dst, value);
+        return *dst;
+    }
+
+    const Operand out = dst ? *dst : newRegister();
+    const auto& children = expression->getChildren();
+    if (dynamic_cast<const ExpressionFieldPath*>(expression)) {
+        emit(OpCode::kFieldPath, out, 0, 0, newNode(expression));
+    } else if (dynamic_cast<const ExpressionAdd*>(expression) ||
+               dynamic_cast<const ExpressionMultiply*>(expression)) {
+        // Evaluate the operands one at a time, giving up on the rest as soon as one is null.
+        const bool isAdd = dynamic_cast<const ExpressionAdd*>(expression);
+        const uint32_t accumulator =
+            newAccumulator(isAdd ? &_program->_numSums : &_program->_numProducts);
+        JumpList toEnd;
+        for (auto&& child : children) {
+            const Operand operand = compile(child.get());
+            toEnd.push_back(emit(isAdd ? OpCode::kSumAdd : OpCode::kProductMultiply,
+                                 out,
+                                 operand,
+                                 0,
+                                 accumulator));
+        }
+        emit(isAdd ? OpCode::kSumEnd : OpCode::kProductEnd, out, 0, 0, accumulator);
+        patch(toEnd);
+    } else if (dynamic_cast<const ExpressionSubtract*>(expression) ||
+               dynamic_cast<const ExpressionDivide*>(expression)) {
+        const Operand lhs = compile(children[0].get());
+        const Operand rhs = compile(children[1].get());
+        emit(dynamic_cast<const ExpressionSubtract*>(expression) ? OpCode::kSubtract
+                                                                   : OpCode::kDivide,
+             out,
+             lhs,
+             rhs);
+    } else if (dynamic_cast<const ExpressionCompare*>(expression)) {
+        const Operand lhs = compile(children[0].get());
+        const Operand rhs = compile(children[1].get());
+        emit(OpCode::kCompare, out, lhs, rhs, newNode(expression));
+    } else if (dynamic_cast<const ExpressionCond*>(expression)) {
+        JumpList toElse;
+        compileBranch(children[0].get(), false, &toElse);
+        compile(children[1].get(), out);
+        const size_t toEnd = emit(OpCode::kJump);
+        patch(toElse);
+        compile(children[2].get(), out);
+        patch({toEnd});
+    } else if (isLogical(expression)) {
+        // An $and is false as soon as one operand is false, and an $or is true as soon as one
+        // operand is true.
+        const bool isOr = dynamic_cast<const ExpressionOr*>(expression);
+        JumpList toShortCircuit;
+        compileBranch(expression, isOr, &toShortCircuit);
+        emit(OpCode::kMove, out, newConstant(Value(!isOr)));
+        const size_t toEnd = emit(OpCode::kJump);
+        patch(toShortCircuit);
+        emit(OpCode::kMove, out, newConstant(Value(isOr)));
+        patch({toEnd});
+    } else if (dynamic_cast<const ExpressionNot*>(expression)) {
+        emit(OpCode::kNot, out, compile(children[0].get()));
+    } else if (dynamic_cast<const ExpressionCoerceToBool*>(expression)) {
+        emit(OpCode::kCoerceToBool, out, compile(children[0].get()));
+    } else {
+        emit(OpCode::kEvaluate, out, 0, 0, newNode(expression));
+    }
+    return out;
+}
+
+void CompiledExpression::Compiler::compileBranch(const Expression* expression,
+                                                 bool jumpIf,
+                                                 JumpList* jumps) {
+    const auto& children = expression->getChildren();
+    if (auto compare = asBooleanCompare(expression)) {
+        const Operand lhs = compile(children[0].get());
+        const Operand rhs = compile(children[1].get());
+        jumps->push_back(emit(jumpIf ? OpCode::kJumpIfCompareTrue : OpCode::kJumpIfCompareFalse,
+                              0,
+                              lhs,
+                              rhs,
+                              newNode(compare)));
+    } else if (dynamic_cast<const ExpressionNot*>(expression)) {
+        compileBranch(children[0].get(), !jumpIf, jumps);
+    } else if (dynamic_cast<const ExpressionCoerceToBool*>(expression)) {
+        compileBranch(children[0].get(), jumpIf, jumps);
+    } else if (isLogical(expression)) {
+        const bool shortCircuitsOn = dynamic_cast<const ExpressionOr*>(expression);
+        if (jumpIf == shortCircuitsOn) {
+            // Any operand that short-circuits decides the branch.
+            for (auto&& child : children) {
+                compileBranch(child.get(), jumpIf, jumps);
+            }
+        } else {
+            // The branch is taken only if no operand short-circuits, which is decided by the last.
+            JumpList toFallThrough;
+            for (size_t i = 0; i + 1 < children.size(); ++i) {
+                compileBranch(children[i].get(), shortCircuitsOn, &toFallThrough);
+            }
+            compileBranch(children.back().get(), jumpIf, jumps);
+            patch(toFallThrough);
+        }
+    } else {
+        const Operand value = compile(expression);
+        jumps->push_back(emit(jumpIf ? OpCode::kJumpIfTrue : OpCode::kJumpIfFalse, 0, value));
+    }
+}
+
+std::unique_ptr<CompiledExpression> CompiledExpression::compile(
+    boost::intrusive_ptr<Expression> expression) {
+    if (!internalQueryEnableExpressionCompilation.load() ||
+        !Compiler::isCompilable(expression.get())) {
+        return nullptr;
+    }
+
+    std::unique_ptr<CompiledExpression> program(new CompiledExpression(std::move(expression)));
+    Compiler compiler(program.get());
+    program->_result = compiler.compile(program->_expression.get());
+    if (compiler.tooLarge()) {
+        return nullptr;
+    }
+    return program;
+}
+
+Value CompiledExpression::evaluate(const Document& root, Variables* variables) const {
+    boost::container::small_vector<Value, kInlineRegisters> registers(_numRegisters);
+    boost::container::small_vector<ExpressionAdd::Sum, 1> sums(_numSums);
+    boost::container::small_vector<ExpressionMultiply::Product, 1> products(_numProducts);
+
+    auto operand = [&](Operand which) -> const Value& {
+        return (which & kConstantBit) ? _constants[which & ~kConstantBit] : registers[which];
+    };
+    auto compare = [&](const Instruction& instruction) {
+        return static_cast<const ExpressionCompare*>(_nodes[instruction.node])
+            ->apply(operand(instruction.lhs), operand(instruction.rhs));
+    };
+
+    const size_t end = _code.size();
+    size_t pc = 0;
+    while (pc < end) {
+        const Instruction& instruction = _code[pc++];
+        switch (instruction.op) {
+            case OpCode::kMove:
+                registers[instruction.dst] = operand(instruction.lhs);
+                break;
+            case OpCode::kEvaluate:
+                registers[instruction.dst] = _nodes[instruction.node]->evaluate(root, variables);
+                break;
+            case OpCode::kFieldPath:
+                // ExpressionFieldPath is final, so this call is not virtual.
+                registers[instruction.dst] =
+                    static_cast<const ExpressionFieldPath*>(_nodes[instruction.node])
+                        ->evaluate(root, variables);
+                break;
+            case OpCode::kSubtract:
+                registers[instruction.dst] =
+                    ExpressionSubtract::apply(operand(instruction.lhs), operand(instruction.rhs));
+                break;
+            case OpCode::kDivide:
+                registers[instruction.dst] =
+                    ExpressionDivide::apply(operand(instruction.lhs), operand(instruction.rhs));
+                break;
+            case OpCode::kCompare:
+                registers[instruction.dst] = compare(instruction);
+                break;
+            case OpCode::kCoerceToBool:
+                registers[instruction.dst] = Value(operand(instruction.lhs).coerceToBool());
+                break;
+            case OpCode::kNot:
+                registers[instruction.dst] = Value(!operand(instruction.lhs).coerceToBool());
+                break;
+            case OpCode::kSumAdd:
+                if (!sums[instruction.node].add(operand(instruction.lhs))) {
+                    registers[instruction.dst] = Value(BSONNULL);
+                    pc = instruction.target;
+                }
+                break;
+            case OpCode::kSumEnd:
+                registers[instruction.dst] = sums[instruction.node].getValue();
+                break;
+            case OpCode::kProductMultiply:
+                if (!products[instruction.node].multiply(operand(instruction.lhs))) {
+                    registers[instruction.dst] = Value(BSONNULL);
+                    pc = instruction.target;
+                }
+                break;
+            case OpCode::kProductEnd:
+                registers[instruction.dst] = products[instruction.node].getValue();
+                break;
+            case OpCode::kJump:
+                pc = instruction.target;
+                break;
+            case OpCode::kJumpIfTrue:
+                if (operand(instruction.lhs).coerceToBool()) {
+                    pc = instruction.target;
+                }
+                break;
+            case OpCode::kJumpIfFalse:
+                if (!operand(instruction.lhs).coerceToBool()) {
+                    pc = instruction.target;
+                }
+                break;
+            case OpCode::kJumpIfCompareTrue:
+                if (compare(instruction).getBool()) {
+                    pc = instruction.target;
+                }
+                break;
+            case OpCode::kJumpIfCompareFalse:
+                if (!compare(instruction).getBool()) {
+                    pc = instruction.target;
+                }
+                break;
+        }
+    }
+
+    if (_result & kConstantBit) {
+        return _constants[_result & ~kConstantBit];
+    }
+    return std::move(registers[_result]);
+}
+
+}  // namespace mongo
@@ -0,0 +1,130 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/intrusive_ptr.hpp>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "mongo/db/exec/document_value/document.h"
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/pipeline/expression.h"
+#include "mongo/db/pipeline/variables.h"
+
+namespace mongo {
+
+/**
+ * An Expression tree lowered to a flat program over a file of Value registers. Running the program
+ * computes exactly what evaluate() on the tree would, evaluating the same operands in the same
+ * order and raising the same errors, but without a virtual call and a temporary Value per node.
+ *
+ * $add, $multiply, $subtract, $divide, the comparisons, $cond, $and, $or and $not become
+ * instructions, and field paths are called directly. Constants stay in a pool and are read in
+ * place rather than copied into registers. A $cond, $and, $or or $not that tests a comparison
+ * jumps on the outcome of the comparison without materializing a boolean. Any other operator,
+ * $dateToString for instance, is evaluated as a subtree.
+ *
+ * A program keeps no state between evaluations, so like the tree it was compiled from it may be
+ * evaluated by several threads at once.
+ */
+class CompiledExpression {
+public:
+    /**
+     * Compiles 'expression', which should already have been optimized. Returns nullptr if
+     * compilation is disabled, or if the program would be no faster than the tree because the root
+     * of the tree is a constant, a field path or an operator the compiler doesn't know.
+     *
+     * The program refers to the nodes of the tree, so it must be thrown away if the tree changes.
+     */
+    static std::unique_ptr<CompiledExpression> compile(boost::intrusive_ptr<Expression> expression);
+
+    Value evaluate(const Document& root, Variables* variables) const;
+
+    const boost::intrusive_ptr<Expression>& getExpression() const {
+        return _expression;
+    }
+
+    size_t getNumInstructions() const {
+        return _code.size();
+    }
+
+private:
+    class Compiler;
+
+    // Names a register, or a constant if kConstantBit is set.
+    using Operand = uint16_t;
+    static constexpr Operand kConstantBit = 0x8000;
+
+    enum class OpCode : uint8_t {
+        kMove,                // dst = lhs
+        kEvaluate,            // dst = node->evaluate()
+        kFieldPath,           // dst = node->evaluate(), where node is an ExpressionFieldPath
+        kSubtract,            // dst = lhs - rhs
+        kDivide,              // dst = lhs / rhs
+        kCompare,             // dst = node->apply(lhs, rhs), where node is an ExpressionCompare
+        kCoerceToBool,        // dst = lhs.coerceToBool()
+        kNot,                 // dst = !lhs.coerceToBool()
+        kSumAdd,              // add lhs to sum 'node', or set dst to null and jump
+        kSumEnd,              // dst = sum 'node'
+        kProductMultiply,     // multiply product 'node' by lhs, or set dst to null and jump
+        kProductEnd,          // dst = product 'node'
+        kJump,                // jump
+        kJumpIfTrue,          // jump if lhs.coerceToBool()
+        kJumpIfFalse,         // jump unless lhs.coerceToBool()
+        kJumpIfCompareTrue,   // jump if node->apply(lhs, rhs) is true
+        kJumpIfCompareFalse,  // jump if node->apply(lhs, rhs) is false
+    };
+
+    struct Instruction {
+        OpCode op;
+        Operand dst = 0;
+        Operand lhs = 0;
+        Operand rhs = 0;
+        uint32_t node = 0;    // Index into '_nodes', or of a sum or product.
+        uint32_t target = 0;  // Index into '_code' to jump to.
+    };
+
+    explicit CompiledExpression(boost::intrusive_ptr<Expression> expression)
+        : _expression(std::move(expression)) {}
+
+    std::vector<Instruction> _code;
+    std::vector<Value> _constants;
+    std::vector<const Expression*> _nodes;  // Points into '_expression'.
+    Operand _result = 0;
+
+    uint16_t _numRegisters = 0;
+    uint16_t _numSums = 0;
+    uint16_t _numProducts = 0;
+
+    boost::intrusive_ptr<Expression> _expression;
+};
+
+}  // namespace mongo
@@ -0,0 +1,214 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/exec/document_value/document_value_test_util.h"
+#include "mongo/db/json.h"
+#include "mongo/db/pipeline/expression_bytecode.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+namespace {
+
+using boost::intrusive_ptr;
+
+intrusive_ptr<Expression> parseAndOptimize(const intrusive_ptr<ExpressionContext>& expCtx,
+                                           const std::string& json) {
+    auto spec = fromjson("{expr: " + json + "}");
+    return Expression::parseOperand(expCtx, spec.firstElement(), expCtx->variablesParseState)
+        ->optimize();
+}
+
+/**
+ * Compiles 'json' and checks that the program returns the same value as the tree, or fails with
+ * the same error, for each document in 'docs'.
+ */
+void assertCompiledMatchesTree(const std::string& json, const std::vector<BSONObj>& docs) {
+    intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto expression = parseAndOptimize(expCtx, json);
+    auto compiled = CompiledExpression::compile(expression);
+    ASSERT(compiled) << json;
+
+    for (auto&& doc : docs) {
+        Document root(doc);
+        StatusWith<Value> expected = Status::OK();
+        StatusWith<Value> actual = Status::OK();
+        try {
+            expected = expression->evaluate(root, &expCtx->variables);
+        } catch (const DBException& ex) {
+            expected = ex.toStatus();
+        }
+        try {
+            actual = compiled->evaluate(root, &expCtx->variables);
+        } catch (const DBException& ex) {
+            actual = ex.toStatus();
+        }
+
+        ASSERT_EQ(expected.getStatus().code(), actual.getStatus().code()) << json << " " << doc;
+        if (expected.isOK()) {
+            ASSERT_VALUE_EQ(expected.getValue(), actual.getValue());
+            ASSERT_EQ(expected.getValue().getType(), actual.getValue().getType())
+                << json << " " << doc;
+        }
+    }
+}
+
+const std::vector<BSONObj> kNumericDocs = {
+    BSON("a" << 1 << "b" << 2 << "c" << 3),
+    BSON("a" << 2LL << "b" << 0 << "c" << -1.5),
+    BSON("a" << 7.5 << "b" << 2LL << "c" << Decimal128("1.1")),
+    BSON("a" << std::numeric_limits<long long>::max() << "b" << 2 << "c" << 1),
+    BSON("a" << BSONNULL << "b" << 1 << "c" << 1),
+    BSON("b" << 1 << "c" << 1),
+    BSON("a" << Date_t::fromMillisSinceEpoch(1000) << "b" << 5 << "c" << 1),
+    BSON("a"
+         << "str"
+         << "b" << 1 << "c" << 1),
+};
+
+TEST(CompiledExpressionTest, ArithmeticMatchesTree) {
+    for (auto&& json : {"{$add: ['$a', {$multiply: ['$b', 2]}, 1]}",
+                        "{$add: ['$a', '$a']}",
+                        "{$multiply: ['$a', '$b', '$c']}",
+                        "{$subtract: [{$divide: ['$a', '$b']}, '$c']}",
+                        "{$subtract: ['$a', {$add: ['$b', '$c']}]}",
+                        "{$divide: [{$add: ['$a', 1]}, {$subtract: ['$b', '$b']}]}"}) {
+        assertCompiledMatchesTree(json, kNumericDocs);
+    }
+
+    // When both operands fail, e.g. with a non-numeric '$a', the error comes from the left one.
+    for (auto&& json : {"{$subtract: [{$add: ['$a', 1]}, {$divide: ['$b', {$subtract: ['$b', "
+                        "'$b']}]}]}",
+                        "{$divide: [{$add: ['$a', 1]}, {$divide: ['$b', {$subtract: ['$b', "
+                        "'$b']}]}]}"}) {
+        assertCompiledMatchesTree(json, kNumericDocs);
+    }
+}
+
+TEST(CompiledExpressionTest, ConditionalsAndLogicMatchTree) {
+    for (auto&& json : {"{$cond: [{$gt: ['$a', 1]}, '$b', '$c']}",
+                        "{$cond: [{$and: [{$gte: ['$a', 1]}, {$lt: ['$b', 2]}]}, 'yes', 'no']}",
+                        "{$cond: [{$or: [{$eq: ['$a', 1]}, '$b', {$not: ['$c']}]}, 'yes', 'no']}",
+                        "{$cond: {if: {$not: [{$lte: ['$a', '$b']}]}, then: {$add: ['$a', 1]}, "
+                        "else: {$multiply: ['$b', '$c']}}}",
+                        "{$cond: [{$cmp: ['$a', '$b']}, 'different', 'same']}",
+                        "{$cond: ['$a', '$b', '$c']}",
+                        "{$and: ['$a', {$ne: ['$b', 0]}, {$lt: ['$c', 2]}]}",
+                        "{$or: [{$gt: ['$a', 5]}, {$and: ['$b', {$not: ['$c']}]}]}",
+                        "{$and: ['$a']}",
+                        "{$not: [{$and: [{$eq: ['$a', 1]}, {$eq: ['$b', 2]}]}]}",
+                        "{$lt: [{$subtract: ['$a', '$b']}, '$c']}"}) {
+        assertCompiledMatchesTree(json, kNumericDocs);
+    }
+}
+
+TEST(CompiledExpressionTest, StopsEvaluatingOperandsAtTheFirstNull) {
+    // The division by zero is never evaluated when an earlier operand is null or missing.
+    for (auto&& json : {"{$add: ['$a', {$divide: [1, '$zero']}]}",
+                        "{$multiply: ['$a', {$divide: [1, '$zero']}]}"}) {
+        assertCompiledMatchesTree(json,
+                                  {BSON("a" << BSONNULL << "zero" << 0),
+                                   BSON("zero" << 0),
+                                   BSON("a" << 1 << "zero" << 0)});
+    }
+}
+
+TEST(CompiledExpressionTest, StopsEvaluatingOperandsAtTheFirstDecidingCondition) {
+    for (auto&& json : {"{$and: [{$gt: ['$a', 1]}, {$divide: [1, '$zero']}]}",
+                        "{$or: [{$gt: ['$a', 1]}, {$divide: [1, '$zero']}]}",
+                        "{$cond: [{$gt: ['$a', 1]}, {$divide: [1, '$zero']}, '$a']}"}) {
+        assertCompiledMatchesTree(json,
+                                  {BSON("a" << 0 << "zero" << 0), BSON("a" << 5 << "zero" << 0)});
+    }
+}
+
+TEST(CompiledExpressionTest, EvaluatesOtherOperatorsAsSubtrees) {
+    assertCompiledMatchesTree(
+        "{$cond: [{$gt: ['$n', 0]}, {$dateToString: {format: '%Y-%m-%d', date: '$d'}}, "
+        "{$concat: ['$s', '!']}]}",
+        {BSON("n" << 1 << "d" << Date_t::fromMillisSinceEpoch(86400 * 1000) << "s"
+                  << "x"),
+         BSON("n" << 0 << "s"
+                  << "x"),
+         BSON("n" << 1 << "d"
+                  << "not a date")});
+}
+
+TEST(CompiledExpressionTest, ComparesWithTheCurrentCollation) {
+    intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto compiled = CompiledExpression::compile(
+        parseAndOptimize(expCtx, "{$cond: [{$eq: ['$a', '$b']}, 'same', 'different']}"));
+    ASSERT(compiled);
+
+    Document doc{{"a", "x"_sd}, {"b", "y"_sd}};
+    ASSERT_VALUE_EQ(compiled->evaluate(doc, &expCtx->variables), Value("different"_sd));
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kAlwaysEqual);
+    expCtx->setCollator(&collator);
+    ASSERT_VALUE_EQ(compiled->evaluate(doc, &expCtx->variables), Value("same"_sd));
+}
+
+TEST(CompiledExpressionTest, ReadsConstantsInPlace) {
+    intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto compiled = CompiledExpression::compile(
+        parseAndOptimize(expCtx, "{$cond: [{$gt: ['$a', {$add: [1, 2]}]}, 'big', 'small']}"));
+    ASSERT(compiled);
+
+    // The folded constant 3 is read in place by the fused compare-and-jump, so the program only
+    // loads '$a', compares and jumps, moves one of the results and jumps over the other.
+    ASSERT_EQ(compiled->getNumInstructions(), 5U);
+    ASSERT_VALUE_EQ(compiled->evaluate(Document{{"a", 4}}, &expCtx->variables), Value("big"_sd));
+    ASSERT_VALUE_EQ(compiled->evaluate(Document{{"a", 3}}, &expCtx->variables),
+                    Value("small"_sd));
+}
+
+TEST(CompiledExpressionTest, DoesNotCompileWhatItCannotSpeedUp) {
+    intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    ASSERT_FALSE(CompiledExpression::compile(parseAndOptimize(expCtx, "{$add: [1, 2]}")));
+    ASSERT_FALSE(CompiledExpression::compile(parseAndOptimize(expCtx, "'$a.b'")));
+    ASSERT_FALSE(CompiledExpression::compile(
+        parseAndOptimize(expCtx, "{$dateToString: {format: '%Y', date: '$d'}}")));
+}
+
+TEST(CompiledExpressionTest, DoesNotCompileWhenDisabled) {
+    intrusive_ptr<ExpressionContextForTest> expCtx(new ExpressionContextForTest());
+    auto expression = parseAndOptimize(expCtx, "{$add: ['$a', 1]}");
+    ASSERT(CompiledExpression::compile(expression));
+
+    internalQueryEnableExpressionCompilation.store(false);
+    ON_BLOCK_EXIT([] { internalQueryEnableExpressionCompilation.store(true); });
+    ASSERT_FALSE(CompiledExpression::compile(expression));
+}
+
+}  // namespace
+}  // namespace mongo
@@ -41,6 +41,7 @@
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/catalog/database_holder.h"
 #include "mongo/db/catalog/index_catalog.h"
+#include "mongo/db/catalog/index_catalog_entry.h"
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
 #include "mongo/db/db_raii.h"
@@ -52,12 +53,15 @@
 #include "mongo/db/exec/trial_stage.h"
 #include "mongo/db/exec/working_set.h"
 #include "mongo/db/index/index_access_method.h"
+#include "mongo/db/index/index_descriptor.h"
 #include "mongo/db/matcher/extensions_callback_real.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/ops/write_ops_exec.h"
 #include "mongo/db/ops/write_ops_gen.h"
+#include "mongo/db/pipeline/column_cache.h"
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_change_stream.h"
+#include "mongo/db/pipeline/document_source_column_cache_scan.h"
 #include "mongo/db/pipeline/document_source_cursor.h"
 #include "mongo/db/pipeline/document_source_geo_near.h"
 #include "mongo/db/pipeline/document_source_geo_near_cursor.h"
@@ -71,8 +75,11 @@
 #include "mongo/db/query/collation/collator_interface.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/planner_ixselect.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/sort_pattern.h"
+#include "mongo/db/repl/read_concern_args.h"
 #include "mongo/db/s/collection_sharding_state.h"
 #include "mongo/db/s/operation_sharding_state.h"
 #include "mongo/db/service_context.h"
@@ -88,6 +95,7 @@
 #include "mongo/s/query/document_source_merge_cursors.h"
 #include "mongo/s/write_ops/cluster_write.h"
 #include "mongo/util/log.h"
+#include "mongo/util/str.h"
 #include "mongo/util/time_support.h"
 
 namespace mongo {
@@ -314,6 +322,115 @@ StringData extractGeoNearFieldFromIndexes(OperationContext* opCtx, Collection* c
     }
     MONGO_UNREACHABLE;
 }
+
+/**
+ * Returns true if an index of 'collection' could answer the initial $match or $sort of 'pipeline'.
+ * The query planner may then read only a fraction of the records, where a $columnCacheScan always
+ * reads all of them.
+ */
+bool hasIndexEligiblePredicateOrSort(Collection* collection, const Pipeline* pipeline) {
+    stdx::unordered_set<std::string> fields;
+    const auto& sources = pipeline->getSources();
+    auto sourcesIt = sources.begin();
+    if (sourcesIt != sources.end()) {
+        if (auto matchStage = dynamic_cast<DocumentSourceMatch*>(sourcesIt->get())) {
+            QueryPlannerIXSelect::getFields(matchStage->getMatchExpression(), &fields);
+            ++sourcesIt;
+        }
+    }
+    if (sourcesIt != sources.end()) {
+        if (auto sortStage = dynamic_cast<DocumentSourceSort*>(sourcesIt->get())) {
+            const auto& sortPattern = sortStage->getSortKeyPattern();
+            if (!sortPattern.empty() && sortPattern[0].fieldPath) {
+                fields.insert(sortPattern[0].fieldPath->fullPath());
+            }
+        }
+    }
+    if (fields.empty()) {
+        return false;
+    }
+
+    auto opCtx = pipeline->getContext()->opCtx;
+    auto ii = collection->getIndexCatalog()->getIndexIterator(opCtx, false);
+    while (ii->more()) {
+        const auto& keyPattern = ii->next()->descriptor()->keyPattern();
+        if (fields.count(keyPattern.firstElementFieldName())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Returns a $columnCacheScan stage to replace the $cursor stage of 'pipeline' if every field the
+ * pipeline depends on is kept in the column cache of 'collection' and no index could narrow down
+ * the records to read, or nullptr otherwise. Also returns nullptr while the cached columns of
+ * 'collection' are being rebuilt after a write.
+ */
+boost::intrusive_ptr<DocumentSource> buildColumnCacheScan(Collection* collection,
+                                                          const AggregationRequest* aggRequest,
+                                                          const Pipeline* pipeline) {
+    auto expCtx = pipeline->getContext();
+    auto opCtx = expCtx->opCtx;
+
+    const auto cachedFields = ColumnCache::get().getFields(collection->ns());
+    if (cachedFields.empty()) {
+        return nullptr;
+    }
+
+    // The cache only holds the latest committed version of each collection, so it can serve
+    // neither reads at a point in time nor reads within a transaction. It doesn't filter out orphan
+    // documents either, which rules out versioned operations on sharded collections.
+    const auto& readConcernArgs = repl::ReadConcernArgs::get(opCtx);
+    const auto readLevel = readConcernArgs.getLevel();
+    const auto readSource = opCtx->recoveryUnit()->getTimestampReadSource();
+    if (collection->isCapped() || expCtx->tailableMode != TailableModeEnum::kNormal ||
+        opCtx->inMultiDocumentTransaction() ||
+        (readLevel != repl::ReadConcernLevel::kLocalReadConcern &&
+         readLevel != repl::ReadConcernLevel::kAvailableReadConcern) ||
+        readConcernArgs.getArgsAfterClusterTime() || readConcernArgs.getArgsAtClusterTime() ||
+        (readSource != RecoveryUnit::ReadSource::kUnset &&
+         readSource != RecoveryUnit::ReadSource::kNoTimestamp) ||
+        OperationShardingState::isOperationVersioned(opCtx)) {
+        return nullptr;
+    }
+
+    // Leave $geoNear, $sample and $text to the stages that use an index or a random cursor.
+    const auto& sources = pipeline->getSources();
+    if (!sources.empty() &&
+        (dynamic_cast<DocumentSourceGeoNear*>(sources.front().get()) ||
+         dynamic_cast<DocumentSourceSample*>(sources.front().get()))) {
+        return nullptr;
+    }
+    if (DocumentSourceMatch::isTextQuery(pipeline->getInitialQuery())) {
+        return nullptr;
+    }
+
+    auto deps = pipeline->getDependencies(DepsTracker::kDefaultUnavailableMetadata);
+    if (deps.needWholeDocument || deps.getNeedsAnyMetadata()) {
+        return nullptr;
+    }
+    for (auto&& field : deps.fields) {
+        const auto topLevelField = str::before(field, '.');
+        if (std::find(cachedFields.begin(), cachedFields.end(), topLevelField) ==
+            cachedFields.end()) {
+            return nullptr;
+        }
+    }
+
+    // A hint asks the query planner for a particular plan, leave the pipeline to it.
+    if ((aggRequest && !aggRequest->getHint().isEmpty()) ||
+        hasIndexEligiblePredicateOrSort(collection, pipeline)) {
+        return nullptr;
+    }
+
+    auto snapshot = ColumnCache::get().getSnapshot(collection);
+    if (!snapshot) {
+        return nullptr;
+    }
+    return DocumentSourceColumnCacheScan::create(
+        expCtx, std::move(snapshot), deps.hasNoRequirements());
+}
 }  // namespace
 
 std::pair<PipelineD::AttachExecutorCallback, std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>>
@@ -333,6 +450,16 @@ PipelineD::buildInnerQueryExecutor(Collection* collection,
     // We are going to generate an input cursor, so we need to be holding the collection lock.
     dassert(expCtx->opCtx->lockState()->isCollectionLockedForMode(nss, MODE_IS));
 
+    // Answer the pipeline from the column cache if it holds every field the pipeline needs and no
+    // index applies. The initial $match and $sort then run in the pipeline rather than in the
+    // PlanExecutor.
+    if (collection) {
+        if (auto columnCacheScan = buildColumnCacheScan(collection, aggRequest, pipeline)) {
+            pipeline->addInitialSource(std::move(columnCacheScan));
+            return {};
+        }
+    }
+
     if (!sources.empty()) {
         auto sampleStage = dynamic_cast<DocumentSourceSample*>(sources.front().get());
         // Optimize an initial $sample stage if possible.
@@ -665,6 +792,11 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prep
         // stream sort keys from 4.2 and earlier.
         invariant(aggRequest);
         expCtx->use42ChangeStreamSortKeys = !aggRequest->getUse44SortKeys();
+    } else if (internalQueryParallelCollectionScanWorkers.load() > 1 &&
+               !expCtx->opCtx->inMultiDocumentTransaction()) {
+        // Worker threads cannot see the writes of a multi-document transaction, so only scans
+        // outside of one may be split between them.
+        plannerOpts |= QueryPlannerParams::ALLOW_PARALLEL_COLLSCAN;
     }
 
     // If there is a sort stage eligible for pushdown, serialize its SortPattern to a BSONObj. The
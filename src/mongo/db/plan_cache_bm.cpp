@@ -0,0 +1,123 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <map>
+#include <vector>
+
+#include "mongo/db/matcher/extensions_callback_noop.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/plan_ranker.h"
+#include "mongo/db/query/query_solution.h"
+#include "mongo/db/query/query_test_service_context.h"
+
+namespace mongo {
+namespace {
+
+const size_t kCacheSize = 5000;
+const size_t kNumShapes = 256;
+
+std::unique_ptr<PlanRankingDecision> makeDecision() {
+    auto why = std::make_unique<PlanRankingDecision>();
+    auto stats = std::make_unique<PlanStageStats>(CommonStats("COLLSCAN"), STAGE_COLLSCAN);
+    stats->specific = std::make_unique<CollectionScanStats>();
+    why->stats.push_back(std::move(stats));
+    why->scores.push_back(0);
+    why->candidateOrder.push_back(0);
+    return why;
+}
+
+/**
+ * Plan caches split into different numbers of partitions, each holding an active entry for the
+ * same 'kNumShapes' query shapes. Built once and shared by all benchmark threads.
+ */
+struct PlanCacheFixture {
+    PlanCacheFixture() {
+        auto opCtx = serviceContext.makeOperationContext();
+        for (size_t i = 0; i < kNumShapes; ++i) {
+            auto qr = std::make_unique<QueryRequest>(NamespaceString("test.coll"));
+            qr->setFilter(BSON("a" + std::to_string(i) << 1));
+            queries.push_back(uassertStatusOK(
+                CanonicalQuery::canonicalize(opCtx.get(), std::move(qr))));
+        }
+
+        for (size_t numPartitions : {1, 16}) {
+            auto cache = std::make_unique<PlanCache>(kCacheSize, numPartitions);
+            for (auto&& cq : queries) {
+                auto soln = std::make_unique<QuerySolution>();
+                soln->cacheData = std::make_unique<SolutionCacheData>();
+                soln->cacheData->tree = std::make_unique<PlanCacheIndexTree>();
+                std::vector<QuerySolution*> solns = {soln.get()};
+
+                // The first set() creates an inactive entry, and the second activates it.
+                uassertStatusOK(cache->set(*cq, solns, makeDecision(), Date_t{}));
+                uassertStatusOK(cache->set(*cq, solns, makeDecision(), Date_t{}));
+            }
+            caches[numPartitions] = std::move(cache);
+        }
+
+        for (auto&& cq : queries) {
+            keys.push_back(caches.begin()->second->computeKey(*cq));
+        }
+    }
+
+    QueryTestServiceContext serviceContext;
+    std::vector<std::unique_ptr<CanonicalQuery>> queries;
+    std::map<size_t, std::unique_ptr<PlanCache>> caches;
+    std::vector<PlanCacheKey> keys;
+};
+
+const PlanCacheFixture& getFixture() {
+    static const PlanCacheFixture fixture;
+    return fixture;
+}
+
+/**
+ * Looks up cached plans from many threads at once, as concurrent finds of different shapes on one
+ * collection do. state.range(0) is the number of partitions of the cache.
+ */
+void BM_PlanCacheGet(benchmark::State& state) {
+    const auto& fixture = getFixture();
+    const PlanCache& cache = *fixture.caches.at(state.range(0));
+
+    size_t i = state.thread_index * 7;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(cache.get(fixture.keys[i++ % fixture.keys.size()]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_PlanCacheGet)->ArgName("partitions")->Arg(1)->Arg(16)->ThreadRange(1, 16);
+
+}  // namespace
+}  // namespace mongo
@@ -176,6 +176,33 @@ TEST(LRUKeyValueTest, ReplaceKeyTest) {
     assertInKVStore(cache, 4, 5);
 }
 
+/**
+ * Test that removeLeastRecentlyUsed() hands back entries in
+ * least recently used order, taking get() into account.
+ */
+TEST(LRUKeyValueTest, RemoveLeastRecentlyUsedTest) {
+    LRUKeyValue<int, int> cache(10);
+    ASSERT(nullptr == cache.removeLeastRecentlyUsed().get());
+
+    cache.add(1, new int(1));
+    cache.add(2, new int(2));
+    cache.add(3, new int(3));
+    assertInKVStore(cache, 1, 1);
+
+    std::unique_ptr<int> removed = cache.removeLeastRecentlyUsed();
+    ASSERT(nullptr != removed.get());
+    ASSERT_EQUALS(*removed, 2);
+    assertNotInKVStore(cache, 2);
+    ASSERT_EQUALS(cache.size(), 2U);
+
+    removed = cache.removeLeastRecentlyUsed();
+    ASSERT_EQUALS(*removed, 3);
+    removed = cache.removeLeastRecentlyUsed();
+    ASSERT_EQUALS(*removed, 1);
+    ASSERT_EQUALS(cache.size(), 0U);
+    ASSERT(nullptr == cache.removeLeastRecentlyUsed().get());
+}
+
 /**
  * Test iteration over the kv-store.
  */
@@ -62,6 +62,19 @@ namespace {
 ServerStatusMetricField<Counter64> totalPlanCacheSizeEstimateBytesMetric(
     "query.planCacheTotalSizeEstimateBytes", &PlanCacheEntry::planCacheTotalSizeEstimateBytes);
 
+// Entries evicted to keep a plan cache within its byte budget, and entries which were not cached
+// at all because they alone exceeded the budget of their partition.
+Counter64 planCacheEvictedForSize;
+ServerStatusMetricField<Counter64> planCacheEvictedForSizeMetric(
+    "query.planCacheEntriesEvictedForSize", &planCacheEvictedForSize);
+Counter64 planCacheTooLargeToCache;
+ServerStatusMetricField<Counter64> planCacheTooLargeToCacheMetric(
+    "query.planCacheEntriesTooLargeToCache", &planCacheTooLargeToCache);
+
+// Splitting a small cache would make its eviction order noticeably different from LRU, so every
+// partition is given at least this many entries.
+const size_t kMinEntriesPerPartition = 64;
+
 // Delimiters for cache key encoding.
 const char kEncodeDiscriminatorsBegin = '<';
 const char kEncodeDiscriminatorsEnd = '>';
@@ -430,7 +443,20 @@ std::string SolutionCacheData::toString() const {
 
 PlanCache::PlanCache() : PlanCache(internalQueryCacheSize.load()) {}
 
-PlanCache::PlanCache(size_t size) : _cache(size) {}
+PlanCache::PlanCache(size_t size)
+    : PlanCache(size,
+                std::min(static_cast<size_t>(internalQueryCachePartitions.load()),
+                         std::max(size / kMinEntriesPerPartition, size_t(1)))) {}
+
+PlanCache::PlanCache(size_t size, size_t numPartitions) {
+    invariant(numPartitions > 0);
+
+    // Spread 'size' over the partitions such that their capacities add up to it exactly.
+    for (size_t i = 0; i < numPartitions; ++i) {
+        const size_t partitionSize = size / numPartitions + (i < size % numPartitions ? 1 : 0);
+        _partitions.push_back(std::make_unique<Partition>(partitionSize));
+    }
+}
 
 PlanCache::~PlanCache() {}
 
@@ -553,7 +579,11 @@ Status PlanCache::set(const CanonicalQuery& query,
 
     const auto key = computeKey(query);
     const size_t newWorks = why->stats[0]->common.works;
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
+    auto& partition = getPartition(key);
+    stdx::lock_guard<Latch> cacheLock(partition.mutex);
+    PlanCacheEntry* oldEntry = nullptr;
+    Status cacheStatus = partition.cache.get(key, &oldEntry);
+    invariant(cacheStatus.isOK() || cacheStatus == ErrorCodes::NoSuchKey);
     bool isNewEntryActive = false;
     uint32_t queryHash;
     uint32_t planCacheKey;
@@ -563,9 +593,6 @@ Status PlanCache::set(const CanonicalQuery& query,
         planCacheKey = canonical_query_encoder::computeHash(key.stringData());
         queryHash = canonical_query_encoder::computeHash(key.getStableKeyStringData());
     } else {
-        PlanCacheEntry* oldEntry = nullptr;
-        Status cacheStatus = _cache.get(key, &oldEntry);
-        invariant(cacheStatus.isOK() || cacheStatus == ErrorCodes::NoSuchKey);
         if (oldEntry) {
             queryHash = oldEntry->queryHash;
             planCacheKey = oldEntry->planCacheKey;
@@ -591,13 +618,40 @@ Status PlanCache::set(const CanonicalQuery& query,
     auto newEntry(PlanCacheEntry::create(
         solns, std::move(why), query, queryHash, planCacheKey, now, isNewEntryActive, newWorks));
 
-    std::unique_ptr<PlanCacheEntry> evictedEntry = _cache.add(key, newEntry.release());
+    // An entry which can't fit in its partition even when alone would only flush out everything
+    // else before being evicted itself, so it isn't cached. Any entry it would have replaced is
+    // left in place.
+    const uint64_t budgetBytes = getPartitionBudgetBytes();
+    const uint64_t newEntryBytes = newEntry->estimatedEntrySizeBytes();
+    if (budgetBytes > 0 && newEntryBytes > budgetBytes) {
+        planCacheTooLargeToCache.increment();
+        LOG(1) << query.nss() << ": not caching plan of estimated size " << newEntryBytes
+               << " bytes, which exceeds the plan cache partition budget of " << budgetBytes
+               << " bytes: " << redact(newEntry->toString());
+        return Status::OK();
+    }
+
+    // add() deletes the entry being replaced, so its size is read beforehand.
+    partition.sizeBytes -= oldEntry ? oldEntry->estimatedEntrySizeBytes() : 0;
+    partition.sizeBytes += newEntryBytes;
+    std::unique_ptr<PlanCacheEntry> evictedEntry = partition.cache.add(key, newEntry.release());
 
     if (nullptr != evictedEntry.get()) {
+        partition.sizeBytes -= evictedEntry->estimatedEntrySizeBytes();
         LOG(1) << query.nss() << ": plan cache maximum size exceeded - "
                << "removed least recently used entry " << redact(evictedEntry->toString());
     }
 
+    // The new entry is the most recently used and fits on its own, so this never evicts it.
+    while (budgetBytes > 0 && partition.sizeBytes > budgetBytes) {
+        evictedEntry = partition.cache.removeLeastRecentlyUsed();
+        invariant(evictedEntry);
+        partition.sizeBytes -= evictedEntry->estimatedEntrySizeBytes();
+        planCacheEvictedForSize.increment();
+        LOG(1) << query.nss() << ": plan cache maximum size in bytes exceeded - "
+               << "removed least recently used entry " << redact(evictedEntry->toString());
+    }
+
     return Status::OK();
 }
 
@@ -608,9 +662,10 @@ void PlanCache::deactivate(const CanonicalQuery& query) {
     }
 
     PlanCacheKey key = computeKey(query);
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
+    auto& partition = getPartition(key);
+    stdx::lock_guard<Latch> cacheLock(partition.mutex);
     PlanCacheEntry* entry = nullptr;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = partition.cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         invariant(cacheStatus == ErrorCodes::NoSuchKey);
         return;
@@ -625,9 +680,10 @@ PlanCache::GetResult PlanCache::get(const CanonicalQuery& query) const {
 }
 
 PlanCache::GetResult PlanCache::get(const PlanCacheKey& key) const {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
+    auto& partition = getPartition(key);
+    stdx::lock_guard<Latch> cacheLock(partition.mutex);
     PlanCacheEntry* entry = nullptr;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = partition.cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         invariant(cacheStatus == ErrorCodes::NoSuchKey);
         return {CacheEntryState::kNotPresent, nullptr};
@@ -642,9 +698,10 @@ PlanCache::GetResult PlanCache::get(const PlanCacheKey& key) const {
 Status PlanCache::feedback(const CanonicalQuery& cq, double score) {
     PlanCacheKey ck = computeKey(cq);
 
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
+    auto& partition = getPartition(ck);
+    stdx::lock_guard<Latch> cacheLock(partition.mutex);
     PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(ck, &entry);
+    Status cacheStatus = partition.cache.get(ck, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
@@ -659,13 +716,26 @@ Status PlanCache::feedback(const CanonicalQuery& cq, double score) {
 }
 
 Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
-    return _cache.remove(computeKey(canonicalQuery));
+    PlanCacheKey key = computeKey(canonicalQuery);
+    auto& partition = getPartition(key);
+    stdx::lock_guard<Latch> cacheLock(partition.mutex);
+    PlanCacheEntry* entry = nullptr;
+    Status cacheStatus = partition.cache.get(key, &entry);
+    if (!cacheStatus.isOK()) {
+        return cacheStatus;
+    }
+    invariant(entry);
+
+    partition.sizeBytes -= entry->estimatedEntrySizeBytes();
+    return partition.cache.remove(key);
 }
 
 void PlanCache::clear() {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
-    _cache.clear();
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<Latch> cacheLock(partition->mutex);
+        partition->cache.clear();
+        partition->sizeBytes = 0;
+    }
 }
 
 PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
@@ -679,9 +749,10 @@ PlanCacheKey PlanCache::computeKey(const CanonicalQuery& cq) const {
 StatusWith<std::unique_ptr<PlanCacheEntry>> PlanCache::getEntry(const CanonicalQuery& query) const {
     PlanCacheKey key = computeKey(query);
 
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
+    auto& partition = getPartition(key);
+    stdx::lock_guard<Latch> cacheLock(partition.mutex);
     PlanCacheEntry* entry;
-    Status cacheStatus = _cache.get(key, &entry);
+    Status cacheStatus = partition.cache.get(key, &entry);
     if (!cacheStatus.isOK()) {
         return cacheStatus;
     }
@@ -691,20 +762,37 @@ StatusWith<std::unique_ptr<PlanCacheEntry>> PlanCache::getEntry(const CanonicalQ
 }
 
 std::vector<std::unique_ptr<PlanCacheEntry>> PlanCache::getAllEntries() const {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
     std::vector<std::unique_ptr<PlanCacheEntry>> entries;
 
-    for (auto&& cacheEntry : _cache) {
-        auto entry = cacheEntry.second;
-        entries.push_back(std::unique_ptr<PlanCacheEntry>(entry->clone()));
+    // Partitions are visited one at a time, so the result need not be a consistent snapshot of
+    // the whole cache.
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<Latch> cacheLock(partition->mutex);
+        for (auto&& cacheEntry : partition->cache) {
+            auto entry = cacheEntry.second;
+            entries.push_back(std::unique_ptr<PlanCacheEntry>(entry->clone()));
+        }
     }
 
     return entries;
 }
 
 size_t PlanCache::size() const {
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
-    return _cache.size();
+    size_t size = 0;
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<Latch> cacheLock(partition->mutex);
+        size += partition->cache.size();
+    }
+    return size;
+}
+
+uint64_t PlanCache::sizeBytes() const {
+    uint64_t sizeBytes = 0;
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<Latch> cacheLock(partition->mutex);
+        sizeBytes += partition->sizeBytes;
+    }
+    return sizeBytes;
 }
 
 void PlanCache::notifyOfIndexUpdates(const std::vector<CoreIndexInfo>& indexCores) {
@@ -715,17 +803,36 @@ std::vector<BSONObj> PlanCache::getMatchingStats(
     const std::function<BSONObj(const PlanCacheEntry&)>& serializationFunc,
     const std::function<bool(const BSONObj&)>& filterFunc) const {
     std::vector<BSONObj> results;
-    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
 
-    for (auto&& cacheEntry : _cache) {
-        const auto entry = cacheEntry.second;
-        auto serializedEntry = serializationFunc(*entry);
-        if (filterFunc(serializedEntry)) {
-            results.push_back(serializedEntry);
+    for (auto&& partition : _partitions) {
+        stdx::lock_guard<Latch> cacheLock(partition->mutex);
+        for (auto&& cacheEntry : partition->cache) {
+            const auto entry = cacheEntry.second;
+            auto serializedEntry = serializationFunc(*entry);
+            if (filterFunc(serializedEntry)) {
+                results.push_back(serializedEntry);
+            }
         }
     }
 
     return results;
 }
 
+PlanCache::Partition& PlanCache::getPartition(const PlanCacheKey& key) const {
+    if (_partitions.size() == 1) {
+        return *_partitions.front();
+    }
+    return *_partitions[PlanCacheKeyHasher{}(key) % _partitions.size()];
+}
+
+uint64_t PlanCache::getPartitionBudgetBytes() const {
+    // Read on every insertion so that changes to the knob apply to existing caches. A non-zero
+    // budget always leaves each partition at least one byte, so 0 keeps meaning "no budget".
+    const long long budgetBytes = internalQueryCacheMaxSizeBytes.load();
+    if (budgetBytes <= 0) {
+        return 0;
+    }
+    return std::max(static_cast<uint64_t>(budgetBytes) / _partitions.size(), uint64_t(1));
+}
+
 }  // namespace mongo
@@ -378,6 +378,14 @@ public:
     // cause this value to be increased.
     size_t works = 0;
 
+    /**
+     * Returns the estimated deep size of this entry in bytes, including its SolutionCacheData
+     * trees. This is what the entry is charged against the plan cache's memory budget.
+     */
+    uint64_t estimatedEntrySizeBytes() const {
+        return _entireObjectSize;
+    }
+
     /**
      * Tracks the approximate cumulative size of the plan cache entries across all the collections.
      */
@@ -461,8 +469,19 @@ public:
      */
     PlanCache();
 
+    /**
+     * Creates a cache which holds up to 'size' entries, spread over the number of partitions
+     * named by 'internalQueryCachePartitions'.
+     */
     PlanCache(size_t size);
 
+    /**
+     * Creates a cache which holds up to 'size' entries, spread over 'numPartitions' partitions.
+     * Each partition is latched and evicts its least recently used entry independently, so the
+     * cache as a whole only approximates LRU order when there is more than one.
+     */
+    PlanCache(size_t size, size_t numPartitions);
+
     ~PlanCache();
 
     /**
@@ -477,7 +496,12 @@ public:
      * an inactive cache entry.  If boost::none is provided, the function will use
      * 'internalQueryCacheWorksGrowthCoefficient'.
      *
-     * If the mapping was set successfully, returns Status::OK(), even if it evicted another entry.
+     * Entries are evicted in least recently used order to keep the cache within both its entry
+     * count and the byte budget named by 'internalQueryCacheMaxSizeBytes'. An entry estimated to
+     * be larger than a partition's share of that budget is not cached.
+     *
+     * If the mapping was set successfully, returns Status::OK(), even if it evicted another entry
+     * or the entry was too large to be cached.
      */
     Status set(const CanonicalQuery& query,
                const std::vector<QuerySolution*>& solns,
@@ -572,6 +596,19 @@ public:
      */
     size_t size() const;
 
+    /**
+     * Returns the estimated number of bytes held by the entries in the cache. See
+     * PlanCacheEntry::estimatedEntrySizeBytes().
+     */
+    uint64_t sizeBytes() const;
+
+    /**
+     * Returns the number of partitions the cache is split into.
+     */
+    size_t numPartitions() const {
+        return _partitions.size();
+    }
+
     /**
      * Updates internal state kept about the collection's indexes.  Must be called when the set
      * of indexes on the associated collection have changed.
@@ -601,10 +638,34 @@ private:
                                    size_t newWorks,
                                    double growthCoefficient);
 
-    LRUKeyValue<PlanCacheKey, PlanCacheEntry, PlanCacheKeyHasher> _cache;
+    /**
+     * The slice of the cache holding the entries whose keys hash to it. Lookups of different query
+     * shapes usually land in different partitions, and so don't contend on the same latch.
+     */
+    struct Partition {
+        explicit Partition(size_t size) : cache(size) {}
+
+        LRUKeyValue<PlanCacheKey, PlanCacheEntry, PlanCacheKeyHasher> cache;
+
+        // The sum of the estimated sizes of the entries in 'cache'.
+        uint64_t sizeBytes = 0;
+
+        // Protects 'cache' and 'sizeBytes'.
+        mutable Mutex mutex = MONGO_MAKE_LATCH("PlanCache::Partition::mutex");
+    };
+
+    /**
+     * Returns the partition which holds the entry for 'key', if there is one.
+     */
+    Partition& getPartition(const PlanCacheKey& key) const;
+
+    /**
+     * Returns the number of bytes each partition may hold, or 0 if there is no byte budget.
+     */
+    uint64_t getPartitionBudgetBytes() const;
 
-    // Protects _cache.
-    mutable Mutex _cacheMutex = MONGO_MAKE_LATCH("PlanCache::_cacheMutex");
+    // Never empty.
+    std::vector<std::unique_ptr<Partition>> _partitions;
 
     // Holds computed information about the collection's indexes.  Used for generating plan
     // cache keys.
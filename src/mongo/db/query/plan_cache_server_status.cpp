@@ -0,0 +1,90 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/collection_catalog.h"
+#include "mongo/db/catalog/collection_catalog_helper.h"
+#include "mongo/db/commands/server_status.h"
+#include "mongo/db/concurrency/d_concurrency.h"
+#include "mongo/db/query/collection_query_info.h"
+#include "mongo/db/query/plan_cache.h"
+#include "mongo/db/query/query_knobs_gen.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Reports the estimated memory held by the plan cache of every collection which has cached plans,
+ * along with the byte budget each of them is held to. Visiting every collection takes its lock, so
+ * the section is only produced when asked for with {planCache: 1}.
+ */
+class PlanCacheServerStatusSection final : public ServerStatusSection {
+public:
+    PlanCacheServerStatusSection() : ServerStatusSection("planCache") {}
+
+    bool includeByDefault() const override {
+        return false;
+    }
+
+    BSONObj generateSection(OperationContext* opCtx,
+                            const BSONElement& configElement) const override {
+        BSONObjBuilder builder;
+        builder.append("totalSizeEstimateBytes",
+                       PlanCacheEntry::planCacheTotalSizeEstimateBytes.get());
+        builder.append("maxSizeBytesPerCollection", internalQueryCacheMaxSizeBytes.load());
+
+        BSONObjBuilder collectionsBuilder(builder.subobjStart("collections"));
+        for (auto&& dbName : CollectionCatalog::get(opCtx).getAllDbNames()) {
+            Lock::DBLock dbLock(opCtx, dbName, MODE_IS);
+            catalog::forEachCollectionFromDb(
+                opCtx, dbName, MODE_IS, [&](const Collection* collection) {
+                    const auto planCache = CollectionQueryInfo::get(collection).getPlanCache();
+                    const auto numEntries = planCache->size();
+                    if (numEntries > 0) {
+                        BSONObjBuilder collBuilder(
+                            collectionsBuilder.subobjStart(collection->ns().ns()));
+                        collBuilder.append("entries", static_cast<long long>(numEntries));
+                        collBuilder.append("sizeBytes",
+                                           static_cast<long long>(planCache->sizeBytes()));
+                    }
+                    return true;
+                });
+        }
+        collectionsBuilder.doneFast();
+
+        return builder.obj();
+    }
+} planCacheServerStatusSection;
+
+}  // namespace
+}  // namespace mongo
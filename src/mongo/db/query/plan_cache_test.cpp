@@ -568,6 +568,139 @@ TEST(PlanCacheTest, PlanCacheLRUPolicyRemovesInactiveEntries) {
     ASSERT_EQ(planCache.get(*cqC).state, PlanCache::CacheEntryState::kPresentInactive);
 }
 
+TEST(PlanCacheTest, PlanCacheDefaultPartitionCountDependsOnSize) {
+    // Tiny caches keep a single partition, and so exact LRU eviction.
+    ASSERT_EQ(PlanCache(2).numPartitions(), 1U);
+
+    // Large enough to give every partition well over its minimum share of entries.
+    const size_t numPartitions = internalQueryCachePartitions.load();
+    ASSERT_EQ(PlanCache(numPartitions * 1000).numPartitions(), numPartitions);
+}
+
+TEST(PlanCacheTest, PartitionedPlanCacheHoldsAndReportsEntriesOfAllPartitions) {
+    PlanCache planCache(1000, 8);
+    ASSERT_EQ(planCache.numPartitions(), 8U);
+
+    const size_t kNumShapes = 50;
+    std::vector<unique_ptr<CanonicalQuery>> queries;
+    for (size_t i = 0; i < kNumShapes; ++i) {
+        queries.push_back(canonicalize(BSON("a" + std::to_string(i) << 1)));
+        addCacheEntryForShape(*queries.back(), &planCache);
+    }
+
+    ASSERT_EQ(planCache.size(), kNumShapes);
+    ASSERT_EQ(planCache.getAllEntries().size(), kNumShapes);
+    auto stats = planCache.getMatchingStats(
+        [](const PlanCacheEntry& entry) { return entry.query; },
+        [](const BSONObj&) { return true; });
+    ASSERT_EQ(stats.size(), kNumShapes);
+    for (auto&& cq : queries) {
+        ASSERT_EQ(planCache.get(*cq).state, PlanCache::CacheEntryState::kPresentInactive);
+    }
+
+    ASSERT_OK(planCache.remove(*queries.front()));
+    ASSERT_EQ(planCache.get(*queries.front()).state, PlanCache::CacheEntryState::kNotPresent);
+    ASSERT_EQ(planCache.size(), kNumShapes - 1);
+
+    planCache.clear();
+    ASSERT_EQ(planCache.size(), 0U);
+}
+
+TEST(PlanCacheTest, PartitionedPlanCacheNeverExceedsItsSize) {
+    const size_t kCacheSize = 10;
+    PlanCache planCache(kCacheSize, 4);
+
+    for (size_t i = 0; i < 100; ++i) {
+        auto cq = canonicalize(BSON("a" + std::to_string(i) << 1));
+        addCacheEntryForShape(*cq, &planCache);
+        ASSERT_LTE(planCache.size(), kCacheSize);
+    }
+}
+
+TEST(PlanCacheTest, PlanCacheTracksEstimatedSizeOfItsEntries) {
+    PlanCache planCache(1000, 4);
+    ASSERT_EQ(planCache.sizeBytes(), 0U);
+
+    std::vector<unique_ptr<CanonicalQuery>> queries;
+    for (size_t i = 0; i < 20; ++i) {
+        queries.push_back(canonicalize(BSON("a" + std::to_string(i) << 1)));
+        addCacheEntryForShape(*queries.back(), &planCache);
+    }
+
+    auto sumOfEntrySizes = [&] {
+        uint64_t sizeBytes = 0;
+        for (auto&& entry : planCache.getAllEntries()) {
+            sizeBytes += entry->estimatedEntrySizeBytes();
+        }
+        return sizeBytes;
+    };
+    ASSERT_GT(planCache.sizeBytes(), 0U);
+    ASSERT_EQ(planCache.sizeBytes(), sumOfEntrySizes());
+
+    // Replacing an entry swaps its size for that of the new one.
+    addCacheEntryForShape(*queries.front(), &planCache);
+    ASSERT_EQ(planCache.sizeBytes(), sumOfEntrySizes());
+
+    ASSERT_OK(planCache.remove(*queries.back()));
+    ASSERT_EQ(planCache.sizeBytes(), sumOfEntrySizes());
+
+    planCache.clear();
+    ASSERT_EQ(planCache.sizeBytes(), 0U);
+}
+
+TEST(PlanCacheTest, PlanCacheEvictsLeastRecentlyUsedEntriesToStayWithinByteBudget) {
+    const long long oldMaxSizeBytes = internalQueryCacheMaxSizeBytes.load();
+    ON_BLOCK_EXIT([oldMaxSizeBytes] { internalQueryCacheMaxSizeBytes.store(oldMaxSizeBytes); });
+
+    // Measure an entry with no budget in place, then leave room for about five of them.
+    internalQueryCacheMaxSizeBytes.store(0);
+    PlanCache planCache(1000, 1);
+    auto first = canonicalize(BSON("a0" << 1));
+    addCacheEntryForShape(*first, &planCache);
+    const uint64_t entrySizeBytes = planCache.sizeBytes();
+    const uint64_t budgetBytes = 5 * entrySizeBytes + entrySizeBytes / 2;
+    internalQueryCacheMaxSizeBytes.store(budgetBytes);
+
+    const size_t kNumShapes = 50;
+    unique_ptr<CanonicalQuery> last;
+    for (size_t i = 1; i < kNumShapes; ++i) {
+        last = canonicalize(BSON("a" + std::to_string(i) << 1));
+        addCacheEntryForShape(*last, &planCache);
+        ASSERT_LTE(planCache.sizeBytes(), budgetBytes);
+    }
+
+    // The entry count limit alone would have kept every shape.
+    ASSERT_GTE(planCache.size(), 4U);
+    ASSERT_LT(planCache.size(), kNumShapes);
+    ASSERT_EQ(planCache.get(*first).state, PlanCache::CacheEntryState::kNotPresent);
+    ASSERT_EQ(planCache.get(*last).state, PlanCache::CacheEntryState::kPresentInactive);
+}
+
+TEST(PlanCacheTest, PlanCacheDoesNotCacheEntryLargerThanItsByteBudget) {
+    const long long oldMaxSizeBytes = internalQueryCacheMaxSizeBytes.load();
+    ON_BLOCK_EXIT([oldMaxSizeBytes] { internalQueryCacheMaxSizeBytes.store(oldMaxSizeBytes); });
+
+    internalQueryCacheMaxSizeBytes.store(0);
+    PlanCache planCache(1000, 1);
+    auto small = canonicalize(BSON("a" << 1));
+    addCacheEntryForShape(*small, &planCache);
+    const uint64_t smallEntrySizeBytes = planCache.sizeBytes();
+    internalQueryCacheMaxSizeBytes.store(2 * smallEntrySizeBytes);
+
+    // A shape with a large $in list carries the whole list in its cached query.
+    BSONArrayBuilder inList;
+    for (int i = 0; i < 10000; ++i) {
+        inList.append(i);
+    }
+    auto large = canonicalize(BSON("b" << BSON("$in" << inList.arr())));
+    addCacheEntryForShape(*large, &planCache);
+
+    ASSERT_EQ(planCache.get(*large).state, PlanCache::CacheEntryState::kNotPresent);
+    ASSERT_EQ(planCache.get(*small).state, PlanCache::CacheEntryState::kPresentInactive);
+    ASSERT_EQ(planCache.size(), 1U);
+    ASSERT_EQ(planCache.sizeBytes(), smallEntrySizeBytes);
+}
+
 TEST(PlanCacheTest, PlanCacheRemoveDeletesInactiveEntries) {
     PlanCache planCache;
     unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
@@ -54,6 +54,7 @@
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/mock_yield_policies.h"
 #include "mongo/db/query/plan_yield_policy.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/service_context.h"
 #include "mongo/util/fail_point.h"
@@ -504,6 +505,45 @@ PlanExecutor::ExecState PlanExecutorImpl::_waitForInserts(CappedInsertNotifierDa
     return FAILURE;
 }
 
+PlanStage::StageState PlanExecutorImpl::_workRoot(WorkingSetID* out) {
+    if (!_batchedResults.empty()) {
+        *out = _batchedResults.front();
+        _batchedResults.pop();
+        return PlanStage::ADVANCED;
+    }
+
+    if (_batchedResultsEndState) {
+        auto endState = *_batchedResultsEndState;
+        _batchedResultsEndState = boost::none;
+        *out = endState.second;
+        return endState.first;
+    }
+
+    const auto batchSize = internalQueryExecBatchSize.load();
+    if (batchSize <= 1) {
+        return _root->work(out);
+    }
+
+    _workBatch.clear();
+    const auto code = _root->workBatch(batchSize, &_workBatch);
+    invariant(PlanStage::ADVANCED != code || !_workBatch.ids.empty());
+    if (_workBatch.ids.empty()) {
+        *out = _workBatch.statusId;
+        return code;
+    }
+
+    for (auto&& id : _workBatch.ids) {
+        _batchedResults.push(id);
+    }
+    if (PlanStage::ADVANCED != code && PlanStage::NEED_TIME != code) {
+        _batchedResultsEndState = std::make_pair(code, _workBatch.statusId);
+    }
+
+    *out = _batchedResults.front();
+    _batchedResults.pop();
+    return PlanStage::ADVANCED;
+}
+
 PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<Document>* objOut,
                                                        RecordId* dlOut) {
     if (MONGO_unlikely(planExecutorAlwaysFails.shouldFail())) {
@@ -531,7 +571,7 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<Document>* ob
         return PlanExecutor::ADVANCED;
     }
 
-    // Incremented on every writeConflict, reset to 0 on any successful call to _root->work.
+    // Incremented on every writeConflict, reset to 0 on any successful call to _workRoot().
     size_t writeConflictsInARow = 0;
 
     // Capped insert data; declared outside the loop so we hold a shared pointer to the capped
@@ -560,7 +600,7 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<Document>* ob
         }
 
         WorkingSetID id = WorkingSet::INVALID_ID;
-        PlanStage::StageState code = _root->work(&id);
+        PlanStage::StageState code = _workRoot(&id);
 
         if (code != PlanStage::NEED_YIELD)
             writeConflictsInARow = 0;
@@ -657,7 +697,11 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<Document>* ob
 
 bool PlanExecutorImpl::isEOF() {
     invariant(_currentState == kUsable);
-    return isMarkedAsKilled() || (_stash.empty() && _root->isEOF());
+    // A batch may have left '_root' at EOF with results still buffered, or with a failure still to
+    // be reported once they have been consumed.
+    const bool batchDrained = _batchedResults.empty() &&
+        (!_batchedResultsEndState || _batchedResultsEndState->first == PlanStage::IS_EOF);
+    return isMarkedAsKilled() || (_stash.empty() && batchDrained && _root->isEOF());
 }
 
 void PlanExecutorImpl::markAsKilled(Status killStatus) {
@@ -32,6 +32,7 @@
 #include <boost/optional.hpp>
 #include <queue>
 
+#include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/query/plan_executor.h"
 
 namespace mongo {
@@ -155,6 +156,13 @@ private:
      */
     ExecState _getNextImpl(Snapshotted<Document>* objOut, RecordId* dlOut);
 
+    /**
+     * Asks '_root' for its next unit of output, with the same contract as PlanStage::work(). When
+     * batched execution is enabled, results are requested from the plan in batches and handed out
+     * one at a time from '_batchedResults'.
+     */
+    PlanStage::StageState _workRoot(WorkingSetID* out);
+
     // The OperationContext that we're executing within. This can be updated if necessary by using
     // detachFromOperationContext() and reattachToOperationContext().
     OperationContext* _opCtx;
@@ -189,6 +197,13 @@ private:
     // stages.
     std::queue<Document> _stash;
 
+    // Results produced by a call to workBatch() on '_root' that have not been returned yet. If the
+    // batch ended in a state other than ADVANCED or NEED_TIME, that state and its accompanying
+    // WorkingSetID are reported once the buffered results have been consumed.
+    std::queue<WorkingSetID> _batchedResults;
+    boost::optional<std::pair<PlanStage::StageState, WorkingSetID>> _batchedResultsEndState;
+    PlanStage::WorkBatch _workBatch;
+
     // The output document that is used by getNext BSON API. This allows us to avoid constantly
     // allocating and freeing DocumentStorage.
     Document _docOutput;
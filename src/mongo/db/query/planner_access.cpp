@@ -221,12 +221,16 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeCollectionScan(
     csn->shouldWaitForOplogVisibility =
         params.options & QueryPlannerParams::OPLOG_SCAN_WAIT_FOR_VISIBLE;
 
+    // Set if the query asks for a particular $natural order, which a parallel scan cannot honor.
+    bool naturalOrderRequested = false;
+
     // If the hint is {$natural: +-1} this changes the direction of the collection scan.
     if (!query.getQueryRequest().getHint().isEmpty()) {
         BSONElement natural =
             dps::extractElementAtPath(query.getQueryRequest().getHint(), "$natural");
         if (!natural.eoo()) {
             csn->direction = natural.numberInt() >= 0 ? 1 : -1;
+            naturalOrderRequested = true;
         }
     }
 
@@ -237,6 +241,7 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeCollectionScan(
         BSONElement natural = dps::extractElementAtPath(sortObj, "$natural");
         if (!natural.eoo()) {
             csn->direction = natural.numberInt() >= 0 ? 1 : -1;
+            naturalOrderRequested = true;
         }
     }
 
@@ -265,6 +270,10 @@ std::unique_ptr<QuerySolutionNode> QueryPlannerAccess::makeCollectionScan(
         }
     }
 
+    csn->allowParallel = (params.options & QueryPlannerParams::ALLOW_PARALLEL_COLLSCAN) &&
+        !naturalOrderRequested && !tailable && !csn->requestResumeToken &&
+        !csn->resumeAfterRecordId && !query.nss().isOplog();
+
     return std::move(csn);
 }
 
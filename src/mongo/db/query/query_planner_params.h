@@ -91,6 +91,11 @@ struct QueryPlannerParams {
         // return exactly one document per value of the distinct field. See the comments above the
         // declaration of getExecutorDistinct() for more detail.
         STRICT_DISTINCT_ONLY = 1 << 9,
+
+        // Set this to allow a forward collection scan to be split between several worker threads.
+        // Only set this if the caller does not depend on the scan's position within the collection,
+        // since the scan will not support resume tokens or tailing.
+        ALLOW_PARALLEL_COLLSCAN = 1 << 10,
     };
 
     // See Options enum above.
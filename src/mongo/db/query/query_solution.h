@@ -353,6 +353,9 @@ struct CollectionScanNode : public QuerySolutionNode {
 
     // Once the first matching document is found, assume that all documents after it must match.
     bool stopApplyingFilterAfterFirstMatch = false;
+
+    // If true, the scan may be split between several worker threads when the stage tree is built.
+    bool allowParallel = false;
 };
 
 struct AndHashNode : public QuerySolutionNode {
@@ -51,6 +51,7 @@
 #include "mongo/db/exec/limit.h"
 #include "mongo/db/exec/merge_sort.h"
 #include "mongo/db/exec/or.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
 #include "mongo/db/exec/projection.h"
 #include "mongo/db/exec/return_key.h"
 #include "mongo/db/exec/shard_filter.h"
@@ -60,6 +61,7 @@
 #include "mongo/db/exec/text.h"
 #include "mongo/db/index/fts_access_method.h"
 #include "mongo/db/matcher/extensions_callback_real.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/s/collection_sharding_state.h"
 #include "mongo/db/storage/oplog_hack.h"
 #include "mongo/util/log.h"
@@ -88,6 +90,23 @@ std::unique_ptr<PlanStage> buildStages(OperationContext* opCtx,
             params.requestResumeToken = csn->requestResumeToken;
             params.resumeAfterRecordId = csn->resumeAfterRecordId;
             params.stopApplyingFilterAfterFirstMatch = csn->stopApplyingFilterAfterFirstMatch;
+
+            const int parallelWorkers = internalQueryParallelCollectionScanWorkers.load();
+            if (csn->allowParallel && parallelWorkers > 1 &&
+                params.direction == CollectionScanParams::FORWARD && !collection->isCapped() &&
+                ParallelCollectionScan::canUseFilter(csn->filter.get()) &&
+                collection->numRecords(opCtx) >=
+                    internalQueryParallelCollectionScanMinRecords.load()) {
+                ParallelCollectionScanParams parallelParams;
+                parallelParams.partitions = parallelWorkers;
+                parallelParams.bufferSizeBytes =
+                    internalQueryParallelCollectionScanBufferSizeBytes.load();
+                parallelParams.preserveOrder =
+                    internalQueryParallelCollectionScanPreserveOrder.load();
+                return std::make_unique<ParallelCollectionScan>(
+                    opCtx, collection, parallelParams, ws, csn->filter.get());
+            }
+
             return std::make_unique<CollectionScan>(
                 opCtx, collection, params, ws, csn->filter.get());
         }
@@ -341,6 +360,7 @@ std::unique_ptr<PlanStage> buildStages(OperationContext* opCtx,
         case STAGE_IDHACK:
         case STAGE_MULTI_ITERATOR:
         case STAGE_MULTI_PLAN:
+        case STAGE_PARALLEL_COLLSCAN:
         case STAGE_PIPELINE_PROXY:
         case STAGE_QUEUED_DATA:
         case STAGE_RECORD_STORE_FAST_COUNT:
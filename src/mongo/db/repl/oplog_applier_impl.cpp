@@ -43,6 +43,8 @@
 #include "mongo/db/logical_session_id.h"
 #include "mongo/db/repl/apply_ops.h"
 #include "mongo/db/repl/insert_group.h"
+#include "mongo/db/repl/oplog_writer_scheduler.h"
+#include "mongo/db/repl/repl_server_parameters_gen.h"
 #include "mongo/db/repl/tla_plus_trace_repl.h"
 #include "mongo/db/repl/transaction_oplog_application.h"
 #include "mongo/db/stats/timer_stats.h"
@@ -206,25 +208,11 @@ void processCrudOp(OperationContext* opCtx,
 }
 
 /**
- * Adds a single oplog entry to the appropriate writer vector.
- */
-void addToWriterVector(OplogEntry* op,
-                       std::vector<std::vector<const OplogEntry*>>* writerVectors,
-                       uint32_t hash) {
-    const uint32_t numWriters = writerVectors->size();
-    auto& writer = (*writerVectors)[hash % numWriters];
-    if (writer.empty()) {
-        writer.reserve(8);  // Skip a few growth rounds
-    }
-    writer.push_back(op);
-}
-
-/**
- * Adds a set of derivedOps to writerVectors.
+ * Adds a set of derivedOps to the writer scheduler.
  */
 void addDerivedOps(OperationContext* opCtx,
                    std::vector<OplogEntry>* derivedOps,
-                   std::vector<std::vector<const OplogEntry*>>* writerVectors,
+                   OplogWriterScheduler* scheduler,
                    CachedCollectionProperties* collPropertiesCache) {
     for (auto&& op : *derivedOps) {
         auto hashedNs = StringMapHasher().hashed_key(op.getNss().ns());
@@ -232,7 +220,7 @@ void addDerivedOps(OperationContext* opCtx,
         if (op.isCrudOpType()) {
             processCrudOp(opCtx, &op, &hash, &hashedNs, collPropertiesCache);
         }
-        addToWriterVector(&op, writerVectors, hash);
+        scheduler->add(&op, hash);
     }
 }
 
@@ -429,9 +417,8 @@ void OplogApplierImpl::_run(OplogBuffer* oplogBuffer) {
 
         // Extract some info from ops that we'll need after releasing the batch below.
         const auto firstOpTimeInBatch = ops.front().getOpTime();
-        const auto lastOpInBatch = ops.back();
-        const auto lastOpTimeInBatch = lastOpInBatch.getOpTime();
-        const auto lastWallTimeInBatch = lastOpInBatch.getWallClockTime();
+        const auto lastOpTimeInBatch = ops.back().getOpTime();
+        const auto lastWallTimeInBatch = ops.back().getWallClockTime();
         const auto lastAppliedOpTimeAtStartOfBatch = _replCoord->getMyLastAppliedOpTime();
 
         // Make sure the oplog doesn't go back in time or repeat an entry.
@@ -725,7 +712,8 @@ StatusWith<OpTime> OplogApplierImpl::_applyOplogBatch(OperationContext* opCtx,
 /**
  * ops - This only modifies the isForCappedCollection field on each op. It does not alter the ops
  *      vector in any other way.
- * writerVectors - Set of operations for each worker thread to apply.
+ * scheduler - Collects the operations, keyed by what they conflict with, to be handed out to the
+ *      worker threads.
  * derivedOps - If provided, this function inserts a decomposition of applyOps operations
  *      and instructions for updating the transactions table.  Required if processing oplogs
  *      with transactions.
@@ -734,7 +722,7 @@ StatusWith<OpTime> OplogApplierImpl::_applyOplogBatch(OperationContext* opCtx,
 void OplogApplierImpl::_deriveOpsAndFillWriterVectors(
     OperationContext* opCtx,
     std::vector<OplogEntry>* ops,
-    std::vector<std::vector<const OplogEntry*>>* writerVectors,
+    OplogWriterScheduler* scheduler,
     std::vector<std::vector<OplogEntry>>* derivedOps,
     SessionUpdateTracker* sessionUpdateTracker) noexcept {
 
@@ -758,7 +746,7 @@ void OplogApplierImpl::_deriveOpsAndFillWriterVectors(
         if (sessionUpdateTracker) {
             if (auto newOplogWrites = sessionUpdateTracker->updateSession(op)) {
                 derivedOps->emplace_back(std::move(*newOplogWrites));
-                addDerivedOps(opCtx, &derivedOps->back(), writerVectors, &collPropertiesCache);
+                addDerivedOps(opCtx, &derivedOps->back(), scheduler, &collPropertiesCache);
             }
         }
 
@@ -802,7 +790,7 @@ void OplogApplierImpl::_deriveOpsAndFillWriterVectors(
                 partialTxnList.clear();
 
                 // Transaction entries cannot have different session updates.
-                addDerivedOps(opCtx, &derivedOps->back(), writerVectors, &collPropertiesCache);
+                addDerivedOps(opCtx, &derivedOps->back(), scheduler, &collPropertiesCache);
             } else {
                 // The applyOps entry was not generated as part of a transaction.
                 invariant(!op.getPrevWriteOpTimeInTransaction());
@@ -810,7 +798,7 @@ void OplogApplierImpl::_deriveOpsAndFillWriterVectors(
                 derivedOps->emplace_back(ApplyOps::extractOperations(op));
 
                 // Nested entries cannot have different session updates.
-                addDerivedOps(opCtx, &derivedOps->back(), writerVectors, &collPropertiesCache);
+                addDerivedOps(opCtx, &derivedOps->back(), scheduler, &collPropertiesCache);
             }
             continue;
         }
@@ -826,11 +814,11 @@ void OplogApplierImpl::_deriveOpsAndFillWriterVectors(
                 readTransactionOperationsFromOplogChain(opCtx, op, partialTxnList));
             partialTxnList.clear();
 
-            addDerivedOps(opCtx, &derivedOps->back(), writerVectors, &collPropertiesCache);
+            addDerivedOps(opCtx, &derivedOps->back(), scheduler, &collPropertiesCache);
             continue;
         }
 
-        addToWriterVector(&op, writerVectors, hash);
+        scheduler->add(&op, hash);
     }
 }
 
@@ -840,15 +828,20 @@ void OplogApplierImpl::fillWriterVectors(
     std::vector<std::vector<const OplogEntry*>>* writerVectors,
     std::vector<std::vector<OplogEntry>>* derivedOps) noexcept {
 
+    OplogWriterScheduler scheduler(replWriterBalanceConflictGroups.load()
+                                       ? OplogWriterScheduler::Policy::kBalanced
+                                       : OplogWriterScheduler::Policy::kHashModulo);
+
     SessionUpdateTracker sessionUpdateTracker;
-    _deriveOpsAndFillWriterVectors(opCtx, ops, writerVectors, derivedOps, &sessionUpdateTracker);
+    _deriveOpsAndFillWriterVectors(opCtx, ops, &scheduler, derivedOps, &sessionUpdateTracker);
 
     auto newOplogWrites = sessionUpdateTracker.flushAll();
     if (!newOplogWrites.empty()) {
         derivedOps->emplace_back(std::move(newOplogWrites));
-        _deriveOpsAndFillWriterVectors(
-            opCtx, &derivedOps->back(), writerVectors, derivedOps, nullptr);
+        _deriveOpsAndFillWriterVectors(opCtx, &derivedOps->back(), &scheduler, derivedOps, nullptr);
     }
+
+    scheduler.assign(writerVectors);
 }
 
 Status applyOplogEntryOrGroupedInserts(OperationContext* opCtx,
@@ -41,7 +41,7 @@ namespace repl {
 MONGO_FAIL_POINT_DEFINE(skipOplogBatcherWaitForData);
 
 OplogBatcher::OplogBatcher(OplogApplier* oplogApplier, OplogBuffer* oplogBuffer)
-    : _oplogApplier(oplogApplier), _oplogBuffer(oplogBuffer), _ops(0) {}
+    : _oplogApplier(oplogApplier), _oplogBuffer(oplogBuffer) {}
 OplogBatcher::~OplogBatcher() {
     invariant(!_thread);
 }
@@ -64,7 +64,7 @@ OplogBatch OplogBatcher::getNextBatch(Seconds maxWaitTime) {
     }
 
     OplogBatch ops = std::move(_ops);
-    _ops = OplogBatch(0);
+    _ops = OplogBatch();
     _cv.notify_all();
     return ops;
 }
@@ -269,7 +269,7 @@ void OplogBatcher::_run(StorageInterface* storageInterface) {
         batchLimits.ops = getBatchLimitOplogEntries();
 
         // Use the OplogBuffer to populate a local OplogBatch. Note that the buffer may be empty.
-        OplogBatch ops(batchLimits.ops);
+        OplogBatch ops;
         {
             auto opCtx = cc().makeOperationContext();
 
@@ -284,14 +284,10 @@ void OplogBatcher::_run(StorageInterface* storageInterface) {
             // Locks the oplog to check its max size, do this in the UninterruptibleLockGuard.
             batchLimits.bytes = getBatchLimitOplogBytes(opCtx.get(), storageInterface);
 
-            auto oplogEntries =
-                fassertNoTrace(31004, getNextApplierBatch(opCtx.get(), batchLimits));
-            for (const auto& oplogEntry : oplogEntries) {
-                ops.emplace_back(oplogEntry);
-            }
+            ops = OplogBatch(fassertNoTrace(31004, getNextApplierBatch(opCtx.get(), batchLimits)));
 
             // If we don't have anything in the batch, wait a bit for something to appear.
-            if (oplogEntries.empty()) {
+            if (ops.empty()) {
                 if (_oplogApplier->inShutdown()) {
                     ops.setMustShutdownFlag();
                 } else {
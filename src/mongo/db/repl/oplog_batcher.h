@@ -46,9 +46,13 @@ class OplogApplier;
  */
 class OplogBatch {
 public:
-    explicit OplogBatch(std::size_t batchLimitOps) {
-        _batch.reserve(batchLimitOps);
-    }
+    OplogBatch() = default;
+
+    /**
+     * Takes the entries by move: they are parsed once by the batcher and not copied again on their
+     * way to the writer threads.
+     */
+    explicit OplogBatch(std::vector<OplogEntry> batch) : _batch(std::move(batch)) {}
     bool empty() const {
         return _batch.empty();
     }
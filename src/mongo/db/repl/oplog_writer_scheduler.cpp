@@ -0,0 +1,103 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/oplog_writer_scheduler.h"
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <queue>
+
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace repl {
+
+void OplogWriterScheduler::add(const OplogEntry* op, uint32_t conflictKey) {
+    auto it = _groupIndexByKey.find(conflictKey);
+    if (it == _groupIndexByKey.end()) {
+        it = _groupIndexByKey.emplace(conflictKey, _groups.size()).first;
+        _groups.push_back({conflictKey, {}});
+    }
+    _groups[it->second].ops.push_back(op);
+}
+
+void OplogWriterScheduler::assign(std::vector<std::vector<const OplogEntry*>>* writerVectors) {
+    const size_t numWriters = writerVectors->size();
+    invariant(numWriters > 0);
+
+    auto appendGroup = [](std::vector<const OplogEntry*>* writer, const Group& group) {
+        if (writer->empty()) {
+            writer->reserve(std::max<size_t>(8, group.ops.size()));  // Skip a few growth rounds
+        }
+        writer->insert(writer->end(), group.ops.begin(), group.ops.end());
+    };
+
+    if (_policy == Policy::kHashModulo || numWriters == 1) {
+        for (const auto& group : _groups) {
+            appendGroup(&(*writerVectors)[group.conflictKey % numWriters], group);
+        }
+    } else {
+        // Longest-processing-time-first: place the largest remaining group on the least loaded
+        // writer. Ties keep the order in which groups were first seen, for determinism.
+        std::vector<size_t> order(_groups.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+            return _groups[lhs].ops.size() > _groups[rhs].ops.size();
+        });
+
+        // Min-heap of (number of operations, writer index).
+        using WriterLoad = std::pair<size_t, size_t>;
+        std::vector<WriterLoad> loads;
+        loads.reserve(numWriters);
+        for (size_t i = 0; i < numWriters; ++i) {
+            loads.emplace_back((*writerVectors)[i].size(), i);
+        }
+        std::priority_queue<WriterLoad, std::vector<WriterLoad>, std::greater<WriterLoad>>
+            leastLoaded(std::greater<WriterLoad>(), std::move(loads));
+
+        for (auto groupIndex : order) {
+            const auto& group = _groups[groupIndex];
+            auto writerLoad = leastLoaded.top();
+            leastLoaded.pop();
+            appendGroup(&(*writerVectors)[writerLoad.second], group);
+            writerLoad.first += group.ops.size();
+            leastLoaded.push(writerLoad);
+        }
+    }
+
+    _groups.clear();
+    _groupIndexByKey.clear();
+}
+
+}  // namespace repl
+}  // namespace mongo
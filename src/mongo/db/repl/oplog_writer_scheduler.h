@@ -0,0 +1,98 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "mongo/db/repl/oplog_entry.h"
+#include "mongo/stdx/unordered_map.h"
+
+namespace mongo {
+namespace repl {
+
+/**
+ * Decides which writer thread applies each operation of an oplog application batch.
+ *
+ * Every operation is added with a conflict key: a hash of the namespace, combined with the hash of
+ * the document's _id for CRUD operations on collections which allow document-level parallelism.
+ * Operations with the same conflict key may depend on each other and form a group which is applied
+ * by a single writer, in the order in which the operations were added. Operations with different
+ * conflict keys are independent. A 32-bit hash collision merges two groups, which only costs
+ * parallelism.
+ *
+ * Under the kHashModulo policy, a group is applied by writer 'key % numWriters'. Under the
+ * kBalanced policy, the groups are handed out largest first to the writer with the fewest
+ * operations so far, so that a few hot documents or an unlucky set of hashes cannot pile the batch
+ * onto a handful of writers while the rest sit idle.
+ */
+class OplogWriterScheduler {
+    OplogWriterScheduler(const OplogWriterScheduler&) = delete;
+    OplogWriterScheduler& operator=(const OplogWriterScheduler&) = delete;
+
+public:
+    enum class Policy { kHashModulo, kBalanced };
+
+    explicit OplogWriterScheduler(Policy policy) : _policy(policy) {}
+
+    /**
+     * Adds 'op' to the group for 'conflictKey', to be applied after every operation previously
+     * added with the same key. 'op' is not owned and must outlive the writer vectors.
+     */
+    void add(const OplogEntry* op, uint32_t conflictKey);
+
+    /**
+     * Appends the operations of every group to one of 'writerVectors', which must not be empty,
+     * and forgets them.
+     */
+    void assign(std::vector<std::vector<const OplogEntry*>>* writerVectors);
+
+    size_t numGroups() const {
+        return _groups.size();
+    }
+
+private:
+    struct Group {
+        uint32_t conflictKey;
+        std::vector<const OplogEntry*> ops;
+    };
+
+    const Policy _policy;
+
+    // Groups in the order in which their first operation was added.
+    std::vector<Group> _groups;
+
+    // Maps a conflict key to its position in '_groups'.
+    stdx::unordered_map<uint32_t, size_t> _groupIndexByKey;
+};
+
+}  // namespace repl
+}  // namespace mongo
@@ -0,0 +1,138 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/bson/bsonelement_comparator.h"
+#include "mongo/db/repl/oplog_writer_scheduler.h"
+#include "mongo/platform/random.h"
+#include "mongo/util/string_map.h"
+#include "third_party/murmurhash3/MurmurHash3.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+constexpr int kBatchSize = 5000;
+constexpr size_t kNumWriters = 16;
+
+/**
+ * Builds a batch of updates to a single collection, where the document targeted by each update is
+ * drawn from 'numDocs' documents. With 'skewed', a few documents receive most of the updates, as in
+ * a bulk update of a hot collection.
+ */
+std::vector<OplogEntry> makeBatch(int numDocs, bool skewed) {
+    PseudoRandom random(1);
+    const NamespaceString nss("test.coll");
+    std::vector<OplogEntry> ops;
+    ops.reserve(kBatchSize);
+    for (int i = 0; i < kBatchSize; ++i) {
+        const double u = random.nextCanonicalDouble();
+        const int id = static_cast<int>(numDocs * (skewed ? u * u * u : u));
+        ops.emplace_back(OpTime(Timestamp(1, i + 1), 1),      // optime
+                         boost::none,                         // hash
+                         OpTypeEnum::kUpdate,                 // opType
+                         nss,                                 // namespace
+                         boost::none,                         // uuid
+                         boost::none,                         // fromMigrate
+                         OplogEntry::kOplogVersion,           // version
+                         BSON("$set" << BSON("x" << i)),      // o
+                         BSON("_id" << id),                   // o2
+                         OperationSessionInfo(),              // sessionInfo
+                         boost::none,                         // upsert
+                         Date_t(),                            // wall clock time
+                         boost::none,                         // statement id
+                         boost::none,   // optime of previous write within same transaction
+                         boost::none,   // pre-image optime
+                         boost::none);  // post-image optime
+    }
+    return ops;
+}
+
+/**
+ * Computes the conflict key the way OplogApplierImpl does for a CRUD op on a collection with
+ * document-level locking and no collation: the namespace hash combined with the _id hash.
+ */
+uint32_t conflictKey(const OplogEntry& op) {
+    uint32_t hash = static_cast<uint32_t>(StringMapHasher().hashed_key(op.getNss().ns()).hash());
+    BSONElementComparator elementHasher(BSONElementComparator::FieldNamesMode::kIgnore, nullptr);
+    const size_t idHash = elementHasher.hash(op.getIdElement());
+    MurmurHash3_x86_32(&idHash, sizeof(idHash), hash, &hash);
+    return hash;
+}
+
+/**
+ * Assigns a batch to the writers and reports, alongside the time taken, the number of operations
+ * on the busiest writer. Since writers apply their operations serially and the batch completes
+ * when the busiest writer does, that count bounds how fast the batch can be applied.
+ */
+void BM_AssignBatch(benchmark::State& state) {
+    const auto policy = state.range(0) ? OplogWriterScheduler::Policy::kBalanced
+                                       : OplogWriterScheduler::Policy::kHashModulo;
+    const auto ops = makeBatch(state.range(1), state.range(2));
+    std::vector<uint32_t> keys;
+    for (const auto& op : ops) {
+        keys.push_back(conflictKey(op));
+    }
+
+    size_t maxWriterOps = 0;
+    for (auto _ : state) {
+        OplogWriterScheduler scheduler(policy);
+        for (size_t i = 0; i < ops.size(); ++i) {
+            scheduler.add(&ops[i], keys[i]);
+        }
+        std::vector<std::vector<const OplogEntry*>> writerVectors(kNumWriters);
+        scheduler.assign(&writerVectors);
+
+        maxWriterOps = 0;
+        for (const auto& writer : writerVectors) {
+            maxWriterOps = std::max(maxWriterOps, writer.size());
+        }
+        benchmark::DoNotOptimize(writerVectors);
+    }
+    state.SetItemsProcessed(state.iterations() * ops.size());
+    state.counters["maxWriterOps"] = maxWriterOps;
+    state.counters["idealWriterOps"] = (ops.size() + kNumWriters - 1) / kNumWriters;
+}
+
+// Arguments are {balanced, number of documents, skewed}.
+BENCHMARK(BM_AssignBatch)
+    ->Args({0, kBatchSize, 0})
+    ->Args({1, kBatchSize, 0})
+    ->Args({0, 64, 0})
+    ->Args({1, 64, 0})
+    ->Args({0, 1000, 1})
+    ->Args({1, 1000, 1});
+
+}  // namespace
+}  // namespace repl
+}  // namespace mongo
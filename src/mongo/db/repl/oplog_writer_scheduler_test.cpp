@@ -0,0 +1,137 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/oplog_writer_scheduler.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+using WriterVectors = std::vector<std::vector<const OplogEntry*>>;
+
+std::vector<OplogEntry> makeInserts(int count) {
+    std::vector<OplogEntry> ops;
+    for (int i = 0; i < count; ++i) {
+        ops.emplace_back(OpTime(Timestamp(1, i + 1), 1),  // optime
+                         boost::none,                     // hash
+                         OpTypeEnum::kInsert,             // opType
+                         NamespaceString("test.coll"),    // namespace
+                         boost::none,                     // uuid
+                         boost::none,                     // fromMigrate
+                         OplogEntry::kOplogVersion,       // version
+                         BSON("_id" << i),                // o
+                         boost::none,                     // o2
+                         OperationSessionInfo(),          // sessionInfo
+                         boost::none,                     // upsert
+                         Date_t(),                        // wall clock time
+                         boost::none,                     // statement id
+                         boost::none,   // optime of previous write within same transaction
+                         boost::none,   // pre-image optime
+                         boost::none);  // post-image optime
+    }
+    return ops;
+}
+
+TEST(OplogWriterSchedulerTest, ConflictingOpsStayOnOneWriterInOrder) {
+    auto ops = makeInserts(6);
+    OplogWriterScheduler scheduler(OplogWriterScheduler::Policy::kBalanced);
+    for (size_t i = 0; i < ops.size(); ++i) {
+        scheduler.add(&ops[i], i % 2);
+    }
+    ASSERT_EQ(2U, scheduler.numGroups());
+
+    WriterVectors writerVectors(4);
+    scheduler.assign(&writerVectors);
+    ASSERT_EQ(0U, scheduler.numGroups());
+
+    size_t numNonEmpty = 0;
+    for (const auto& writer : writerVectors) {
+        if (writer.empty()) {
+            continue;
+        }
+        ++numNonEmpty;
+        ASSERT_EQ(3U, writer.size());
+        const size_t key = (writer[0] - &ops[0]) % 2;
+        for (size_t i = 0; i < writer.size(); ++i) {
+            ASSERT_EQ(&ops[key + 2 * i], writer[i]);
+        }
+    }
+    ASSERT_EQ(2U, numNonEmpty);
+}
+
+TEST(OplogWriterSchedulerTest, HashModuloPlacesCollidingKeysOnOneWriter) {
+    auto ops = makeInserts(2);
+    OplogWriterScheduler scheduler(OplogWriterScheduler::Policy::kHashModulo);
+    scheduler.add(&ops[0], 1);
+    scheduler.add(&ops[1], 5);
+
+    WriterVectors writerVectors(4);
+    scheduler.assign(&writerVectors);
+    ASSERT_EQ(2U, writerVectors[1].size());
+    ASSERT_EQ(&ops[0], writerVectors[1][0]);
+    ASSERT_EQ(&ops[1], writerVectors[1][1]);
+}
+
+TEST(OplogWriterSchedulerTest, BalancedSpreadsCollidingKeysAcrossWriters) {
+    auto ops = makeInserts(2);
+    OplogWriterScheduler scheduler(OplogWriterScheduler::Policy::kBalanced);
+    scheduler.add(&ops[0], 1);
+    scheduler.add(&ops[1], 5);
+
+    WriterVectors writerVectors(4);
+    scheduler.assign(&writerVectors);
+    for (const auto& writer : writerVectors) {
+        ASSERT_LTE(writer.size(), 1U);
+    }
+}
+
+TEST(OplogWriterSchedulerTest, BalancedPlacesLargestGroupFirst) {
+    // One group of ten operations and ten groups of one operation fit exactly on two writers.
+    auto ops = makeInserts(20);
+    OplogWriterScheduler scheduler(OplogWriterScheduler::Policy::kBalanced);
+    for (size_t i = 0; i < 10; ++i) {
+        scheduler.add(&ops[i], 100 + i);
+    }
+    for (size_t i = 10; i < 20; ++i) {
+        scheduler.add(&ops[i], 0);
+    }
+
+    WriterVectors writerVectors(2);
+    scheduler.assign(&writerVectors);
+    ASSERT_EQ(10U, writerVectors[0].size());
+    ASSERT_EQ(10U, writerVectors[1].size());
+}
+
+}  // namespace
+}  // namespace repl
+}  // namespace mongo
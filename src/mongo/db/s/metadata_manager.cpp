@@ -144,6 +144,7 @@ void scheduleCleanup(executor::TaskExecutor* executor,
             }
             auto uniqueOpCtx = Client::getCurrent()->makeOperationContext();
             auto opCtx = uniqueOpCtx.get();
+            opCtx->setAdmissionPriority(AdmissionPriority::kBackground);
 
             suspendRangeDeletion.pauseWhileSet();
 
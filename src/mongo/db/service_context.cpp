@@ -45,6 +45,7 @@
 #include "mongo/db/operation_context.h"
 #include "mongo/db/storage/recovery_unit_noop.h"
 #include "mongo/transport/service_entry_point.h"
+#include "mongo/transport/service_executor.h"
 #include "mongo/transport/session.h"
 #include "mongo/transport/transport_layer.h"
 #include "mongo/util/assert_util.h"
@@ -247,11 +248,14 @@ ServiceContext::UniqueOperationContext ServiceContext::makeOperationContext(Clie
         opCtx->setRecoveryUnit(std::make_unique<RecoveryUnitNoop>(),
                                WriteUnitOfWork::RecoveryUnitState::kNotInUnitOfWork);
     }
-    // The baton must be attached before attaching to a client
-    if (_transportLayer) {
-        _transportLayer->makeBaton(opCtx.get());
-    } else {
-        makeBaton(opCtx.get());
+    // The baton must be attached before attaching to a client. The service executor gets the first
+    // say, since it decides how the threads it runs operations on may wait.
+    if (!_serviceExecutor || !_serviceExecutor->makeBaton(opCtx.get())) {
+        if (_transportLayer) {
+            _transportLayer->makeBaton(opCtx.get());
+        } else {
+            makeBaton(opCtx.get());
+        }
     }
     {
         stdx::lock_guard<Client> lk(*client);
@@ -575,7 +575,10 @@ bool runCommandImpl(OperationContext* opCtx,
                     BSONObjBuilder* extraFieldsBuilder,
                     const OperationSessionInfoFromClient& sessionOptions) {
     const Command* command = invocation->definition();
-    auto bytesToReserve = command->reserveBytesForReply();
+    // Reserve a little over the running average so that typical replies fit without regrowing.
+    const auto replySizeEstimate = command->getReplySizeEstimate();
+    auto bytesToReserve =
+        std::max(command->reserveBytesForReply(), replySizeEstimate + replySizeEstimate / 4);
 // SERVER-22100: In Windows DEBUG builds, the CRT heap debugging overhead, in conjunction with the
 // additional memory pressure introduced by reply buffer pre-allocation, causes the concurrency
 // suite to run extremely slowly. As a workaround we do not pre-allocate in Windows DEBUG builds.
@@ -1095,6 +1098,7 @@ DbResponse receivedCommands(OperationContext* opCtx,
                             const ServiceEntryPointCommon::Hooks& behaviors) {
     auto replyBuilder = rpc::makeReplyBuilder(rpc::protocolForMessage(message));
     OpMsgRequest request;
+    Command* c = nullptr;
     [&] {
         try {  // Parse.
             request = rpc::opMsgRequestFromAnyProtocol(message);
@@ -1124,7 +1128,6 @@ DbResponse receivedCommands(OperationContext* opCtx,
         try {  // Execute.
             curOpCommandSetup(opCtx, request);
 
-            Command* c = nullptr;
             // In the absence of a Command object, no redaction is possible. Therefore
             // to avoid displaying potentially sensitive information in the logs,
             // we restrict the log message to the name of the unrecognized command.
@@ -1189,6 +1192,9 @@ DbResponse receivedCommands(OperationContext* opCtx,
 
     dbResponse.response = replyBuilder->done();
     CurOp::get(opCtx)->debug().responseLength = dbResponse.response.header().dataLen();
+    if (c) {
+        c->recordReplySize(dbResponse.response.size());
+    }
 
     return dbResponse;
 }
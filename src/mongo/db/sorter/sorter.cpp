@@ -48,8 +48,8 @@
 
 #include "mongo/db/sorter/sorter.h"
 
+#include <algorithm>
 #include <boost/filesystem/operations.hpp>
-#include <snappy.h>
 #include <vector>
 
 #include "mongo/base/string_data.h"
@@ -63,6 +63,7 @@
 #include "mongo/s/is_mongos.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/destructor_guard.h"
+#include "mongo/util/future.h"
 #include "mongo/util/str.h"
 #include "mongo/util/unowned_ptr.h"
 
@@ -94,6 +95,18 @@ inline std::string myErrnoWithDescription() {
     return sb.str();
 }
 
+/**
+ * Whether Key is serialized relative to the key before it in a spilled block. See sorter.h.
+ */
+template <typename Key, typename = void>
+struct IsSerializedWithPrevious : std::false_type {};
+
+template <typename Key>
+struct IsSerializedWithPrevious<Key,
+                                std::void_t<decltype(std::declval<const Key&>().serializeForSorter(
+                                    std::declval<BufBuilder&>(), std::declval<const Key&>()))>>
+    : std::true_type {};
+
 template <typename Data, typename Comparator>
 void dassertCompIsSane(const Comparator& comp, const Data& lhs, const Data& rhs) {
 #if defined(MONGO_CONFIG_DEBUG_BUILD) && !defined(_MSC_VER)
@@ -117,6 +130,54 @@ void dassertCompIsSane(const Comparator& comp, const Data& lhs, const Data& rhs)
 #endif
 }
 
+/**
+ * Stably sorts 'data' in up to 'numThreads' slices, all but the first of which are sorted on the
+ * shared slice pool. Contiguous slices are sorted concurrently and then merged with their
+ * neighbours in order, which keeps the result stable.
+ */
+template <typename Container, typename Less>
+void parallelStableSort(Container* data, size_t numThreads, const Less& less) {
+    // Below this many elements per slice, handing a slice to another thread costs more than it
+    // saves.
+    const size_t kMinSliceSize = 16 * 1024;
+    numThreads = std::min(numThreads, data->size() / kMinSliceSize);
+    if (numThreads <= 1) {
+        std::stable_sort(data->begin(), data->end(), less);
+        return;
+    }
+
+    std::vector<typename Container::iterator> bounds;
+    for (size_t i = 0; i <= numThreads; i++)
+        bounds.push_back(data->begin() + data->size() * i / numThreads);
+
+    std::vector<Future<void>> slices;
+    for (size_t i = 1; i < numThreads; i++) {
+        slices.push_back(scheduleSortSliceTask(
+            [&bounds, &less, i] { std::stable_sort(bounds[i], bounds[i + 1], less); }));
+    }
+
+    // The other slices refer to 'bounds', so they must all be waited for, even if this one fails.
+    Status status = Status::OK();
+    try {
+        std::stable_sort(bounds[0], bounds[1], less);
+    } catch (...) {
+        status = exceptionToStatus();
+    }
+    for (auto&& slice : slices) {
+        auto sliceStatus = std::move(slice).getNoThrow();
+        if (status.isOK())
+            status = std::move(sliceStatus);
+    }
+    uassertStatusOK(status);
+
+    for (size_t width = 1; width < numThreads; width *= 2) {
+        for (size_t i = 0; i + width < numThreads; i += 2 * width) {
+            std::inplace_merge(
+                bounds[i], bounds[i + width], bounds[std::min(i + 2 * width, numThreads)], less);
+        }
+    }
+}
+
 /**
  * Returns results from sorted in-memory storage.
  */
@@ -172,12 +233,14 @@ public:
                  std::streampos fileStartOffset,
                  std::streampos fileEndOffset,
                  const Settings& settings,
-                 const uint32_t checksum)
+                 const uint32_t checksum,
+                 SpillCompressor compressor)
         : _settings(settings),
           _done(false),
           _fileName(fileName),
           _fileStartOffset(fileStartOffset),
           _fileEndOffset(fileEndOffset),
+          _compressor(compressor),
           _originalChecksum(checksum) {
         uassert(16815,
                 str::stream() << "unexpected empty file: " << _fileName,
@@ -185,6 +248,16 @@ public:
     }
 
     void openSource() {
+        // Give the stream a buffer large enough to read several blocks ahead of the one being
+        // decoded. A merge interleaves reads from all of its inputs, so without this each input
+        // costs a small read, and usually a seek, per block. The buffer must be installed before
+        // the file is opened.
+        const size_t readAheadBytes = getSpillReadAheadBytes();
+        if (readAheadBytes > 0) {
+            _readAheadBuffer.reset(new char[readAheadBytes]);
+            _file.rdbuf()->pubsetbuf(_readAheadBuffer.get(), readAheadBytes);
+        }
+
         _file.open(_fileName.c_str(), std::ios::in | std::ios::binary);
         uassert(16814,
                 str::stream() << "error opening file \"" << _fileName
@@ -203,6 +276,7 @@ public:
                 str::stream() << "error closing file \"" << _fileName
                               << "\": " << myErrnoWithDescription(),
                 !_file.fail());
+        _readAheadBuffer.reset();
 
         // If the file iterator reads through all data objects, we can ensure non-corrupt data
         // by comparing the newly calculated checksum with the original checksum from the data
@@ -233,7 +307,16 @@ public:
         // buffer. Since Key comes before Value in the _bufferReader, and C++ makes no function
         // parameter evaluation order guarantees, we cannot deserialize Key and Value straight into
         // the Data constructor
-        auto first = Key::deserializeForSorter(*_bufferReader, _settings.first);
+        auto first = [&] {
+            if constexpr (IsSerializedWithPrevious<Key>::value) {
+                auto key = Key::deserializeForSorter(
+                    *_bufferReader, _settings.first, _previousKey ? *_previousKey : Key());
+                _previousKey = key;
+                return key;
+            } else {
+                return Key::deserializeForSorter(*_bufferReader, _settings.first);
+            }
+        }();
         auto second = Value::deserializeForSorter(*_bufferReader, _settings.second);
 
         // The difference of _bufferReader's position before and after reading the data
@@ -275,6 +358,9 @@ private:
         read(_buffer.get(), blockSize);
         uassert(16816, "file too short?", !_done);
 
+        // The first key in a block isn't serialized relative to anything.
+        _previousKey = boost::none;
+
         auto encryptionHooks = EncryptionHooks::get(getGlobalServiceContext());
         if (encryptionHooks->enabled()) {
             std::unique_ptr<char[]> out(new char[blockSize]);
@@ -297,17 +383,9 @@ private:
             return;
         }
 
-        dassert(snappy::IsValidCompressedBuffer(_buffer.get(), blockSize));
-
-        size_t uncompressedSize;
-        uassert(17061,
-                "couldn't get uncompressed length",
-                snappy::GetUncompressedLength(_buffer.get(), blockSize, &uncompressedSize));
-
-        std::unique_ptr<char[]> decompressionBuffer(new char[uncompressedSize]);
-        uassert(17062,
-                "decompression failed",
-                snappy::RawUncompress(_buffer.get(), blockSize, decompressionBuffer.get()));
+        std::unique_ptr<char[]> decompressionBuffer;
+        size_t uncompressedSize =
+            decompressSpillBlock(_compressor, _buffer.get(), blockSize, &decompressionBuffer);
 
         // hold on to decompressed data and throw out compressed data at block exit
         _buffer.swap(decompressionBuffer);
@@ -347,10 +425,14 @@ private:
 
     std::unique_ptr<char[]> _buffer;
     std::unique_ptr<BufReader> _bufferReader;
+    // The last key read from the current block, for Keys serialized relative to the one before.
+    boost::optional<Key> _previousKey;
     std::string _fileName;            // File containing the sorted data range.
     std::streampos _fileStartOffset;  // File offset at which the sorted data range starts.
     std::streampos _fileEndOffset;    // File offset at which the sorted data range ends.
+    SpillCompressor _compressor;      // Compressor used for blocks which are marked compressed.
     std::ifstream _file;
+    std::unique_ptr<char[]> _readAheadBuffer;  // Backs '_file' while the source is open.
 
     // Checksum value that is updated with each read of a data object from disk. We can compare
     // this value with _originalChecksum to check for data corruption if and only if the
@@ -408,7 +490,7 @@ public:
         // file. Some systems will error closing the file if any file handles are still open.
         _current.reset();
         _heap.clear();
-        DESTRUCTOR_GUARD(boost::filesystem::remove(_itersSourceFileName));
+        DESTRUCTOR_GUARD(removeSpillFile(_itersSourceFileName));
     }
 
     void openSource() {}
@@ -512,6 +594,168 @@ private:
     std::string _itersSourceFileName;
 };
 
+/**
+ * Merge-sorts results from 0 or more FileIterators, like MergeIterator, but keeps its inputs in a
+ * tournament tree of losers rather than a heap. Replacing the winner then costs exactly one
+ * comparison per level of the tree, against up to two for a heap, which adds up when an external
+ * sort merges hundreds of runs. Used when SortOptions::parallelExtSort is set.
+ */
+template <typename Key, typename Value, typename Comparator>
+class TournamentMergeIterator : public SortIteratorInterface<Key, Value> {
+public:
+    typedef SortIteratorInterface<Key, Value> Input;
+    typedef std::pair<Key, Value> Data;
+
+    TournamentMergeIterator(const std::vector<std::shared_ptr<Input>>& iters,
+                            const std::string& itersSourceFileName,
+                            const SortOptions& opts,
+                            const Comparator& comp)
+        : _remaining(opts.limit ? opts.limit : std::numeric_limits<unsigned long long>::max()),
+          _comp(comp),
+          _itersSourceFileName(itersSourceFileName) {
+        for (auto&& iter : iters) {
+            iter->openSource();
+            if (iter->more()) {
+                _streams.push_back(std::make_unique<Stream>(iter));
+            } else {
+                iter->closeSource();
+            }
+        }
+
+        if (_streams.empty()) {
+            _remaining = 0;
+            return;
+        }
+
+        _tree.resize(_streams.size());
+        _tree[0] = initTree(1);
+    }
+
+    ~TournamentMergeIterator() {
+        // Close the file handles before deleting the file.
+        _streams.clear();
+        DESTRUCTOR_GUARD(removeSpillFile(_itersSourceFileName));
+    }
+
+    void openSource() {}
+    void closeSource() {}
+
+    bool more() {
+        if (_remaining > 0 && !_streams[_tree[0]]->exhausted())
+            return true;
+
+        _remaining = 0;
+        return false;
+    }
+
+    Data next() {
+        verify(more());
+
+        _remaining--;
+
+        const size_t winner = _tree[0];
+        Data out = _streams[winner]->advance();
+        replay(winner);
+        return out;
+    }
+
+private:
+    /**
+     * Data iterator over an Input stream, which it closes upon destruction.
+     */
+    class Stream {
+    public:
+        explicit Stream(std::shared_ptr<Input> rest) : _current(rest->next()), _rest(rest) {}
+
+        ~Stream() {
+            _rest->closeSource();
+        }
+
+        const Data& current() const {
+            return _current;
+        }
+        bool exhausted() const {
+            return _exhausted;
+        }
+
+        /**
+         * Returns the current element and moves on to the next one, if there is one.
+         */
+        Data advance() {
+            Data out = std::move(_current);
+            if (_rest->more()) {
+                _current = _rest->next();
+            } else {
+                _exhausted = true;
+            }
+            return out;
+        }
+
+    private:
+        Data _current;
+        bool _exhausted = false;
+        std::shared_ptr<Input> _rest;
+    };
+
+    /**
+     * Returns true if stream 'lhs' must be returned before stream 'rhs'. Exhausted streams lose to
+     * all others, and ties go to the earlier stream to keep the merge stable.
+     */
+    bool beats(size_t lhs, size_t rhs) const {
+        if (_streams[lhs]->exhausted())
+            return false;
+        if (_streams[rhs]->exhausted())
+            return true;
+
+        dassertCompIsSane(_comp, _streams[lhs]->current(), _streams[rhs]->current());
+        int ret = _comp(_streams[lhs]->current(), _streams[rhs]->current());
+        if (ret)
+            return ret < 0;
+        return lhs < rhs;
+    }
+
+    /**
+     * Plays the matches of the subtree rooted at 'node', records the loser of each in '_tree' and
+     * returns the winner. The k streams are the leaves k..2k-1 of an implicit binary tree whose
+     * internal nodes are 1..k-1, with the children of node n at 2n and 2n+1.
+     */
+    size_t initTree(size_t node) {
+        if (node >= _streams.size())
+            return node - _streams.size();
+
+        size_t left = initTree(2 * node);
+        size_t right = initTree(2 * node + 1);
+        if (beats(left, right)) {
+            _tree[node] = right;
+            return left;
+        }
+        _tree[node] = left;
+        return right;
+    }
+
+    /**
+     * Replays the matches on the path from 'stream' to the root after its current element changed.
+     */
+    void replay(size_t stream) {
+        size_t winner = stream;
+        for (size_t node = (stream + _streams.size()) / 2; node > 0; node /= 2) {
+            if (beats(_tree[node], winner))
+                std::swap(_tree[node], winner);
+        }
+        _tree[0] = winner;
+    }
+
+    unsigned long long _remaining;
+    const Comparator _comp;
+    std::vector<std::unique_ptr<Stream>> _streams;
+
+    // The overall winner at index 0, followed by the loser of the match played at each internal
+    // node of the tree.
+    std::vector<size_t> _tree;
+
+    std::string _itersSourceFileName;
+};
+
 template <typename Key, typename Value, typename Comparator>
 class NoLimitSorter : public Sorter<Key, Value> {
 public:
@@ -532,10 +776,14 @@ public:
     }
 
     ~NoLimitSorter() {
+        if (_backgroundSpill) {
+            std::move(*_backgroundSpill).getNoThrow().ignore();
+        }
+
         if (!_done) {
             // If done() was never called to return a MergeIterator, then this Sorter still owns
             // file deletion.
-            DESTRUCTOR_GUARD(boost::filesystem::remove(_fileName));
+            DESTRUCTOR_GUARD(removeSpillFile(_fileName));
         }
     }
 
@@ -547,19 +795,24 @@ public:
         _memUsed += key.memUsageForSorter();
         _memUsed += val.memUsageForSorter();
 
-        if (_memUsed > _opts.maxMemoryUsageBytes)
+        // A parallel sort holds the run being filled and the one being spilled in memory at once.
+        const size_t runMemoryLimit =
+            _opts.parallelExtSort ? _opts.maxMemoryUsageBytes / 2 : _opts.maxMemoryUsageBytes;
+        if (_memUsed > runMemoryLimit)
             spill();
     }
 
     Iterator* done() {
         invariant(!_done);
 
+        waitForBackgroundSpill();
         if (_iters.empty()) {
-            sort();
+            sort(&_data);
             return new InMemIterator<Key, Value>(_data);
         }
 
         spill();
+        waitForBackgroundSpill();
         Iterator* mergeIt = Iterator::merge(_iters, _fileName, _opts, _comp);
         _done = true;
         return mergeIt;
@@ -578,9 +831,14 @@ private:
         const Comparator& _comp;
     };
 
-    void sort() {
+    void sort(std::deque<Data>* data) {
         STLComparator less(_comp);
-        std::stable_sort(_data.begin(), _data.end(), less);
+        if (_opts.parallelExtSort) {
+            parallelStableSort(data, getParallelExtSortThreads(), less);
+            return;
+        }
+
+        std::stable_sort(data->begin(), data->end(), less);
 
         // Does 2x more compares than stable_sort
         // TODO test on windows
@@ -606,19 +864,48 @@ private:
                           << " Pass allowDiskUse:true to opt in.");
         }
 
-        sort();
+        _memUsed = 0;
+
+        if (!_opts.parallelExtSort) {
+            writeRun(&_data);
+            return;
+        }
+
+        // Hand the run off to the shared spill pool and keep filling a new one. Runs are appended
+        // to the same file, so the previous run must have been written out first.
+        waitForBackgroundSpill();
+        _backgroundSpill = scheduleSpillTask(
+            [this, run = std::move(_data)]() mutable { writeRun(&run); });
+        _data.clear();
+    }
+
+    /**
+     * Sorts 'run' and appends it to the spill file, leaving it empty.
+     */
+    void writeRun(std::deque<Data>* run) {
+        sort(run);
 
         SortedFileWriter<Key, Value> writer(
             _opts, _fileName, _nextSortedFileWriterOffset, _settings);
-        for (; !_data.empty(); _data.pop_front()) {
-            writer.addAlreadySorted(_data.front().first, _data.front().second);
+        for (; !run->empty(); run->pop_front()) {
+            writer.addAlreadySorted(run->front().first, run->front().second);
         }
         Iterator* iteratorPtr = writer.done();
         _nextSortedFileWriterOffset = writer.getFileEndOffset();
 
         _iters.push_back(std::shared_ptr<Iterator>(iteratorPtr));
+    }
 
-        _memUsed = 0;
+    /**
+     * Waits for the run being spilled in the background, if any, and rethrows its failure.
+     */
+    void waitForBackgroundSpill() {
+        if (!_backgroundSpill) {
+            return;
+        }
+        auto status = std::move(*_backgroundSpill).getNoThrow();
+        _backgroundSpill.reset();
+        uassertStatusOK(status);
     }
 
     const Comparator _comp;
@@ -630,6 +917,11 @@ private:
     size_t _memUsed;
     std::deque<Data> _data;                         // the "current" data
     std::vector<std::shared_ptr<Iterator>> _iters;  // data that has already been spilled
+
+    // Becomes ready once the previous run, handed to the spill pool if parallelExtSort is set, has
+    // been written out. Only the spill task touches '_iters' and '_nextSortedFileWriterOffset'
+    // until then.
+    boost::optional<Future<void>> _backgroundSpill;
 };
 
 template <typename Key, typename Value, typename Comparator>
@@ -712,7 +1004,7 @@ public:
         if (!_done) {
             // If done() was never called to return a MergeIterator, then this Sorter still owns
             // file deletion.
-            DESTRUCTOR_GUARD(boost::filesystem::remove(_fileName));
+            DESTRUCTOR_GUARD(removeSpillFile(_fileName));
         }
     }
 
@@ -945,7 +1237,11 @@ SortedFileWriter<Key, Value>::SortedFileWriter(const SortOptions& opts,
                                                const std::string& fileName,
                                                const std::streampos fileStartOffset,
                                                const Settings& settings)
-    : _settings(settings) {
+    : _settings(settings),
+      _blockSizeBytes(opts.spillBlockSizeBytes ? opts.spillBlockSizeBytes
+                                               : sorter::getDefaultSpillBlockSizeBytes()),
+      _compressor(opts.spillCompressor ? *opts.spillCompressor
+                                       : sorter::getDefaultSpillCompressor()) {
 
     // This should be checked by consumers, but if we get here don't allow writes.
     uassert(
@@ -983,7 +1279,12 @@ void SortedFileWriter<Key, Value>::addAlreadySorted(const Key& key, const Value&
     int _nextObjPos = _buffer.len();
 
     // Add serialized key and value to the buffer.
-    key.serializeForSorter(_buffer);
+    if constexpr (sorter::IsSerializedWithPrevious<Key>::value) {
+        key.serializeForSorter(_buffer, _previousKey ? *_previousKey : Key());
+        _previousKey = key;
+    } else {
+        key.serializeForSorter(_buffer);
+    }
     val.serializeForSorter(_buffer);
 
     // Serializing the key and value grows the buffer, but _buffer.buf() still points to the
@@ -991,7 +1292,7 @@ void SortedFileWriter<Key, Value>::addAlreadySorted(const Key& key, const Value&
     _checksum =
         addDataToChecksum(_buffer.buf() + _nextObjPos, _buffer.len() - _nextObjPos, _checksum);
 
-    if (_buffer.len() > 64 * 1024)
+    if (static_cast<size_t>(_buffer.len()) > _blockSizeBytes)
         spill();
 }
 
@@ -1004,10 +1305,8 @@ void SortedFileWriter<Key, Value>::spill() {
         return;
 
     std::string compressed;
-    snappy::Compress(outBuffer, size, &compressed);
-    verify(compressed.size() <= size_t(std::numeric_limits<int32_t>::max()));
-
-    const bool shouldCompress = compressed.size() < size_t(_buffer.len() / 10 * 9);
+    const bool shouldCompress =
+        sorter::compressSpillBlock(_compressor, outBuffer, size, &compressed);
     if (shouldCompress) {
         size = compressed.size();
         outBuffer = const_cast<char*>(compressed.data());
@@ -1031,18 +1330,26 @@ void SortedFileWriter<Key, Value>::spill() {
         size = resultLen;
     }
 
+    // Fails with OutOfDiskSpace if this block would take spill files over the server's budget.
+    const size_t reservedBytes = sizeof(size) + size;
+    sorter::reserveSpillSpace(_fileName, reservedBytes, _buffer.len());
+
     // negative size means compressed
     size = shouldCompress ? -size : size;
     try {
         _file.write(reinterpret_cast<const char*>(&size), sizeof(size));
         _file.write(outBuffer, std::abs(size));
     } catch (const std::exception&) {
+        // The block never made it to disk in full, so it must not count against the budget until
+        // the file is removed.
+        sorter::releaseSpillSpace(_fileName, reservedBytes, _buffer.len());
         msgasserted(16821,
                     str::stream() << "error writing to file \"" << _fileName
                                   << "\": " << sorter::myErrnoWithDescription());
     }
 
     _buffer.reset();
+    _previousKey = boost::none;
 }
 
 template <typename Key, typename Value>
@@ -1060,7 +1367,7 @@ SortIteratorInterface<Key, Value>* SortedFileWriter<Key, Value>::done() {
     _file.close();
 
     return new sorter::FileIterator<Key, Value>(
-        _fileName, _fileStartOffset, _fileEndOffset, _settings, _checksum);
+        _fileName, _fileStartOffset, _fileEndOffset, _settings, _checksum, _compressor);
 }
 
 //
@@ -1074,6 +1381,10 @@ SortIteratorInterface<Key, Value>* SortIteratorInterface<Key, Value>::merge(
     const std::string& fileName,
     const SortOptions& opts,
     const Comparator& comp) {
+    if (opts.parallelExtSort) {
+        return new sorter::TournamentMergeIterator<Key, Value, Comparator>(
+            iters, fileName, opts, comp);
+    }
     return new sorter::MergeIterator<Key, Value, Comparator>(iters, fileName, opts, comp);
 }
 
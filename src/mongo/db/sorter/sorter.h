@@ -38,7 +38,10 @@
 #include <utility>
 #include <vector>
 
+#include <boost/optional.hpp>
+
 #include "mongo/bson/util/builder.h"
+#include "mongo/db/sorter/sorter_spill.h"
 #include "mongo/util/bufreader.h"
 
 /**
@@ -58,6 +61,15 @@
  * // Deserialize and return an object from the BufReader
  * static Type deserializeForSorter(BufReader& buf, const Type::SorterDeserializeSettings&);
  *
+ * // Optional, for Keys only. If these are defined, each Key in a spilled block is serialized
+ * // relative to the Key before it, which is a default-constructed Key for the first in the
+ * // block. Keys come out of a sort in order, so this is a cheap way to leave out shared prefixes.
+ * // Keys held in memory stay whole, since sorting them needs random access to every key.
+ * void serializeForSorter(BufBuilder& buf, const Type& previous) const;
+ * static Type deserializeForSorter(BufReader& buf,
+ *                                  const Type::SorterDeserializeSettings&,
+ *                                  const Type& previous);
+ *
  * // How much memory is used by your type? Include sizeof(*this) and any memory you reference.
  * int memUsageForSorter() const;
  *
@@ -107,7 +119,25 @@ struct SortOptions {
     // extSortAllowed is true.
     std::string tempDir;
 
-    SortOptions() : limit(0), maxMemoryUsageBytes(64 * 1024 * 1024), extSortAllowed(false) {}
+    // Number of bytes of sorted data buffered before a block is compressed and written to disk.
+    // 0 means use the 'internalQueryExternalSortBlockSizeBytes' server parameter.
+    size_t spillBlockSizeBytes;
+
+    // Compressor applied to each block written to disk. If unset, the one named by the
+    // 'internalQueryExternalSortCompressor' server parameter is used.
+    boost::optional<sorter::SpillCompressor> spillCompressor;
+
+    // Whether spilled runs are merged with a tournament tree and, for a sort without a limit, are
+    // sorted and written on background threads while the caller fills the next run. Two runs are
+    // then held in memory at once, so each is limited to half of maxMemoryUsageBytes.
+    bool parallelExtSort;
+
+    SortOptions()
+        : limit(0),
+          maxMemoryUsageBytes(64 * 1024 * 1024),
+          extSortAllowed(false),
+          spillBlockSizeBytes(0),
+          parallelExtSort(false) {}
 
     // Fluent API to support expressions like SortOptions().Limit(1000).ExtSortAllowed(true)
 
@@ -130,6 +160,21 @@ struct SortOptions {
         tempDir = newTempDir;
         return *this;
     }
+
+    SortOptions& SpillBlockSizeBytes(size_t newSpillBlockSizeBytes) {
+        spillBlockSizeBytes = newSpillBlockSizeBytes;
+        return *this;
+    }
+
+    SortOptions& SpillCompressor(sorter::SpillCompressor newSpillCompressor) {
+        spillCompressor = newSpillCompressor;
+        return *this;
+    }
+
+    SortOptions& ParallelExtSort(bool newParallelExtSort = true) {
+        parallelExtSort = newParallelExtSort;
+        return *this;
+    }
 };
 
 /**
@@ -285,6 +330,15 @@ private:
     std::ofstream _file;
     BufBuilder _buffer;
 
+    // The last key added to '_buffer', for Keys which are serialized relative to the key before
+    // them. Reset whenever '_buffer' is spilled, since each block is decoded on its own.
+    boost::optional<Key> _previousKey;
+
+    // Size at which '_buffer' is written out as a block, and the compressor applied to each block.
+    // Both are fixed for the lifetime of the writer so the FileIterator can decode every block.
+    size_t _blockSizeBytes;
+    sorter::SpillCompressor _compressor;
+
     // Keeps track of the hash of all data objects spilled to disk. Passed to the FileIterator
     // to ensure data has not been corrupted after reading from disk.
     uint32_t _checksum = 0;
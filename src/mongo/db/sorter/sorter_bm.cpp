@@ -0,0 +1,128 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+#include "mongo/db/record_id.h"
+#include "mongo/db/service_context_test_fixture.h"
+#include "mongo/db/sorter/sorter.h"
+#include "mongo/db/storage/key_string.h"
+#include "mongo/unittest/temp_dir.h"
+
+namespace mongo {
+
+std::string nextFileName() {
+    static AtomicWord<unsigned> sorterBenchmarkFileCounter;
+    return "extsort-sorter-bm." + std::to_string(sorterBenchmarkFileCounter.fetchAndAdd(1));
+}
+
+}  // namespace mongo
+
+#include "mongo/db/sorter/sorter.cpp"
+
+namespace mongo {
+namespace {
+
+using KeyStringSorter = Sorter<KeyString::Value, RecordId>;
+
+class KeyStringRecordIdComparator {
+public:
+    int operator()(const KeyStringSorter::Data& lhs, const KeyStringSorter::Data& rhs) const {
+        int cmp = lhs.first.compare(rhs.first);
+        if (cmp)
+            return cmp;
+        return lhs.second.compare(rhs.second);
+    }
+};
+
+class ServiceContextHolder : public ScopedGlobalServiceContextForTest {};
+
+/**
+ * Returns 'numKeys' single-field index keys in random order, with a few duplicates.
+ */
+std::vector<KeyString::Value> makeKeys(size_t numKeys) {
+    std::mt19937_64 gen(1234);
+    std::uniform_int_distribution<long long> dist(0, numKeys * 4);
+
+    std::vector<KeyString::Value> keys;
+    keys.reserve(numKeys);
+    for (size_t i = 0; i < numKeys; i++) {
+        KeyString::Builder builder(KeyString::Version::kLatestVersion,
+                                   BSON("" << dist(gen) << "" << std::string(16, 'x')),
+                                   Ordering::make(BSONObj()));
+        keys.push_back(builder.getValueCopy());
+    }
+    return keys;
+}
+
+/**
+ * Sorts state.range(0) index keys the way an index build does, with a memory limit low enough
+ * that the sort spills a few dozen runs. Parallel external sorting is enabled if state.range(1) is
+ * non-zero.
+ */
+void BM_SortKeyStringRecordId(benchmark::State& state) {
+    ServiceContextHolder serviceContext;
+    const auto keys = makeKeys(state.range(0));
+    const KeyStringSorter::Settings settings{{KeyString::Version::kLatestVersion}, {}};
+
+    for (auto _ : state) {
+        unittest::TempDir tempDir("sorterBenchmark");
+        std::unique_ptr<KeyStringSorter> sorter(
+            KeyStringSorter::make(SortOptions()
+                                      .TempDir(tempDir.path())
+                                      .ExtSortAllowed()
+                                      .MaxMemoryUsageBytes(4 * 1024 * 1024)
+                                      .ParallelExtSort(state.range(1)),
+                                  KeyStringRecordIdComparator(),
+                                  settings));
+        for (size_t i = 0; i < keys.size(); i++)
+            sorter->add(keys[i], RecordId(i + 1));
+
+        std::unique_ptr<KeyStringSorter::Iterator> it(sorter->done());
+        while (it->more())
+            benchmark::DoNotOptimize(it->next());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_SortKeyStringRecordId)
+    ->ArgNames({"keys", "parallel"})
+    ->Args({1 << 18, 0})
+    ->Args({1 << 18, 1})
+    ->Args({1 << 21, 0})
+    ->Args({1 << 21, 1})
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,274 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/sorter/sorter_spill.h"
+
+#include <boost/filesystem/operations.hpp>
+#include <limits>
+#include <snappy.h>
+#include <zstd.h>
+
+#include "mongo/base/counter.h"
+#include "mongo/db/commands/server_status_metric.h"
+#include "mongo/db/sorter/sorter_spill_gen.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/unordered_map.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace sorter {
+namespace {
+
+// Bytes written to spill files since startup, before and after compression.
+Counter64 spilledBytes;
+Counter64 spilledUncompressedBytes;
+
+// Bytes held by spill files which have not been removed yet.
+Counter64 spillSpaceInUseBytes;
+
+// Bytes reserved for each spill file which has not been removed yet. Removing a file gives back
+// exactly what was reserved for it, whatever ended up on disk after a failed or partial append.
+Mutex spillFilesMutex = MONGO_MAKE_LATCH("sorter::spillFilesMutex");
+stdx::unordered_map<std::string, long long> spillFileReservedBytes;
+
+// Number of spills rejected because they would have exceeded the spill space budget.
+Counter64 spillSpaceBudgetExceeded;
+
+ServerStatusMetricField<Counter64> displaySpilledBytes("sorter.spilledBytes", &spilledBytes);
+ServerStatusMetricField<Counter64> displaySpilledUncompressedBytes(
+    "sorter.spilledUncompressedBytes", &spilledUncompressedBytes);
+ServerStatusMetricField<Counter64> displaySpillSpaceInUseBytes("sorter.spillSpaceInUseBytes",
+                                                               &spillSpaceInUseBytes);
+ServerStatusMetricField<Counter64> displaySpillSpaceBudgetExceeded(
+    "sorter.spillSpaceBudgetExceeded", &spillSpaceBudgetExceeded);
+
+StatusWith<SpillCompressor> parseSpillCompressor(StringData name) {
+    if (name == "none")
+        return SpillCompressor::kNone;
+    if (name == "snappy")
+        return SpillCompressor::kSnappy;
+    if (name == "zstd")
+        return SpillCompressor::kZstd;
+    return Status(ErrorCodes::BadValue,
+                  str::stream() << "Unrecognized sorter spill compressor '" << name
+                                << "'; expected one of 'none', 'snappy' or 'zstd'");
+}
+
+ThreadPool* makeTaskPool(const std::string& poolName) {
+    ThreadPool::Options options;
+    options.poolName = poolName;
+    options.threadNamePrefix = poolName + "-";
+    options.minThreads = 0;
+    options.maxThreads = gParallelExtSortPoolThreads;
+
+    // Never destroyed, so that it outlives any sort still running when the process exits.
+    auto pool = new ThreadPool(std::move(options));
+    pool->startup();
+    return pool;
+}
+
+Future<void> scheduleTask(ThreadPool* pool, unique_function<void()> task) {
+    auto pf = makePromiseFuture<void>();
+    pool->schedule([promise = std::move(pf.promise), task = std::move(task)](Status status) mutable {
+        if (!status.isOK()) {
+            promise.setError(std::move(status));
+            return;
+        }
+        promise.setWith(task);
+    });
+    return std::move(pf.future);
+}
+
+}  // namespace
+
+Future<void> scheduleSpillTask(unique_function<void()> task) {
+    static ThreadPool* const pool = makeTaskPool("SorterSpill");
+    return scheduleTask(pool, std::move(task));
+}
+
+Future<void> scheduleSortSliceTask(unique_function<void()> task) {
+    static ThreadPool* const pool = makeTaskPool("SorterSortSlice");
+    return scheduleTask(pool, std::move(task));
+}
+
+Status validateSpillCompressor(const std::string& name) {
+    return parseSpillCompressor(name).getStatus();
+}
+
+SpillCompressor getDefaultSpillCompressor() {
+    return uassertStatusOK(parseSpillCompressor(gSpillCompressorName.get()));
+}
+
+size_t getDefaultSpillBlockSizeBytes() {
+    return gSpillBlockSizeBytes.load();
+}
+
+size_t getSpillReadAheadBytes() {
+    return gSpillReadAheadBytes.load();
+}
+
+bool useParallelExtSort() {
+    return gParallelExtSort.load();
+}
+
+size_t getParallelExtSortThreads() {
+    return gParallelExtSortThreads.load();
+}
+
+bool compressSpillBlock(SpillCompressor compressor,
+                        const char* data,
+                        size_t size,
+                        std::string* out) {
+    switch (compressor) {
+        case SpillCompressor::kNone:
+            return false;
+        case SpillCompressor::kSnappy:
+            snappy::Compress(data, size, out);
+            break;
+        case SpillCompressor::kZstd: {
+            out->resize(ZSTD_compressBound(size));
+            size_t ret = ZSTD_compress(&(*out)[0], out->size(), data, size, ZSTD_CLEVEL_DEFAULT);
+            uassert(4840001,
+                    str::stream() << "Failed to compress sorter spill block: "
+                                  << ZSTD_getErrorName(ret),
+                    !ZSTD_isError(ret));
+            out->resize(ret);
+            break;
+        }
+    }
+    invariant(out->size() <= size_t(std::numeric_limits<int32_t>::max()));
+    return out->size() < size / 10 * 9;
+}
+
+size_t decompressSpillBlock(SpillCompressor compressor,
+                            const char* data,
+                            size_t size,
+                            std::unique_ptr<char[]>* out) {
+    switch (compressor) {
+        case SpillCompressor::kNone:
+            uasserted(4840004, "found a compressed block in an uncompressed spill file");
+        case SpillCompressor::kSnappy: {
+            dassert(snappy::IsValidCompressedBuffer(data, size));
+
+            size_t uncompressedSize;
+            uassert(17061,
+                    "couldn't get uncompressed length",
+                    snappy::GetUncompressedLength(data, size, &uncompressedSize));
+
+            out->reset(new char[uncompressedSize]);
+            uassert(17062, "decompression failed", snappy::RawUncompress(data, size, out->get()));
+            return uncompressedSize;
+        }
+        case SpillCompressor::kZstd: {
+            unsigned long long uncompressedSize = ZSTD_getFrameContentSize(data, size);
+            uassert(4840002,
+                    "couldn't get uncompressed length",
+                    uncompressedSize != ZSTD_CONTENTSIZE_UNKNOWN &&
+                        uncompressedSize != ZSTD_CONTENTSIZE_ERROR);
+
+            out->reset(new char[uncompressedSize]);
+            size_t ret = ZSTD_decompress(out->get(), uncompressedSize, data, size);
+            uassert(4840003,
+                    str::stream() << "decompression failed: " << ZSTD_getErrorName(ret),
+                    !ZSTD_isError(ret) && ret == uncompressedSize);
+            return uncompressedSize;
+        }
+    }
+    MONGO_UNREACHABLE;
+}
+
+void reserveSpillSpace(const std::string& fileName,
+                       size_t compressedBytes,
+                       size_t uncompressedBytes) {
+    const long long maxSpillBytes = gMaxSpillBytes.load();
+
+    // Reserve first and back out on failure, so that concurrent spills can never jointly exceed
+    // the budget. A spill may be turned away spuriously while another is backing out, which is
+    // acceptable for a limit meant to protect the disk.
+    spillSpaceInUseBytes.increment(compressedBytes);
+    if (maxSpillBytes > 0 && spillSpaceInUseBytes.get() > maxSpillBytes) {
+        spillSpaceInUseBytes.decrement(compressedBytes);
+        spillSpaceBudgetExceeded.increment();
+        uasserted(ErrorCodes::OutOfDiskSpace,
+                  str::stream() << "Sort exceeded the server-wide limit of " << maxSpillBytes
+                                << " bytes of spill space set by "
+                                   "internalQueryExternalSortMaxSpillBytes");
+    }
+
+    {
+        stdx::lock_guard<Latch> lk(spillFilesMutex);
+        spillFileReservedBytes[fileName] += compressedBytes;
+    }
+
+    spilledBytes.increment(compressedBytes);
+    spilledUncompressedBytes.increment(uncompressedBytes);
+}
+
+void releaseSpillSpace(const std::string& fileName,
+                       size_t compressedBytes,
+                       size_t uncompressedBytes) {
+    {
+        stdx::lock_guard<Latch> lk(spillFilesMutex);
+        auto it = spillFileReservedBytes.find(fileName);
+        invariant(it != spillFileReservedBytes.end() &&
+                  it->second >= static_cast<long long>(compressedBytes));
+        it->second -= compressedBytes;
+    }
+
+    spillSpaceInUseBytes.decrement(compressedBytes);
+    spilledBytes.decrement(compressedBytes);
+    spilledUncompressedBytes.decrement(uncompressedBytes);
+}
+
+void removeSpillFile(const std::string& fileName) {
+    long long reservedBytes = 0;
+    {
+        stdx::lock_guard<Latch> lk(spillFilesMutex);
+        auto it = spillFileReservedBytes.find(fileName);
+        if (it != spillFileReservedBytes.end()) {
+            reservedBytes = it->second;
+            spillFileReservedBytes.erase(it);
+        }
+    }
+    spillSpaceInUseBytes.decrement(reservedBytes);
+
+    boost::filesystem::remove(fileName);
+}
+
+long long getSpillSpaceInUseBytes() {
+    return spillSpaceInUseBytes.get();
+}
+
+}  // namespace sorter
+}  // namespace mongo
@@ -0,0 +1,147 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+#include "mongo/base/status.h"
+#include "mongo/base/string_data.h"
+#include "mongo/util/functional.h"
+#include "mongo/util/future.h"
+
+namespace mongo {
+namespace sorter {
+
+/**
+ * Codec used to compress the blocks of a sorter spill file. All blocks written by a single
+ * SortedFileWriter use the same compressor, which is handed to the FileIterator reading them back.
+ */
+enum class SpillCompressor { kNone, kSnappy, kZstd };
+
+/**
+ * Returns the compressor named by the 'internalQueryExternalSortCompressor' server parameter.
+ */
+SpillCompressor getDefaultSpillCompressor();
+
+/**
+ * Returns the block size named by the 'internalQueryExternalSortBlockSizeBytes' server parameter.
+ */
+size_t getDefaultSpillBlockSizeBytes();
+
+/**
+ * Returns the number of bytes each FileIterator should buffer ahead of the block it is currently
+ * decoding, as named by the 'internalQueryExternalSortReadAheadBytes' server parameter.
+ */
+size_t getSpillReadAheadBytes();
+
+/**
+ * Returns whether callers of the Sorter which can spill should set SortOptions::parallelExtSort, as
+ * named by the 'internalQueryExternalSortParallel' server parameter.
+ */
+bool useParallelExtSort();
+
+/**
+ * Returns the number of threads a parallel external sort uses to sort each run, as named by the
+ * 'internalQueryExternalSortParallelThreads' server parameter.
+ */
+size_t getParallelExtSortThreads();
+
+/**
+ * Runs 'task' on the pool of threads which write out the runs of every parallel external sort in
+ * the process, and returns a Future which becomes ready once 'task' has run. The pool has at most
+ * 'internalQueryExternalSortParallelPoolThreads' threads.
+ */
+Future<void> scheduleSpillTask(unique_function<void()> task);
+
+/**
+ * Same as scheduleSpillTask(), for the slices which a parallel external sort sorts concurrently.
+ * Spill tasks wait for the slices of their run, so slices have a pool of their own, and a slice
+ * task must never wait for another task.
+ */
+Future<void> scheduleSortSliceTask(unique_function<void()> task);
+
+/**
+ * Compresses 'size' bytes at 'data' with 'compressor' into 'out'. Returns false if the compressed
+ * block would not be at least 10% smaller than the original, in which case the block should be
+ * written uncompressed and the contents of 'out' are unspecified.
+ */
+bool compressSpillBlock(SpillCompressor compressor,
+                        const char* data,
+                        size_t size,
+                        std::string* out);
+
+/**
+ * Decompresses the 'size' bytes at 'data', which were compressed with 'compressor', into a newly
+ * allocated buffer stored in 'out'. Returns the uncompressed size. Throws if the block is corrupt.
+ */
+size_t decompressSpillBlock(SpillCompressor compressor,
+                            const char* data,
+                            size_t size,
+                            std::unique_ptr<char[]>* out);
+
+/**
+ * Accounts for 'compressedBytes' about to be appended to the spill file 'fileName', holding
+ * 'uncompressedBytes' of sorted data. Throws OutOfDiskSpace, without reserving anything, if doing
+ * so would take the space used by spill files across the server over
+ * 'internalQueryExternalSortMaxSpillBytes'. The reservation is held until the file is removed, or
+ * until it is handed back with releaseSpillSpace() because the append failed.
+ */
+void reserveSpillSpace(const std::string& fileName,
+                       size_t compressedBytes,
+                       size_t uncompressedBytes);
+
+/**
+ * Returns a reservation made by reserveSpillSpace() for an append to 'fileName' which did not
+ * happen, taking it back out of the spill statistics as well.
+ */
+void releaseSpillSpace(const std::string& fileName,
+                       size_t compressedBytes,
+                       size_t uncompressedBytes);
+
+/**
+ * Deletes the spill file 'fileName', if it exists, and returns everything reserved for it to the
+ * budget checked by reserveSpillSpace(). Every spill file must be removed through this function.
+ */
+void removeSpillFile(const std::string& fileName);
+
+/**
+ * Returns the number of bytes currently held by spill files across the server.
+ */
+long long getSpillSpaceInUseBytes();
+
+/**
+ * Used by the IDL to validate the 'internalQueryExternalSortCompressor' server parameter.
+ */
+Status validateSpillCompressor(const std::string& name);
+
+}  // namespace sorter
+}  // namespace mongo
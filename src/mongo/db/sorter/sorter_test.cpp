@@ -38,10 +38,12 @@
 #include "mongo/base/static_assert.h"
 #include "mongo/config.h"
 #include "mongo/db/service_context_test_fixture.h"
+#include "mongo/db/sorter/sorter_spill_gen.h"
 #include "mongo/platform/random.h"
 #include "mongo/stdx/thread.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/str.h"
 
 #include <memory>
@@ -103,6 +105,43 @@ private:
     int _i;
 };
 
+/**
+ * An int which is serialized as its difference from the key before it in a spilled block.
+ */
+class DeltaIntWrapper {
+public:
+    DeltaIntWrapper(int i = 0) : _i(i) {}
+    operator const int&() const {
+        return _i;
+    }
+
+    /// members for Sorter
+    struct SorterDeserializeSettings {};  // unused
+    void serializeForSorter(BufBuilder& buf) const {
+        buf.appendNum(_i);
+    }
+    void serializeForSorter(BufBuilder& buf, const DeltaIntWrapper& previous) const {
+        buf.appendNum(_i - previous._i);
+    }
+    static DeltaIntWrapper deserializeForSorter(BufReader& buf, const SorterDeserializeSettings&) {
+        return buf.read<LittleEndian<int>>().value;
+    }
+    static DeltaIntWrapper deserializeForSorter(BufReader& buf,
+                                                const SorterDeserializeSettings&,
+                                                const DeltaIntWrapper& previous) {
+        return previous._i + buf.read<LittleEndian<int>>().value;
+    }
+    int memUsageForSorter() const {
+        return sizeof(DeltaIntWrapper);
+    }
+    DeltaIntWrapper getOwned() const {
+        return *this;
+    }
+
+private:
+    int _i;
+};
+
 typedef pair<IntWrapper, IntWrapper> IWPair;
 typedef SortIteratorInterface<IntWrapper, IntWrapper> IWIterator;
 typedef Sorter<IntWrapper, IntWrapper> IWSorter;
@@ -309,14 +348,152 @@ public:
     }
 };
 
+class SortedFileWriterSpillOptionsTests : public ScopedGlobalServiceContextForTest {
+public:
+    void run() {
+        unittest::TempDir tempDir("sortedFileWriterSpillOptionsTests");
+        const long long spillSpaceAtStart = getSpillSpaceInUseBytes();
+
+        for (auto compressor :
+             {SpillCompressor::kNone, SpillCompressor::kSnappy, SpillCompressor::kZstd}) {
+            // Small blocks, so that each file holds many of them.
+            const SortOptions opts =
+                SortOptions().TempDir(tempDir.path()).SpillBlockSizeBytes(4096).SpillCompressor(
+                    compressor);
+            std::string fileName = opts.tempDir + "/" + nextFileName();
+            SortedFileWriter<IntWrapper, IntWrapper> sorter(opts, fileName, 0);
+            for (int i = 0; i < 100 * 1000; i++)
+                sorter.addAlreadySorted(i, -i);
+
+            ASSERT_ITERATORS_EQUIVALENT(std::shared_ptr<IWIterator>(sorter.done()),
+                                        make_shared<IntIterator>(0, 100 * 1000));
+
+            // Everything written is accounted for until the file is removed.
+            ASSERT_EQ(getSpillSpaceInUseBytes() - spillSpaceAtStart,
+                      static_cast<long long>(boost::filesystem::file_size(fileName)));
+            removeSpillFile(fileName);
+            ASSERT_EQ(getSpillSpaceInUseBytes(), spillSpaceAtStart);
+        }
+
+        ASSERT(boost::filesystem::is_empty(tempDir.path()));
+    }
+};
+
+class SortedFileWriterKeyWithPreviousTests : public ScopedGlobalServiceContextForTest {
+public:
+    void run() {
+        unittest::TempDir tempDir("sortedFileWriterKeyWithPreviousTests");
+
+        // Small blocks, so that the first key of each block is serialized on its own many times.
+        const SortOptions opts = SortOptions().TempDir(tempDir.path()).SpillBlockSizeBytes(4096);
+        std::string fileName = opts.tempDir + "/" + nextFileName();
+        SortedFileWriter<DeltaIntWrapper, IntWrapper> sorter(opts, fileName, 0);
+        for (int i = 1000; i < 100 * 1000; i += 3)
+            sorter.addAlreadySorted(i, -i);
+
+        std::unique_ptr<SortIteratorInterface<DeltaIntWrapper, IntWrapper>> it(sorter.done());
+        it->openSource();
+        for (int i = 1000; i < 100 * 1000; i += 3) {
+            ASSERT(it->more());
+            auto data = it->next();
+            ASSERT_EQ(static_cast<int>(data.first), i);
+            ASSERT_EQ(static_cast<int>(data.second), -i);
+        }
+        ASSERT(!it->more());
+        it->closeSource();
+
+        removeSpillFile(fileName);
+        ASSERT(boost::filesystem::is_empty(tempDir.path()));
+    }
+};
+
+class SpillSpaceBudgetTests : public ScopedGlobalServiceContextForTest {
+public:
+    void run() {
+        unittest::TempDir tempDir("spillSpaceBudgetTests");
+        const SortOptions opts = SortOptions().TempDir(tempDir.path());
+        const long long spillSpaceAtStart = getSpillSpaceInUseBytes();
+
+        const long long originalMaxSpillBytes = gMaxSpillBytes.load();
+        gMaxSpillBytes.store(spillSpaceAtStart + 64 * 1024);
+        ON_BLOCK_EXIT([&] { gMaxSpillBytes.store(originalMaxSpillBytes); });
+
+        std::string fileName = opts.tempDir + "/" + nextFileName();
+        {
+            SortedFileWriter<IntWrapper, IntWrapper> sorter(opts, fileName, 0);
+            ASSERT_THROWS_CODE(
+                [&] {
+                    for (int i = 0; i < 10 * 1000 * 1000; i++)
+                        sorter.addAlreadySorted(i, -i);
+                }(),
+                DBException,
+                ErrorCodes::OutOfDiskSpace);
+        }
+
+        // The blocks written before the budget ran out stay accounted for until the file is gone.
+        ASSERT_GT(getSpillSpaceInUseBytes(), spillSpaceAtStart);
+        removeSpillFile(fileName);
+        ASSERT_EQ(getSpillSpaceInUseBytes(), spillSpaceAtStart);
+        ASSERT(boost::filesystem::is_empty(tempDir.path()));
+    }
+};
+
+class SpillSpaceReleaseTests {
+public:
+    void run() {
+        unittest::TempDir tempDir("spillSpaceReleaseTests");
+        const std::string fileName = tempDir.path() + "/" + nextFileName();
+        const long long spillSpaceAtStart = getSpillSpaceInUseBytes();
+
+        // An append which fails after reserving hands its reservation straight back.
+        reserveSpillSpace(fileName, 1000, 4000);
+        reserveSpillSpace(fileName, 500, 2000);
+        releaseSpillSpace(fileName, 500, 2000);
+        ASSERT_EQ(getSpillSpaceInUseBytes() - spillSpaceAtStart, 1000);
+
+        // Removing the file gives back what was reserved for it, not what happens to be on disk.
+        removeSpillFile(fileName);
+        ASSERT_EQ(getSpillSpaceInUseBytes(), spillSpaceAtStart);
+        ASSERT(boost::filesystem::is_empty(tempDir.path()));
+    }
+};
+
+class ParallelStableSortTests {
+public:
+    void run() {
+        // Few distinct keys, so that stability is observable through the values.
+        std::deque<IWPair> data;
+        PseudoRandom random(int64_t(time(nullptr)));
+        for (int i = 0; i < 200 * 1000; i++)
+            data.emplace_back(random.nextInt32(100), i);
+
+        auto less = [](const IWPair& lhs, const IWPair& rhs) { return lhs.first < rhs.first; };
+        std::deque<IWPair> expected = data;
+        std::stable_sort(expected.begin(), expected.end(), less);
+
+        for (size_t numThreads : {1, 2, 3, 4, 7}) {
+            std::deque<IWPair> sorted = data;
+            parallelStableSort(&sorted, numThreads, less);
+            ASSERT_EQ(sorted.size(), expected.size());
+            for (size_t i = 0; i < sorted.size(); i++) {
+                ASSERT_EQ(sorted[i].first, expected[i].first);
+                ASSERT_EQ(sorted[i].second, expected[i].second);
+            }
+        }
+    }
+};
 
+template <bool Parallel>
 class MergeIteratorTests {
 public:
     void run() {
+        // Exercises the tournament tree merge when 'Parallel' is set, and the heap merge otherwise.
+        const SortOptions opts = SortOptions().ParallelExtSort(Parallel);
+
         {  // test empty (no inputs)
             std::vector<std::shared_ptr<IWIterator>> vec;
             std::shared_ptr<IWIterator> mergeIter(
-                IWIterator::merge(vec, "", SortOptions(), IWComparator()));
+                IWIterator::merge(vec, "", opts, IWComparator()));
             ASSERT_ITERATORS_EQUIVALENT(mergeIter, make_shared<EmptyIterator>());
         }
         {  // test empty (only empty inputs)
@@ -324,7 +501,7 @@ public:
                                                        make_shared<EmptyIterator>(),
                                                        make_shared<EmptyIterator>()};
 
-            ASSERT_ITERATORS_EQUIVALENT(mergeIterators(iterators, ASC),
+            ASSERT_ITERATORS_EQUIVALENT(mergeIterators(iterators, ASC, opts),
                                         make_shared<EmptyIterator>());
         }
 
@@ -335,7 +512,7 @@ public:
                 make_shared<IntIterator>(0, 20, 2)  // 0, 2, ... 18
             };
 
-            ASSERT_ITERATORS_EQUIVALENT(mergeIterators(iterators, ASC),
+            ASSERT_ITERATORS_EQUIVALENT(mergeIterators(iterators, ASC, opts),
                                         make_shared<IntIterator>(0, 20, 1));
         }
 
@@ -349,7 +526,7 @@ public:
                 ,
                 make_shared<EmptyIterator>()};
 
-            ASSERT_ITERATORS_EQUIVALENT(mergeIterators(iterators, DESC),
+            ASSERT_ITERATORS_EQUIVALENT(mergeIterators(iterators, DESC, opts),
                                         make_shared<IntIterator>(30, 0, -1));
         }
         {  // test Limit
@@ -360,9 +537,18 @@ public:
             };
 
             ASSERT_ITERATORS_EQUIVALENT(
-                mergeIterators(iterators, ASC, SortOptions().Limit(10)),
+                mergeIterators(iterators, ASC, SortOptions(opts).Limit(10)),
                 make_shared<LimitIterator>(10, make_shared<IntIterator>(0, 20, 1)));
         }
+        {  // test many sources, so that the tournament tree is not a perfect binary tree
+            std::vector<std::shared_ptr<IWIterator>> vec;
+            for (int i = 0; i < 37; i++)
+                vec.push_back(make_shared<IntIterator>(i, 1000, 37));
+
+            ASSERT_ITERATORS_EQUIVALENT(
+                std::shared_ptr<IWIterator>(IWIterator::merge(vec, "", opts, IWComparator(ASC))),
+                make_shared<IntIterator>(0, 1000, 1));
+        }
     }
 };
 
@@ -552,6 +738,24 @@ public:
     PseudoRandom _random;
 };
 
+// Sorts and spills runs on background threads. The memory limit is large enough for each run to
+// be sorted by several threads.
+template <bool Random = true>
+class LotsOfDataParallel : public LotsOfDataLittleMemory<Random> {
+    SortOptions adjustSortOptions(SortOptions opts) override {
+        return opts.MaxMemoryUsageBytes(1024 * 1024).ExtSortAllowed().ParallelExtSort();
+    }
+};
+
+// Spills many small zstd-compressed blocks, so that the merge reads from each file through its
+// read-ahead buffer many times.
+class LotsOfDataSmallZstdBlocks : public LotsOfDataLittleMemory</*random=*/true> {
+    SortOptions adjustSortOptions(SortOptions opts) override {
+        return LotsOfDataLittleMemory::adjustSortOptions(opts)
+            .SpillBlockSizeBytes(4096)
+            .SpillCompressor(SpillCompressor::kZstd);
+    }
+};
 
 template <long long Limit, bool Random = true>
 class LotsOfDataWithLimit : public LotsOfDataLittleMemory<Random> {
@@ -588,12 +792,21 @@ public:
     void setupTests() override {
         add<InMemIterTests>();
         add<SortedFileWriterAndFileIteratorTests>();
-        add<MergeIteratorTests>();
+        add<SortedFileWriterSpillOptionsTests>();
+        add<SortedFileWriterKeyWithPreviousTests>();
+        add<SpillSpaceBudgetTests>();
+        add<SpillSpaceReleaseTests>();
+        add<MergeIteratorTests</*parallel=*/false>>();
+        add<MergeIteratorTests</*parallel=*/true>>();
+        add<ParallelStableSortTests>();
         add<SorterTests::Basic>();
         add<SorterTests::Limit>();
         add<SorterTests::Dupes>();
         add<SorterTests::LotsOfDataLittleMemory</*random=*/false>>();
         add<SorterTests::LotsOfDataLittleMemory</*random=*/true>>();
+        add<SorterTests::LotsOfDataSmallZstdBlocks>();
+        add<SorterTests::LotsOfDataParallel</*random=*/false>>();
+        add<SorterTests::LotsOfDataParallel</*random=*/true>>();
         add<SorterTests::LotsOfDataWithLimit<1, /*random=*/false>>();     // limit=1 is special case
         add<SorterTests::LotsOfDataWithLimit<1, /*random=*/true>>();      // limit=1 is special case
         add<SorterTests::LotsOfDataWithLimit<100, /*random=*/false>>();   // fits in mem
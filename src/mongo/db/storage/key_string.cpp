@@ -40,6 +40,7 @@
 #include "mongo/base/data_view.h"
 #include "mongo/bson/bson_depth.h"
 #include "mongo/platform/bits.h"
+#include "mongo/platform/byte_mask.h"
 #include "mongo/platform/strnlen.h"
 #include "mongo/util/decimal_counter.h"
 #include "mongo/util/hex.h"
@@ -2563,6 +2564,67 @@ int compare(const char* leftBuf, const char* rightBuf, size_t leftSize, size_t r
     return leftSize < rightSize ? -1 : 1;
 }
 
+size_t commonPrefixSize(const char* leftBuf, const char* rightBuf, size_t size) {
+    size_t pos = 0;
+
+#ifdef MONGO_HAVE_VECTOR_BYTE_MASK
+    for (; pos + byte_mask::kVectorSize <= size; pos += byte_mask::kVectorSize) {
+        const uint64_t differing =
+            ~byte_mask::equal(leftBuf + pos, rightBuf + pos) & byte_mask::kAllBytes;
+        if (differing)
+            return pos + byte_mask::firstByte(differing);
+    }
+#endif
+
+    // Whatever is left is less than a vector, or there are no vectors on this platform.
+    for (; pos + sizeof(uint64_t) <= size; pos += sizeof(uint64_t)) {
+        const uint64_t differing = ConstDataView(leftBuf).read<LittleEndian<uint64_t>>(pos) ^
+            ConstDataView(rightBuf).read<LittleEndian<uint64_t>>(pos);
+        if (differing)
+            return pos + countTrailingZeros64(differing) / 8;
+    }
+    while (pos < size && leftBuf[pos] == rightBuf[pos]) {
+        ++pos;
+    }
+    return pos;
+}
+
+void Value::serializeWithPrefix(BufBuilder& buf, const Value& previous) const {
+    const size_t shared =
+        commonPrefixSize(_buffer.get(),
+                         previous.getBuffer(),
+                         std::min({getSize(), previous.getSize(), size_t{UINT8_MAX}}));
+
+    buf.appendUChar(static_cast<uint8_t>(shared));
+    buf.appendNum(static_cast<int32_t>(_ksSize - shared));  // Serialize the rest of the KeyString
+    buf.appendBuf(_buffer.get() + shared, _bufSize - shared);  // Serialize the rest + TypeBits
+}
+
+Value Value::deserializeWithPrefix(BufReader& buf,
+                                   KeyString::Version version,
+                                   const Value& previous) {
+    const uint8_t shared = buf.read<uint8_t>();
+    keyStringAssert(31411,
+                    "KeyString shares more bytes with the previous key than it has",
+                    shared <= previous.getSize());
+    const int32_t sizeOfRest = buf.read<LittleEndian<int32_t>>();
+    const void* restPtr = buf.skip(sizeOfRest);
+
+    BufBuilder newBuf(shared + sizeOfRest + 1);
+    if (shared) {
+        newBuf.appendBuf(previous.getBuffer(), shared);
+    }
+    newBuf.appendBuf(restPtr, sizeOfRest);
+
+    auto typeBits = TypeBits::fromBuffer(version, &buf);  // advances the buf
+    if (typeBits.isAllZeros()) {
+        newBuf.appendChar(0);
+    } else {
+        newBuf.appendBuf(typeBits.getBuffer(), typeBits.getSize());
+    }
+    return {version, shared + sizeOfRest, newBuf.len(), newBuf.release()};
+}
+
 template class BuilderBase<BufBuilder>;
 template class BuilderBase<StackBufBuilder>;
 
@@ -379,6 +379,18 @@ public:
         return {version, sizeOfKeystring, newBuf.len(), newBuf.release()};
     }
 
+    // Serializes this Value like serialize(), except that the leading bytes of the KeyString which
+    // it shares with 'previous' are left out. Takes the following form:
+    //   [shared prefix size][remaining keystring size][remaining keystring encoding]
+    //   [typebits encoding]
+    // The shared prefix size is a single byte, so at most 255 bytes are left out.
+    void serializeWithPrefix(BufBuilder& buf, const Value& previous) const;
+
+    // Deserialize a Value which was serialized with serializeWithPrefix() against 'previous'.
+    static Value deserializeWithPrefix(BufReader& buf,
+                                       KeyString::Version version,
+                                       const Value& previous);
+
     /// Members for Sorter
     struct SorterDeserializeSettings {
         SorterDeserializeSettings(Version version) : keyStringVersion(version) {}
@@ -393,6 +405,18 @@ public:
         return deserialize(buf, settings.keyStringVersion);
     }
 
+    // Keys come out of a sort in order, so consecutive keys in a spilled block tend to share long
+    // prefixes, particularly with compound and string-heavy indexes.
+    void serializeForSorter(BufBuilder& buf, const Value& previous) const {
+        serializeWithPrefix(buf, previous);
+    }
+
+    static Value deserializeForSorter(BufReader& buf,
+                                      const SorterDeserializeSettings& settings,
+                                      const Value& previous) {
+        return deserializeWithPrefix(buf, settings.keyStringVersion, previous);
+    }
+
     int memUsageForSorter() const {
         // Use buffer capacity as a more accurate measure of memory usage.
         return sizeof(Value) + _buffer.capacity();
@@ -866,6 +890,12 @@ RecordId decodeRecordId(BufReader* reader);
 
 int compare(const char* leftBuf, const char* rightBuf, size_t leftSize, size_t rightSize);
 
+/**
+ * Returns how many leading bytes 'leftBuf' and 'rightBuf' have in common, looking at no more than
+ * 'size' bytes of each.
+ */
+size_t commonPrefixSize(const char* leftBuf, const char* rightBuf, size_t size);
+
 template <class BufferT>
 template <class T>
 int BuilderBase<BufferT>::compare(const T& other) const {
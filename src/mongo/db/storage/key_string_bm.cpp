@@ -31,6 +31,7 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 #include <benchmark/benchmark.h>
 #include <random>
 #include <vector>
@@ -208,6 +209,113 @@ void BM_KeyStringStackBuilderCopy(benchmark::State& state, BsonValueType bsonTyp
     state.SetItemsProcessed(state.iterations() * kSampleSize);
 }
 
+enum SortedRunType {
+    // Compound keys with low-cardinality leading fields, as on {tenant: 1, status: 1, ts: 1}.
+    COMPOUND,
+    // Long strings with long shared prefixes, like paths or URLs.
+    STRING_HEAVY,
+};
+
+/**
+ * Generates keys in the order a bulk build's sorter emits them.
+ */
+std::vector<KeyString::Value> generateSortedRun(SortedRunType runType) {
+    const auto version = KeyString::Version::V1;
+    std::vector<KeyString::Value> keys;
+    for (int i = 0; i < kSampleSize; i++) {
+        BSONObj bson;
+        switch (runType) {
+            case COMPOUND:
+                bson = BSON("" << ("tenant-" + std::to_string(1000 + i / 100)) << ""
+                               << (i % 100 < 50 ? "active" : "inactive") << "" << (i * 37));
+                break;
+            case STRING_HEAVY:
+                bson = BSON("" << ("https://www.example.com/catalog/products/category-" +
+                                   std::to_string(1000 + i / 50) + "/item-" +
+                                   std::to_string(100000 + i)));
+                break;
+        }
+        keys.push_back(KeyString::HeapBuilder(version, bson, ALL_ASCENDING, RecordId(i + 1))
+                           .release());
+    }
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+void BM_KeyStringSerializeSortedRun(benchmark::State& state,
+                                    SortedRunType runType,
+                                    bool withPrefix) {
+    const auto keys = generateSortedRun(runType);
+    size_t serializedSize = 0;
+    for (auto _ : state) {
+        benchmark::ClobberMemory();
+        BufBuilder buf;
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (withPrefix) {
+                keys[i].serializeWithPrefix(buf, i ? keys[i - 1] : KeyString::Value());
+            } else {
+                keys[i].serialize(buf);
+            }
+        }
+        serializedSize = buf.len();
+        benchmark::DoNotOptimize(buf.buf());
+    }
+    state.counters["bytesPerKey"] = static_cast<double>(serializedSize) / keys.size();
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+void BM_KeyStringDeserializeSortedRun(benchmark::State& state,
+                                      SortedRunType runType,
+                                      bool withPrefix) {
+    const auto version = KeyString::Version::V1;
+    const auto keys = generateSortedRun(runType);
+    BufBuilder buf;
+    for (size_t i = 0; i < keys.size(); i++) {
+        if (withPrefix) {
+            keys[i].serializeWithPrefix(buf, i ? keys[i - 1] : KeyString::Value());
+        } else {
+            keys[i].serialize(buf);
+        }
+    }
+
+    for (auto _ : state) {
+        benchmark::ClobberMemory();
+        BufReader reader(buf.buf(), buf.len());
+        KeyString::Value previous;
+        while (!reader.atEof()) {
+            previous = withPrefix
+                ? KeyString::Value::deserializeWithPrefix(reader, version, previous)
+                : KeyString::Value::deserialize(reader, version);
+        }
+        benchmark::DoNotOptimize(previous);
+    }
+    state.SetBytesProcessed(state.iterations() * buf.len());
+    state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+void BM_KeyStringCompareAdjacent(benchmark::State& state, SortedRunType runType) {
+    const auto keys = generateSortedRun(runType);
+    for (auto _ : state) {
+        for (size_t i = 1; i < keys.size(); i++) {
+            benchmark::DoNotOptimize(keys[i].compare(keys[i - 1]));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * (keys.size() - 1));
+}
+
+void BM_KeyStringCommonPrefixSizeAdjacent(benchmark::State& state, SortedRunType runType) {
+    const auto keys = generateSortedRun(runType);
+    for (auto _ : state) {
+        for (size_t i = 1; i < keys.size(); i++) {
+            benchmark::DoNotOptimize(
+                KeyString::commonPrefixSize(keys[i].getBuffer(),
+                                            keys[i - 1].getBuffer(),
+                                            std::min(keys[i].getSize(), keys[i - 1].getSize())));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * (keys.size() - 1));
+}
+
 BENCHMARK_CAPTURE(BM_KeyStringValueAssign, Int, INT);
 BENCHMARK_CAPTURE(BM_KeyStringValueAssign, Double, DOUBLE);
 BENCHMARK_CAPTURE(BM_KeyStringValueAssign, Decimal, DECIMAL);
@@ -246,5 +354,20 @@ BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_String, KeyString::Version::V1, STRING)
 BENCHMARK_CAPTURE(BM_KeyStringToBSON, V0_Array, KeyString::Version::V0, ARRAY);
 BENCHMARK_CAPTURE(BM_KeyStringToBSON, V1_Array, KeyString::Version::V1, ARRAY);
 
+BENCHMARK_CAPTURE(BM_KeyStringSerializeSortedRun, Compound, COMPOUND, false);
+BENCHMARK_CAPTURE(BM_KeyStringSerializeSortedRun, CompoundWithPrefix, COMPOUND, true);
+BENCHMARK_CAPTURE(BM_KeyStringSerializeSortedRun, StringHeavy, STRING_HEAVY, false);
+BENCHMARK_CAPTURE(BM_KeyStringSerializeSortedRun, StringHeavyWithPrefix, STRING_HEAVY, true);
+
+BENCHMARK_CAPTURE(BM_KeyStringDeserializeSortedRun, Compound, COMPOUND, false);
+BENCHMARK_CAPTURE(BM_KeyStringDeserializeSortedRun, CompoundWithPrefix, COMPOUND, true);
+BENCHMARK_CAPTURE(BM_KeyStringDeserializeSortedRun, StringHeavy, STRING_HEAVY, false);
+BENCHMARK_CAPTURE(BM_KeyStringDeserializeSortedRun, StringHeavyWithPrefix, STRING_HEAVY, true);
+
+BENCHMARK_CAPTURE(BM_KeyStringCompareAdjacent, Compound, COMPOUND);
+BENCHMARK_CAPTURE(BM_KeyStringCompareAdjacent, StringHeavy, STRING_HEAVY);
+BENCHMARK_CAPTURE(BM_KeyStringCommonPrefixSizeAdjacent, Compound, COMPOUND);
+BENCHMARK_CAPTURE(BM_KeyStringCommonPrefixSizeAdjacent, StringHeavy, STRING_HEAVY);
+
 }  // namespace
 }  // namespace mongo
@@ -1876,6 +1876,58 @@ TEST_F(KeyStringBuilderTest, DecimalFromUniformDoublePerf) {
     perfTest(version, numbers);
 }
 
+TEST(KeyStringTest, CommonPrefixSize) {
+    // Cover mismatches on both sides of vector and word boundaries, and no mismatch at all.
+    std::string left(100, 'x');
+    for (size_t size = 0; size <= left.size(); ++size) {
+        ASSERT_EQ(KeyString::commonPrefixSize(left.data(), left.data(), size), size);
+        for (size_t pos = 0; pos < size; ++pos) {
+            std::string right = left;
+            right[pos] = 'y';
+            ASSERT_EQ(KeyString::commonPrefixSize(left.data(), right.data(), size), pos);
+        }
+    }
+}
+
+TEST_F(KeyStringBuilderTest, SerializeWithPrefixRoundTrips) {
+    std::vector<KeyString::Value> keys;
+    const std::string longString(300, 'a');
+    for (int i = 0; i < 10; ++i) {
+        // Shared prefixes both shorter and longer than the 255 bytes that can be left out, and
+        // TypeBits which differ from key to key.
+        BSONObjBuilder key;
+        key.append("", longString);
+        if (i % 2) {
+            key.append("", 2);
+        } else {
+            key.append("", 2.0);
+        }
+        key.append("", i);
+        keys.push_back(
+            KeyString::HeapBuilder(version, key.obj(), ALL_ASCENDING, RecordId(i)).release());
+        keys.push_back(
+            KeyString::HeapBuilder(version, BSON("" << i << "" << i), ALL_ASCENDING).release());
+    }
+
+    BufBuilder buf;
+    KeyString::Value previous;
+    for (const auto& key : keys) {
+        key.serializeWithPrefix(buf, previous);
+        previous = key;
+    }
+
+    BufReader reader(buf.buf(), buf.len());
+    previous = KeyString::Value();
+    for (const auto& key : keys) {
+        auto deserialized = KeyString::Value::deserializeWithPrefix(reader, version, previous);
+        ASSERT_EQ(deserialized.compare(key), 0);
+        ASSERT_BSONOBJ_EQ(KeyString::toBson(deserialized, ALL_ASCENDING),
+                          KeyString::toBson(key, ALL_ASCENDING));
+        previous = deserialized;
+    }
+    ASSERT(reader.atEof());
+}
+
 DEATH_TEST(KeyStringBuilderTest, ToBsonPromotesAssertionsToTerminate, "terminate() called") {
     const char invalidString[] = {
         60,  // CType::kStringLike
@@ -171,6 +171,24 @@ public:
      */
     virtual boost::optional<Record> seekExact(const RecordId& id) = 0;
 
+    /**
+     * Positions a forward cursor on the first Record whose id is greater than or equal to 'start'
+     * and returns it, or returns boost::none if there is no such Record. Subsequent calls to
+     * next() continue from the returned Record.
+     *
+     * The default implementation advances with next() from the cursor's current position, so it
+     * is only meaningful on a cursor that has not yet been advanced. Storage engines that can
+     * position a cursor directly should override it.
+     */
+    virtual boost::optional<Record> seekAtOrAfter(const RecordId& start) {
+        while (auto record = next()) {
+            if (record->id >= start) {
+                return record;
+            }
+        }
+        return boost::none;
+    }
+
     /**
      * Prepares for state changes in underlying data without necessarily saving the current
      * state.
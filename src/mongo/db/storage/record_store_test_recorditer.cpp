@@ -483,5 +483,59 @@ TEST(RecordStoreTestHarness, SeekExactForMissingRecordReturnsNone) {
     ASSERT_FALSE(recordStore->findRecord(opCtx.get(), recordIds[1], &outputData));
 }
 
+// seekAtOrAfter() must position the cursor on the first record at or after the given RecordId,
+// whether or not that RecordId exists, and next() must continue from there.
+TEST(RecordStoreTestHarness, SeekAtOrAfterPositionsOnNextExistingRecord) {
+    const auto harnessHelper{newRecordStoreHarnessHelper()};
+    auto recordStore = harnessHelper->newNonCappedRecordStore();
+    ServiceContext::UniqueOperationContext opCtx{harnessHelper->newOperationContext()};
+
+    const int nToInsert = 4;
+    RecordId recordIds[nToInsert];
+    for (int i = 0; i < nToInsert; ++i) {
+        StringBuilder sb;
+        sb << "record " << i;
+        string data = sb.str();
+
+        WriteUnitOfWork uow{opCtx.get()};
+        auto res =
+            recordStore->insertRecord(opCtx.get(), data.c_str(), data.size() + 1, Timestamp{});
+        ASSERT_OK(res.getStatus());
+        recordIds[i] = res.getValue();
+        uow.commit();
+    }
+    std::sort(recordIds, recordIds + nToInsert);
+
+    // Delete the second record so that seeking to it has to land on the third.
+    {
+        WriteUnitOfWork uow{opCtx.get()};
+        recordStore->deleteRecord(opCtx.get(), recordIds[1]);
+        uow.commit();
+    }
+
+    {
+        auto cursor = recordStore->getCursor(opCtx.get());
+        auto record = cursor->seekAtOrAfter(recordIds[0]);
+        ASSERT(record);
+        ASSERT_EQUALS(recordIds[0], record->id);
+    }
+
+    {
+        auto cursor = recordStore->getCursor(opCtx.get());
+        auto record = cursor->seekAtOrAfter(recordIds[1]);
+        ASSERT(record);
+        ASSERT_EQUALS(recordIds[2], record->id);
+        record = cursor->next();
+        ASSERT(record);
+        ASSERT_EQUALS(recordIds[3], record->id);
+        ASSERT(!cursor->next());
+    }
+
+    {
+        auto cursor = recordStore->getCursor(opCtx.get());
+        ASSERT(!cursor->seekAtOrAfter(RecordId(recordIds[3].repr() + 1)));
+    }
+}
+
 }  // namespace
 }  // namespace mongo
@@ -86,6 +86,7 @@
 #include "mongo/util/background.h"
 #include "mongo/util/concurrency/idle_thread_block.h"
 #include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/concurrency/ticketholder_tuner.h"
 #include "mongo/util/debug_util.h"
 #include "mongo/util/exit.h"
 #include "mongo/util/log.h"
@@ -548,6 +549,23 @@ private:
 namespace {
 TicketHolder openWriteTransaction(128);
 TicketHolder openReadTransaction(128);
+
+TicketHolderTuner openWriteTransactionTuner(&openWriteTransaction);
+TicketHolderTuner openReadTransactionTuner(&openReadTransaction);
+
+void adjustConcurrentTransactions() {
+    if (!gAdaptiveConcurrentTransactions.load()) {
+        return;
+    }
+
+    TicketHolderTuner::Options options;
+    options.minTickets = gAdaptiveConcurrentTransactionsMin.load();
+    options.maxTickets = std::max(gAdaptiveConcurrentTransactionsMax.load(), options.minTickets);
+    options.targetQueueDelay =
+        Microseconds(gAdaptiveConcurrentTransactionsTargetQueueDelayMicros.load());
+    openWriteTransactionTuner.adjust(options);
+    openReadTransactionTuner.adjust(options);
+}
 }  // namespace
 
 OpenWriteTransactionParam::OpenWriteTransactionParam(StringData name, ServerParameterType spt)
@@ -811,6 +829,14 @@ WiredTigerKVEngine::~WiredTigerKVEngine() {
 }
 
 void WiredTigerKVEngine::startAsyncThreads() {
+    // The tuner samples the ticket holders once a second whether or not it is enabled, so that it
+    // can be turned on at runtime.
+    if (auto runner = getGlobalServiceContext()->getPeriodicRunner()) {
+        _ticketTunerJob = runner->makeJob(
+            {"WTTicketHolderTuner", [](Client*) { adjustConcurrentTransactions(); }, Seconds(1)});
+        _ticketTunerJob.start();
+    }
+
     if (!_ephemeral) {
         if (_durable) {
             _journalFlusher = std::make_unique<WiredTigerJournalFlusher>(_sessionCache.get());
@@ -831,6 +857,9 @@ void WiredTigerKVEngine::appendGlobalStats(BSONObjBuilder& b) {
         bbb.append("out", openWriteTransaction.used());
         bbb.append("available", openWriteTransaction.available());
         bbb.append("totalTickets", openWriteTransaction.outof());
+        BSONObjBuilder adaptiveBuilder(bbb.subobjStart("adaptive"));
+        openWriteTransactionTuner.appendStats(&adaptiveBuilder);
+        adaptiveBuilder.done();
         bbb.done();
     }
     {
@@ -838,6 +867,9 @@ void WiredTigerKVEngine::appendGlobalStats(BSONObjBuilder& b) {
         bbb.append("out", openReadTransaction.used());
         bbb.append("available", openReadTransaction.available());
         bbb.append("totalTickets", openReadTransaction.outof());
+        BSONObjBuilder adaptiveBuilder(bbb.subobjStart("adaptive"));
+        openReadTransactionTuner.appendStats(&adaptiveBuilder);
+        adaptiveBuilder.done();
         bbb.done();
     }
     bb.done();
@@ -913,6 +945,10 @@ void WiredTigerKVEngine::cleanShutdown() {
         return;
     }
 
+    if (_ticketTunerJob) {
+        _ticketTunerJob.stop();
+    }
+
     // these must be the last things we do before _conn->close();
     if (_sessionSweeper) {
         log() << "Shutting down session sweeper thread";
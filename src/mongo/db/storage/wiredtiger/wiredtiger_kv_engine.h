@@ -47,6 +47,7 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 #include "mongo/platform/mutex.h"
 #include "mongo/util/elapsed_tracker.h"
+#include "mongo/util/periodic_runner.h"
 
 namespace mongo {
 
@@ -456,6 +457,10 @@ private:
     std::unique_ptr<WiredTigerJournalFlusher> _journalFlusher;  // Depends on _sizeStorer
     std::unique_ptr<WiredTigerCheckpointThread> _checkpointThread;
 
+    // Resizes the read and write ticket holders while wiredTigerAdaptiveConcurrentTransactions is
+    // enabled.
+    PeriodicJobAnchor _ticketTunerJob;
+
     std::string _rsOptions;
     std::string _indexOptions;
 
@@ -1982,6 +1982,58 @@ boost::optional<Record> WiredTigerRecordStoreCursorBase::seekExact(const RecordI
     return {{id, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
 }
 
+boost::optional<Record> WiredTigerRecordStoreCursorBase::seekAtOrAfter(const RecordId& start) {
+    invariant(_hasRestored);
+    invariant(_forward);
+    if (_oplogVisibleTs && start.repr() > *_oplogVisibleTs) {
+        _eof = true;
+        return {};
+    }
+
+    _skipNextAdvance = false;
+    WT_CURSOR* c = _cursor->get();
+    setKey(c, start);
+
+    int cmp;
+    int ret = wiredTigerPrepareConflictRetry(_opCtx, [&] { return c->search_near(c, &cmp); });
+    if (ret == WT_NOTFOUND) {
+        _eof = true;
+        return {};
+    }
+    invariantWTOK(ret);
+
+    if (cmp < 0) {
+        // We landed on the last key before 'start'; the record we want is the one after it.
+        ret = wiredTigerPrepareConflictRetry(_opCtx, [&] { return c->next(c); });
+        if (ret == WT_NOTFOUND) {
+            _eof = true;
+            return {};
+        }
+        invariantWTOK(ret);
+    }
+
+    // Nothing after this point can throw WCEs.
+    RecordId id;
+    if (hasWrongPrefix(c, &id)) {
+        _eof = true;
+        return {};
+    }
+    if (!id.isValid()) {
+        id = getKey(c);
+    }
+
+    if (_oplogVisibleTs && id.repr() > *_oplogVisibleTs) {
+        _eof = true;
+        return {};
+    }
+
+    WT_ITEM value;
+    invariantWTOK(c->get_value(c, &value));
+
+    _lastReturnedId = id;
+    _eof = false;
+    return {{id, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
+}
 
 void WiredTigerRecordStoreCursorBase::save() {
     try {
@@ -442,6 +442,8 @@ public:
 
     boost::optional<Record> seekExact(const RecordId& id);
 
+    boost::optional<Record> seekAtOrAfter(const RecordId& start);
+
     void save();
 
     void saveUnpositioned();
@@ -125,6 +125,9 @@ private:
         const ServiceContext::UniqueOperationContext opCtxPtr = cc().makeOperationContext();
         OperationContext& opCtx = *opCtxPtr;
 
+        // TTL deletes must not hold up user operations queued for storage engine tickets.
+        opCtx.setAdmissionPriority(AdmissionPriority::kBackground);
+
         // If part of replSet but not in a readable state (e.g. during initial sync), skip.
         if (repl::ReplicationCoordinator::get(&opCtx)->getReplicationMode() ==
                 repl::ReplicationCoordinator::modeReplSet &&
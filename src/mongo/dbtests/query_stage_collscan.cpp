@@ -42,15 +42,18 @@
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/parallel_collection_scan.h"
 #include "mongo/db/exec/plan_stage.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/storage/record_store.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/fail_point.h"
+#include "mongo/util/scopeguard.h"
 
 namespace query_stage_collection_scan {
 
@@ -144,6 +147,32 @@ public:
         }
     }
 
+    /**
+     * Runs 'stage' to completion and returns the values of the 'foo' field of its results, in the
+     * order in which they were returned.
+     */
+    vector<int> getFooValues(PlanStage* stage, WorkingSet* ws) {
+        vector<int> out;
+        while (!stage->isEOF()) {
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState state = stage->work(&id);
+            ASSERT_NE(PlanStage::FAILURE, state);
+            if (PlanStage::ADVANCED == state) {
+                out.push_back(ws->get(id)->doc.value()["foo"].getInt());
+                ws->free(id);
+            }
+        }
+        return out;
+    }
+
+    unique_ptr<MatchExpression> parseFilter(const BSONObj& filterObj) {
+        const boost::intrusive_ptr<ExpressionContext> expCtx(
+            new ExpressionContext(&_opCtx, nullptr));
+        auto statusWithMatcher = MatchExpressionParser::parse(filterObj, expCtx);
+        ASSERT_OK(statusWithMatcher.getStatus());
+        return std::move(statusWithMatcher.getValue());
+    }
+
     static int numObj() {
         return 50;
     }
@@ -238,6 +267,197 @@ TEST_F(QueryStageCollectionScanTest, QueryStageCollscanObjectsInOrderBackward) {
     ASSERT_EQUALS(numObj(), count);
 }
 
+// Pull batches directly from the scan and make sure they contain every matching object, in order.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanWorkBatchForwardWithMatch) {
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+    params.tailable = false;
+
+    const boost::intrusive_ptr<ExpressionContext> expCtx(new ExpressionContext(&_opCtx, nullptr));
+    auto statusWithMatcher =
+        MatchExpressionParser::parse(BSON("foo" << BSON("$gte" << 10 << "$lt" << 40)), expCtx);
+    ASSERT_OK(statusWithMatcher.getStatus());
+    unique_ptr<MatchExpression> filterExpr = std::move(statusWithMatcher.getValue());
+
+    WorkingSet ws;
+    auto scan =
+        std::make_unique<CollectionScan>(&_opCtx, collection, params, &ws, filterExpr.get());
+
+    int count = 0;
+    PlanStage::WorkBatch batch;
+    while (!scan->isEOF()) {
+        batch.clear();
+        PlanStage::StageState state = scan->workBatch(7, &batch);
+        ASSERT_NE(PlanStage::FAILURE, state);
+        ASSERT_LTE(batch.ids.size(), 7U);
+
+        for (auto&& id : batch.ids) {
+            WorkingSetMember* member = ws.get(id);
+            ASSERT_TRUE(member->hasOwnedObj());
+            ASSERT_EQUALS(10 + count, member->doc.value()["foo"].getInt());
+            ws.free(id);
+            ++count;
+        }
+    }
+    ASSERT_EQUALS(30, count);
+
+    // Every object was tested against the filter exactly once.
+    auto stats = static_cast<const CollectionScanStats*>(scan->getSpecificStats());
+    ASSERT_EQUALS(static_cast<size_t>(numObj()), stats->docsTested);
+}
+
+// The executor should return the same results whether or not it pulls batches from the plan.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanBatchedExecutionMatchesUnbatched) {
+    BSONObj obj = BSON("foo" << BSON("$lt" << 25));
+    const int unbatched = countResults(CollectionScanParams::FORWARD, obj);
+
+    const int originalBatchSize = internalQueryExecBatchSize.load();
+    internalQueryExecBatchSize.store(16);
+    ON_BLOCK_EXIT([&] { internalQueryExecBatchSize.store(originalBatchSize); });
+
+    ASSERT_EQUALS(unbatched, countResults(CollectionScanParams::FORWARD, obj));
+    ASSERT_EQUALS(numObj(), countResults(CollectionScanParams::BACKWARD, BSONObj()));
+}
+
+// A scan bounded by 'minRecord' and 'maxRecord' returns exactly the records in that range.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanRecordIdRange) {
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    vector<RecordId> recordIds;
+    getRecordIds(collection, CollectionScanParams::FORWARD, &recordIds);
+
+    CollectionScanParams params;
+    params.minRecord = recordIds[10];
+    params.maxRecord = recordIds[30];
+
+    WorkingSet ws;
+    auto scan = std::make_unique<CollectionScan>(&_opCtx, collection, params, &ws, nullptr);
+    vector<int> values = getFooValues(scan.get(), &ws);
+
+    ASSERT_EQUALS(20U, values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQUALS(static_cast<int>(10 + i), values[i]);
+    }
+}
+
+// If the 'minRecord' of a range no longer exists, the scan starts at the record after it.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanRecordIdRangeMissingMinRecord) {
+    dbtests::WriteContextForTests ctx(&_opCtx, nss.ns());
+    auto coll = ctx.getCollection();
+
+    vector<RecordId> recordIds;
+    getRecordIds(coll, CollectionScanParams::FORWARD, &recordIds);
+    remove(coll->docFor(&_opCtx, recordIds[10]).value());
+
+    CollectionScanParams params;
+    params.minRecord = recordIds[10];
+
+    WorkingSet ws;
+    auto scan = std::make_unique<CollectionScan>(&_opCtx, coll, params, &ws, nullptr);
+    vector<int> values = getFooValues(scan.get(), &ws);
+
+    ASSERT_EQUALS(static_cast<size_t>(numObj() - 11), values.size());
+    ASSERT_EQUALS(11, values.front());
+    ASSERT_EQUALS(numObj() - 1, values.back());
+}
+
+// Partition boundaries are distinct, increasing RecordIds from the collection.
+TEST_F(QueryStageCollectionScanTest, QueryStageParallelCollscanPartitionBoundaries) {
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    ASSERT_TRUE(ParallelCollectionScan::choosePartitionBoundaries(&_opCtx, collection, 1).empty());
+
+    auto boundaries = ParallelCollectionScan::choosePartitionBoundaries(&_opCtx, collection, 4);
+    ASSERT_LTE(boundaries.size(), 3U);
+    for (size_t i = 1; i < boundaries.size(); ++i) {
+        ASSERT_LT(boundaries[i - 1], boundaries[i]);
+    }
+}
+
+// An order-preserving parallel scan returns the same results as a forward scan, in the same
+// order.
+TEST_F(QueryStageCollectionScanTest, QueryStageParallelCollscanPreservesOrder) {
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    auto filterExpr = parseFilter(BSON("foo" << BSON("$lt" << 25)));
+
+    ParallelCollectionScanParams params;
+    params.partitions = 4;
+    params.preserveOrder = true;
+
+    // Use a tiny buffer so that the workers have to wait for the consumer.
+    params.bufferSizeBytes = 1;
+
+    WorkingSet ws;
+    auto scan = std::make_unique<ParallelCollectionScan>(
+        &_opCtx, collection, params, &ws, filterExpr.get());
+    vector<int> values = getFooValues(scan.get(), &ws);
+
+    ASSERT_EQUALS(25U, values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQUALS(static_cast<int>(i), values[i]);
+    }
+
+    auto stats = static_cast<const ParallelCollectionScanStats*>(scan->getSpecificStats());
+    ASSERT_EQUALS(static_cast<size_t>(numObj()), stats->docsTested);
+    ASSERT_GTE(stats->partitions, 1U);
+    ASSERT_LTE(stats->partitions, 4U);
+}
+
+// A parallel scan which does not preserve order still returns every matching document once.
+TEST_F(QueryStageCollectionScanTest, QueryStageParallelCollscanUnordered) {
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    ParallelCollectionScanParams params;
+    params.partitions = 3;
+    params.preserveOrder = false;
+
+    WorkingSet ws;
+    auto scan =
+        std::make_unique<ParallelCollectionScan>(&_opCtx, collection, params, &ws, nullptr);
+    vector<int> values = getFooValues(scan.get(), &ws);
+
+    std::sort(values.begin(), values.end());
+    ASSERT_EQUALS(static_cast<size_t>(numObj()), values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+        ASSERT_EQUALS(static_cast<int>(i), values[i]);
+    }
+}
+
+// Destroying a parallel scan before it reaches EOF stops its workers.
+TEST_F(QueryStageCollectionScanTest, QueryStageParallelCollscanDestroyBeforeEOF) {
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    ParallelCollectionScanParams params;
+    params.partitions = 4;
+    params.bufferSizeBytes = 1;
+
+    WorkingSet ws;
+    auto scan =
+        std::make_unique<ParallelCollectionScan>(&_opCtx, collection, params, &ws, nullptr);
+
+    size_t advanced = 0;
+    while (advanced < 5) {
+        WorkingSetID id = WorkingSet::INVALID_ID;
+        PlanStage::StageState state = scan->work(&id);
+        ASSERT_NE(PlanStage::FAILURE, state);
+        ASSERT_NE(PlanStage::IS_EOF, state);
+        if (PlanStage::ADVANCED == state) {
+            ws.free(id);
+            ++advanced;
+        }
+    }
+    scan.reset();
+}
+
 // Scan through half the objects, delete the one we're about to fetch, then expect to get the "next"
 // object we would have gotten after that.
 TEST_F(QueryStageCollectionScanTest, QueryStageCollscanDeleteUpcomingObject) {
@@ -0,0 +1,122 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_M_AMD64) || defined(__amd64__)
+#include <emmintrin.h>
+#define MONGO_HAVE_VECTOR_BYTE_MASK
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define MONGO_HAVE_VECTOR_BYTE_MASK
+#endif
+
+#include "mongo/platform/bits.h"
+
+namespace mongo {
+
+/**
+ * Compares a vector of 16 bytes at a time and returns the result as an integer mask, in which the
+ * bytes are in order from the least significant bit on. Find the first matching byte with
+ * firstByte(), and test a mask against kAllBytes.
+ *
+ * SSE2 has movemask to build the mask with one bit per byte. aarch64 lacks it, so there the
+ * comparison result is narrowed to four bits per byte instead. Without either, the mask is built
+ * one byte at a time; callers with a cheaper scalar path of their own should only use this when
+ * MONGO_HAVE_VECTOR_BYTE_MASK is defined.
+ *
+ * None of the loads have any alignment requirement.
+ */
+namespace byte_mask {
+
+constexpr size_t kVectorSize = 16;
+
+#if defined(__aarch64__)
+constexpr int kBitsPerByte = 4;
+constexpr uint64_t kAllBytes = ~uint64_t{0};
+#else
+constexpr int kBitsPerByte = 1;
+constexpr uint64_t kAllBytes = 0xffff;
+#endif
+
+/**
+ * Returns the mask of the bytes in [left, left + kVectorSize) that are equal to the byte at the
+ * same offset from 'right'.
+ */
+inline uint64_t equal(const char* left, const char* right) {
+#if defined(_M_AMD64) || defined(__amd64__)
+    const auto l = _mm_loadu_si128(reinterpret_cast<const __m128i*>(left));
+    const auto r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(right));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(l, r)));
+#elif defined(__aarch64__)
+    const auto l = vld1q_u8(reinterpret_cast<const uint8_t*>(left));
+    const auto r = vld1q_u8(reinterpret_cast<const uint8_t*>(right));
+    const auto nibbles = vshrn_n_u16(vreinterpretq_u16_u8(vceqq_u8(l, r)), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+#else
+    uint64_t mask = 0;
+    for (size_t i = 0; i < kVectorSize; ++i) {
+        mask |= uint64_t{left[i] == right[i]} << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * Returns the mask of the bytes in [ptr, ptr + kVectorSize) that are zero.
+ */
+inline uint64_t zero(const char* ptr) {
+#if defined(_M_AMD64) || defined(__amd64__)
+    const auto bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ptr));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_setzero_si128())));
+#elif defined(__aarch64__)
+    const auto bytes = vld1q_u8(reinterpret_cast<const uint8_t*>(ptr));
+    const auto nibbles = vshrn_n_u16(vreinterpretq_u16_u8(vceqq_u8(bytes, vdupq_n_u8(0))), 4);
+    return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+#else
+    uint64_t mask = 0;
+    for (size_t i = 0; i < kVectorSize; ++i) {
+        mask |= uint64_t{ptr[i] == 0} << i;
+    }
+    return mask;
+#endif
+}
+
+/**
+ * Returns the offset of the first byte in a non-zero 'mask'.
+ */
+inline size_t firstByte(uint64_t mask) {
+    return countTrailingZeros64(mask) / kBitsPerByte;
+}
+
+}  // namespace byte_mask
+}  // namespace mongo
@@ -0,0 +1,101 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/platform/byte_mask.h"
+
+#include <cstring>
+
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+// Room for a vector at every offset from an aligned start, so that most of the loads cross a
+// 16-byte boundary.
+constexpr size_t kBufferSize = 2 * byte_mask::kVectorSize;
+
+TEST(ByteMaskTest, EqualFindsFirstDifferingByteAtEveryAlignment) {
+    alignas(16) char left[kBufferSize];
+    alignas(16) char right[kBufferSize];
+    for (size_t offset = 0; offset < byte_mask::kVectorSize; ++offset) {
+        for (size_t differing = 0; differing < byte_mask::kVectorSize; ++differing) {
+            std::memset(left, 'a', sizeof(left));
+            std::memset(right, 'a', sizeof(right));
+            right[offset + differing] = 'b';
+            // A second difference further on must not hide the first one.
+            right[offset + byte_mask::kVectorSize - 1] = 'c';
+
+            const uint64_t mask = ~byte_mask::equal(left + offset, right + offset) &
+                byte_mask::kAllBytes;
+            ASSERT_NE(mask, 0U);
+            ASSERT_EQ(byte_mask::firstByte(mask), differing);
+        }
+
+        std::memset(right, 'a', sizeof(right));
+        ASSERT_EQ(byte_mask::equal(left + offset, right + offset), byte_mask::kAllBytes);
+    }
+}
+
+TEST(ByteMaskTest, ZeroFindsFirstNulAtEveryAlignment) {
+    alignas(16) char buffer[kBufferSize];
+    for (size_t offset = 0; offset < byte_mask::kVectorSize; ++offset) {
+        for (size_t nul = 0; nul < byte_mask::kVectorSize; ++nul) {
+            std::memset(buffer, 'x', sizeof(buffer));
+            // NULs just before the vector and after the first one must not count.
+            if (offset > 0) {
+                buffer[offset - 1] = '\0';
+            }
+            buffer[offset + nul] = '\0';
+            buffer[offset + byte_mask::kVectorSize - 1] = '\0';
+
+            const uint64_t mask = byte_mask::zero(buffer + offset);
+            ASSERT_NE(mask, 0U);
+            ASSERT_EQ(byte_mask::firstByte(mask), nul);
+        }
+
+        std::memset(buffer, 'x', sizeof(buffer));
+        buffer[offset + byte_mask::kVectorSize] = '\0';
+        ASSERT_EQ(byte_mask::zero(buffer + offset), 0U);
+    }
+}
+
+TEST(ByteMaskTest, ComparesBytesAsUnsigned) {
+    alignas(16) char left[kBufferSize];
+    alignas(16) char right[kBufferSize];
+    std::memset(left, 0x80, sizeof(left));
+    std::memset(right, 0x80, sizeof(right));
+    right[3 + 5] = 0x7f;
+    const uint64_t mask = ~byte_mask::equal(left + 3, right + 3) & byte_mask::kAllBytes;
+    ASSERT_EQ(byte_mask::firstByte(mask), 5U);
+}
+
+}  // namespace
+}  // namespace mongo
@@ -77,6 +77,27 @@ uint32_t calculateChecksum(const Message& message) {
     return wiredtiger_crc32c_func()(message.singleData().view2ptr(), message.size() - kCrc32Size);
 }
 #endif  // MONGO_CONFIG_WIREDTIGER_ENABLED
+/**
+ * Returns the number of documents in the document sequence of 'size' bytes at 'data', by walking
+ * their length prefixes, so that the vector holding them can be allocated once. Neither validates
+ * nor consumes the documents: counting stops at the first bad length, and the validating read
+ * reports the error.
+ */
+size_t countSequenceDocuments(const void* data, unsigned size) {
+    BufReader reader(data, size);
+    size_t count = 0;
+    while (reader.remaining() >= sizeof(int32_t)) {
+        const int32_t docSize = reader.peek<LittleEndian<int32_t>>();
+        if (docSize < BSONObj::kMinBSONLength ||
+            static_cast<unsigned>(docSize) > reader.remaining()) {
+            break;
+        }
+        reader.skip(docSize);
+        ++count;
+    }
+    return count;
+}
+
 }  // namespace
 
 uint32_t OpMsg::flags(const Message& message) {
@@ -182,8 +203,10 @@ OpMsg OpMsg::parse(const Message& message) try {
                         !msg.getSequence(name));  // TODO IDL
 
                 msg.sequences.push_back({name.toString()});
+                auto& objs = msg.sequences.back().objs;
+                objs.reserve(countSequenceDocuments(seqBuf.pos(), seqBuf.remaining()));
                 while (!seqBuf.atEof()) {
-                    msg.sequences.back().objs.push_back(seqBuf.read<Validated<BSONObj>>());
+                    objs.push_back(seqBuf.read<Validated<BSONObj>>());
                 }
                 break;
             }
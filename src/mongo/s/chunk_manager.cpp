@@ -33,6 +33,8 @@
 
 #include "mongo/s/chunk_manager.h"
 
+#include <numeric>
+
 #include "mongo/base/owned_pointer_vector.h"
 #include "mongo/bson/simple_bsonobj_comparator.h"
 #include "mongo/db/matcher/extensions_callback_noop.h"
@@ -58,6 +60,25 @@ void checkAllElementsAreOfType(BSONType type, const BSONObj& o) {
     }
 }
 
+/**
+ * Checks that the range of 'right' starts exactly where the range of 'left' ends.
+ */
+void checkChunksAreContiguous(const ChunkInfo& left, const ChunkInfo& right) {
+    const auto& leftMax = left.getMax();
+    const auto& rightMin = right.getMin();
+    if (SimpleBSONObjComparator::kInstance.evaluate(leftMax == rightMin)) {
+        return;
+    }
+
+    uasserted(ErrorCodes::ConflictingOperationInProgress,
+              str::stream() << (SimpleBSONObjComparator::kInstance.evaluate(leftMax < rightMin)
+                                    ? "Gap"
+                                    : "Overlap")
+                            << " exists in the routing table between chunks "
+                            << left.getRange().toString() << " and "
+                            << right.getRange().toString());
+}
+
 std::string extractKeyStringInternal(const BSONObj& shardKeyValue, Ordering ordering) {
     BSONObjBuilder strippedKeyValue;
     for (const auto& elem : shardKeyValue) {
@@ -70,13 +91,310 @@ std::string extractKeyStringInternal(const BSONObj& shardKeyValue, Ordering orde
 
 }  // namespace
 
+void ChunkMap::KeyStringArray::insert(size_t index, StringData keyString) {
+    const size_t begin = _begin(index);
+    _bytes.insert(begin, keyString.rawData(), keyString.size());
+    _ends.insert(_ends.begin() + index, begin);
+    for (size_t i = index; i < _ends.size(); ++i) {
+        _ends[i] += keyString.size();
+    }
+}
+
+void ChunkMap::KeyStringArray::set(size_t index, StringData keyString) {
+    erase(index, index + 1);
+    insert(index, keyString);
+}
+
+void ChunkMap::KeyStringArray::append(const KeyStringArray& other, size_t first, size_t last) {
+    const size_t begin = other._begin(first);
+    const size_t offset = _bytes.size();
+    _bytes.append(other._bytes, begin, other._begin(last) - begin);
+    for (size_t i = first; i < last; ++i) {
+        _ends.push_back(offset + other._ends[i] - begin);
+    }
+}
+
+void ChunkMap::KeyStringArray::erase(size_t first, size_t last) {
+    const size_t begin = _begin(first);
+    const size_t length = _begin(last) - begin;
+    _bytes.erase(begin, length);
+    _ends.erase(_ends.begin() + first, _ends.begin() + last);
+    for (size_t i = first; i < _ends.size(); ++i) {
+        _ends[i] -= length;
+    }
+}
+
+ChunkMap::const_iterator& ChunkMap::const_iterator::operator++() {
+    if (++_path.back().second < _path.back().first->chunks.size()) {
+        return *this;
+    }
+
+    // Climb to the nearest ancestor with a next child and continue from the first chunk under it
+    _path.pop_back();
+    while (!_path.empty()) {
+        auto& step = _path.back();
+        if (++step.second < step.first->children.size()) {
+            _descendToFirst(step.first->children[step.second].get());
+            break;
+        }
+        _path.pop_back();
+    }
+    return *this;
+}
+
+ChunkMap::const_iterator& ChunkMap::const_iterator::operator--() {
+    if (_path.empty()) {
+        _descendToLast(_map->_root.get());
+        return *this;
+    }
+
+    // Climb to the nearest ancestor with a previous child and continue from the last chunk under it
+    while (_path.back().second == 0) {
+        _path.pop_back();
+    }
+    auto& step = _path.back();
+    --step.second;
+    if (!step.first->isLeaf()) {
+        _descendToLast(step.first->children[step.second].get());
+    }
+    return *this;
+}
+
+void ChunkMap::const_iterator::_descendToFirst(const Node* node) {
+    while (true) {
+        _path.emplace_back(node, 0);
+        if (node->isLeaf()) {
+            return;
+        }
+        node = node->children.front().get();
+    }
+}
+
+void ChunkMap::const_iterator::_descendToLast(const Node* node) {
+    while (true) {
+        const size_t last = node->maxKeyStrings.size() - 1;
+        _path.emplace_back(node, last);
+        if (node->isLeaf()) {
+            return;
+        }
+        node = node->children[last].get();
+    }
+}
+
+ChunkMap::const_iterator ChunkMap::begin() const {
+    const_iterator it(this);
+    if (_root) {
+        it._descendToFirst(_root.get());
+    }
+    return it;
+}
+
+template <typename IsBefore>
+ChunkMap::const_iterator ChunkMap::_partitionPoint(IsBefore isBefore) const {
+    const_iterator it(this);
+    for (const Node* node = _root.get(); node;) {
+        const size_t index = node->maxKeyStrings.partitionPoint(isBefore);
+        if (index == node->maxKeyStrings.size()) {
+            return end();
+        }
+
+        it._path.emplace_back(node, index);
+        node = node->isLeaf() ? nullptr : node->children[index].get();
+    }
+    return it;
+}
+
+ChunkMap::const_iterator ChunkMap::upperBound(StringData keyString) const {
+    return _partitionPoint([&](StringData max) { return !(keyString < max); });
+}
+
+ChunkMap::const_iterator ChunkMap::lowerBound(StringData keyString) const {
+    return _partitionPoint([&](StringData max) { return max < keyString; });
+}
+
+ChunkMap::const_iterator ChunkMap::upperBound(StringData keyString, const_iterator hint) const {
+    if (hint == end() || keyString < hint._maxKeyString()) {
+        return hint;
+    }
+
+    // The result is past the hint, so look for it in the rest of the hint's leaf before falling
+    // back to a lookup from the root
+    auto& step = hint._path.back();
+    const auto& maxKeyStrings = step.first->maxKeyStrings;
+    if (!(keyString < maxKeyStrings.back())) {
+        return upperBound(keyString);
+    }
+
+    step.second = maxKeyStrings.partitionPoint(
+        [&](StringData max) { return !(keyString < max); }, step.second + 1);
+    return hint;
+}
+
+void ChunkMap::replace(const_iterator first,
+                       const_iterator last,
+                       std::string maxKeyString,
+                       std::shared_ptr<ChunkInfo> chunk) {
+    invariant(first._map == this && last._map == this);
+
+    if (first != last) {
+        _size -= std::distance(first, last);
+
+        // The iterators point into nodes which may be modified in place, so copy the bounds out
+        const std::string from = first._maxKeyString().toString();
+        const auto to = last == end() ? boost::none
+                                      : boost::make_optional(last._maxKeyString().toString());
+        _erase(_mutableNode(_root), &from, to ? to.get_ptr() : nullptr);
+    }
+
+    if (!_root) {
+        _root = std::make_shared<Node>();
+    }
+    _insert(_mutableNode(_root), std::move(maxKeyString), std::move(chunk));
+    ++_size;
+
+    // The root is the only place where the depth of the tree changes, which keeps all the leaves
+    // at the same depth
+    if (_root->maxKeyStrings.size() > kMaxNodeSize) {
+        auto newRoot = std::make_shared<Node>();
+        newRoot->maxKeyStrings.push_back(_root->maxKeyStrings.back());
+        newRoot->children.push_back(std::move(_root));
+        _rebalanceChild(*newRoot, 0);
+        _root = std::move(newRoot);
+    }
+    while (_root->children.size() == 1) {
+        _root = _root->children.front();
+    }
+}
+
+ChunkMap::Node& ChunkMap::_mutableNode(std::shared_ptr<Node>& node) {
+    if (node.use_count() != 1) {
+        node = std::make_shared<Node>(*node);
+    }
+    return *node;
+}
+
+void ChunkMap::_erase(Node& node, const std::string* from, const std::string* to) {
+    auto& maxKeyStrings = node.maxKeyStrings;
+    auto indexOf = [&](const std::string* bound, size_t unbounded) -> size_t {
+        if (!bound)
+            return unbounded;
+        return maxKeyStrings.lowerBound(*bound);
+    };
+    const size_t first = indexOf(from, 0);
+    const size_t last = indexOf(to, maxKeyStrings.size());
+
+    if (node.isLeaf()) {
+        maxKeyStrings.erase(first, last);
+        node.chunks.erase(node.chunks.begin() + first, node.chunks.begin() + last);
+        return;
+    }
+
+    if (first == maxKeyStrings.size()) {
+        return;
+    }
+
+    if (first == last) {
+        _erase(_mutableNode(node.children[first]), from, to);
+        _rebalanceChild(node, first);
+        return;
+    }
+
+    // The children between 'first' and 'last' lie entirely within the range, so they are dropped
+    // without being visited, and only the two at its ends are trimmed
+    const bool lastIsTrimmed = last < maxKeyStrings.size();
+    if (lastIsTrimmed) {
+        _erase(_mutableNode(node.children[last]), nullptr, to);
+    }
+    _erase(_mutableNode(node.children[first]), from, nullptr);
+
+    maxKeyStrings.erase(first + 1, last);
+    node.children.erase(node.children.begin() + first + 1, node.children.begin() + last);
+
+    if (lastIsTrimmed) {
+        _rebalanceChild(node, first + 1);
+    }
+    _rebalanceChild(node, first);
+}
+
+void ChunkMap::_insert(Node& node, std::string maxKeyString, std::shared_ptr<ChunkInfo> chunk) {
+    auto& maxKeyStrings = node.maxKeyStrings;
+    size_t index = maxKeyStrings.lowerBound(maxKeyString);
+
+    if (node.isLeaf()) {
+        dassert(index == maxKeyStrings.size() || StringData(maxKeyString) < maxKeyStrings[index]);
+        maxKeyStrings.insert(index, maxKeyString);
+        node.chunks.insert(node.chunks.begin() + index, std::move(chunk));
+        return;
+    }
+
+    // Past the max of every child, so it goes at the end of the last one
+    if (index == maxKeyStrings.size()) {
+        --index;
+    }
+    _insert(_mutableNode(node.children[index]), std::move(maxKeyString), std::move(chunk));
+    _rebalanceChild(node, index);
+}
+
+void ChunkMap::_rebalanceChild(Node& parent, size_t index) {
+    auto& child = *parent.children[index];
+    const size_t size = child.maxKeyStrings.size();
+
+    if (size == 0) {
+        parent.maxKeyStrings.erase(index, index + 1);
+        parent.children.erase(parent.children.begin() + index);
+        return;
+    }
+
+    if (size > kMaxNodeSize) {
+        const size_t half = size / 2;
+        auto upper = std::make_shared<Node>();
+        upper->maxKeyStrings.append(child.maxKeyStrings, half, size);
+        child.maxKeyStrings.erase(half, size);
+        if (child.isLeaf()) {
+            upper->chunks.assign(std::make_move_iterator(child.chunks.begin() + half),
+                                 std::make_move_iterator(child.chunks.end()));
+            child.chunks.resize(half);
+        } else {
+            upper->children.assign(std::make_move_iterator(child.children.begin() + half),
+                                   std::make_move_iterator(child.children.end()));
+            child.children.resize(half);
+        }
+
+        parent.maxKeyStrings.insert(index + 1, upper->maxKeyStrings.back());
+        parent.children.insert(parent.children.begin() + index + 1, std::move(upper));
+    } else if (size < kMaxNodeSize / 4 && parent.children.size() > 1) {
+        // Merge with the next sibling, or the previous one for the last child, if they fit
+        const size_t left = index + 1 < parent.children.size() ? index : index - 1;
+        if (parent.children[left]->maxKeyStrings.size() +
+                parent.children[left + 1]->maxKeyStrings.size() <=
+            kMaxNodeSize) {
+            auto& leftNode = _mutableNode(parent.children[left]);
+            const auto& rightNode = *parent.children[left + 1];
+            leftNode.maxKeyStrings.append(
+                rightNode.maxKeyStrings, 0, rightNode.maxKeyStrings.size());
+            leftNode.chunks.insert(
+                leftNode.chunks.end(), rightNode.chunks.begin(), rightNode.chunks.end());
+            leftNode.children.insert(
+                leftNode.children.end(), rightNode.children.begin(), rightNode.children.end());
+
+            parent.maxKeyStrings.erase(left, left + 2);
+            parent.maxKeyStrings.insert(left, leftNode.maxKeyStrings.back());
+            parent.children.erase(parent.children.begin() + left + 1);
+            return;
+        }
+    }
+
+    parent.maxKeyStrings.set(index, child.maxKeyStrings.back());
+}
+
 RoutingTableHistory::RoutingTableHistory(NamespaceString nss,
                                          boost::optional<UUID> uuid,
                                          KeyPattern shardKeyPattern,
                                          std::unique_ptr<CollatorInterface> defaultCollator,
                                          bool unique,
-                                         ChunkInfoMap chunkMap,
-                                         ChunkVersion collectionVersion)
+                                         ChunkMap chunkMap,
+                                         ChunkVersion collectionVersion,
+                                         ShardVersionMap shardVersions)
     : _sequenceNumber(nextCMSequenceNumber.addAndFetch(1)),
       _nss(std::move(nss)),
       _uuid(uuid),
@@ -86,7 +404,7 @@ RoutingTableHistory::RoutingTableHistory(NamespaceString nss,
       _unique(unique),
       _chunkMap(std::move(chunkMap)),
       _collectionVersion(collectionVersion),
-      _shardVersions(_constructShardVersionMap()) {}
+      _shardVersions(std::move(shardVersions)) {}
 
 Chunk ChunkManager::findIntersectingChunk(const BSONObj& shardKey, const BSONObj& collation) const {
     const bool hasSimpleCollation = (collation.isEmpty() && !_rt->getDefaultCollator()) ||
@@ -100,26 +418,86 @@ Chunk ChunkManager::findIntersectingChunk(const BSONObj& shardKey, const BSONObj
         }
     }
 
-    const auto it = _rt->getChunkMap().upper_bound(_rt->_extractKeyString(shardKey));
+    const auto it = _rt->getChunkMap().upperBound(_rt->_extractKeyString(shardKey));
     uassert(ErrorCodes::ShardKeyNotFound,
             str::stream() << "Cannot target single shard using key " << shardKey
                           << " for namespace " << getns(),
-            it != _rt->getChunkMap().end() && it->second->containsKey(shardKey));
+            it != _rt->getChunkMap().end() && (*it)->containsKey(shardKey));
+
+    return Chunk(**it, _clusterTime);
+}
+
+std::vector<const ShardId*> ChunkManager::findShardIdsForDocuments(
+    const std::vector<BSONObj>& docs) const {
+    // Encode the shard keys back to back into a single buffer, so that apart from extracting the
+    // shard key the pass over the documents doesn't allocate anything per document. An empty range
+    // marks a document without a valid shard key.
+    std::string keyStrings;
+    std::vector<std::pair<size_t, size_t>> keyStringRanges;
+    keyStringRanges.reserve(docs.size());
+
+    KeyString::Builder ks(KeyString::Version::V1, _rt->_shardKeyOrdering);
+    for (const auto& doc : docs) {
+        const auto shardKey = getShardKeyPattern().extractShardKeyFromDoc(doc);
+        if (shardKey.isEmpty()) {
+            keyStringRanges.emplace_back(keyStrings.size(), 0);
+            continue;
+        }
+
+        ks.resetToKey(shardKey, _rt->_shardKeyOrdering);
+        keyStringRanges.emplace_back(keyStrings.size(), ks.getSize());
+        keyStrings.append(ks.getBuffer(), ks.getSize());
+    }
+
+    const auto keyStringAt = [&](size_t i) {
+        return StringData(keyStrings.data() + keyStringRanges[i].first,
+                          keyStringRanges[i].second);
+    };
+
+    std::vector<size_t> order(docs.size());
+    std::iota(order.begin(), order.end(), 0);
+    order.erase(std::remove_if(order.begin(),
+                               order.end(),
+                               [&](size_t i) { return keyStringRanges[i].second == 0; }),
+                order.end());
+    std::sort(order.begin(), order.end(), [&](size_t lhs, size_t rhs) {
+        return keyStringAt(lhs) < keyStringAt(rhs);
+    });
+
+    // Merge the sorted keys with the chunks, resolving the owning shard once per chunk hit
+    std::vector<const ShardId*> shardIds(docs.size(), nullptr);
+
+    const auto& chunkMap = _rt->getChunkMap();
+    auto it = chunkMap.begin();
+    const ShardId* shardId = nullptr;
+    for (const size_t i : order) {
+        auto next = chunkMap.upperBound(keyStringAt(i), it);
+        if (next == chunkMap.end()) {
+            // This and all the remaining keys sort at or after the max of the last chunk
+            break;
+        }
 
-    return Chunk(*(it->second), _clusterTime);
+        if (!shardId || next != it) {
+            it = std::move(next);
+            shardId = &(*it)->getShardIdAt(_clusterTime);
+        }
+        shardIds[i] = shardId;
+    }
+
+    return shardIds;
 }
 
 bool ChunkManager::keyBelongsToShard(const BSONObj& shardKey, const ShardId& shardId) const {
     if (shardKey.isEmpty())
         return false;
 
-    const auto it = _rt->getChunkMap().upper_bound(_rt->_extractKeyString(shardKey));
+    const auto it = _rt->getChunkMap().upperBound(_rt->_extractKeyString(shardKey));
     if (it == _rt->getChunkMap().end())
         return false;
 
-    invariant(it->second->containsKey(shardKey));
+    invariant((*it)->containsKey(shardKey));
 
-    return it->second->getShardIdAt(_clusterTime) == shardId;
+    return (*it)->getShardIdAt(_clusterTime) == shardId;
 }
 
 void ChunkManager::getShardIdsForQuery(OperationContext* opCtx,
@@ -183,7 +561,7 @@ void ChunkManager::getShardIdsForQuery(OperationContext* opCtx,
     // For now, we satisfy that assumption by adding a shard with no matches rather than returning
     // an empty set of shards.
     if (shardIds->empty()) {
-        shardIds->insert(_rt->getChunkMap().begin()->second->getShardIdAt(_clusterTime));
+        shardIds->insert((*_rt->getChunkMap().begin())->getShardIdAt(_clusterTime));
     }
 }
 
@@ -192,7 +570,7 @@ void ChunkManager::getShardIdsForRange(const BSONObj& min,
                                        std::set<ShardId>* shardIds) const {
     const auto bounds = _rt->overlappingRanges(min, max, true);
     for (auto it = bounds.first; it != bounds.second; ++it) {
-        shardIds->insert(it->second->getShardIdAt(_clusterTime));
+        shardIds->insert((*it)->getShardIdAt(_clusterTime));
 
         // No need to iterate through the rest of the ranges, because we already know we need to use
         // all shards.
@@ -204,8 +582,8 @@ void ChunkManager::getShardIdsForRange(const BSONObj& min,
 
 bool ChunkManager::rangeOverlapsShard(const ChunkRange& range, const ShardId& shardId) const {
     const auto bounds = _rt->overlappingRanges(range.getMin(), range.getMax(), false);
-    const auto it = std::find_if(bounds.first, bounds.second, [this, &shardId](const auto& scr) {
-        return scr.second->getShardIdAt(_clusterTime) == shardId;
+    const auto it = std::find_if(bounds.first, bounds.second, [this, &shardId](const auto& chunk) {
+        return chunk->getShardIdAt(_clusterTime) == shardId;
     });
 
     return it != bounds.second;
@@ -213,10 +591,10 @@ bool ChunkManager::rangeOverlapsShard(const ChunkRange& range, const ShardId& sh
 
 ChunkManager::ConstRangeOfChunks ChunkManager::getNextChunkOnShard(const BSONObj& shardKey,
                                                                    const ShardId& shardId) const {
-    for (auto it = _rt->getChunkMap().upper_bound(_rt->_extractKeyString(shardKey));
+    for (auto it = _rt->getChunkMap().upperBound(_rt->_extractKeyString(shardKey));
          it != _rt->getChunkMap().end();
          ++it) {
-        const auto& chunk = it->second;
+        const auto& chunk = *it;
         if (chunk->getShardIdAt(_clusterTime) == shardId) {
             const auto begin = it;
             const auto end = ++it;
@@ -234,15 +612,15 @@ void RoutingTableHistory::getAllShardIds(std::set<ShardId>* all) const {
                    [](const ShardVersionMap::value_type& pair) { return pair.first; });
 }
 
-std::pair<ChunkInfoMap::const_iterator, ChunkInfoMap::const_iterator>
+std::pair<ChunkMap::const_iterator, ChunkMap::const_iterator>
 RoutingTableHistory::overlappingRanges(const BSONObj& min,
                                        const BSONObj& max,
                                        bool isMaxInclusive) const {
 
-    const auto itMin = _chunkMap.upper_bound(_extractKeyString(min));
+    const auto itMin = _chunkMap.upperBound(_extractKeyString(min));
     const auto itMax = [this, &max, isMaxInclusive]() {
-        auto it = isMaxInclusive ? _chunkMap.upper_bound(_extractKeyString(max))
-                                 : _chunkMap.lower_bound(_extractKeyString(max));
+        auto it = isMaxInclusive ? _chunkMap.upperBound(_extractKeyString(max))
+                                 : _chunkMap.lowerBound(_extractKeyString(max));
         return it == _chunkMap.end() ? it : ++it;
     }();
 
@@ -389,7 +767,7 @@ ChunkVersion RoutingTableHistory::getVersion(const ShardId& shardName) const {
         return ChunkVersion(0, 0, _collectionVersion.epoch());
     }
 
-    return it->second;
+    return it->second.shardVersion;
 }
 
 std::string RoutingTableHistory::toString() const {
@@ -398,93 +776,52 @@ std::string RoutingTableHistory::toString() const {
 
     sb << "Chunks:\n";
     for (const auto& chunk : _chunkMap) {
-        sb << "\t" << chunk.second->toString() << '\n';
+        sb << "\t" << chunk->toString() << '\n';
     }
 
     sb << "Shard versions:\n";
     for (const auto& entry : _shardVersions) {
-        sb << "\t" << entry.first << ": " << entry.second.toString() << '\n';
+        sb << "\t" << entry.first << ": " << entry.second.shardVersion.toString() << '\n';
     }
 
     return sb.str();
 }
 
-ShardVersionMap RoutingTableHistory::_constructShardVersionMap() const {
-    const OID& epoch = _collectionVersion.epoch();
-
+ShardVersionMap RoutingTableHistory::_constructShardVersionMap(const ChunkMap& chunkMap,
+                                                               const OID& epoch) {
     ShardVersionMap shardVersions;
-    ChunkInfoMap::const_iterator current = _chunkMap.cbegin();
 
-    boost::optional<BSONObj> firstMin = boost::none;
-    boost::optional<BSONObj> lastMax = boost::none;
+    // Consecutive chunks tend to live on the same shard, so remember the last one looked up
+    auto shardVersionIt = shardVersions.end();
+    const ChunkInfo* previousChunk = nullptr;
 
-    while (current != _chunkMap.cend()) {
-        const auto& firstChunkInRange = current->second;
-        const auto& currentRangeShardId = firstChunkInRange->getShardIdAt(boost::none);
-
-        // Tracks the max shard version for the shard on which the current range will reside
-        auto shardVersionIt = shardVersions.find(currentRangeShardId);
-        if (shardVersionIt == shardVersions.end()) {
+    for (const auto& chunk : chunkMap) {
+        const auto& shardId = chunk->getShardIdAt(boost::none);
+        if (shardVersionIt == shardVersions.end() || shardVersionIt->first != shardId) {
             shardVersionIt =
-                shardVersions.emplace(currentRangeShardId, ChunkVersion(0, 0, epoch)).first;
+                shardVersions.emplace(shardId, ShardVersionInfo{ChunkVersion(0, 0, epoch)}).first;
         }
 
-        auto& maxShardVersion = shardVersionIt->second;
-
-        current =
-            std::find_if(current,
-                         _chunkMap.cend(),
-                         [&currentRangeShardId,
-                          &maxShardVersion](const ChunkInfoMap::value_type& chunkMapEntry) {
-                             const auto& currentChunk = chunkMapEntry.second;
-
-                             if (currentChunk->getShardIdAt(boost::none) != currentRangeShardId)
-                                 return true;
-
-                             if (currentChunk->getLastmod() > maxShardVersion)
-                                 maxShardVersion = currentChunk->getLastmod();
-
-                             return false;
-                         });
+        auto& shardVersionInfo = shardVersionIt->second;
+        ++shardVersionInfo.numChunks;
+        if (chunk->getLastmod() > shardVersionInfo.shardVersion)
+            shardVersionInfo.shardVersion = chunk->getLastmod();
 
-        const auto rangeLast = std::prev(current);
-
-        const auto& rangeMin = firstChunkInRange->getMin();
-        const auto& rangeMax = rangeLast->second->getMax();
+        // If a shard has chunks it must have a shard version, otherwise we have an invalid chunk
+        // somewhere, which should have been caught at chunk load time
+        invariant(shardVersionInfo.shardVersion.isSet());
 
         // Check the continuity of the chunks map
-        if (lastMax && !SimpleBSONObjComparator::kInstance.evaluate(*lastMax == rangeMin)) {
-            if (SimpleBSONObjComparator::kInstance.evaluate(*lastMax < rangeMin))
-                uasserted(ErrorCodes::ConflictingOperationInProgress,
-                          str::stream()
-                              << "Gap exists in the routing table between chunks "
-                              << _chunkMap.at(_extractKeyString(*lastMax))->getRange().toString()
-                              << " and " << rangeLast->second->getRange().toString());
-            else
-                uasserted(ErrorCodes::ConflictingOperationInProgress,
-                          str::stream()
-                              << "Overlap exists in the routing table between chunks "
-                              << _chunkMap.at(_extractKeyString(*lastMax))->getRange().toString()
-                              << " and " << rangeLast->second->getRange().toString());
-        }
-
-        if (!firstMin)
-            firstMin = rangeMin;
-
-        lastMax = rangeMax;
+        if (previousChunk)
+            checkChunksAreContiguous(*previousChunk, *chunk);
+        else
+            checkAllElementsAreOfType(MinKey, chunk->getMin());
 
-        // If a shard has chunks it must have a shard version, otherwise we have an invalid chunk
-        // somewhere, which should have been caught at chunk load time
-        invariant(maxShardVersion.isSet());
+        previousChunk = chunk.get();
     }
 
-    if (!_chunkMap.empty()) {
-        invariant(!shardVersions.empty());
-        invariant(firstMin.is_initialized());
-        invariant(lastMax.is_initialized());
-
-        checkAllElementsAreOfType(MinKey, firstMin.get());
-        checkAllElementsAreOfType(MaxKey, lastMax.get());
+    if (previousChunk) {
+        checkAllElementsAreOfType(MaxKey, previousChunk->getMax());
     }
 
     return shardVersions;
@@ -508,7 +845,8 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeNew(
                                std::move(defaultCollator),
                                std::move(unique),
                                {},
-                               {0, 0, epoch})
+                               {0, 0, epoch},
+                               {})
         .makeUpdated(chunks);
 }
 
@@ -516,7 +854,19 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
     const std::vector<ChunkType>& changedChunks) {
 
     const auto startingCollectionVersion = getVersion();
+    const OID& epoch = startingCollectionVersion.epoch();
+
+    // Both copies share all their contents with this routing table and only clone what the changed
+    // chunks touch
     auto chunkMap = _chunkMap;
+    auto shardVersions = _shardVersions;
+
+    // Shards which lost the chunk carrying their max version and didn't get a newer one since, so
+    // their version has to be found by going over all the chunks
+    std::set<ShardId> shardsWithRemovedVersion;
+
+    std::vector<std::string> changedMaxKeyStrings;
+    changedMaxKeyStrings.reserve(changedChunks.size());
 
     ChunkVersion collectionVersion = startingCollectionVersion;
     for (const auto& chunk : changedChunks) {
@@ -534,15 +884,15 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
         collectionVersion = chunkVersion;
 
         const auto chunkMinKeyString = _extractKeyString(chunk.getMin());
-        const auto chunkMaxKeyString = _extractKeyString(chunk.getMax());
+        auto chunkMaxKeyString = _extractKeyString(chunk.getMax());
 
         // Returns the first chunk with a max key that is > min - implies that the chunk overlaps
         // min
-        const auto low = chunkMap.upper_bound(chunkMinKeyString);
+        const auto low = chunkMap.upperBound(chunkMinKeyString);
 
         // Returns the first chunk with a max key that is > max - implies that the next chunk cannot
         // not overlap max
-        const auto high = chunkMap.upper_bound(chunkMaxKeyString);
+        const auto high = chunkMap.upperBound(chunkMaxKeyString);
 
         // If we are in the middle of splitting a chunk, for the first few
         // chunks inserted, low == high, because both lookups will point to the
@@ -560,17 +910,41 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
 
         auto newChunk = std::make_shared<ChunkInfo>(chunk);
         if (foundSingleChunk) {
-            auto chunkBeingReplacedBySplit = low->second;
+            auto chunkBeingReplacedBySplit = *low;
             auto bytesInReplacedChunk =
                 chunkBeingReplacedBySplit->getWritesTracker()->getBytesWritten();
             newChunk->getWritesTracker()->addBytesWritten(bytesInReplacedChunk);
         }
 
-        // Erase all chunks from the map, which overlap the chunk we got from the persistent store
-        chunkMap.erase(low, high);
+        for (auto it = low; it != high; ++it) {
+            const auto& replacedChunk = *it;
+            auto shardVersionIt = shardVersions.find(replacedChunk->getShardIdAt(boost::none));
+            invariant(shardVersionIt != shardVersions.end());
+
+            auto& shardVersionInfo = shardVersionIt->second;
+            if (--shardVersionInfo.numChunks == 0) {
+                shardsWithRemovedVersion.erase(shardVersionIt->first);
+                shardVersions.erase(shardVersionIt);
+            } else if (replacedChunk->getLastmod() == shardVersionInfo.shardVersion) {
+                shardsWithRemovedVersion.insert(shardVersionIt->first);
+            }
+        }
 
-        // Insert only the chunk itself
-        chunkMap.insert(std::make_pair(chunkMaxKeyString, newChunk));
+        // Chunks come in version order, so the new chunk has the max version on its shard
+        const auto& shardId = newChunk->getShardIdAt(boost::none);
+        auto& shardVersionInfo =
+            shardVersions.emplace(shardId, ShardVersionInfo{ChunkVersion(0, 0, epoch)})
+                .first->second;
+        ++shardVersionInfo.numChunks;
+        shardVersionInfo.shardVersion = chunkVersion;
+        invariant(shardVersionInfo.shardVersion.isSet());
+        shardsWithRemovedVersion.erase(shardId);
+
+        changedMaxKeyStrings.push_back(chunkMaxKeyString);
+
+        // Replace all chunks in the map which overlap the chunk we got from the persistent store
+        // with only the chunk itself
+        chunkMap.replace(low, high, std::move(chunkMaxKeyString), std::move(newChunk));
     }
 
     // If at least one diff was applied, the metadata is correct, but it might not have changed so
@@ -584,6 +958,29 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
         return shared_from_this();
     }
 
+    if (shardsWithRemovedVersion.empty()) {
+        // The rest of the routing table was already checked, so only the boundaries which the
+        // changed chunks took part in have to be checked for continuity
+        for (const auto& maxKeyString : changedMaxKeyStrings) {
+            const auto it = chunkMap.lowerBound(maxKeyString);
+            if (it == chunkMap.end())
+                continue;
+
+            if (it == chunkMap.begin())
+                checkAllElementsAreOfType(MinKey, (*it)->getMin());
+            else
+                checkChunksAreContiguous(**std::prev(it), **it);
+
+            const auto next = std::next(it);
+            if (next == chunkMap.end())
+                checkAllElementsAreOfType(MaxKey, (*it)->getMax());
+            else
+                checkChunksAreContiguous(**it, **next);
+        }
+    } else {
+        shardVersions = _constructShardVersionMap(chunkMap, epoch);
+    }
+
     return std::shared_ptr<RoutingTableHistory>(
         new RoutingTableHistory(_nss,
                                 _uuid,
@@ -591,7 +988,8 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
                                 CollatorInterface::cloneCollator(getDefaultCollator()),
                                 isUnique(),
                                 std::move(chunkMap),
-                                collectionVersion));
+                                collectionVersion,
+                                std::move(shardVersions)));
 }
 
 }  // namespace mongo
@@ -34,6 +34,8 @@
 #include <string>
 #include <vector>
 
+#include <boost/container/small_vector.hpp>
+
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/query/collation/collator_interface.h"
 #include "mongo/s/chunk.h"
@@ -49,11 +51,251 @@ struct QuerySolutionNode;
 class OperationContext;
 class ChunkManager;
 
-// Ordered map from the max for each chunk to an entry describing the chunk
-using ChunkInfoMap = std::map<std::string, std::shared_ptr<ChunkInfo>>;
+/**
+ * Ordered collection of the chunks of a collection, keyed by the KeyString encoding of each
+ * chunk's max.
+ *
+ * The chunks are kept in a B+tree whose nodes store their keys back to back in a single sorted
+ * buffer, so a lookup is a few binary searches over densely packed keys rather than a walk down a
+ * tree of separately allocated nodes and strings. Nodes are never modified once they are shared: copying a ChunkMap
+ * only copies a pointer to its root, and modifying the copy clones just the nodes on the paths to
+ * the chunks it changes. A refresh therefore costs time proportional to the number of changed
+ * chunks times the depth of the tree, and readers of the original map keep seeing it unchanged.
+ */
+class ChunkMap {
+    /**
+     * Sorted KeyStrings stored back to back in one buffer, along with the offset at which each of
+     * them ends.
+     */
+    class KeyStringArray {
+    public:
+        size_t size() const {
+            return _ends.size();
+        }
+
+        StringData operator[](size_t index) const {
+            const size_t begin = _begin(index);
+            return StringData(_bytes.data() + begin, _ends[index] - begin);
+        }
+        StringData back() const {
+            return (*this)[size() - 1];
+        }
+
+        /**
+         * Returns the index of the first KeyString from 'from' on for which 'isBefore' returns
+         * false, or size() if there is none.
+         */
+        template <typename IsBefore>
+        size_t partitionPoint(IsBefore isBefore, size_t from = 0) const {
+            for (size_t count = size() - from; count > 0;) {
+                const size_t half = count / 2;
+                if (isBefore((*this)[from + half])) {
+                    from += half + 1;
+                    count -= half + 1;
+                } else {
+                    count = half;
+                }
+            }
+            return from;
+        }
+
+        size_t lowerBound(StringData keyString) const {
+            return partitionPoint([&](StringData key) { return key < keyString; });
+        }
+
+        /**
+         * The KeyStrings passed to these must not point into this array.
+         */
+        void insert(size_t index, StringData keyString);
+        void set(size_t index, StringData keyString);
+        void push_back(StringData keyString) {
+            insert(size(), keyString);
+        }
+
+        /**
+         * Appends the KeyStrings of 'other' in ['first', 'last').
+         */
+        void append(const KeyStringArray& other, size_t first, size_t last);
+
+        /**
+         * Removes the KeyStrings in ['first', 'last').
+         */
+        void erase(size_t first, size_t last);
+
+    private:
+        size_t _begin(size_t index) const {
+            return index == 0 ? 0 : _ends[index - 1];
+        }
+
+        std::string _bytes;
+        std::vector<uint32_t> _ends;
+    };
+
+    struct Node {
+        bool isLeaf() const {
+            return children.empty();
+        }
+
+        // The max of each chunk in a leaf, or of the last chunk under each child otherwise.
+        KeyStringArray maxKeyStrings;
+
+        // Only one of these is populated, depending on whether the node is a leaf.
+        std::vector<std::shared_ptr<ChunkInfo>> chunks;
+        std::vector<std::shared_ptr<Node>> children;
+    };
+
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = std::shared_ptr<ChunkInfo>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        const_iterator() = default;
+
+        reference operator*() const {
+            return _path.back().first->chunks[_path.back().second];
+        }
+        pointer operator->() const {
+            return &**this;
+        }
+
+        const_iterator& operator++();
+        const_iterator operator++(int) {
+            auto result = *this;
+            ++*this;
+            return result;
+        }
+        const_iterator& operator--();
+        const_iterator operator--(int) {
+            auto result = *this;
+            --*this;
+            return result;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            if (_path.empty() || other._path.empty()) {
+                return _path.empty() && other._path.empty();
+            }
+            return _path.back() == other._path.back();
+        }
+        bool operator!=(const const_iterator& other) const {
+            return !(*this == other);
+        }
+
+    private:
+        friend class ChunkMap;
+
+        explicit const_iterator(const ChunkMap* map) : _map(map) {}
+
+        StringData _maxKeyString() const {
+            return _path.back().first->maxKeyStrings[_path.back().second];
+        }
+
+        /**
+         * Extends the path from 'node' down to the first (or last) chunk under it.
+         */
+        void _descendToFirst(const Node* node);
+        void _descendToLast(const Node* node);
+
+        const ChunkMap* _map = nullptr;
+
+        // Each node from the root down to the current chunk's leaf, along with the index of the
+        // child (or chunk) taken in it. Empty for the end iterator.
+        boost::container::small_vector<std::pair<const Node*, size_t>, 4> _path;
+    };
+
+    const_iterator begin() const;
+    const_iterator end() const {
+        return const_iterator(this);
+    }
+
+    size_t size() const {
+        return _size;
+    }
+    bool empty() const {
+        return _size == 0;
+    }
+
+    /**
+     * Returns the first chunk whose max sorts after 'keyString', which is the chunk containing
+     * 'keyString' if there is one.
+     */
+    const_iterator upperBound(StringData keyString) const;
+
+    /**
+     * Returns the first chunk whose max doesn't sort before 'keyString'.
+     */
+    const_iterator lowerBound(StringData keyString) const;
+
+    /**
+     * Same as upperBound(keyString), but starts from 'hint', which must not be past the result.
+     * Looking up keys in sorted order with each result as the hint for the next key only searches
+     * the rest of the current leaf for keys which land nearby, instead of descending from the root.
+     */
+    const_iterator upperBound(StringData keyString, const_iterator hint) const;
+
+    /**
+     * Removes the chunks in ['first', 'last') and puts 'chunk', whose max is 'maxKeyString', in
+     * their place. 'maxKeyString' must sort after the max of every chunk before 'first' and before
+     * the max of every chunk from 'last' on.
+     */
+    void replace(const_iterator first,
+                 const_iterator last,
+                 std::string maxKeyString,
+                 std::shared_ptr<ChunkInfo> chunk);
+
+private:
+    // Nodes are split when they grow past this many entries, and merged with a sibling when they
+    // shrink below a quarter of it.
+    static constexpr size_t kMaxNodeSize = 64;
+
+    /**
+     * Descends from the root to the first chunk for which 'isBefore' returns false when given its
+     * max.
+     */
+    template <typename IsBefore>
+    const_iterator _partitionPoint(IsBefore isBefore) const;
+
+    /**
+     * Returns the node held by 'node', cloning it first if it is shared with another ChunkMap.
+     */
+    static Node& _mutableNode(std::shared_ptr<Node>& node);
+
+    /**
+     * Removes the chunks whose max is in ['from', 'to') from the subtree under 'node', which must
+     * not be shared. A null bound leaves that side of the range open.
+     */
+    static void _erase(Node& node, const std::string* from, const std::string* to);
+
+    /**
+     * Adds 'chunk' with max 'maxKeyString' to the subtree under 'node', which must not be shared.
+     */
+    static void _insert(Node& node, std::string maxKeyString, std::shared_ptr<ChunkInfo> chunk);
+
+    /**
+     * Removes, splits or merges the child of 'parent' at 'index' as needed after it was modified,
+     * and brings its max in 'parent' up to date. The child must not be shared.
+     */
+    static void _rebalanceChild(Node& parent, size_t index);
+
+    std::shared_ptr<Node> _root;
+    size_t _size = 0;
+};
+
+/**
+ * The max chunk version on a shard, along with the number of chunks it owns, which lets a refresh
+ * tell when the last of them goes away.
+ */
+struct ShardVersionInfo {
+    ChunkVersion shardVersion;
+    size_t numChunks = 0;
+};
 
 // Map from a shard is to the max chunk version on that shard
-using ShardVersionMap = std::map<ShardId, ChunkVersion>;
+using ShardVersionMap = std::map<ShardId, ShardVersionInfo>;
 
 /**
  * In-memory representation of the routing table for a single sharded collection at various points
@@ -122,7 +364,7 @@ public:
 
     ChunkVersion getVersion(const ShardId& shardId) const;
 
-    const ChunkInfoMap& getChunkMap() const {
+    const ChunkMap& getChunkMap() const {
         return _chunkMap;
     }
 
@@ -146,7 +388,7 @@ public:
         return _uuid;
     }
 
-    std::pair<ChunkInfoMap::const_iterator, ChunkInfoMap::const_iterator> overlappingRanges(
+    std::pair<ChunkMap::const_iterator, ChunkMap::const_iterator> overlappingRanges(
         const BSONObj& min, const BSONObj& max, bool isMaxInclusive) const;
 
 
@@ -156,13 +398,15 @@ private:
                         KeyPattern shardKeyPattern,
                         std::unique_ptr<CollatorInterface> defaultCollator,
                         bool unique,
-                        ChunkInfoMap chunkMap,
-                        ChunkVersion collectionVersion);
+                        ChunkMap chunkMap,
+                        ChunkVersion collectionVersion,
+                        ShardVersionMap shardVersions);
 
     /**
-     * Does a single pass over the chunkMap and constructs the ShardVersionMap object.
+     * Does a single pass over 'chunkMap', checking that its chunks cover the whole key space, and
+     * constructs the ShardVersionMap object.
      */
-    ShardVersionMap _constructShardVersionMap() const;
+    static ShardVersionMap _constructShardVersionMap(const ChunkMap& chunkMap, const OID& epoch);
 
     std::string _extractKeyString(const BSONObj& shardKeyValue) const;
 
@@ -189,7 +433,7 @@ private:
 
     // Map from the max for each chunk to an entry describing the chunk. The union of all chunks'
     // ranges must cover the complete space from [MinKey, MaxKey).
-    const ChunkInfoMap _chunkMap;
+    const ChunkMap _chunkMap;
 
     // Max version across all chunks
     const ChunkVersion _collectionVersion;
@@ -211,7 +455,7 @@ public:
     class ConstChunkIterator {
     public:
         ConstChunkIterator() = default;
-        explicit ConstChunkIterator(ChunkInfoMap::const_iterator iter,
+        explicit ConstChunkIterator(ChunkMap::const_iterator iter,
                                     boost::optional<Timestamp> clusterTime)
             : _iter{std::move(iter)}, _clusterTime{std::move(clusterTime)} {}
 
@@ -229,11 +473,11 @@ public:
             return !(*this == other);
         }
         const Chunk operator*() const {
-            return Chunk{*_iter->second, _clusterTime};
+            return Chunk{**_iter, _clusterTime};
         }
 
     private:
-        ChunkInfoMap::const_iterator _iter;
+        ChunkMap::const_iterator _iter;
         boost::optional<Timestamp> _clusterTime;
     };
 
@@ -289,8 +533,8 @@ public:
     }
 
     ConstRangeOfChunks chunks() const {
-        return {ConstChunkIterator{_rt->getChunkMap().cbegin(), _clusterTime},
-                ConstChunkIterator{_rt->getChunkMap().cend(), _clusterTime}};
+        return {ConstChunkIterator{_rt->getChunkMap().begin(), _clusterTime},
+                ConstChunkIterator{_rt->getChunkMap().end(), _clusterTime}};
     }
 
     int numChunks() const {
@@ -337,6 +581,18 @@ public:
         return findIntersectingChunk(shardKey, CollationSpec::kSimpleSpec);
     }
 
+    /**
+     * Bulk form of findIntersectingChunkWithSimpleCollation for documents about to be inserted.
+     * Extracts and encodes the shard keys of all of 'docs' in one pass, sorts them and assigns
+     * them to chunks with a single forward walk over the routing table, so a key which falls in
+     * or near the chunk of the previous one costs a comparison rather than a full lookup.
+     *
+     * Returns, for each document, the shard which owns it, or nullptr if the document doesn't
+     * have a valid shard key or no chunk contains its key; targeting such a document on its own
+     * reports why. The returned ShardIds are owned by the routing table and live as long as it.
+     */
+    std::vector<const ShardId*> findShardIdsForDocuments(const std::vector<BSONObj>& docs) const;
+
     /**
      * Finds the shard IDs for a given filter and collation. If collation is empty, we use the
      * collection default collation for targeting.
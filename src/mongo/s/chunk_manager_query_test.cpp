@@ -488,5 +488,43 @@ TEST_F(ChunkManagerQueryTest, SimpleCollationNumbersMultiShard) {
         {ShardId("0")});
 }
 
+TEST_F(ChunkManagerQueryTest, FindShardIdsForDocumentsMatchesSingleDocumentLookups) {
+    // Enough chunks for the routing table to span several nodes
+    std::vector<BSONObj> splitPoints;
+    for (int i = 0; i < 300; ++i) {
+        splitPoints.push_back(BSON("a" << i * 10));
+    }
+
+    const ShardKeyPattern shardKeyPattern(BSON("a" << 1));
+    auto chunkManager = makeChunkManager(kNss, shardKeyPattern, nullptr, false, splitPoints);
+
+    // Unsorted keys, with repeats, keys which fall in the same chunk and in neighbouring ones,
+    // large jumps backwards and forwards, a missing shard key and a MaxKey one
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < 500; ++i) {
+        docs.push_back(BSON("a" << (i * 7919) % 3100 - 50 << "i" << i));
+    }
+    docs.push_back(BSON("a" << 1234));
+    docs.push_back(BSON("a" << 1234));
+    docs.push_back(BSON("b" << 1));
+    docs.push_back(BSON("a" << MAXKEY));
+    docs.push_back(BSON("a" << BSON_ARRAY(1 << 2)));
+
+    const auto shardIds = chunkManager->findShardIdsForDocuments(docs);
+    ASSERT_EQ(docs.size(), shardIds.size());
+
+    for (size_t i = 0; i < docs.size() - 2; ++i) {
+        ASSERT(shardIds[i]) << docs[i];
+        const auto shardKey = shardKeyPattern.extractShardKeyFromDoc(docs[i]);
+        ASSERT_EQ(chunkManager->findIntersectingChunkWithSimpleCollation(shardKey).getShardId(),
+                  *shardIds[i])
+            << docs[i];
+    }
+
+    // No chunk contains MaxKey, and an array isn't a valid shard key
+    ASSERT_FALSE(shardIds[docs.size() - 2]);
+    ASSERT_FALSE(shardIds[docs.size() - 1]);
+}
+
 }  // namespace
 }  // namespace mongo
@@ -122,7 +122,49 @@ void BM_IncrementalRefreshOfPessimalBalancedDistribution(benchmark::State& state
     }
 }
 
-BENCHMARK(BM_IncrementalRefreshOfPessimalBalancedDistribution)->Args({2, 50000});
+BENCHMARK(BM_IncrementalRefreshOfPessimalBalancedDistribution)
+    ->Args({2, 50000})
+    ->Args({2, 500000})
+    ->Args({100, 500000});
+
+/**
+ * Splits a different chunk on every iteration, each time refreshing the routing table produced by
+ * the previous one, so the routing tables share their structure with a long line of predecessors.
+ */
+void BM_SuccessiveIncrementalRefreshes(benchmark::State& state) {
+    const int nShards = state.range(0);
+    const int nChunks = state.range(1);
+    auto cm = makeChunkManagerWithPessimalBalancedDistribution(nShards, nChunks);
+
+    auto rt = cm->getChunkManager()->getRoutingHistory();
+    auto version = rt->getVersion();
+    const auto collName = NamespaceString(cm->getChunkManager()->getns());
+
+    int iteration = 0;
+    for (auto keepRunning : state) {
+        // Every pass over the chunks splits one more key off the front of each of them
+        const int i = 1 + iteration % (nChunks - 2);
+        const int pass = iteration / (nChunks - 2);
+        invariant(pass < 99);
+        ++iteration;
+
+        const auto range = getRangeForChunk(i, nChunks);
+        const auto lowerMin = BSON("_id" << (i - 1) * 100 + pass);
+        const auto upperMin = BSON("_id" << (i - 1) * 100 + pass + 1);
+        const auto shardId = pessimalShardSelector(i, nShards, nChunks);
+
+        std::vector<ChunkType> newChunks;
+        version.incMajor();
+        newChunks.emplace_back(collName, ChunkRange{lowerMin, upperMin}, version, shardId);
+        version.incMinor();
+        newChunks.emplace_back(collName, ChunkRange{upperMin, range.getMax()}, version, shardId);
+
+        rt = rt->makeUpdated(newChunks);
+        benchmark::DoNotOptimize(rt);
+    }
+}
+
+BENCHMARK(BM_SuccessiveIncrementalRefreshes)->Args({2, 50000})->Args({2, 500000});
 
 template <typename ShardSelectorFn>
 auto BM_FullBuildOfChunkManager(benchmark::State& state, ShardSelectorFn selectShard) {
@@ -247,6 +289,25 @@ void BM_FindIntersectingChunk(benchmark::State& state,
     state.SetItemsProcessed(state.iterations());
 }
 
+/**
+ * Targets all the keys at once, as a large insert does, to compare with BM_FindIntersectingChunk.
+ */
+template <typename CollectionMetadataBuilderFn>
+void BM_FindShardIdsForDocuments(benchmark::State& state,
+                                 CollectionMetadataBuilderFn makeCollectionMetadata) {
+    const int nShards = state.range(0);
+    const int nChunks = state.range(1);
+
+    auto cm = makeCollectionMetadata(nShards, nChunks);
+    auto docs = makeKeys(nChunks);
+
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(cm->getChunkManager()->findShardIdsForDocuments(docs));
+    }
+
+    state.SetItemsProcessed(state.iterations() * docs.size());
+}
+
 template <typename CollectionMetadataBuilderFn>
 void BM_GetShardIdsForRange(benchmark::State& state,
                             CollectionMetadataBuilderFn makeCollectionMetadata) {
@@ -329,6 +390,12 @@ MONGO_INITIALIZER(RegisterBenchmarks)(InitializerContext* context) {
             BM_FindIntersectingChunk, Pessimal, makeChunkManagerWithPessimalBalancedDistribution),
         REGISTER_BENCHMARK_CAPTURE(
             BM_FindIntersectingChunk, Optimal, makeChunkManagerWithOptimalBalancedDistribution),
+        REGISTER_BENCHMARK_CAPTURE(BM_FindShardIdsForDocuments,
+                                   Pessimal,
+                                   makeChunkManagerWithPessimalBalancedDistribution),
+        REGISTER_BENCHMARK_CAPTURE(BM_FindShardIdsForDocuments,
+                                   Optimal,
+                                   makeChunkManagerWithOptimalBalancedDistribution),
         REGISTER_BENCHMARK_CAPTURE(
             BM_GetShardIdsForRange, Pessimal, makeChunkManagerWithPessimalBalancedDistribution),
         REGISTER_BENCHMARK_CAPTURE(
@@ -348,6 +415,7 @@ MONGO_INITIALIZER(RegisterBenchmarks)(InitializerContext* context) {
             ->Args({10, 50000})
             ->Args({100, 50000})
             ->Args({1000, 50000})
+            ->Args({10, 500000})
             ->Args({2, 2});
     }
 
@@ -103,6 +103,19 @@ public:
     virtual StatusWith<ShardEndpoint> targetInsert(OperationContext* opCtx,
                                                    const BSONObj& doc) const = 0;
 
+    /**
+     * Targets a run of documents to be inserted, amortizing the cost of the lookups across them.
+     *
+     * Appends to 'endpoints' each endpoint targeted which it doesn't already hold, so it can be
+     * reused across calls made with the same targeting information. Returns, for each document,
+     * the position of its endpoint in 'endpoints', or boost::none if it couldn't be targeted, in
+     * which case targetInsert() on that document alone reports why.
+     */
+    virtual std::vector<boost::optional<size_t>> targetInserts(
+        OperationContext* opCtx,
+        const std::vector<BSONObj>& docs,
+        std::vector<ShardEndpoint>* endpoints) const = 0;
+
     /**
      * Returns a vector of ShardEndpoints for a potentially multi-shard update.
      *
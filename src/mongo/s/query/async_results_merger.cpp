@@ -41,6 +41,7 @@
 #include "mongo/db/query/killcursors_request.h"
 #include "mongo/executor/remote_command_request.h"
 #include "mongo/executor/remote_command_response.h"
+#include "mongo/s/query/async_results_merger_knobs_gen.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 
@@ -91,8 +92,8 @@ AsyncResultsMerger::AsyncResultsMerger(OperationContext* opCtx,
       // since that is not supported we treat boost::none (unspecified) to mean 'kNormal'.
       _tailableMode(params.getTailableMode().value_or(TailableModeEnum::kNormal)),
       _params(std::move(params)),
-      _mergeQueue(MergingComparator(
-          _remotes, _params.getSort().value_or(BSONObj()), _params.getCompareWholeSortKey())),
+      _mergeTree(
+          _remotes, _params.getSort().value_or(BSONObj()), _params.getCompareWholeSortKey()),
       _promisedMinSortKeys(PromisedMinSortKeyComparator(_params.getSort().value_or(BSONObj()))) {
     if (params.getTxnNumber()) {
         invariant(params.getSessionId());
@@ -191,6 +192,7 @@ void AsyncResultsMerger::addNewShardCursors(std::vector<RemoteCursor>&& newCurso
                               remote.getCursorResponse().getPartialResultsReturned());
         _addBatchToBuffer(lk, newIndex, remote.getCursorResponse());
     }
+    _mergeTree.invalidate();
 }
 
 bool AsyncResultsMerger::partialResultsReturned() const {
@@ -273,12 +275,12 @@ bool AsyncResultsMerger::_readySorted(WithLock lk) {
 }
 
 bool AsyncResultsMerger::_readySortedTailable(WithLock lk) {
-    if (_mergeQueue.empty()) {
+    const auto smallestRemote = _mergeTree.top();
+    if (!smallestRemote) {
         return false;
     }
 
-    auto smallestRemote = _mergeQueue.top();
-    auto smallestResult = _remotes[smallestRemote].docBuffer.front();
+    const auto& smallestResult = _remotes[*smallestRemote].docBuffer.front();
     auto keyWeWantToReturn =
         extractSortKey(*smallestResult.getResult(), _params.getCompareWholeSortKey());
     // We should always have a minPromisedSortKey from every shard in the sorted tailable case.
@@ -321,28 +323,21 @@ StatusWith<ClusterQueryResult> AsyncResultsMerger::nextReady() {
     return _params.getSort() ? _nextReadySorted(lk) : _nextReadyUnsorted(lk);
 }
 
-ClusterQueryResult AsyncResultsMerger::_nextReadySorted(WithLock) {
+ClusterQueryResult AsyncResultsMerger::_nextReadySorted(WithLock lk) {
     // Tailable non-awaitData cursors cannot have a sort.
     invariant(_tailableMode != TailableModeEnum::kTailable);
 
-    if (_mergeQueue.empty()) {
+    const auto smallestRemote = _mergeTree.top();
+    if (!smallestRemote) {
         return {};
     }
 
-    size_t smallestRemote = _mergeQueue.top();
-    _mergeQueue.pop();
+    invariant(_remotes[*smallestRemote].status.isOK());
 
-    invariant(!_remotes[smallestRemote].docBuffer.empty());
-    invariant(_remotes[smallestRemote].status.isOK());
+    ClusterQueryResult front = _takeNextResult(lk, *smallestRemote);
 
-    ClusterQueryResult front = _remotes[smallestRemote].docBuffer.front();
-    _remotes[smallestRemote].docBuffer.pop();
-
-    // Re-populate the merging queue with the next result from 'smallestRemote', if it has a
-    // next result.
-    if (!_remotes[smallestRemote].docBuffer.empty()) {
-        _mergeQueue.push(smallestRemote);
-    }
+    // Let the next result from 'smallestRemote', if it has one, compete for the next spot.
+    _mergeTree.replayTop();
 
     // For sorted tailable awaitData cursors, update the high water mark to the document's sort key.
     if (_tailableMode == TailableModeEnum::kTailableAndAwaitData) {
@@ -353,15 +348,14 @@ ClusterQueryResult AsyncResultsMerger::_nextReadySorted(WithLock) {
     return front;
 }
 
-ClusterQueryResult AsyncResultsMerger::_nextReadyUnsorted(WithLock) {
+ClusterQueryResult AsyncResultsMerger::_nextReadyUnsorted(WithLock lk) {
     size_t remotesAttempted = 0;
     while (remotesAttempted < _remotes.size()) {
         // It is illegal to call this method if there is an error received from any shard.
         invariant(_remotes[_gettingFromRemote].status.isOK());
 
         if (_remotes[_gettingFromRemote].hasNext()) {
-            ClusterQueryResult front = _remotes[_gettingFromRemote].docBuffer.front();
-            _remotes[_gettingFromRemote].docBuffer.pop();
+            ClusterQueryResult front = _takeNextResult(lk, _gettingFromRemote);
 
             if (_tailableMode == TailableModeEnum::kTailable &&
                 !_remotes[_gettingFromRemote].hasNext()) {
@@ -384,6 +378,51 @@ ClusterQueryResult AsyncResultsMerger::_nextReadyUnsorted(WithLock) {
     return {};
 }
 
+ClusterQueryResult AsyncResultsMerger::_takeNextResult(WithLock lk, size_t remoteIndex) {
+    auto& remote = _remotes[remoteIndex];
+    invariant(!remote.docBuffer.empty());
+
+    ClusterQueryResult front = std::move(remote.docBuffer.front());
+    remote.docBuffer.pop();
+
+    const size_t resultBytes = front.getResult()->objsize();
+    remote.bufferedBytes -= resultBytes;
+    _bufferedBytes -= resultBytes;
+
+    _prefetchIfBelowWatermark(lk, remoteIndex);
+    return front;
+}
+
+void AsyncResultsMerger::_prefetchIfBelowWatermark(WithLock lk, size_t remoteIndex) {
+    auto& remote = _remotes[remoteIndex];
+
+    // A remote with an empty buffer gets its next batch requested through nextEvent() as usual.
+    if (!remote.hasNext() || remote.exhausted() || remote.cbHandle.isValid() ||
+        !remote.status.isOK()) {
+        return;
+    }
+
+    if (remote.docBuffer.size() * 2 >= remote.lastBatchCount) {
+        return;
+    }
+
+    // Batches from tailable cursors are passed through to the client as they are. A request which
+    // outlives the client's operation must neither be cut short by its deadline nor run on a
+    // session which the next operation in a transaction will need.
+    if (_tailableMode != TailableModeEnum::kNormal || _lifecycleState != kAlive || !_opCtx ||
+        _opCtx->getDeadline() != Date_t::max() || _params.getTxnNumber()) {
+        return;
+    }
+
+    const auto maxPrefetchedBytes =
+        static_cast<size_t>(internalQueryARMMaxPrefetchedBytes.load());
+    if (_bufferedBytes + remote.lastBatchBytes > maxPrefetchedBytes) {
+        return;
+    }
+
+    remote.status = _askForNextBatch(lk, remoteIndex);
+}
+
 Status AsyncResultsMerger::_askForNextBatch(WithLock, size_t remoteIndex) {
     invariant(_opCtx, "Cannot schedule a getMore without an OperationContext");
     auto& remote = _remotes[remoteIndex];
@@ -614,6 +653,9 @@ void AsyncResultsMerger::_cleanUpFailedBatch(WithLock lk, Status status, size_t
         remote.partialResultsReturned = (remote.status != ErrorCodes::ExchangePassthrough);
         std::queue<ClusterQueryResult> emptyBuffer;
         std::swap(remote.docBuffer, emptyBuffer);
+        _bufferedBytes -= remote.bufferedBytes;
+        remote.bufferedBytes = 0;
+        _mergeTree.invalidate();
         remote.status = Status::OK();
         remote.cursorId = 0;
     }
@@ -669,6 +711,11 @@ bool AsyncResultsMerger::_addBatchToBuffer(WithLock lk,
                                            const CursorResponse& response) {
     auto& remote = _remotes[remoteIndex];
     _updateRemoteMetadata(lk, remoteIndex, response);
+
+    // The first buffered result only changes if the buffer was empty
+    const bool hadBufferedResults = remote.hasNext();
+    size_t batchBytes = 0;
+
     for (const auto& obj : response.getBatch()) {
         // If there's a sort, we're expecting the remote node to have given us back a sort key.
         if (_params.getSort()) {
@@ -691,12 +738,18 @@ bool AsyncResultsMerger::_addBatchToBuffer(WithLock lk,
         ClusterQueryResult result(obj);
         remote.docBuffer.push(result);
         ++remote.fetchedCount;
+        batchBytes += obj.objsize();
     }
 
-    // If we're doing a sorted merge, then we have to make sure to put this remote onto the merge
-    // queue.
-    if (_params.getSort() && !response.getBatch().empty()) {
-        _mergeQueue.push(remoteIndex);
+    remote.bufferedBytes += batchBytes;
+    _bufferedBytes += batchBytes;
+    remote.lastBatchCount = response.getBatch().size();
+    remote.lastBatchBytes = batchBytes;
+
+    // If we're doing a sorted merge, then we have to make sure this remote's next result takes part
+    // in the merge.
+    if (_params.getSort() && !response.getBatch().empty() && !hadBufferedResults) {
+        _mergeTree.invalidate();
     }
     return true;
 }
@@ -809,16 +862,75 @@ bool AsyncResultsMerger::RemoteCursorData::exhausted() const {
 }
 
 //
-// AsyncResultsMerger::MergingComparator
+// AsyncResultsMerger::MergeTree
 //
 
-bool AsyncResultsMerger::MergingComparator::operator()(const size_t& lhs, const size_t& rhs) {
+boost::optional<size_t> AsyncResultsMerger::MergeTree::top() {
+    if (!_valid || _tree.size() != _remotes.size()) {
+        _rebuild();
+    }
+
+    if (_tree.empty() || !_remotes[_tree[0]].hasNext()) {
+        return boost::none;
+    }
+    return _tree[0];
+}
+
+void AsyncResultsMerger::MergeTree::replayTop() {
+    if (!_valid) {
+        return;
+    }
+
+    // Walk up from the winner's leaf, swapping in whichever stored loser now beats the candidate.
+    const size_t numRemotes = _tree.size();
+    size_t winner = _tree[0];
+    for (size_t node = (numRemotes + winner) / 2; node > 0; node /= 2) {
+        if (_goesBefore(_tree[node], winner)) {
+            std::swap(_tree[node], winner);
+        }
+    }
+    _tree[0] = winner;
+}
+
+bool AsyncResultsMerger::MergeTree::_goesBefore(size_t lhs, size_t rhs) const {
+    if (!_remotes[lhs].hasNext() || !_remotes[rhs].hasNext()) {
+        return _remotes[lhs].hasNext();
+    }
+
     const ClusterQueryResult& leftDoc = _remotes[lhs].docBuffer.front();
     const ClusterQueryResult& rightDoc = _remotes[rhs].docBuffer.front();
 
-    return compareSortKeys(extractSortKey(*leftDoc.getResult(), _compareWholeSortKey),
-                           extractSortKey(*rightDoc.getResult(), _compareWholeSortKey),
-                           _sort) > 0;
+    const int comparison =
+        compareSortKeys(extractSortKey(*leftDoc.getResult(), _compareWholeSortKey),
+                        extractSortKey(*rightDoc.getResult(), _compareWholeSortKey),
+                        _sort);
+
+    // Break ties by remote so that the merge order doesn't depend on the shape of the tree.
+    return comparison < 0 || (comparison == 0 && lhs < rhs);
+}
+
+void AsyncResultsMerger::MergeTree::_rebuild() {
+    const size_t numRemotes = _remotes.size();
+    _tree.assign(numRemotes, 0);
+    _valid = true;
+    if (numRemotes <= 1) {
+        return;
+    }
+
+    // Play the matches bottom-up, recording the winner of each internal node so that its parent
+    // can play it.
+    std::vector<size_t> winners(numRemotes);
+    auto winnerAt = [&](size_t node) {
+        return node < numRemotes ? winners[node] : node - numRemotes;
+    };
+    for (size_t node = numRemotes - 1; node > 0; --node) {
+        const size_t left = winnerAt(2 * node);
+        const size_t right = winnerAt(2 * node + 1);
+        const bool leftWins = !_goesBefore(right, left);
+        winners[node] = leftWins ? left : right;
+        _tree[node] = leftWins ? right : left;
+    }
+    _tree[0] = winners[1];
 }
 
 bool AsyncResultsMerger::PromisedMinSortKeyComparator::operator()(
@@ -67,6 +67,11 @@ class CursorResponse;
  * This requires waiting until we have a response from every remote before returning results.
  * Without a sort, we are ready to return results as soon as we have *any* response from a remote.
  *
+ * So that a sorted merge doesn't wait out a round trip every time one of the remotes runs dry, the
+ * next batch is requested from a remote as soon as less than half of its previous batch is left
+ * buffered, as long as the results buffered across all remotes stay within
+ * 'internalQueryARMMaxPrefetchedBytes'.
+ *
  * On any error, the caller is responsible for shutting down the ARM using the kill() method.
  *
  * Does not throw exceptions.
@@ -88,8 +93,8 @@ public:
      * the hosts on which they exist in _remotes.
      *
      * Additionally copies each remote's first batch of results, if one exists, into that remote's
-     * docBuffer. If a sort is specified in the ClusterClientCursorParams, places the remotes with
-     * buffered results onto _mergeQueue.
+     * docBuffer. If a sort is specified in the ClusterClientCursorParams, the remotes with
+     * buffered results take part in the merge through _mergeTree.
      *
      * The TaskExecutor* must remain valid for the lifetime of the ARM.
      *
@@ -315,18 +320,62 @@ private:
         // Count of fetched docs during ARM processing of the current batch. Used to reduce the
         // batchSize in getMore when mongod returned less docs than the requested batchSize.
         long long fetchedCount = 0;
+
+        // The total size of the documents in 'docBuffer'.
+        size_t bufferedBytes = 0;
+
+        // The number of documents and their total size in the last batch received from the remote.
+        // Used to decide when to ask for the next batch and whether there is room to buffer it.
+        size_t lastBatchCount = 0;
+        size_t lastBatchBytes = 0;
     };
 
-    class MergingComparator {
+    /**
+     * Picks the remote holding the next document in sort order, using a tournament tree in which
+     * each internal node keeps the remote which lost the match played there. Taking a document from
+     * the winning remote only replays the matches on the path from its leaf to the root, which
+     * costs one comparison per level rather than the two per level of a binary heap.
+     *
+     * Remotes without a buffered document lose every match.
+     */
+    class MergeTree {
     public:
-        MergingComparator(const std::vector<RemoteCursorData>& remotes,
-                          const BSONObj& sort,
-                          bool compareWholeSortKey)
+        MergeTree(const std::vector<RemoteCursorData>& remotes,
+                  const BSONObj& sort,
+                  bool compareWholeSortKey)
             : _remotes(remotes), _sort(sort), _compareWholeSortKey(compareWholeSortKey) {}
 
-        bool operator()(const size_t& lhs, const size_t& rhs);
+        /**
+         * Returns the index of the remote with the next document in sort order, or boost::none if
+         * no remote has a buffered document.
+         */
+        boost::optional<size_t> top();
+
+        /**
+         * Must be called after the first buffered document of the remote returned by top()
+         * changed.
+         */
+        void replayTop();
+
+        /**
+         * Must be called after the first buffered document of any other remote changed, or
+         * remotes were added.
+         */
+        void invalidate() {
+            _valid = false;
+        }
 
     private:
+        /**
+         * Returns true if the next document of remote 'lhs' goes before that of remote 'rhs'.
+         */
+        bool _goesBefore(size_t lhs, size_t rhs) const;
+
+        /**
+         * Plays every match again.
+         */
+        void _rebuild();
+
         const std::vector<RemoteCursorData>& _remotes;
 
         const BSONObj _sort;
@@ -335,6 +384,13 @@ private:
         // We extract the sort key {$sortKey: <value>}. The sort key pattern '_sort' is verified to
         // be {$sortKey: 1}.
         const bool _compareWholeSortKey;
+
+        // For n remotes, entry 0 is the overall winner, and entries 1 to n - 1 are the internal
+        // nodes of a complete binary tree, holding the loser of their match. The children of node
+        // i are nodes 2i and 2i + 1, where node n + r stands for the leaf of remote r.
+        std::vector<size_t> _tree;
+
+        bool _valid = false;
     };
 
     using MinSortKeyRemoteIdPair = std::pair<BSONObj, size_t>;
@@ -390,6 +446,18 @@ private:
     ClusterQueryResult _nextReadySorted(WithLock);
     ClusterQueryResult _nextReadyUnsorted(WithLock);
 
+    /**
+     * Removes the first buffered result of the given remote and returns it, asking the remote for
+     * its next batch ahead of time if the buffer got low enough.
+     */
+    ClusterQueryResult _takeNextResult(WithLock, size_t remoteIndex);
+
+    /**
+     * Asks the given remote for its next batch if it still has results to give, its buffer holds
+     * less than half of its last batch and the next batch fits within the prefetch memory limit.
+     */
+    void _prefetchIfBelowWatermark(WithLock, size_t remoteIndex);
+
     using CbData = executor::TaskExecutor::RemoteCommandCallbackArgs;
     using CbResponse = executor::TaskExecutor::ResponseStatus;
 
@@ -469,9 +537,12 @@ private:
     // Data tracking the state of our communication with each of the remote nodes.
     std::vector<RemoteCursorData> _remotes;
 
-    // The top of this priority queue is the index into '_remotes' for the remote host that has the
-    // next document to return, according to the sort order. Used only if there is a sort.
-    std::priority_queue<size_t, std::vector<size_t>, MergingComparator> _mergeQueue;
+    // Picks the index into '_remotes' for the remote host that has the next document to return,
+    // according to the sort order. Used only if there is a sort.
+    MergeTree _mergeTree;
+
+    // The total size of the results buffered across all the remotes.
+    size_t _bufferedBytes = 0;
 
     // The index into '_remotes' for the remote from which we are currently retrieving results.
     // Used only if there is *not* a sort.
@@ -1905,5 +1905,110 @@ TEST_F(AsyncResultsMergerTest, ShouldNotScheduleGetMoresWithoutAnOperationContex
     executor()->waitForEvent(killedEvent);
 }
 
+TEST_F(AsyncResultsMergerTest, AsksForNextBatchOnceLessThanHalfOfLastBatchIsLeft) {
+    setMaxPrefetchedBytes(1024 * 1024);
+
+    std::vector<BSONObj> firstBatch = {
+        fromjson("{_id: 1}"), fromjson("{_id: 2}"), fromjson("{_id: 3}"), fromjson("{_id: 4}")};
+    std::vector<RemoteCursor> cursors;
+    cursors.push_back(makeRemoteCursor(
+        kTestShardIds[0], kTestShardHosts[0], CursorResponse(kTestNss, 5, firstBatch)));
+    auto arm = makeARMFromExistingCursors(std::move(cursors));
+
+    // Half of the batch is still buffered, so there's no need for the next one yet.
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 1}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 2}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_FALSE(networkHasReadyRequests());
+
+    // Dropping below half of the batch sends the getMore while results are still buffered.
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 3}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_TRUE(networkHasReadyRequests());
+    ASSERT_TRUE(arm->ready());
+
+    std::vector<CursorResponse> responses;
+    std::vector<BSONObj> secondBatch = {fromjson("{_id: 5}"), fromjson("{_id: 6}")};
+    responses.emplace_back(kTestNss, CursorId(0), secondBatch);
+    scheduleNetworkResponses(std::move(responses));
+
+    // The remaining results come back in order without waiting on the network.
+    for (int id = 4; id <= 6; ++id) {
+        ASSERT_TRUE(arm->ready());
+        ASSERT_BSONOBJ_EQ(BSON("_id" << id), *unittest::assertGet(arm->nextReady()).getResult());
+    }
+    ASSERT_TRUE(arm->ready());
+    ASSERT_TRUE(arm->remotesExhausted());
+    ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
+}
+
+TEST_F(AsyncResultsMergerTest, DoesNotAskForNextBatchEarlyBeyondPrefetchMemoryLimit) {
+    setMaxPrefetchedBytes(1);
+
+    std::vector<BSONObj> firstBatch = {fromjson("{_id: 1}"), fromjson("{_id: 2}")};
+    std::vector<RemoteCursor> cursors;
+    cursors.push_back(makeRemoteCursor(
+        kTestShardIds[0], kTestShardHosts[0], CursorResponse(kTestNss, 5, firstBatch)));
+    auto arm = makeARMFromExistingCursors(std::move(cursors));
+
+    ASSERT_TRUE(arm->ready());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 1}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_FALSE(networkHasReadyRequests());
+    ASSERT_BSONOBJ_EQ(fromjson("{_id: 2}"), *unittest::assertGet(arm->nextReady()).getResult());
+    ASSERT_FALSE(networkHasReadyRequests());
+    ASSERT_FALSE(arm->ready());
+
+    auto killedEvent = arm->kill(operationContext());
+    executor()->waitForEvent(killedEvent);
+}
+
+TEST_F(AsyncResultsMergerTest, SortedMergeKeepsOrderWhilePrefetching) {
+    setMaxPrefetchedBytes(1024 * 1024);
+
+    BSONObj findCmd = fromjson("{find: 'testcoll', sort: {_id: 1}}");
+    std::vector<RemoteCursor> cursors;
+    for (size_t i = 0; i < kTestShardIds.size(); ++i) {
+        // Shard i holds the sort keys i, i + 3, i + 6 and i + 9, and starts with three of them.
+        std::vector<BSONObj> firstBatch = {BSON("$sortKey" << BSON("" << int(i))),
+                                           BSON("$sortKey" << BSON("" << int(i + 3))),
+                                           BSON("$sortKey" << BSON("" << int(i + 6)))};
+        cursors.push_back(makeRemoteCursor(kTestShardIds[i],
+                                           kTestShardHosts[i],
+                                           CursorResponse(kTestNss, 10 + i, firstBatch)));
+    }
+    auto arm = makeARMFromExistingCursors(std::move(cursors), findCmd);
+
+    int nextSortKey = 0;
+    auto assertNextSortKey = [&]() {
+        ASSERT_TRUE(arm->ready());
+        ASSERT_BSONOBJ_EQ(BSON("$sortKey" << BSON("" << nextSortKey++)),
+                          *unittest::assertGet(arm->nextReady()).getResult());
+    };
+
+    // Taking the first two results of each shard leaves less than half of its batch, so each one
+    // is asked for its final batch while the merge goes on.
+    for (size_t i = 0; i < kTestShardIds.size(); ++i) {
+        assertNextSortKey();
+        ASSERT_FALSE(networkHasReadyRequests());
+    }
+    for (size_t i = 0; i < kTestShardIds.size(); ++i) {
+        assertNextSortKey();
+    }
+    ASSERT_TRUE(networkHasReadyRequests());
+
+    std::vector<CursorResponse> responses;
+    for (size_t i = 0; i < kTestShardIds.size(); ++i) {
+        std::vector<BSONObj> lastBatch = {BSON("$sortKey" << BSON("" << int(i + 9)))};
+        responses.emplace_back(kTestNss, CursorId(0), lastBatch);
+    }
+    scheduleNetworkResponses(std::move(responses));
+
+    while (nextSortKey < 12) {
+        assertNextSortKey();
+    }
+    ASSERT_TRUE(arm->ready());
+    ASSERT_TRUE(arm->remotesExhausted());
+    ASSERT_TRUE(unittest::assertGet(arm->nextReady()).isEOF());
+}
+
 }  // namespace
 }  // namespace mongo
@@ -31,11 +31,13 @@
 
 #include "mongo/s/query/cluster_aggregation_planner.h"
 
+#include "mongo/db/pipeline/document_source_exchange.h"
 #include "mongo/db/pipeline/document_source_group.h"
 #include "mongo/db/pipeline/document_source_limit.h"
 #include "mongo/db/pipeline/document_source_match.h"
 #include "mongo/db/pipeline/document_source_merge.h"
 #include "mongo/db/pipeline/document_source_out.h"
+#include "mongo/db/pipeline/document_source_parallel_merge.h"
 #include "mongo/db/pipeline/document_source_project.h"
 #include "mongo/db/pipeline/document_source_sequential_document_cache.h"
 #include "mongo/db/pipeline/document_source_skip.h"
@@ -447,6 +449,31 @@ void abandonCacheIfSentToShards(Pipeline* shardsPipeline) {
     }
 }
 
+/**
+ * Returns a key pattern for the exchange which sends every document going into 'group' to the same
+ * consumer as the other documents of its group, or boost::none if there is no such pattern. The
+ * exchange hashes the values of the fields in the pattern, so every group key must be a top-level
+ * field of the input document: with a dotted path, or an expression, documents whose keys compare
+ * equal might hash differently.
+ */
+boost::optional<BSONObj> exchangeKeyForGroup(const DocumentSourceGroup& group) {
+    std::set<std::string> fields;
+    for (auto&& idField : group.getIdFields()) {
+        auto fieldPath = dynamic_cast<ExpressionFieldPath*>(idField.second.get());
+        if (!fieldPath || !fieldPath->isRootFieldPath() ||
+            fieldPath->getFieldPath().getPathLength() != 2) {
+            return boost::none;
+        }
+        fields.insert(fieldPath->getFieldPath().getFieldName(1).toString());
+    }
+
+    BSONObjBuilder keyPattern;
+    for (auto&& field : fields) {
+        keyPattern.append(field, 1);
+    }
+    return keyPattern.obj();
+}
+
 }  // namespace
 
 SplitPipeline splitPipeline(std::unique_ptr<Pipeline, PipelineDeleter> pipeline) {
@@ -542,6 +569,73 @@ ClusterClientCursorGuard buildClusterCursor(OperationContext* opCtx,
         opCtx, std::make_unique<RouterStagePipeline>(std::move(pipeline)), std::move(cursorParams));
 }
 
+bool parallelizeMergingGroupOnMongos(Pipeline* mergePipeline) {
+    const auto nConsumers = internalQueryMongosMergeConsumers.load();
+    const auto& expCtx = mergePipeline->getContext();
+    if (nConsumers < 2 || expCtx->explain || expCtx->tailableMode != TailableModeEnum::kNormal) {
+        return false;
+    }
+
+    // This covers both a $group which merges partial groups from the shards, and one which runs on
+    // mongos as a whole because it follows a $sort. In either case each consumer sees the documents
+    // of its groups in the order in which they arrived, so order sensitive accumulators such as
+    // $first behave exactly as they would on a single thread.
+    const auto& sources = mergePipeline->getSources();
+    if (sources.size() < 2 || !dynamic_cast<DocumentSourceMergeCursors*>(sources.front().get())) {
+        return false;
+    }
+    auto group = dynamic_cast<DocumentSourceGroup*>(std::next(sources.begin())->get());
+    if (!group) {
+        return false;
+    }
+    auto keyPattern = exchangeKeyForGroup(*group);
+    if (!keyPattern) {
+        return false;
+    }
+
+    auto mergeCursors = mergePipeline->popFront();
+    auto groupStage = mergePipeline->popFront();  // Keeps 'group' alive.
+
+    auto copyExpCtx = [&] {
+        return expCtx->copyWith(
+            expCtx->ns,
+            expCtx->uuid,
+            expCtx->getCollator() ? expCtx->getCollator()->clone() : nullptr);
+    };
+
+    ExchangeSpec spec;
+    spec.setPolicy(ExchangePolicyEnum::kHash);
+    spec.setConsumers(nConsumers);
+    spec.setKey(*keyPattern);
+
+    // The input pipeline gets an ExpressionContext of its own, because the exchange detaches it
+    // from the OperationContext in between batches while the merge pipeline carries on.
+    boost::intrusive_ptr<Exchange> exchange =
+        new Exchange(std::move(spec),
+                     uassertStatusOK(Pipeline::create({mergeCursors}, copyExpCtx())),
+                     Exchange::LoadingPolicy::kProducer);
+
+    // Between them the consumers may use as much memory as the single $group would have. They
+    // share that budget rather than split it evenly, since mongos can't spill and the group keys
+    // may well be skewed towards some of the consumers.
+    auto sharedMemoryUsageBytes = std::make_shared<AtomicWord<long long>>(0);
+
+    std::vector<std::unique_ptr<Pipeline, PipelineDeleter>> consumers;
+    for (int consumerId = 0; consumerId < nConsumers; ++consumerId) {
+        auto consumerExpCtx = copyExpCtx();
+        boost::intrusive_ptr<DocumentSource> consumer =
+            new DocumentSourceExchange(consumerExpCtx, exchange, consumerId, nullptr);
+        consumers.emplace_back(uassertStatusOK(Pipeline::create(
+            {consumer,
+             group->clone(consumerExpCtx, group->getMaxMemoryUsageBytes(), sharedMemoryUsageBytes)},
+            consumerExpCtx)));
+    }
+
+    mergePipeline->addInitialSource(
+        DocumentSourceParallelMerge::create(expCtx, std::move(exchange), std::move(consumers)));
+    return true;
+}
+
 boost::optional<ShardedExchangePolicy> checkIfEligibleForExchange(OperationContext* opCtx,
                                                                   const Pipeline* mergePipeline) {
     if (internalQueryDisableExchange.load()) {
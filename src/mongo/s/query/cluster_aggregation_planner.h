@@ -98,6 +98,14 @@ ClusterClientCursorGuard buildClusterCursor(OperationContext* opCtx,
                                             std::unique_ptr<Pipeline, PipelineDeleter> pipeline,
                                             ClusterClientCursorParams&&);
 
+/**
+ * If 'mergePipeline', which must already begin with a $mergeCursors stage and run on mongos, goes
+ * on to a $group, replaces the two with a stage which hash-partitions the results from the shards
+ * by group key and runs the $group in several consumers side by side, as many as
+ * internalQueryMongosMergeConsumers asks for. Returns true if the pipeline was changed.
+ */
+bool parallelizeMergingGroupOnMongos(Pipeline* mergePipeline);
+
 struct ShardedExchangePolicy {
     // The exchange specification that will be sent to shards as part of the aggregate command.
     // It will be used by producers to determine how to distribute documents to consumers.
@@ -36,6 +36,7 @@
 #include "mongo/db/pipeline/document_source_match.h"
 #include "mongo/db/pipeline/document_source_merge.h"
 #include "mongo/db/pipeline/document_source_out.h"
+#include "mongo/db/pipeline/document_source_parallel_merge.h"
 #include "mongo/db/pipeline/document_source_project.h"
 #include "mongo/db/pipeline/document_source_sort.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
@@ -43,6 +44,9 @@
 #include "mongo/s/catalog/type_shard.h"
 #include "mongo/s/catalog_cache_test_fixture.h"
 #include "mongo/s/query/cluster_aggregation_planner.h"
+#include "mongo/s/query/cluster_query_knobs_gen.h"
+#include "mongo/s/query/document_source_merge_cursors.h"
+#include "mongo/s/query/router_stage_pipeline.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/scopeguard.h"
 
@@ -691,5 +695,117 @@ TEST_F(ClusterExchangeTest, CompoundShardKeyThreeShards) {
 
     future.default_timed_get();
 }
+
+class ClusterParallelMergeTest : public ClusterExchangeTest {
+public:
+    void setUp() {
+        ClusterExchangeTest::setUp();
+        _originalConsumers = internalQueryMongosMergeConsumers.load();
+        internalQueryMongosMergeConsumers.store(4);
+    }
+
+    void tearDown() {
+        internalQueryMongosMergeConsumers.store(_originalConsumers);
+        ClusterExchangeTest::tearDown();
+    }
+
+    /**
+     * Returns a merge pipeline which reads exhausted cursors from two shards through $mergeCursors
+     * and then runs 'stages'.
+     */
+    std::unique_ptr<Pipeline, PipelineDeleter> makeMergePipeline(
+        const std::vector<std::string>& stages) {
+        AsyncResultsMergerParams armParams;
+        armParams.setNss(kTestAggregateNss);
+        std::vector<RemoteCursor> cursors;
+        for (int i = 0; i < 2; ++i) {
+            RemoteCursor cursor;
+            cursor.setShardId(ShardId(str::stream() << i));
+            cursor.setHostAndPort(HostAndPort(str::stream() << "Host" << i << ":12345"));
+            cursor.setCursorResponse(CursorResponse(kTestAggregateNss, CursorId(0), {}));
+            cursors.push_back(std::move(cursor));
+        }
+        armParams.setRemotes(std::move(cursors));
+
+        Pipeline::SourceContainer sources{
+            DocumentSourceMergeCursors::create(executor(), std::move(armParams), expCtx())};
+        for (auto&& stage : stages) {
+            sources.push_back(parse(stage));
+        }
+        return unittest::assertGet(Pipeline::create(std::move(sources), expCtx()));
+    }
+
+private:
+    int _originalConsumers;
+};
+
+TEST_F(ClusterParallelMergeTest, MergingGroupOnTopLevelFieldIsParallelized) {
+    setupNShards(2);
+    auto mergePipe = makeMergePipeline(
+        {"{$group: {_id: '$a', total: {$sum: '$b'}}}", "{$sort: {total: 1}}"});
+    ASSERT_TRUE(cluster_aggregation_planner::parallelizeMergingGroupOnMongos(mergePipe.get()));
+
+    const auto& sources = mergePipe->getSources();
+    ASSERT_EQ(sources.size(), 2UL);
+    auto parallelMerge = dynamic_cast<DocumentSourceParallelMerge*>(sources.front().get());
+    ASSERT(parallelMerge);
+    ASSERT_EQ(parallelMerge->getConsumers(), 4UL);
+    ASSERT(dynamic_cast<DocumentSourceMergeCursors*>(parallelMerge->getInputSource()));
+    ASSERT(dynamic_cast<DocumentSourceSort*>(sources.back().get()));
+
+    // The router stage still knows how many shards it reads from.
+    RouterStagePipeline routerStage(std::move(mergePipe));
+    ASSERT_EQ(routerStage.getNumRemotes(), 2UL);
+}
+
+TEST_F(ClusterParallelMergeTest, CompoundGroupKeyIsParallelized) {
+    setupNShards(2);
+    auto mergePipe = makeMergePipeline({"{$group: {_id: {a: '$a', b: '$b'}, n: {$sum: 1}}}"});
+    ASSERT_TRUE(cluster_aggregation_planner::parallelizeMergingGroupOnMongos(mergePipe.get()));
+    ASSERT(dynamic_cast<DocumentSourceParallelMerge*>(mergePipe->getSources().front().get()));
+}
+
+TEST_F(ClusterParallelMergeTest, NotParallelizedWithFewerThanTwoConsumers) {
+    setupNShards(2);
+    internalQueryMongosMergeConsumers.store(1);
+    auto mergePipe = makeMergePipeline({"{$group: {_id: '$a', total: {$sum: '$b'}}}"});
+    ASSERT_FALSE(cluster_aggregation_planner::parallelizeMergingGroupOnMongos(mergePipe.get()));
+    ASSERT_EQ(mergePipe->getSources().size(), 2UL);
+
+    RouterStagePipeline routerStage(std::move(mergePipe));
+    ASSERT_EQ(routerStage.getNumRemotes(), 2UL);
+}
+
+TEST_F(ClusterParallelMergeTest, NotParallelizedUnlessGroupFollowsMergeCursors) {
+    setupNShards(2);
+    auto mergePipe = makeMergePipeline(
+        {"{$match: {a: 1}}", "{$group: {_id: '$a', total: {$sum: '$b'}}}"});
+    ASSERT_FALSE(cluster_aggregation_planner::parallelizeMergingGroupOnMongos(mergePipe.get()));
+    ASSERT(dynamic_cast<DocumentSourceMergeCursors*>(mergePipe->getSources().front().get()));
+
+    mergePipe = unittest::assertGet(
+        Pipeline::create({parse("{$group: {_id: '$a', total: {$sum: '$b'}}}")}, expCtx()));
+    ASSERT_FALSE(cluster_aggregation_planner::parallelizeMergingGroupOnMongos(mergePipe.get()));
+}
+
+TEST_F(ClusterParallelMergeTest, NotParallelizedForDottedOrComputedGroupKeys) {
+    setupNShards(2);
+    auto mergePipe = makeMergePipeline({"{$group: {_id: '$a.b', total: {$sum: '$c'}}}"});
+    ASSERT_FALSE(cluster_aggregation_planner::parallelizeMergingGroupOnMongos(mergePipe.get()));
+    ASSERT_EQ(mergePipe->getSources().size(), 2UL);
+
+    mergePipe = makeMergePipeline({"{$group: {_id: {$add: ['$a', 1]}, total: {$sum: '$c'}}}"});
+    ASSERT_FALSE(cluster_aggregation_planner::parallelizeMergingGroupOnMongos(mergePipe.get()));
+    ASSERT_EQ(mergePipe->getSources().size(), 2UL);
+}
+
+TEST_F(ClusterParallelMergeTest, NotParallelizedForExplain) {
+    setupNShards(2);
+    expCtx()->explain = ExplainOptions::Verbosity::kQueryPlanner;
+    auto mergePipe = makeMergePipeline({"{$group: {_id: '$a', total: {$sum: '$b'}}}"});
+    ASSERT_FALSE(cluster_aggregation_planner::parallelizeMergingGroupOnMongos(mergePipe.get()));
+    ASSERT_EQ(mergePipe->getSources().size(), 2UL);
+}
+
 }  // namespace
 }  // namespace mongo
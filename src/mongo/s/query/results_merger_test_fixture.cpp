@@ -34,6 +34,7 @@
 #include "mongo/executor/network_interface_mock.h"
 #include "mongo/executor/thread_pool_task_executor_test_fixture.h"
 #include "mongo/s/catalog/type_shard.h"
+#include "mongo/s/query/async_results_merger_knobs_gen.h"
 #include "mongo/s/query/results_merger_test_fixture.h"
 
 namespace mongo {
@@ -49,6 +50,9 @@ const std::vector<HostAndPort> ResultsMergerTestFixture::kTestShardHosts = {
 const NamespaceString ResultsMergerTestFixture::kTestNss = NamespaceString{"testdb.testcoll"};
 
 void ResultsMergerTestFixture::setUp() {
+    _originalMaxPrefetchedBytes = internalQueryARMMaxPrefetchedBytes.load();
+    setMaxPrefetchedBytes(0);
+
     setRemote(HostAndPort("ClientHost", 12345));
 
     configTargeter()->setFindHostReturnValue(kTestConfigShardHost);
@@ -74,4 +78,13 @@ void ResultsMergerTestFixture::setUp() {
     setupShards(shards);
 }
 
+void ResultsMergerTestFixture::tearDown() {
+    setMaxPrefetchedBytes(_originalMaxPrefetchedBytes);
+    ShardingTestFixture::tearDown();
+}
+
+void ResultsMergerTestFixture::setMaxPrefetchedBytes(long long maxPrefetchedBytes) {
+    internalQueryARMMaxPrefetchedBytes.store(maxPrefetchedBytes);
+}
+
 }  // namespace mongo
@@ -49,8 +49,15 @@ public:
     ResultsMergerTestFixture() {}
 
     void setUp() override;
+    void tearDown() override;
 
 protected:
+    /**
+     * Sets the memory limit for results fetched ahead of time. Prefetching is disabled by default
+     * in these tests, so that each getMore they see was requested because a buffer ran empty.
+     */
+    void setMaxPrefetchedBytes(long long maxPrefetchedBytes);
+
     /**
      * Constructs an AsyncResultsMergerParams object with the given vector of existing cursors.
      *
@@ -247,6 +254,9 @@ protected:
         invariant(mockClock);
         return mockClock;
     }
+
+private:
+    long long _originalMaxPrefetchedBytes = 0;
 };
 
 }  // namespace mongo
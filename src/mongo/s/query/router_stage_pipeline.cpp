@@ -34,6 +34,7 @@
 #include "mongo/db/pipeline/document_source.h"
 #include "mongo/db/pipeline/document_source_change_stream.h"
 #include "mongo/db/pipeline/document_source_list_local_sessions.h"
+#include "mongo/db/pipeline/document_source_parallel_merge.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/s/query/document_source_merge_cursors.h"
 
@@ -43,8 +44,12 @@ RouterStagePipeline::RouterStagePipeline(std::unique_ptr<Pipeline, PipelineDelet
     : RouterExecStage(mergePipeline->getContext()->opCtx),
       _mergePipeline(std::move(mergePipeline)) {
     invariant(!_mergePipeline->getSources().empty());
-    _mergeCursorsStage =
-        dynamic_cast<DocumentSourceMergeCursors*>(_mergePipeline->getSources().front().get());
+    auto firstStage = _mergePipeline->getSources().front().get();
+    // A $group run in parallel on mongos reads the results from the shards through an exchange.
+    if (auto parallelMerge = dynamic_cast<DocumentSourceParallelMerge*>(firstStage)) {
+        firstStage = parallelMerge->getInputSource();
+    }
+    _mergeCursorsStage = dynamic_cast<DocumentSourceMergeCursors*>(firstStage);
 }
 
 StatusWith<ClusterQueryResult> RouterStagePipeline::next(RouterExecStage::ExecContext execContext) {
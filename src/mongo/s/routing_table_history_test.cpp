@@ -93,8 +93,8 @@ std::set<ChunkInfo*> getChunksInRange(std::shared_ptr<RoutingTableHistory> rt,
     std::transform(chunksFromSplitIter.first,
                    chunksFromSplitIter.second,
                    std::inserter(chunksFromSplit, chunksFromSplit.begin()),
-                   [](const std::pair<std::string, std::shared_ptr<ChunkInfo>>& pair) {
-                       return pair.second.get();
+                   [](const std::shared_ptr<ChunkInfo>& chunkInfo) {
+                       return chunkInfo.get();
                    });
     return chunksFromSplit;
 }
@@ -108,7 +108,7 @@ std::shared_ptr<ChunkInfo> getChunkToSplit(std::shared_ptr<RoutingTableHistory>
     invariant(std::distance(chunkToSplitIter.first, chunkToSplitIter.second) <= 1);
     invariant(chunkToSplitIter.first != rt->getChunkMap().end());
 
-    return (*chunkToSplitIter.first).second;
+    return *chunkToSplitIter.first;
 }
 
 /**
@@ -136,8 +136,7 @@ void assertCorrectBytesWritten(std::shared_ptr<RoutingTableHistory> rt,
     auto chunksFromSplit = getChunksInRange(rt, minSplitBoundary, maxSplitBoundary);
     ASSERT_EQ(chunksFromSplit.size(), expectedNumChunksFromSplit);
 
-    for (auto kv : rt->getChunkMap()) {
-        auto chunkInfo = kv.second;
+    for (const auto& chunkInfo : rt->getChunkMap()) {
         auto writesTracker = chunkInfo->getWritesTracker();
         auto bytesWritten = writesTracker->getBytesWritten();
         if (chunksFromSplit.count(chunkInfo.get()) > 0) {
@@ -170,8 +169,7 @@ public:
 
         ASSERT_EQ(_rt->getChunkMap().size(), 1ull);
         // Should only be one
-        for (auto kv : _rt->getChunkMap()) {
-            auto chunkInfo = kv.second;
+        for (const auto& chunkInfo : _rt->getChunkMap()) {
             auto writesTracker = chunkInfo->getWritesTracker();
             writesTracker->addBytesWritten(_bytesInOriginalChunk);
         }
@@ -234,8 +232,7 @@ TEST_F(RoutingTableHistoryTest, SplittingOnlyChunkCopiesBytesWrittenToAllSubchun
     auto rt = splitChunk(getInitialRoutingTable(), newChunkBoundaryPoints);
 
     ASSERT_EQ(rt->getChunkMap().size(), 3ull);
-    for (auto kv : rt->getChunkMap()) {
-        auto chunkInfo = kv.second;
+    for (const auto& chunkInfo : rt->getChunkMap()) {
         auto writesTracker = chunkInfo->getWritesTracker();
         auto bytesWritten = writesTracker->getBytesWritten();
         ASSERT_EQ(bytesWritten, getBytesInOriginalChunk());
@@ -318,5 +315,78 @@ TEST_F(RoutingTableHistoryTestThreeInitialChunks,
                               expectedBytesInChunksNotSplit);
 }
 
+TEST_F(RoutingTableHistoryTest, SplittingIntoManyChunksLeavesOriginalTableUnchanged) {
+    std::vector<BSONObj> newChunkBoundaryPoints = {getShardKeyPattern().globalMin()};
+    for (int i = 0; i < 2000; ++i) {
+        newChunkBoundaryPoints.push_back(BSON("a" << i));
+    }
+    newChunkBoundaryPoints.push_back(getShardKeyPattern().globalMax());
+
+    auto rt = splitChunk(getInitialRoutingTable(), newChunkBoundaryPoints);
+    ASSERT_EQ(rt->getChunkMap().size(), 2001ull);
+    ASSERT_EQ(getInitialRoutingTable()->getChunkMap().size(), 1ull);
+
+    // Chunks come back in order and each can be found from its own min.
+    auto chunkMax = getShardKeyPattern().globalMin();
+    for (const auto& chunkInfo : rt->getChunkMap()) {
+        ASSERT_BSONOBJ_EQ(chunkInfo->getMin(), chunkMax);
+        chunkMax = chunkInfo->getMax();
+
+        auto overlapping = rt->overlappingRanges(chunkInfo->getMin(), chunkInfo->getMin(), true);
+        ASSERT_EQ(std::distance(overlapping.first, overlapping.second), 1);
+        ASSERT_EQ(overlapping.first->get(), chunkInfo.get());
+    }
+    ASSERT_BSONOBJ_EQ(chunkMax, getShardKeyPattern().globalMax());
+
+    // Merge a range spanning several blocks back into a single chunk.
+    const auto mergeMin = BSON("a" << 100);
+    const auto mergeMax = BSON("a" << 1900);
+    ChunkVersion mergeVersion = rt->getVersion();
+    mergeVersion.incMajor();
+    auto merged = rt->makeUpdated(
+        {ChunkType{kNss, ChunkRange{mergeMin, mergeMax}, mergeVersion, kThisShard}});
+    ASSERT_EQ(merged->getChunkMap().size(), 2001ull - 1800ull + 1ull);
+    ASSERT_EQ(rt->getChunkMap().size(), 2001ull);
+
+    auto overlapping = merged->overlappingRanges(BSON("a" << 1000), BSON("a" << 1000), true);
+    ASSERT_EQ(std::distance(overlapping.first, overlapping.second), 1);
+    ASSERT_BSONOBJ_EQ((*overlapping.first)->getMin(), mergeMin);
+    ASSERT_BSONOBJ_EQ((*overlapping.first)->getMax(), mergeMax);
+}
+
+TEST_F(RoutingTableHistoryTestThreeInitialChunks, MovingChunksUpdatesShardVersions) {
+    const ShardId otherShard("otherShard");
+    const auto boundaries = getInitialChunkBoundaryPoints();
+    auto rt = getInitialRoutingTable();
+    const auto middleChunkVersion = getChunkToSplit(rt, boundaries[1], boundaries[2])->getLastmod();
+    ASSERT_EQ(rt->getVersion(kThisShard), rt->getVersion());
+
+    // Moving away the chunk with the max version leaves the shard with the max of the others
+    ChunkVersion version = rt->getVersion();
+    version.incMajor();
+    auto moved = rt->makeUpdated(
+        {ChunkType{kNss, ChunkRange{boundaries[2], boundaries[3]}, version, otherShard}});
+    ASSERT_EQ(moved->getVersion(otherShard), version);
+    ASSERT_EQ(moved->getVersion(kThisShard), middleChunkVersion);
+    ASSERT_EQ(rt->getVersion(otherShard), ChunkVersion(0, 0, version.epoch()));
+
+    // Moving back the only chunk of a shard leaves it without a version
+    version.incMajor();
+    auto movedBack = moved->makeUpdated(
+        {ChunkType{kNss, ChunkRange{boundaries[2], boundaries[3]}, version, kThisShard}});
+    ASSERT_EQ(movedBack->getVersion(otherShard), ChunkVersion(0, 0, version.epoch()));
+    ASSERT_EQ(movedBack->getVersion(kThisShard), version);
+}
+
+TEST_F(RoutingTableHistoryTestThreeInitialChunks, UpdateLeavingOverlapFails) {
+    const auto boundaries = getInitialChunkBoundaryPoints();
+    ChunkVersion version = getInitialRoutingTable()->getVersion();
+    version.incMajor();
+    ASSERT_THROWS_CODE(getInitialRoutingTable()->makeUpdated({ChunkType{
+                           kNss, ChunkRange{boundaries[1], BSON("a" << 15)}, version, kThisShard}}),
+                       DBException,
+                       ErrorCodes::ConflictingOperationInProgress);
+}
+
 }  // namespace
 }  // namespace mongo
@@ -67,6 +67,11 @@ struct WriteErrorDetailComp {
 const int kEstUpdateOverheadBytes = (BSONObjMaxInternalSize - BSONObjMaxUserSize) / 100;
 const int kEstDeleteOverheadBytes = (BSONObjMaxInternalSize - BSONObjMaxUserSize) / 100;
 
+// Inserts are targeted in bulk, a window of the remaining documents at a time. The first window
+// has this many documents and each next one is twice as large, so an ordered batch which has to
+// stop early at a change of shard doesn't pay for targeting documents it won't send this round.
+const size_t kMinInsertTargetingWindow = 64;
+
 /**
  * Returns a new write concern that has the copy of every field from the original
  * document but with a w set to 1. This is intended for upgrading { w: 0 } write
@@ -304,6 +309,17 @@ Status BatchWriteOp::targetBatch(const NSTargeter& targeter,
 
     const size_t numWriteOps = _clientRequest.sizeWriteOps();
 
+    // Bulk targeting state for inserts. The targets of the current window are indexed by write op
+    // from 'insertTargetsBegin' on, and point into 'insertEndpoints'. The batch for each of these
+    // endpoints is remembered once found, so adding a write to it needs no map lookup.
+    const bool targetInsertsInBulk =
+        _clientRequest.getBatchType() == BatchedCommandRequest::BatchType_Insert;
+    std::vector<ShardEndpoint> insertEndpoints;
+    std::vector<TargetedWriteBatch*> insertEndpointBatches;
+    std::vector<boost::optional<size_t>> insertTargets;
+    size_t insertTargetsBegin = 0;
+    size_t insertTargetingWindow = kMinInsertTargetingWindow;
+
     for (size_t i = 0; i < numWriteOps; ++i) {
         WriteOp& writeOp = _writeOps[i];
 
@@ -311,6 +327,71 @@ Status BatchWriteOp::targetBatch(const NSTargeter& targeter,
         if (writeOp.getWriteState() != WriteOpState_Ready)
             continue;
 
+        // Account the array overhead once for the actual updates array and once for the statement
+        // ids array, if retryable writes are used
+        const int writeSizeBytes = getWriteSizeBytes(writeOp) +
+            write_ops::kWriteCommandBSONArrayPerElementOverheadBytes +
+            (_batchTxnNum ? write_ops::kWriteCommandBSONArrayPerElementOverheadBytes + 4 : 0);
+
+        if (targetInsertsInBulk) {
+            if (i >= insertTargetsBegin + insertTargets.size()) {
+                std::vector<BSONObj> docs;
+                size_t windowEnd = i;
+                for (; windowEnd < numWriteOps && docs.size() < insertTargetingWindow;
+                     ++windowEnd) {
+                    if (_writeOps[windowEnd].getWriteState() == WriteOpState_Ready)
+                        docs.push_back(_writeOps[windowEnd].getWriteItem().getDocument());
+                }
+
+                auto docTargets = targeter.targetInserts(_opCtx, docs, &insertEndpoints);
+                insertEndpointBatches.resize(insertEndpoints.size(), nullptr);
+
+                insertTargets.assign(windowEnd - i, boost::none);
+                insertTargetsBegin = i;
+                for (size_t j = i, docIndex = 0; j < windowEnd; ++j) {
+                    if (_writeOps[j].getWriteState() == WriteOpState_Ready)
+                        insertTargets[j - i] = docTargets[docIndex++];
+                }
+
+                insertTargetingWindow =
+                    std::min(2 * insertTargetingWindow, size_t(write_ops::kMaxWriteBatchSize));
+            }
+
+            // Documents which couldn't be targeted in bulk go through the regular path below, which
+            // reports the error
+            if (const auto& target = insertTargets[i - insertTargetsBegin]) {
+                const ShardEndpoint& endpoint = insertEndpoints[*target];
+                TargetedWriteBatch*& batch = insertEndpointBatches[*target];
+                if (!batch) {
+                    const auto batchIt = batchMap.find(&endpoint);
+                    if (batchIt != batchMap.end())
+                        batch = batchIt->second;
+                }
+
+                // The same rules for starting a new batch as for the regular path below, applied
+                // to the single endpoint of an insert
+                if (ordered && !batchMap.empty() && !batch)
+                    break;
+
+                if (batch &&
+                    (batch->getNumOps() >= write_ops::kMaxWriteBatchSize ||
+                     batch->getEstimatedSizeBytes() + writeSizeBytes > BSONObjMaxUserSize))
+                    break;
+
+                if (!ordered && !batch && targetedShards.count(endpoint.shardName))
+                    break;
+
+                if (!batch) {
+                    batch = new TargetedWriteBatch(endpoint);
+                    batchMap.emplace(&batch->getEndpoint(), batch);
+                    targetedShards.insert(endpoint.shardName);
+                }
+
+                writeOp.noteTargetedWrite(batch->addWrite(WriteOpRef(i, 0), writeSizeBytes));
+                continue;
+            }
+        }
+
         //
         // Get TargetedWrites from the targeter for the write operation
         //
@@ -371,12 +452,6 @@ Status BatchWriteOp::targetBatch(const NSTargeter& targeter,
             }
         }
 
-        // Account the array overhead once for the actual updates array and once for the statement
-        // ids array, if retryable writes are used
-        const int writeSizeBytes = getWriteSizeBytes(writeOp) +
-            write_ops::kWriteCommandBSONArrayPerElementOverheadBytes +
-            (_batchTxnNum ? write_ops::kWriteCommandBSONArrayPerElementOverheadBytes + 4 : 0);
-
         if (wouldMakeBatchesTooBig(writes, writeSizeBytes, batchMap)) {
             invariant(!batchMap.empty());
             writeOp.cancelWrites(nullptr);
@@ -263,7 +263,7 @@ public:
     }
 
     const std::vector<TargetedWrite*>& getWrites() const {
-        return _writes.vector();
+        return _writes;
     }
 
     size_t getNumOps() const {
@@ -278,17 +278,46 @@ public:
      * TargetedWrite is owned here once given to the TargetedWriteBatch.
      */
     void addWrite(TargetedWrite* targetedWrite, int estWriteSize) {
-        _writes.mutableVector().push_back(targetedWrite);
+        _adoptedWrites.emplace_back(targetedWrite);
+        _writes.push_back(targetedWrite);
         _estimatedSizeBytes += estWriteSize;
     }
 
+    /**
+     * Adds a write of the item at 'writeOpRef' to this batch's endpoint. The TargetedWrite is
+     * constructed in storage owned by the batch, which is allocated in growing blocks rather than
+     * once per write, and is returned.
+     */
+    TargetedWrite* addWrite(WriteOpRef writeOpRef, int estWriteSize) {
+        if (_writeBlocks.empty() ||
+            _writeBlocks.back().size() == _writeBlocks.back().capacity()) {
+            const size_t blockSize = _writeBlocks.empty()
+                ? kMinWriteBlockSize
+                : std::min(2 * _writeBlocks.back().capacity(), kMaxWriteBlockSize);
+            _writeBlocks.emplace_back();
+            _writeBlocks.back().reserve(blockSize);
+        }
+
+        // Blocks are never grown past the capacity reserved up front, so the writes don't move
+        _writeBlocks.back().emplace_back(_endpoint, writeOpRef);
+        _writes.push_back(&_writeBlocks.back().back());
+        _estimatedSizeBytes += estWriteSize;
+        return _writes.back();
+    }
+
 private:
+    static constexpr size_t kMinWriteBlockSize = 16;
+    static constexpr size_t kMaxWriteBlockSize = 4096;
+
     // Where to send the batch
     const ShardEndpoint _endpoint;
 
     // Where the responses go
-    // TargetedWrite*s are owned by the TargetedWriteBatch
-    OwnedPointerVector<TargetedWrite> _writes;
+    std::vector<TargetedWrite*> _writes;
+
+    // Owners of the TargetedWrites in '_writes', depending on which addWrite() added them
+    std::vector<std::unique_ptr<TargetedWrite>> _adoptedWrites;
+    std::vector<std::vector<TargetedWrite>> _writeBlocks;
 
     // Conservatvely estimated size of the batch, for ensuring it doesn't grow past the maximum BSON
     // size
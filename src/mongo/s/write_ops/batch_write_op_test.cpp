@@ -1229,6 +1229,160 @@ TEST_F(BatchWriteOpTest, MultiOpFailedTargetUnordered) {
     ASSERT_EQUALS(clientResponse.getErrDetailsAt(0)->getIndex(), 1);
 }
 
+// Many-doc unordered insert, targeted in bulk over several windows. Each shard should get one batch
+// with its writes in the order of the original batch.
+TEST_F(BatchWriteOpTest, ManyInsertsTwoShardsUnordered) {
+    NamespaceString nss("foo.bar");
+    ShardEndpoint endpointA(ShardId("shardA"), ChunkVersion::IGNORED());
+    ShardEndpoint endpointB(ShardId("shardB"), ChunkVersion::IGNORED());
+    MockNSTargeter targeter;
+    initTargeterSplitRange(nss, endpointA, endpointB, &targeter);
+
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < 1000; ++i) {
+        docs.push_back(BSON("x" << (i % 2 ? i : -1 - i)));
+    }
+
+    BatchedCommandRequest request([&] {
+        write_ops::Insert insertOp(nss);
+        insertOp.setWriteCommandBase([] {
+            write_ops::WriteCommandBase wcb;
+            wcb.setOrdered(false);
+            return wcb;
+        }());
+        insertOp.setDocuments(docs);
+        return insertOp;
+    }());
+
+    BatchWriteOp batchOp(operationContext(), request);
+
+    OwnedPointerMap<ShardId, TargetedWriteBatch> targetedOwned;
+    std::map<ShardId, TargetedWriteBatch*>& targeted = targetedOwned.mutableMap();
+    ASSERT_OK(batchOp.targetBatch(targeter, false, &targeted));
+    ASSERT_EQUALS(targeted.size(), 2u);
+    verifyTargetedBatches({{endpointA.shardName, 500u}, {endpointB.shardName, 500u}}, targeted);
+
+    for (const auto& entry : targeted) {
+        const auto& writes = entry.second->getWrites();
+        const int firstIndex = entry.first == endpointA.shardName ? 0 : 1;
+        for (size_t i = 0; i < writes.size(); ++i) {
+            ASSERT_EQUALS(writes[i]->writeOpRef.first, firstIndex + 2 * int(i));
+            ASSERT_EQUALS(writes[i]->endpoint.shardName, entry.first);
+        }
+    }
+
+    BatchedCommandResponse response;
+    buildResponse(500, &response);
+
+    for (auto it = targeted.begin(); it != targeted.end(); ++it) {
+        ASSERT(!batchOp.isFinished());
+        batchOp.noteBatchResponse(*it->second, response, nullptr);
+    }
+    ASSERT(batchOp.isFinished());
+
+    BatchedCommandResponse clientResponse;
+    batchOp.buildClientResponse(&clientResponse);
+    ASSERT(clientResponse.getOk());
+    ASSERT_EQUALS(clientResponse.getN(), 1000);
+}
+
+// Many-doc ordered insert which switches shards past the first bulk targeting window. The first
+// round should stop right at the switch.
+TEST_F(BatchWriteOpTest, ManyInsertsTwoShardsOrdered) {
+    NamespaceString nss("foo.bar");
+    ShardEndpoint endpointA(ShardId("shardA"), ChunkVersion::IGNORED());
+    ShardEndpoint endpointB(ShardId("shardB"), ChunkVersion::IGNORED());
+    MockNSTargeter targeter;
+    initTargeterSplitRange(nss, endpointA, endpointB, &targeter);
+
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < 300; ++i) {
+        docs.push_back(BSON("x" << (i < 200 ? i : -i)));
+    }
+
+    BatchedCommandRequest request([&] {
+        write_ops::Insert insertOp(nss);
+        insertOp.setDocuments(docs);
+        return insertOp;
+    }());
+
+    BatchWriteOp batchOp(operationContext(), request);
+
+    OwnedPointerMap<ShardId, TargetedWriteBatch> targetedOwned;
+    std::map<ShardId, TargetedWriteBatch*>& targeted = targetedOwned.mutableMap();
+    ASSERT_OK(batchOp.targetBatch(targeter, false, &targeted));
+    ASSERT_EQUALS(targeted.size(), 1u);
+    verifyTargetedBatches({{endpointB.shardName, 200u}}, targeted);
+
+    BatchedCommandResponse response;
+    buildResponse(200, &response);
+    batchOp.noteBatchResponse(*targeted.begin()->second, response, nullptr);
+    ASSERT(!batchOp.isFinished());
+
+    targetedOwned.clear();
+    ASSERT_OK(batchOp.targetBatch(targeter, false, &targeted));
+    ASSERT_EQUALS(targeted.size(), 1u);
+    verifyTargetedBatches({{endpointA.shardName, 100u}}, targeted);
+    ASSERT_EQUALS(targeted.begin()->second->getWrites().front()->writeOpRef.first, 200);
+
+    buildResponse(100, &response);
+    batchOp.noteBatchResponse(*targeted.begin()->second, response, nullptr);
+    ASSERT(batchOp.isFinished());
+
+    BatchedCommandResponse clientResponse;
+    batchOp.buildClientResponse(&clientResponse);
+    ASSERT(clientResponse.getOk());
+    ASSERT_EQUALS(clientResponse.getN(), 300);
+}
+
+// Many-doc unordered insert where some docs can't be targeted. Those should get a targeting error
+// each, and the rest should still be batched together.
+TEST_F(BatchWriteOpTest, ManyInsertsFailedTargetUnordered) {
+    NamespaceString nss("foo.bar");
+    ShardEndpoint endpoint(ShardId("shard"), ChunkVersion::IGNORED());
+    MockNSTargeter targeter;
+    initTargeterHalfRange(nss, endpoint, &targeter);
+
+    std::vector<BSONObj> docs;
+    for (int i = 0; i < 200; ++i) {
+        docs.push_back(BSON("x" << (i % 10 == 5 ? i : -1 - i)));
+    }
+
+    BatchedCommandRequest request([&] {
+        write_ops::Insert insertOp(nss);
+        insertOp.setWriteCommandBase([] {
+            write_ops::WriteCommandBase wcb;
+            wcb.setOrdered(false);
+            return wcb;
+        }());
+        insertOp.setDocuments(docs);
+        return insertOp;
+    }());
+
+    BatchWriteOp batchOp(operationContext(), request);
+
+    OwnedPointerMap<ShardId, TargetedWriteBatch> targetedOwned;
+    std::map<ShardId, TargetedWriteBatch*>& targeted = targetedOwned.mutableMap();
+    ASSERT_OK(batchOp.targetBatch(targeter, true, &targeted));
+    ASSERT(!batchOp.isFinished());
+    ASSERT_EQUALS(targeted.size(), 1u);
+    ASSERT_EQUALS(targeted.begin()->second->getWrites().size(), 180u);
+
+    BatchedCommandResponse response;
+    buildResponse(180, &response);
+    batchOp.noteBatchResponse(*targeted.begin()->second, response, nullptr);
+    ASSERT(batchOp.isFinished());
+
+    BatchedCommandResponse clientResponse;
+    batchOp.buildClientResponse(&clientResponse);
+    ASSERT(clientResponse.getOk());
+    ASSERT_EQUALS(clientResponse.getN(), 180);
+    ASSERT_EQUALS(clientResponse.sizeErrDetails(), 20u);
+    for (size_t i = 0; i < clientResponse.sizeErrDetails(); ++i) {
+        ASSERT_EQUALS(clientResponse.getErrDetailsAt(i)->getIndex(), int(10 * i + 5));
+    }
+}
+
 // Batch failure (ok : 0) reported in a multi-op batch (ordered). Expect this gets translated down
 // into write errors for first affected write.
 TEST_F(BatchWriteOpTest, MultiOpFailedBatchOrdered) {
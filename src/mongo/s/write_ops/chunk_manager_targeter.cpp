@@ -256,7 +256,7 @@ ChunkVersion getShardVersion(const CachedCollectionRoutingInfo& routingInfo,
  * ChunkManager or is implicit in the primary shard of the collection.
  */
 CompareResult compareAllShardVersions(const CachedCollectionRoutingInfo& routingInfo,
-                                      const ShardVersionMap& remoteShardVersions) {
+                                      const std::map<ShardId, ChunkVersion>& remoteShardVersions) {
     CompareResult finalResult = CompareResult_GTE;
 
     for (const auto& shardVersionEntry : remoteShardVersions) {
@@ -412,6 +412,61 @@ StatusWith<ShardEndpoint> ChunkManagerTargeter::targetInsert(OperationContext* o
     return Status::OK();
 }
 
+std::vector<boost::optional<size_t>> ChunkManagerTargeter::targetInserts(
+    OperationContext* opCtx,
+    const std::vector<BSONObj>& docs,
+    std::vector<ShardEndpoint>* endpoints) const {
+    // All the endpoints come from the same routing information, so there is at most one per shard
+    const auto findOrAddEndpoint = [&](const ShardId& shardId, auto makeEndpoint) {
+        const auto it = std::find_if(
+            endpoints->begin(), endpoints->end(), [&](const ShardEndpoint& endpoint) {
+                return endpoint.shardName == shardId;
+            });
+        if (it != endpoints->end()) {
+            return size_t(it - endpoints->begin());
+        }
+
+        endpoints->push_back(makeEndpoint());
+        return endpoints->size() - 1;
+    };
+
+    std::vector<boost::optional<size_t>> targets(docs.size());
+
+    if (!_routingInfo->cm()) {
+        if (const auto& primary = _routingInfo->db().primary()) {
+            const auto index = findOrAddEndpoint(primary->getId(), [&] {
+                return ShardEndpoint(primary->getId(),
+                                     ChunkVersion::UNSHARDED(),
+                                     _routingInfo->db().databaseVersion());
+            });
+            std::fill(targets.begin(), targets.end(), index);
+        }
+        return targets;
+    }
+
+    const auto& cm = _routingInfo->cm();
+    const auto shardIds = cm->findShardIdsForDocuments(docs);
+
+    // Consecutive documents usually go to the same shard, so remember the last one resolved
+    const ShardId* lastShardId = nullptr;
+    size_t lastIndex = 0;
+    for (size_t i = 0; i < docs.size(); ++i) {
+        if (!shardIds[i]) {
+            continue;
+        }
+
+        if (shardIds[i] != lastShardId) {
+            lastShardId = shardIds[i];
+            lastIndex = findOrAddEndpoint(*lastShardId, [&] {
+                return ShardEndpoint(*lastShardId, cm->getVersion(*lastShardId));
+            });
+        }
+        targets[i] = lastIndex;
+    }
+
+    return targets;
+}
+
 StatusWith<std::vector<ShardEndpoint>> ChunkManagerTargeter::targetUpdate(
     OperationContext* opCtx, const write_ops::UpdateOpEntry& updateDoc) const {
     // If the update is replacement-style:
@@ -80,6 +80,11 @@ public:
     StatusWith<ShardEndpoint> targetInsert(OperationContext* opCtx,
                                            const BSONObj& doc) const override;
 
+    std::vector<boost::optional<size_t>> targetInserts(
+        OperationContext* opCtx,
+        const std::vector<BSONObj>& docs,
+        std::vector<ShardEndpoint>* endpoints) const override;
+
     // Returns ShardKeyNotFound if the update can't be targeted without a shard key.
     StatusWith<std::vector<ShardEndpoint>> targetUpdate(
         OperationContext* opCtx, const write_ops::UpdateOpEntry& updateDoc) const override;
@@ -84,6 +84,35 @@ public:
         return swEndpoints.getValue().front();
     }
 
+    /**
+     * Targets each doc on its own through targetInsert()
+     */
+    std::vector<boost::optional<size_t>> targetInserts(
+        OperationContext* opCtx,
+        const std::vector<BSONObj>& docs,
+        std::vector<ShardEndpoint>* endpoints) const override {
+        std::vector<boost::optional<size_t>> targets;
+        for (const auto& doc : docs) {
+            auto swEndpoint = targetInsert(opCtx, doc);
+            if (!swEndpoint.isOK()) {
+                targets.push_back(boost::none);
+                continue;
+            }
+
+            const auto it = std::find_if(
+                endpoints->begin(), endpoints->end(), [&](const ShardEndpoint& endpoint) {
+                    return endpoint.shardName == swEndpoint.getValue().shardName &&
+                        endpoint.shardVersion == swEndpoint.getValue().shardVersion;
+                });
+            targets.push_back(size_t(it - endpoints->begin()));
+            if (it == endpoints->end()) {
+                endpoints->push_back(std::move(swEndpoint.getValue()));
+            }
+        }
+
+        return targets;
+    }
+
     /**
      * Returns the first ShardEndpoint for the query from the mock ranges.  Only can handle
      * queries of the form { field : { $gte : <value>, $lt : <value> } }.
@@ -108,6 +108,18 @@ Status WriteOp::targetWrites(OperationContext* opCtx,
     return Status::OK();
 }
 
+void WriteOp::noteTargetedWrite(TargetedWrite* targetedWrite) {
+    invariant(_state == WriteOpState_Ready);
+    invariant(_childOps.empty());
+    dassert(targetedWrite->writeOpRef == WriteOpRef(_itemRef.getItemIndex(), 0));
+
+    _childOps.emplace_back(this);
+    _childOps.back().pendingWrite = targetedWrite;
+    _childOps.back().state = WriteOpState_Pending;
+
+    _state = WriteOpState_Pending;
+}
+
 size_t WriteOp::getNumTargeted() {
     return _childOps.size();
 }
@@ -122,6 +122,14 @@ public:
                         const NSTargeter& targeter,
                         std::vector<TargetedWrite*>* targetedWrites);
 
+    /**
+     * Equivalent to targetWrites() producing just 'targetedWrite', for a write which the caller
+     * has already targeted at a single endpoint, e.g. through NSTargeter::targetInserts(). An op
+     * which is ready to be targeted has no child writes, so the writeOpRef of 'targetedWrite' must
+     * be this op's item index and child 0.
+     */
+    void noteTargetedWrite(TargetedWrite* targetedWrite);
+
     /**
      * Returns the number of child writes that were last targeted.
      */
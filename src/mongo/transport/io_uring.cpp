@@ -0,0 +1,254 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/io_uring.h"
+
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#include "mongo/util/assert_util.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace transport {
+namespace {
+
+Status makeErrnoStatus(StringData what, int err) {
+    return Status(ErrorCodes::OperationFailed,
+                  str::stream() << what << " failed: " << errnoWithDescription(err));
+}
+
+}  // namespace
+
+StatusWith<std::unique_ptr<IOUring>> IOUring::make(unsigned entries, unsigned flags) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = flags;
+
+    const int fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (fd < 0) {
+        return makeErrnoStatus("io_uring_setup", errno);
+    }
+
+    std::unique_ptr<IOUring> ring(new IOUring());
+    ring->_fd = fd;
+
+    // Without NODROP the kernel discards completions which don't fit in the completion queue,
+    // which would leave whoever is waiting on them waiting forever.
+    if (!(params.features & IORING_FEAT_NODROP)) {
+        return Status(ErrorCodes::OperationFailed,
+                      "io_uring does not support IORING_FEAT_NODROP on this kernel");
+    }
+
+    ring->_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        ring->_sqRingSize = ring->_cqRingSize = std::max(ring->_sqRingSize, ring->_cqRingSize);
+    }
+
+    auto mapRing = [&](size_t size, off_t offset) -> void* {
+        auto ptr =
+            mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+        return ptr == MAP_FAILED ? nullptr : ptr;
+    };
+
+    ring->_sqRing = mapRing(ring->_sqRingSize, IORING_OFF_SQ_RING);
+    if (!ring->_sqRing) {
+        return makeErrnoStatus("Mapping the io_uring submission queue", errno);
+    }
+
+    if (singleMmap) {
+        ring->_cqRing = ring->_sqRing;
+    } else {
+        ring->_cqRing = mapRing(ring->_cqRingSize, IORING_OFF_CQ_RING);
+        if (!ring->_cqRing) {
+            return makeErrnoStatus("Mapping the io_uring completion queue", errno);
+        }
+    }
+
+    ring->_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    auto sqes = mapRing(ring->_sqesSize, IORING_OFF_SQES);
+    if (!sqes) {
+        return makeErrnoStatus("Mapping the io_uring submission queue entries", errno);
+    }
+
+    auto sqRing = static_cast<char*>(ring->_sqRing);
+    auto& sq = ring->_sq;
+    sq.head = reinterpret_cast<unsigned*>(sqRing + params.sq_off.head);
+    sq.tail = reinterpret_cast<unsigned*>(sqRing + params.sq_off.tail);
+    sq.mask = *reinterpret_cast<unsigned*>(sqRing + params.sq_off.ring_mask);
+    sq.entries = *reinterpret_cast<unsigned*>(sqRing + params.sq_off.ring_entries);
+    sq.array = reinterpret_cast<unsigned*>(sqRing + params.sq_off.array);
+    sq.sqes = static_cast<io_uring_sqe*>(sqes);
+    sq.localTail = *sq.tail;
+
+    // Entries are always submitted in the order they are handed out, so the indirection array
+    // never changes.
+    for (unsigned i = 0; i < sq.entries; ++i) {
+        sq.array[i] = i;
+    }
+
+    auto cqRing = static_cast<char*>(ring->_cqRing);
+    auto& cq = ring->_cq;
+    cq.head = reinterpret_cast<unsigned*>(cqRing + params.cq_off.head);
+    cq.tail = reinterpret_cast<unsigned*>(cqRing + params.cq_off.tail);
+    cq.mask = *reinterpret_cast<unsigned*>(cqRing + params.cq_off.ring_mask);
+    cq.cqes = reinterpret_cast<io_uring_cqe*>(cqRing + params.cq_off.cqes);
+
+    return {std::move(ring)};
+}
+
+IOUring::~IOUring() {
+    if (_sq.sqes) {
+        munmap(_sq.sqes, _sqesSize);
+    }
+    if (_cqRing && _cqRing != _sqRing) {
+        munmap(_cqRing, _cqRingSize);
+    }
+    if (_sqRing) {
+        munmap(_sqRing, _sqRingSize);
+    }
+    if (_fd >= 0) {
+        close(_fd);
+    }
+}
+
+bool IOUring::supportsOpcodes(std::initializer_list<int> opcodes) const {
+    constexpr unsigned kMaxOps = 256;
+    std::vector<char> storage(sizeof(io_uring_probe) + kMaxOps * sizeof(io_uring_probe_op));
+    auto probe = reinterpret_cast<io_uring_probe*>(storage.data());
+    if (syscall(__NR_io_uring_register, _fd, IORING_REGISTER_PROBE, probe, kMaxOps) < 0) {
+        return false;
+    }
+
+    for (auto op : opcodes) {
+        if (op > probe->last_op || !(probe->ops[op].flags & IO_URING_OP_SUPPORTED)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+io_uring_sqe* IOUring::getSqe() {
+    const auto head = __atomic_load_n(_sq.head, __ATOMIC_ACQUIRE);
+    if (_sq.localTail - head >= _sq.entries) {
+        return nullptr;
+    }
+
+    auto sqe = &_sq.sqes[_sq.localTail & _sq.mask];
+    ++_sq.localTail;
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+unsigned IOUring::numUnsubmitted() const {
+    return _sq.localTail - __atomic_load_n(_sq.head, __ATOMIC_ACQUIRE);
+}
+
+Status IOUring::submit(unsigned waitFor) {
+    __atomic_store_n(_sq.tail, _sq.localTail, __ATOMIC_RELEASE);
+
+    while (true) {
+        const auto toSubmit = numUnsubmitted();
+        if (!toSubmit && !waitFor) {
+            return Status::OK();
+        }
+
+        const unsigned flags = waitFor ? IORING_ENTER_GETEVENTS : 0;
+        if (syscall(__NR_io_uring_enter, _fd, toSubmit, waitFor, flags, nullptr, 0) >= 0) {
+            return Status::OK();
+        }
+
+        const int err = errno;
+        if (err == EINTR) {
+            continue;
+        }
+        if (err == EBUSY || err == EAGAIN) {
+            return Status::OK();
+        }
+        return makeErrnoStatus("io_uring_enter", err);
+    }
+}
+
+StatusWith<std::unique_ptr<IOUringBufferGroup>> IOUringBufferGroup::make(uint16_t groupId,
+                                                                         uint16_t count,
+                                                                         size_t bufferSize) {
+    invariant(count > 0 && bufferSize > 0);
+
+    std::unique_ptr<IOUringBufferGroup> group(new IOUringBufferGroup(groupId, count, bufferSize));
+    auto buffers = mmap(nullptr,
+                        size_t(count) * bufferSize,
+                        PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS,
+                        -1,
+                        0);
+    if (buffers == MAP_FAILED) {
+        return makeErrnoStatus("Allocating io_uring buffers", errno);
+    }
+    group->_buffers = static_cast<char*>(buffers);
+
+    return {std::move(group)};
+}
+
+IOUringBufferGroup::~IOUringBufferGroup() {
+    if (_buffers) {
+        munmap(_buffers, size_t(_count) * _bufferSize);
+    }
+}
+
+void IOUringBufferGroup::prepareProvideAll(io_uring_sqe* sqe) const {
+    _prepareProvide(sqe, 0, _count);
+}
+
+void IOUringBufferGroup::prepareRecycle(io_uring_sqe* sqe, uint16_t bufferId) const {
+    invariant(bufferId < _count);
+    _prepareProvide(sqe, bufferId, 1);
+}
+
+void IOUringBufferGroup::_prepareProvide(io_uring_sqe* sqe,
+                                         uint16_t firstId,
+                                         uint16_t count) const {
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = count;
+    sqe->addr = reinterpret_cast<uint64_t>(data(firstId));
+    sqe->len = _bufferSize;
+    sqe->off = firstId;
+    sqe->buf_group = _groupId;
+}
+
+}  // namespace transport
+}  // namespace mongo
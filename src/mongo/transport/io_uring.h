@@ -0,0 +1,213 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <initializer_list>
+#include <linux/io_uring.h>
+#include <memory>
+
+#include "mongo/base/status_with.h"
+
+namespace mongo {
+namespace transport {
+
+/**
+ * A minimal wrapper around a single io_uring instance, driven directly through the
+ * io_uring_setup(2), io_uring_enter(2) and io_uring_register(2) system calls.
+ *
+ * Submission queue entries are handed out by getSqe() and are not visible to the kernel until the
+ * next call to submit(), so any number of them can be queued up and then handed to the kernel with
+ * a single system call. This class is not thread safe: every method must be called from the
+ * thread which owns the ring. Rings created with IORING_SETUP_SINGLE_ISSUER additionally require
+ * that this be the thread which created them.
+ */
+class IOUring {
+    IOUring(const IOUring&) = delete;
+    IOUring& operator=(const IOUring&) = delete;
+
+public:
+    /**
+     * Creates a ring with room for at least 'entries' submissions, passing 'flags' through to
+     * io_uring_setup(2).
+     */
+    static StatusWith<std::unique_ptr<IOUring>> make(unsigned entries, unsigned flags = 0);
+
+    ~IOUring();
+
+    int fd() const {
+        return _fd;
+    }
+
+    /**
+     * Returns true if the kernel supports every opcode in 'opcodes'.
+     */
+    bool supportsOpcodes(std::initializer_list<int> opcodes) const;
+
+    /**
+     * Returns a zeroed submission queue entry to be filled in by the caller, or nullptr if the
+     * submission queue is full, in which case the caller must submit() before trying again.
+     */
+    io_uring_sqe* getSqe();
+
+    /**
+     * Returns the number of entries obtained from getSqe() which have not yet been submitted.
+     */
+    unsigned numUnsubmitted() const;
+
+    /**
+     * Returns the number of entries getSqe() can hand out before the next submit().
+     */
+    unsigned spaceLeft() const {
+        return _sq.entries - numUnsubmitted();
+    }
+
+    /**
+     * Submits every entry queued since the last call and then, if 'waitFor' is non-zero, blocks
+     * until at least that many completions are available to reap(). Both happen in one system
+     * call. If the kernel is temporarily unable to accept submissions because completions are
+     * backing up, returns OK after submitting only some of them; the rest are submitted by the
+     * next call, once the caller has reaped.
+     */
+    Status submit(unsigned waitFor = 0);
+
+    /**
+     * Invokes 'cb' with each available completion queue entry, in order, and then releases them
+     * back to the kernel. Returns the number of entries reaped.
+     */
+    template <typename Callback>
+    size_t reap(Callback&& cb) {
+        size_t count = 0;
+        auto head = *_cq.head;
+        const auto tail = __atomic_load_n(_cq.tail, __ATOMIC_ACQUIRE);
+        for (; head != tail; ++head, ++count) {
+            cb(_cq.cqes[head & _cq.mask]);
+        }
+        if (count) {
+            __atomic_store_n(_cq.head, head, __ATOMIC_RELEASE);
+        }
+        return count;
+    }
+
+private:
+    struct SubmissionQueue {
+        unsigned* head;
+        unsigned* tail;
+        unsigned mask;
+        unsigned entries;
+        unsigned* array;
+        io_uring_sqe* sqes;
+
+        // The tail as seen by this process: entries up to here have been handed out by getSqe()
+        // but are only published to the kernel by submit().
+        unsigned localTail;
+    };
+
+    struct CompletionQueue {
+        unsigned* head;
+        unsigned* tail;
+        unsigned mask;
+        io_uring_cqe* cqes;
+    };
+
+    IOUring() = default;
+
+    int _fd = -1;
+
+    void* _sqRing = nullptr;
+    size_t _sqRingSize = 0;
+    void* _cqRing = nullptr;
+    size_t _cqRingSize = 0;
+    size_t _sqesSize = 0;
+
+    SubmissionQueue _sq{};
+    CompletionQueue _cq{};
+};
+
+/**
+ * A group of equally sized buffers which the kernel picks from for every receive submitted with
+ * IOSQE_BUFFER_SELECT and this group's id. Each completion names the buffer that was used, and the
+ * buffer is the application's until it is handed back with prepareRecycle().
+ *
+ * Buffers are handed to the kernel with IORING_OP_PROVIDE_BUFFERS, so giving them back costs a
+ * submission queue entry but no system call of its own: it goes to the kernel along with whatever
+ * else is submitted next.
+ */
+class IOUringBufferGroup {
+    IOUringBufferGroup(const IOUringBufferGroup&) = delete;
+    IOUringBufferGroup& operator=(const IOUringBufferGroup&) = delete;
+
+public:
+    /**
+     * Allocates 'count' buffers of 'bufferSize' bytes each, to be provided as group 'groupId'.
+     */
+    static StatusWith<std::unique_ptr<IOUringBufferGroup>> make(uint16_t groupId,
+                                                                uint16_t count,
+                                                                size_t bufferSize);
+
+    ~IOUringBufferGroup();
+
+    uint16_t groupId() const {
+        return _groupId;
+    }
+
+    size_t bufferSize() const {
+        return _bufferSize;
+    }
+
+    const char* data(uint16_t bufferId) const {
+        return _buffers + size_t(bufferId) * _bufferSize;
+    }
+
+    /**
+     * Fills in 'sqe' to provide every buffer in the group to the kernel.
+     */
+    void prepareProvideAll(io_uring_sqe* sqe) const;
+
+    /**
+     * Fills in 'sqe' to hand 'bufferId' back to the kernel.
+     */
+    void prepareRecycle(io_uring_sqe* sqe, uint16_t bufferId) const;
+
+private:
+    IOUringBufferGroup(uint16_t groupId, uint16_t count, size_t bufferSize)
+        : _groupId(groupId), _count(count), _bufferSize(bufferSize) {}
+
+    void _prepareProvide(io_uring_sqe* sqe, uint16_t firstId, uint16_t count) const;
+
+    const uint16_t _groupId;
+    const uint16_t _count;
+    const size_t _bufferSize;
+
+    char* _buffers = nullptr;
+};
+
+}  // namespace transport
+}  // namespace mongo
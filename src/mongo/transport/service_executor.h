@@ -33,6 +33,7 @@
 
 #include "mongo/base/status.h"
 #include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/baton.h"
 #include "mongo/platform/bitwise_enum_operators.h"
 #include "mongo/transport/service_executor_task_names.h"
 #include "mongo/transport/transport_mode.h"
@@ -44,6 +45,17 @@ class ServiceContext;
 
 namespace transport {
 
+/**
+ * Validation callback for setParameter 'coroutineServiceExecutorThreads', which must be -1 or at
+ * least 1.
+ */
+inline Status validateCoroutineServiceExecutorThreads(const int& value) {
+    if (value == 0) {
+        return {ErrorCodes::BadValue, "coroutineServiceExecutorThreads must be -1 or at least 1"};
+    }
+    return Status::OK();
+}
+
 /*
  * This is the interface for all ServiceExecutors.
  */
@@ -91,6 +103,14 @@ public:
      */
     virtual Status shutdown(Milliseconds timeout) = 0;
 
+    /*
+     * Gives the executor a chance to attach a Baton of its own to an OperationContext which is being
+     * created. Returns nullptr if it doesn't, in which case the transport layer makes the baton.
+     */
+    virtual BatonHandle makeBaton(OperationContext* opCtx) {
+        return nullptr;
+    }
+
     /*
      * Returns if this service executor is using asynchronous or synchronous networking.
      */
@@ -0,0 +1,726 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kExecutor
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/service_executor_coroutine.h"
+
+#include <deque>
+#include <map>
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "mongo/db/client.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/transport/service_entry_point_utils.h"
+#include "mongo/transport/service_executor_gen.h"
+#include "mongo/util/concurrency/idle_thread_block.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+namespace for_debuggers {
+// Defined in idle_thread_block.cpp.
+extern thread_local const char* idleThreadLocation;
+}  // namespace for_debuggers
+
+namespace transport {
+namespace {
+constexpr auto kExecutorLabel = "executor"_sd;
+constexpr auto kExecutorName = "coroutine"_sd;
+constexpr auto kThreadsRunning = "threadsRunning"_sd;
+constexpr auto kCoroutinesRunning = "coroutinesRunning"_sd;
+constexpr auto kCoroutinesCreated = "coroutinesCreated"_sd;
+
+// How long the network thread runs the reactor for before checking whether it should exit.
+constexpr Milliseconds kNetworkRunTime{100};
+
+const auto kDetached = Status(ErrorCodes::ShutdownInProgress, "Baton detached");
+}  // namespace
+
+thread_local ServiceExecutorCoroutine::Coroutine* ServiceExecutorCoroutine::_currentCoroutine =
+    nullptr;
+
+/**
+ * A fixed-size stack, with a guard page below it, and the context of whatever runs on it.
+ *
+ * A coroutine is in one of four states, which are guarded by its worker's mutex:
+ *  - Runnable: on its worker's run queue.
+ *  - Running: on its worker thread.
+ *  - Suspended: waiting for wake() to make it runnable again.
+ *  - Finished: its last task has returned.
+ *
+ * wake() is level triggered: waking a coroutine which isn't suspended makes its next suspension
+ * return straight away.
+ */
+class ServiceExecutorCoroutine::Coroutine : public std::enable_shared_from_this<Coroutine> {
+    Coroutine(const Coroutine&) = delete;
+    Coroutine& operator=(const Coroutine&) = delete;
+
+public:
+    Coroutine(Worker* worker, Task task) : _worker(worker) {
+        _localQueue.emplace_back(std::move(task));
+    }
+
+    ~Coroutine() {
+        if (_stack) {
+            munmap(_stack, _mappingSize);
+        }
+    }
+
+    /**
+     * Allocates the stack. The pages are only backed by memory once the coroutine touches them.
+     */
+    Status init(size_t stackSize);
+
+    Worker* worker() const {
+        return _worker;
+    }
+
+    /**
+     * Runs the coroutine until it next suspends, yields or finishes. Only called by the worker.
+     */
+    void resume();
+
+    /**
+     * Makes the coroutine runnable if it is suspended. May be called from any thread.
+     */
+    void wake();
+
+    // The rest is only called on the coroutine.
+
+    /**
+     * Schedules a task on the coroutine, which runs it once the task at hand returns or, if
+     * allowed, right away.
+     */
+    void schedule(Task task, ScheduleFlags flags);
+
+    /**
+     * Suspends the coroutine until the next call to wake(), or returns straight away if wake() has
+     * been called since the coroutine last suspended.
+     */
+    void suspend();
+
+    /**
+     * Like suspend(), but also wakes the coroutine at 'deadline'.
+     */
+    void suspendUntil(Date_t deadline);
+
+    /**
+     * Lets the other runnable coroutines on the worker run first.
+     */
+    void yield() {
+        _yielding = true;
+        _switchOut();
+    }
+
+private:
+    friend class ServiceExecutorCoroutine::Worker;
+
+    enum class State { kRunnable, kRunning, kSuspended, kFinished };
+
+    using TimerIterator = std::multimap<Date_t, Coroutine*>::iterator;
+
+    static void _entry() {
+        auto self = _currentCoroutine;
+        try {
+            self->_run();
+        } catch (...) {
+            // An exception can't unwind past the start of the stack.
+            std::terminate();
+        }
+        // Returning switches to uc_link, which is the worker's scheduler context.
+    }
+
+    void _run();
+
+    /**
+     * Switches to the worker. Thread-local state which belongs to the coroutine goes with it.
+     */
+    void _switchOut();
+
+    Worker* const _worker;
+
+    void* _stack = nullptr;
+    size_t _mappingSize = 0;
+    ucontext_t _context;
+
+    // Guarded by the worker's mutex.
+    State _state = State::kRunnable;
+    bool _wakePending = false;
+
+    // The rest is only used on the worker thread.
+    std::deque<Task> _localQueue;
+    int _recursionDepth = 0;
+    bool _yielding = false;
+    bool _finished = false;
+    boost::optional<TimerIterator> _timer;
+};
+
+/**
+ * A thread which runs coroutines, one at a time, and the coroutines' timers.
+ */
+class ServiceExecutorCoroutine::Worker {
+    Worker(const Worker&) = delete;
+    Worker& operator=(const Worker&) = delete;
+
+public:
+    Worker(ServiceExecutorCoroutine* executor, size_t id)
+        : _executor(executor), _name(str::stream() << "coroutine-worker-" << id) {}
+
+    ServiceExecutorCoroutine* executor() const {
+        return _executor;
+    }
+
+    ucontext_t* schedulerContext() {
+        return &_schedulerContext;
+    }
+
+    /**
+     * Queues a new coroutine to run on this worker, unless the worker has exited.
+     */
+    Status start(std::shared_ptr<Coroutine> coroutine) {
+        stdx::lock_guard<Latch> lk(_mutex);
+        if (_exited) {
+            return {ErrorCodes::ShutdownInProgress, "Executor is not running"};
+        }
+        ++_numCoroutines;
+        _runQueue.push_back(std::move(coroutine));
+        _cv.notify_one();
+        return Status::OK();
+    }
+
+    /**
+     * Wakes the worker so that it can exit once it runs no more coroutines.
+     */
+    void notifyShutdown() {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _cv.notify_one();
+    }
+
+    bool hasRunnableCoroutines() {
+        stdx::lock_guard<Latch> lk(_mutex);
+        return !_runQueue.empty();
+    }
+
+    /**
+     * Arranges for 'coroutine' to be woken at 'deadline'. Only called on the worker thread.
+     */
+    Coroutine::TimerIterator addTimer(Date_t deadline, Coroutine* coroutine) {
+        return _timers.emplace(deadline, coroutine);
+    }
+
+    void cancelTimer(Coroutine::TimerIterator it) {
+        _timers.erase(it);
+    }
+
+    void run();
+
+private:
+    friend class ServiceExecutorCoroutine::Coroutine;
+
+    /**
+     * Wakes the coroutines whose timers have expired and returns the next deadline.
+     */
+    Date_t _fireTimers() {
+        const auto now = Date_t::now();
+        while (!_timers.empty() && _timers.begin()->first <= now) {
+            auto coroutine = _timers.begin()->second;
+            coroutine->_timer = boost::none;
+            _timers.erase(_timers.begin());
+            coroutine->wake();
+        }
+        return _timers.empty() ? Date_t::max() : _timers.begin()->first;
+    }
+
+    void _afterResume(const std::shared_ptr<Coroutine>& coroutine) {
+        stdx::lock_guard<Latch> lk(_mutex);
+        if (coroutine->_finished) {
+            coroutine->_state = Coroutine::State::kFinished;
+            --_numCoroutines;
+            _executor->_numRunningCoroutines.subtractAndFetch(1);
+        } else if (coroutine->_yielding || coroutine->_wakePending) {
+            // A pending wake-up is left in place for a yielding coroutine's next suspension.
+            if (!std::exchange(coroutine->_yielding, false)) {
+                coroutine->_wakePending = false;
+            }
+            coroutine->_state = Coroutine::State::kRunnable;
+            _runQueue.push_back(coroutine);
+        } else {
+            coroutine->_state = Coroutine::State::kSuspended;
+        }
+    }
+
+    ServiceExecutorCoroutine* const _executor;
+    const std::string _name;
+
+    Mutex _mutex = MONGO_MAKE_LATCH("ServiceExecutorCoroutine::Worker::_mutex");
+    stdx::condition_variable _cv;
+    std::deque<std::shared_ptr<Coroutine>> _runQueue;
+    size_t _numCoroutines = 0;
+    bool _exited = false;
+
+    // The rest is only used on the worker thread.
+    ucontext_t _schedulerContext;
+    std::multimap<Date_t, Coroutine*> _timers;
+};
+
+Status ServiceExecutorCoroutine::Coroutine::init(size_t stackSize) {
+    const size_t pageSize = sysconf(_SC_PAGESIZE);
+    stackSize = (stackSize + pageSize - 1) / pageSize * pageSize;
+    _mappingSize = stackSize + pageSize;
+
+    auto stack = mmap(nullptr,
+                      _mappingSize,
+                      PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                      -1,
+                      0);
+    if (stack == MAP_FAILED) {
+        return {ErrorCodes::InternalError,
+                str::stream() << "Failed to allocate a coroutine stack: "
+                              << errnoWithDescription()};
+    }
+    _stack = stack;
+
+    // Overflowing the stack faults on the guard page instead of corrupting whatever is next.
+    if (mprotect(_stack, pageSize, PROT_NONE) != 0) {
+        return {ErrorCodes::InternalError,
+                str::stream() << "Failed to protect a coroutine stack: " << errnoWithDescription()};
+    }
+
+    invariant(getcontext(&_context) == 0);
+    _context.uc_stack.ss_sp = static_cast<char*>(_stack) + pageSize;
+    _context.uc_stack.ss_size = stackSize;
+    _context.uc_link = _worker->schedulerContext();
+    makecontext(&_context, &Coroutine::_entry, 0);
+    return Status::OK();
+}
+
+void ServiceExecutorCoroutine::Coroutine::resume() {
+    _currentCoroutine = this;
+    invariant(swapcontext(_worker->schedulerContext(), &_context) == 0);
+    _currentCoroutine = nullptr;
+}
+
+void ServiceExecutorCoroutine::Coroutine::_switchOut() {
+    auto client = haveClient() ? Client::releaseCurrent() : ServiceContext::UniqueClient();
+    const auto threadName = getThreadName().toString();
+    // An IdleThreadBlock marks the coroutine idle, not the worker, which goes on to run others.
+    // IdleThreadBlocks don't nest, so the next coroutine to wait for a message would trip over it.
+    const auto idleLocation = std::exchange(for_debuggers::idleThreadLocation, nullptr);
+
+    invariant(swapcontext(&_context, _worker->schedulerContext()) == 0);
+
+    invariant(!for_debuggers::idleThreadLocation);
+    for_debuggers::idleThreadLocation = idleLocation;
+    if (client) {
+        Client::setCurrent(std::move(client));
+    }
+    if (getThreadName() != threadName) {
+        setThreadName(threadName);
+    }
+}
+
+void ServiceExecutorCoroutine::Coroutine::wake() {
+    stdx::lock_guard<Latch> lk(_worker->_mutex);
+    switch (_state) {
+        case State::kSuspended:
+            _state = State::kRunnable;
+            _worker->_runQueue.push_back(shared_from_this());
+            _worker->_cv.notify_one();
+            break;
+        case State::kRunnable:
+        case State::kRunning:
+            _wakePending = true;
+            break;
+        case State::kFinished:
+            break;
+    }
+}
+
+void ServiceExecutorCoroutine::Coroutine::schedule(Task task, ScheduleFlags flags) {
+    if ((flags & ScheduleFlags::kMayYieldBeforeSchedule) && _worker->hasRunnableCoroutines()) {
+        yield();
+    }
+
+    // As with ServiceExecutorSynchronous, running the task right away is cheaper than queueing it,
+    // but the recursion is bounded so that the stack doesn't overflow.
+    if ((flags & ScheduleFlags::kMayRecurse) &&
+        (_recursionDepth < coroutineServiceExecutorRecursionLimit.loadRelaxed())) {
+        ++_recursionDepth;
+        task();
+    } else {
+        _localQueue.emplace_back(std::move(task));
+    }
+}
+
+void ServiceExecutorCoroutine::Coroutine::suspend() {
+    {
+        stdx::lock_guard<Latch> lk(_worker->_mutex);
+        if (std::exchange(_wakePending, false)) {
+            return;
+        }
+    }
+
+    // If wake() is called before the switch completes, it sets _wakePending and the worker puts
+    // the coroutine straight back on the run queue.
+    _switchOut();
+}
+
+void ServiceExecutorCoroutine::Coroutine::suspendUntil(Date_t deadline) {
+    if (deadline == Date_t::max()) {
+        suspend();
+        return;
+    }
+
+    _timer = _worker->addTimer(deadline, this);
+    suspend();
+    if (_timer) {
+        _worker->cancelTimer(*_timer);
+        _timer = boost::none;
+    }
+}
+
+void ServiceExecutorCoroutine::Coroutine::_run() {
+    auto executor = _worker->executor();
+    while (!_localQueue.empty() && executor->_stillRunning.loadRelaxed()) {
+        _recursionDepth = 1;
+        _localQueue.front()();
+        _localQueue.pop_front();
+    }
+    _localQueue.clear();
+    _finished = true;
+}
+
+void ServiceExecutorCoroutine::Worker::run() {
+    setThreadName(_name);
+
+    while (true) {
+        const auto nextDeadline = _fireTimers();
+
+        std::shared_ptr<Coroutine> coroutine;
+        {
+            stdx::unique_lock<Latch> lk(_mutex);
+            auto canExit = [&] { return _numCoroutines == 0 && !_executor->_stillRunning.load(); };
+            if (_runQueue.empty()) {
+                if (canExit()) {
+                    _exited = true;
+                    return;
+                }
+
+                auto hasWork = [&] { return !_runQueue.empty() || canExit(); };
+                if (nextDeadline == Date_t::max()) {
+                    _cv.wait(lk, hasWork);
+                } else {
+                    _cv.wait_until(lk, nextDeadline.toSystemTimePoint(), hasWork);
+                }
+                continue;
+            }
+
+            coroutine = std::move(_runQueue.front());
+            _runQueue.pop_front();
+            coroutine->_state = Coroutine::State::kRunning;
+        }
+
+        coroutine->resume();
+        _afterResume(coroutine);
+    }
+}
+
+/**
+ * A Baton which suspends the coroutine which created it rather than blocking the worker thread.
+ */
+class ServiceExecutorCoroutine::CoroutineBaton final : public Baton {
+public:
+    CoroutineBaton(OperationContext* opCtx, std::shared_ptr<Coroutine> coroutine)
+        : _opCtx(opCtx), _coroutine(std::move(coroutine)) {}
+
+    ~CoroutineBaton() {
+        invariant(!_opCtx);
+        invariant(_scheduled.empty());
+    }
+
+    void markKillOnClientDisconnect() noexcept override {
+        if (_opCtx->getClient() && _opCtx->getClient()->session()) {
+            _hasIngressSocket = true;
+        }
+    }
+
+    void schedule(Task func) noexcept override {
+        stdx::unique_lock<Latch> lk(_mutex);
+
+        if (!_opCtx) {
+            lk.unlock();
+            func(kDetached);
+
+            return;
+        }
+
+        _scheduled.push_back(std::move(func));
+        lk.unlock();
+
+        _coroutine->wake();
+    }
+
+    void notify() noexcept override {
+        _coroutine->wake();
+    }
+
+    Waitable::TimeoutState run_until(ClockSource* clkSource, Date_t oldDeadline) noexcept override {
+        invariant(_currentCoroutine == _coroutine.get());
+
+        stdx::unique_lock<Latch> lk(_mutex);
+
+        // We'll run jobs on the way out, ensuring we don't hold any locks
+        const auto guard = makeGuard([&] {
+            while (_scheduled.size()) {
+                auto toRun = std::exchange(_scheduled, {});
+
+                lk.unlock();
+                for (auto& job : toRun) {
+                    job(Status::OK());
+                }
+                lk.lock();
+            }
+        });
+
+        // If anything was scheduled, run it now.
+        if (_scheduled.size()) {
+            return Waitable::TimeoutState::NoTimeout;
+        }
+
+        // If we have an ingress socket, sleep no more than 1 second (so we poll for closure in the
+        // outside opCtx waitForConditionOrInterruptUntil implementation)
+        auto newDeadline = oldDeadline;
+        if (_hasIngressSocket) {
+            newDeadline = std::min(oldDeadline, clkSource->now() + Seconds(1));
+        }
+
+        lk.unlock();
+        _coroutine->suspendUntil(newDeadline);
+        lk.lock();
+
+        // Whatever woke us up, it is as good as a spurious wakeup unless the deadline has passed.
+        return clkSource->now() < oldDeadline ? Waitable::TimeoutState::NoTimeout
+                                              : Waitable::TimeoutState::Timeout;
+    }
+
+    void run(ClockSource* clkSource) noexcept override {
+        run_until(clkSource, Date_t::max());
+    }
+
+private:
+    void detachImpl() noexcept override {
+        decltype(_scheduled) scheduled;
+
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+
+            invariant(_opCtx->getBaton().get() == this);
+            _opCtx->setBaton(nullptr);
+
+            _opCtx = nullptr;
+            _hasIngressSocket = false;
+
+            using std::swap;
+            swap(_scheduled, scheduled);
+        }
+
+        for (auto& job : scheduled) {
+            job(kDetached);
+        }
+    }
+
+    Mutex _mutex = MONGO_MAKE_LATCH("ServiceExecutorCoroutine::CoroutineBaton::_mutex");
+    OperationContext* _opCtx;
+    const std::shared_ptr<Coroutine> _coroutine;
+
+    bool _hasIngressSocket = false;
+
+    std::vector<Task> _scheduled;
+};
+
+ServiceExecutorCoroutine::ServiceExecutorCoroutine(ServiceContext* ctx, ReactorHandle reactor)
+    : _reactor(std::move(reactor)) {}
+
+ServiceExecutorCoroutine::~ServiceExecutorCoroutine() {
+    invariant(_numRunningThreads.load() == 0);
+}
+
+Status ServiceExecutorCoroutine::start() {
+    auto numWorkers = coroutineServiceExecutorThreads;
+    if (numWorkers == -1) {
+        numWorkers = static_cast<int>(ProcessInfo::getNumAvailableCores());
+    }
+
+    _stillRunning.store(true);
+
+    // Every worker exists before any of them starts, so that schedule() can pick from all of them.
+    for (int i = 0; i < numWorkers; ++i) {
+        _workers.push_back(std::make_unique<Worker>(this, i));
+    }
+
+    for (auto& worker : _workers) {
+        _numRunningThreads.addAndFetch(1);
+        auto status = launchServiceWorkerThread([this, worker = worker.get()] {
+            worker->run();
+            _onThreadExit();
+        });
+        if (!status.isOK()) {
+            _onThreadExit();
+            return status;
+        }
+    }
+
+    if (_reactor) {
+        // Async network operations complete on the reactor, which resumes the coroutines waiting on
+        // them. It keeps running until every coroutine is done, since they may be waiting on it.
+        _numRunningThreads.addAndFetch(1);
+        auto status = launchServiceWorkerThread([this] {
+            setThreadName("coroutine-network");
+            while (_stillRunning.load() || _numRunningCoroutines.load() > 0) {
+                _reactor->runFor(kNetworkRunTime);
+            }
+            _onThreadExit();
+        });
+        if (!status.isOK()) {
+            _onThreadExit();
+            return status;
+        }
+    }
+
+    log() << "Started coroutine service executor with " << numWorkers << " worker threads";
+    return Status::OK();
+}
+
+Status ServiceExecutorCoroutine::shutdown(Milliseconds timeout) {
+    LOG(3) << "Shutting down coroutine executor";
+
+    _stillRunning.store(false);
+    for (auto& worker : _workers) {
+        worker->notifyShutdown();
+    }
+
+    stdx::unique_lock<Latch> lock(_shutdownMutex);
+    bool result = _shutdownCondition.wait_for(lock, timeout.toSystemDuration(), [this]() {
+        return _numRunningThreads.load() == 0;
+    });
+
+    return result
+        ? Status::OK()
+        : Status(ErrorCodes::Error::ExceededTimeLimit,
+                 "coroutine executor couldn't shutdown all worker threads within time limit.");
+}
+
+Status ServiceExecutorCoroutine::schedule(Task task,
+                                          ScheduleFlags flags,
+                                          ServiceExecutorTaskName taskName) {
+    if (!_stillRunning.load()) {
+        return Status{ErrorCodes::ShutdownInProgress, "Executor is not running"};
+    }
+
+    // Everything a connection schedules once it runs on a coroutine stays on that coroutine.
+    if (_currentCoroutine && _currentCoroutine->worker()->executor() == this) {
+        _currentCoroutine->schedule(std::move(task), flags);
+        return Status::OK();
+    }
+
+    // First call to schedule() for this connection, start a coroutine which runs it and every task
+    // the connection schedules from then on.
+    auto& worker = _workers[_nextWorker.fetchAndAdd(1) % _workers.size()];
+    auto coroutine = std::make_shared<Coroutine>(worker.get(), std::move(task));
+    auto status = coroutine->init(static_cast<size_t>(coroutineServiceExecutorStackSizeKB) * 1024);
+    if (!status.isOK()) {
+        return status;
+    }
+
+    _numRunningCoroutines.addAndFetch(1);
+    status = worker->start(std::move(coroutine));
+    if (!status.isOK()) {
+        _numRunningCoroutines.subtractAndFetch(1);
+        return status;
+    }
+    _numCreatedCoroutines.addAndFetch(1);
+    return Status::OK();
+}
+
+BatonHandle ServiceExecutorCoroutine::makeBaton(OperationContext* opCtx) {
+    if (!_currentCoroutine || _currentCoroutine->worker()->executor() != this) {
+        return nullptr;
+    }
+
+    auto baton = std::make_shared<CoroutineBaton>(opCtx, _currentCoroutine->shared_from_this());
+    opCtx->setBaton(baton);
+    return baton;
+}
+
+void ServiceExecutorCoroutine::appendStats(BSONObjBuilder* bob) const {
+    *bob << kExecutorLabel << kExecutorName << kThreadsRunning
+         << static_cast<int>(_numRunningThreads.loadRelaxed()) << kCoroutinesRunning
+         << static_cast<long long>(_numRunningCoroutines.loadRelaxed()) << kCoroutinesCreated
+         << _numCreatedCoroutines.loadRelaxed();
+}
+
+bool ServiceExecutorCoroutine::onCoroutine() {
+    return _currentCoroutine;
+}
+
+void ServiceExecutorCoroutine::_suspendUntilResumed(
+    unique_function<void(unique_function<void()>)> arm) {
+    auto coroutine = _currentCoroutine;
+    invariant(coroutine);
+
+    auto resumed = std::make_shared<AtomicWord<bool>>(false);
+    arm([resumed, anchor = coroutine->shared_from_this()] {
+        resumed->store(true);
+        anchor->wake();
+    });
+
+    while (!resumed->load()) {
+        coroutine->suspend();
+    }
+}
+
+void ServiceExecutorCoroutine::_onThreadExit() {
+    if (_numRunningThreads.subtractAndFetch(1) == 0) {
+        stdx::lock_guard<Latch> lk(_shutdownMutex);
+        _shutdownCondition.notify_all();
+    }
+}
+
+}  // namespace transport
+}  // namespace mongo
@@ -0,0 +1,153 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "mongo/base/status.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/transport/service_executor.h"
+#include "mongo/transport/service_executor_task_names.h"
+#include "mongo/transport/transport_layer.h"
+#include "mongo/util/functional.h"
+#include "mongo/util/future.h"
+
+namespace mongo {
+namespace transport {
+
+/**
+ * Runs each connection on a lightweight coroutine rather than on a thread of its own.
+ *
+ * The first task scheduled for a connection starts a coroutine, with a stack of its own, on one of
+ * a fixed number of worker threads, and every task the connection schedules from then on runs on
+ * that coroutine, just like ServiceExecutorSynchronous runs them all on the connection's thread.
+ * The ServiceStateMachine thus runs each connection's source/process/sink loop as straight-line
+ * code, but where a dedicated thread would block, the coroutine suspends and its worker thread
+ * goes on to run other coroutines:
+ *
+ *  - Network I/O is asynchronous, and the ServiceStateMachine waits for it with await(). If the
+ *    transport layer has an ingress reactor, a dedicated thread runs it.
+ *  - Operations created on a coroutine get a Baton which suspends the coroutine, rather than the
+ *    thread, whenever the operation waits on a condition variable through its OperationContext.
+ *    That covers lock acquisition and ticket admission, among others.
+ *
+ * A coroutine always resumes on the worker thread which started it, so anything which is tied to a
+ * thread, like a held mutex, stays valid across suspensions. The current Client and the thread name
+ * are carried along with the coroutine. Other thread-local state is not, so code which keeps state
+ * in thread-locals across a wait on an OperationContext must not run on this executor.
+ */
+class ServiceExecutorCoroutine final : public ServiceExecutor {
+public:
+    /**
+     * 'reactor' is the transport layer's ingress reactor, if it has one.
+     */
+    ServiceExecutorCoroutine(ServiceContext* ctx, ReactorHandle reactor);
+
+    ~ServiceExecutorCoroutine() override;
+
+    Status start() override;
+    Status shutdown(Milliseconds timeout) override;
+    Status schedule(Task task, ScheduleFlags flags, ServiceExecutorTaskName taskName) override;
+
+    /**
+     * Attaches a Baton which suspends the calling coroutine, if 'opCtx' is being created on one.
+     */
+    BatonHandle makeBaton(OperationContext* opCtx) override;
+
+    Mode transportMode() const override {
+        return Mode::kAsynchronous;
+    }
+
+    void appendStats(BSONObjBuilder* bob) const override;
+
+    /**
+     * Returns true if the caller runs on a coroutine of a ServiceExecutorCoroutine.
+     */
+    static bool onCoroutine();
+
+    /**
+     * Waits for 'future' to become ready and returns its result. On a coroutine, this suspends the
+     * coroutine, and its worker thread runs other coroutines in the meantime. Anywhere else, this
+     * blocks the calling thread.
+     */
+    template <typename T>
+    static StatusOrStatusWith<T> await(Future<T> future) {
+        if (future.isReady() || !onCoroutine()) {
+            return std::move(future).getNoThrow();
+        }
+
+        boost::optional<StatusOrStatusWith<T>> result;
+        _suspendUntilResumed([&](unique_function<void()> resume) {
+            std::move(future).getAsync(
+                [&result, resume = std::move(resume)](StatusOrStatusWith<T> value) mutable {
+                    result.emplace(std::move(value));
+                    resume();
+                });
+        });
+        return std::move(*result);
+    }
+
+private:
+    class Coroutine;
+    class CoroutineBaton;
+    class Worker;
+
+    /**
+     * Calls 'arm' with a callback and suspends the calling coroutine until that callback has been
+     * invoked, which may happen on any thread, or inline in 'arm'.
+     */
+    static void _suspendUntilResumed(unique_function<void(unique_function<void()>)> arm);
+
+    void _onThreadExit();
+
+    // The coroutine running on this thread, if any.
+    static thread_local Coroutine* _currentCoroutine;
+
+    const ReactorHandle _reactor;
+
+    AtomicWord<bool> _stillRunning{false};
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    AtomicWord<size_t> _nextWorker{0};
+
+    AtomicWord<size_t> _numRunningThreads{0};
+    AtomicWord<size_t> _numRunningCoroutines{0};
+    AtomicWord<long long> _numCreatedCoroutines{0};
+
+    mutable Mutex _shutdownMutex = MONGO_MAKE_LATCH("ServiceExecutorCoroutine::_shutdownMutex");
+    stdx::condition_variable _shutdownCondition;
+};
+
+}  // namespace transport
+}  // namespace mongo
@@ -35,10 +35,15 @@
 
 #include "mongo/db/service_context.h"
 #include "mongo/transport/service_executor_adaptive.h"
+#ifdef __linux__
+#include "mongo/transport/service_executor_coroutine.h"
+#include "mongo/transport/service_executor_gen.h"
+#endif
 #include "mongo/transport/service_executor_synchronous.h"
 #include "mongo/transport/service_executor_task_names.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/log.h"
+#include "mongo/util/future.h"
 #include "mongo/util/scopeguard.h"
 
 #include <asio.hpp>
@@ -176,6 +181,30 @@ protected:
     std::unique_ptr<ServiceExecutorSynchronous> executor;
 };
 
+#ifdef __linux__
+class ServiceExecutorCoroutineFixture : public unittest::Test {
+protected:
+    void setUp() override {
+        auto scOwned = ServiceContext::make();
+        setGlobalServiceContext(std::move(scOwned));
+
+        // A single worker thread, so that coroutines can only make progress by suspending.
+        _savedThreads = coroutineServiceExecutorThreads;
+        coroutineServiceExecutorThreads = 1;
+        executor = std::make_unique<ServiceExecutorCoroutine>(getGlobalServiceContext(), nullptr);
+    }
+
+    void tearDown() override {
+        coroutineServiceExecutorThreads = _savedThreads;
+    }
+
+    std::unique_ptr<ServiceExecutorCoroutine> executor;
+
+private:
+    int _savedThreads;
+};
+#endif
+
 void scheduleBasicTask(ServiceExecutor* exec, bool expectSuccess) {
     stdx::condition_variable cond;
     auto mutex = MONGO_MAKE_LATCH();
@@ -217,6 +246,47 @@ TEST_F(ServiceExecutorSynchronousFixture, ScheduleFailsBeforeStartup) {
     scheduleBasicTask(executor.get(), false);
 }
 
+#ifdef __linux__
+TEST_F(ServiceExecutorCoroutineFixture, BasicTaskRuns) {
+    ASSERT_OK(executor->start());
+    auto guard = makeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
+
+    scheduleBasicTask(executor.get(), true);
+}
+
+TEST_F(ServiceExecutorCoroutineFixture, ScheduleFailsBeforeStartup) {
+    scheduleBasicTask(executor.get(), false);
+}
+
+TEST_F(ServiceExecutorCoroutineFixture, AwaitSuspendsOnlyTheCoroutine) {
+    ASSERT_OK(executor->start());
+    auto guard = makeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
+
+    auto pf = makePromiseFuture<int>();
+    auto done = makePromiseFuture<int>();
+
+    // The first coroutine waits on a future which only the second one fulfills. Both share the
+    // one worker thread, so this completes only if await() hands the thread over.
+    ASSERT_OK(executor->schedule(
+        [&] {
+            ASSERT_TRUE(ServiceExecutorCoroutine::onCoroutine());
+            auto result = ServiceExecutorCoroutine::await(std::move(pf.future));
+            done.promise.setFromStatusWith(std::move(result));
+        },
+        ServiceExecutor::kEmptyFlags,
+        ServiceExecutorTaskName::kSSMStartSession));
+    ASSERT_OK(executor->schedule([&] { pf.promise.emplaceValue(42); },
+                                 ServiceExecutor::kEmptyFlags,
+                                 ServiceExecutorTaskName::kSSMStartSession));
+
+    ASSERT_EQ(std::move(done.future).get(), 42);
+}
+
+TEST_F(ServiceExecutorCoroutineFixture, AwaitBlocksOffCoroutine) {
+    ASSERT_FALSE(ServiceExecutorCoroutine::onCoroutine());
+    ASSERT_EQ(ServiceExecutorCoroutine::await(Future<int>::makeReady(7)).getValue(), 7);
+}
+#endif
 
 }  // namespace
 }  // namespace mongo
@@ -45,6 +45,9 @@
 #include "mongo/transport/message_compressor_manager.h"
 #include "mongo/transport/service_entry_point.h"
 #include "mongo/transport/service_executor_task_names.h"
+#ifdef __linux__
+#include "mongo/transport/service_executor_coroutine.h"
+#endif
 #include "mongo/transport/session.h"
 #include "mongo/transport/transport_layer.h"
 #include "mongo/util/assert_util.h"
@@ -307,7 +310,17 @@ void ServiceStateMachine::_sourceMessage(ThreadGuard guard) {
             return Future<Message>::makeReady(_session()->sourceMessage());
         } else {
             invariant(_transportMode == transport::Mode::kAsynchronous);
-            return _session()->asyncSourceMessage();
+            auto future = _session()->asyncSourceMessage();
+#ifdef __linux__
+            // A coroutine suspends until the message arrives, so that the rest of the state
+            // machine keeps running on its own stack rather than on the reactor's.
+            if (transport::ServiceExecutorCoroutine::onCoroutine()) {
+                MONGO_IDLE_THREAD_BLOCK;
+                return Future<Message>::makeReady(
+                    transport::ServiceExecutorCoroutine::await(std::move(future)));
+            }
+#endif
+            return future;
         }
     };
 
@@ -334,7 +347,14 @@ void ServiceStateMachine::_sinkMessage(ThreadGuard guard, Message toSink) {
             return Future<void>::makeReady(_session()->sinkMessage(std::move(toSink)));
         } else {
             invariant(_transportMode == transport::Mode::kAsynchronous);
-            return _session()->asyncSinkMessage(std::move(toSink));
+            auto future = _session()->asyncSinkMessage(std::move(toSink));
+#ifdef __linux__
+            if (transport::ServiceExecutorCoroutine::onCoroutine()) {
+                return Future<void>::makeReady(
+                    transport::ServiceExecutorCoroutine::await(std::move(future)));
+            }
+#endif
+            return future;
         }
     };
 
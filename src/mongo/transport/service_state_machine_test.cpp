@@ -43,13 +43,19 @@
 #include "mongo/transport/mock_session.h"
 #include "mongo/transport/service_entry_point.h"
 #include "mongo/transport/service_executor.h"
+#ifdef __linux__
+#include "mongo/transport/service_executor_coroutine.h"
+#include "mongo/transport/service_executor_gen.h"
+#endif
 #include "mongo/transport/service_executor_task_names.h"
 #include "mongo/transport/service_state_machine.h"
 #include "mongo/transport/transport_layer_mock.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/clock_source_mock.h"
+#include "mongo/util/future.h"
 #include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/tick_source_mock.h"
 
 namespace mongo {
@@ -847,5 +853,126 @@ TEST_F(ServiceStateMachineFixture, SSMRunsRecursively) {
     ASSERT_EQ(_ssm->state(), State::Ended);
 }
 
+#ifdef __linux__
+/**
+ * A session whose messages arrive whenever the test delivers them, so that sourcing a message
+ * suspends the coroutine which runs the SSM.
+ */
+class AsyncMockSession : public MockSession {
+public:
+    using MockSession::MockSession;
+
+    Future<Message> asyncSourceMessage(const BatonHandle& handle = nullptr) override {
+        stdx::lock_guard<Latch> lk(_mutex);
+        auto pf = makePromiseFuture<Message>();
+        _pendingSource.emplace(std::move(pf.promise));
+        _cond.notify_all();
+        return std::move(pf.future);
+    }
+
+    Future<void> asyncSinkMessage(Message message, const BatonHandle& handle = nullptr) override {
+        stdx::lock_guard<Latch> lk(_mutex);
+        ++_numSunk;
+        _cond.notify_all();
+        return Future<void>::makeReady();
+    }
+
+    /**
+     * Waits for the SSM to wait for a message.
+     */
+    void waitForSource() {
+        stdx::unique_lock<Latch> lk(_mutex);
+        _cond.wait(lk, [&] { return !!_pendingSource; });
+    }
+
+    /**
+     * Waits for the SSM to wait for a message, then hands it 'msg'.
+     */
+    void deliver(StatusWith<Message> msg) {
+        stdx::unique_lock<Latch> lk(_mutex);
+        _cond.wait(lk, [&] { return !!_pendingSource; });
+        auto promise = std::move(*_pendingSource);
+        _pendingSource = boost::none;
+        lk.unlock();
+        promise.setFromStatusWith(std::move(msg));
+    }
+
+    void waitForSinks(int numSunk) {
+        stdx::unique_lock<Latch> lk(_mutex);
+        _cond.wait(lk, [&] { return _numSunk >= numSunk; });
+    }
+
+private:
+    Mutex _mutex = MONGO_MAKE_LATCH("AsyncMockSession::_mutex");
+    stdx::condition_variable _cond;
+    boost::optional<Promise<Message>> _pendingSource;
+    int _numSunk = 0;
+};
+
+// Each SSM waits for its next message inside an IdleThreadBlock. Those don't nest, so the block
+// must go with the coroutine when it suspends rather than stay on the worker thread.
+TEST(ServiceStateMachineCoroutineTest, TwoSessionsShareOneWorker) {
+    setGlobalServiceContext(ServiceContext::make());
+    auto sc = getGlobalServiceContext();
+    sc->setServiceEntryPoint(std::make_unique<MockSEP>());
+
+    const auto savedThreads = coroutineServiceExecutorThreads;
+    coroutineServiceExecutorThreads = 1;
+    ON_BLOCK_EXIT([&] { coroutineServiceExecutorThreads = savedThreads; });
+    sc->setServiceExecutor(std::make_unique<ServiceExecutorCoroutine>(sc, nullptr));
+    ASSERT_OK(sc->getServiceExecutor()->start());
+
+    auto tl = std::make_unique<TransportLayerMock>();
+    tl->createSessionHook = [](TransportLayer* tl) {
+        return std::make_shared<AsyncMockSession>(tl);
+    };
+    auto tlPtr = tl.get();
+    sc->setTransportLayer(std::move(tl));
+    ASSERT_OK(tlPtr->start());
+
+    std::vector<std::shared_ptr<AsyncMockSession>> sessions;
+    std::vector<std::shared_ptr<ServiceStateMachine>> ssms;
+    SimpleEvent ended;
+    AtomicWord<int> numEnded{0};
+    for (int i = 0; i < 2; ++i) {
+        auto session = tlPtr->createSession();
+        sessions.push_back(std::dynamic_pointer_cast<AsyncMockSession>(session));
+        auto ssm = ServiceStateMachine::create(sc, std::move(session), Mode::kAsynchronous);
+        ssm->setCleanupHook([&] {
+            if (numEnded.addAndFetch(1) == 2) {
+                ended.signal();
+            }
+        });
+        ssm->start(ServiceStateMachine::Ownership::kOwned);
+        ssms.push_back(std::move(ssm));
+    }
+
+    // Both SSMs suspend waiting for a message before either one gets one.
+    for (auto& session : sessions) {
+        session->waitForSource();
+    }
+
+    for (int round = 1; round <= 2; ++round) {
+        for (auto& session : sessions) {
+            session->deliver(buildOpMsg(BSON("ping" << 1)));
+        }
+        for (auto& session : sessions) {
+            session->waitForSinks(round);
+        }
+    }
+
+    for (auto& session : sessions) {
+        session->deliver(TransportLayer::TicketSessionClosedStatus);
+    }
+    ended.wait();
+
+    for (auto& ssm : ssms) {
+        ASSERT_EQ(ssm->state(), State::Ended);
+    }
+    ASSERT_OK(sc->getServiceExecutor()->shutdown(Seconds(10)));
+    tlPtr->shutdown();
+}
+#endif
+
 }  // namespace
 }  // namespace mongo
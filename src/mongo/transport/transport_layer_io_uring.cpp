@@ -0,0 +1,1390 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetwork
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/transport_layer_io_uring.h"
+
+#include <deque>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <set>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+
+#include "mongo/db/server_options.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/rpc/message.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/stdx/unordered_set.h"
+#include "mongo/transport/io_uring.h"
+#include "mongo/transport/service_entry_point.h"
+#include "mongo/transport/transport_layer_io_uring_gen.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/functional.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/socket_utils.h"
+#include "mongo/util/net/ssl_options.h"
+#include "mongo/util/processinfo.h"
+
+namespace mongo {
+namespace transport {
+namespace {
+
+constexpr auto kHeaderSize = sizeof(MSGHEADER::Value);
+
+// Every ring is created with these flags. SINGLE_ISSUER also serves as the feature check: kernels
+// which accept it support multishot accept and receive.
+constexpr unsigned kRingFlags = IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_COOP_TASKRUN;
+constexpr unsigned kRingEntries = 4096;
+
+// Each I/O loop provides its ring with this many receive buffers. A buffer is only held for as
+// long as it takes to copy its contents into the message being assembled, so this bounds how many
+// receives can complete between two iterations of the loop rather than how many connections the
+// loop can serve.
+constexpr uint16_t kBufferGroupId = 0;
+constexpr uint16_t kNumBuffers = 1024;
+constexpr size_t kBufferSize = 16 * 1024;
+
+// A connection stops receiving once it has this many bytes of complete messages which haven't been
+// picked up yet, and starts again once half of them have been.
+constexpr size_t kMaxQueuedBytes = 16 * 1024 * 1024;
+
+// The user_data of submissions whose completions need no handling.
+constexpr uint64_t kIgnoredUserData = 0;
+
+const Status kCanceledStatus(ErrorCodes::CallbackCanceled, "Callback was canceled");
+const Status kTimedOutStatus(ErrorCodes::NetworkTimeout, "Socket operation timed out");
+
+Status errnoToStatus(int err) {
+    switch (err) {
+        case ECANCELED:
+            return kCanceledStatus;
+        case EAGAIN:
+        case ETIME:
+            return kTimedOutStatus;
+        case ECONNRESET:
+            return {ErrorCodes::HostUnreachable, "Connection reset by peer"};
+        case ENETRESET:
+            return {ErrorCodes::HostUnreachable, "Connection reset by network"};
+        default:
+            return {ErrorCodes::SocketException, errnoWithDescription(err)};
+    }
+}
+
+SockAddr sockAddrFromSocket(int fd, bool peer) {
+    sockaddr_storage storage;
+    socklen_t len = sizeof(storage);
+    const int ret = peer ? getpeername(fd, reinterpret_cast<sockaddr*>(&storage), &len)
+                         : getsockname(fd, reinterpret_cast<sockaddr*>(&storage), &len);
+    if (ret != 0) {
+        uasserted(ErrorCodes::SocketException, errnoWithDescription());
+    }
+    return SockAddr(storage, len);
+}
+
+}  // namespace
+
+Status validateIOUringLoopThreads(const int& value) {
+    if (value == 0) {
+        return {ErrorCodes::BadValue, "ioUringLoopThreads must be -1 or at least 1"};
+    }
+    return Status::OK();
+}
+
+/**
+ * Something in flight on a Loop's ring. The address of the Operation is the user_data of every
+ * submission made on its behalf, and complete() is called on the loop thread with each of its
+ * completions.
+ */
+class TransportLayerIOUring::Operation {
+public:
+    virtual ~Operation() = default;
+
+    virtual void complete(const io_uring_cqe& cqe) = 0;
+
+    uint64_t userData() {
+        return reinterpret_cast<uint64_t>(this);
+    }
+};
+
+/**
+ * A thread driving an IOUring. Other threads hand work to the loop with post(); the loop runs it,
+ * and then submits everything that work queued on the ring and waits for more completions in a
+ * single io_uring_enter(2). Every method other than start(), stop(), post() and the connection
+ * registry must only be called on the loop thread.
+ */
+class TransportLayerIOUring::Loop {
+    Loop(const Loop&) = delete;
+    Loop& operator=(const Loop&) = delete;
+
+public:
+    /**
+     * Tasks are run on the loop thread with an OK status, or inline with an error status if the
+     * loop has already stopped.
+     */
+    using Task = unique_function<void(Status)>;
+
+    Loop(std::string name, bool provideBuffers)
+        : _name(std::move(name)), _provideBuffers(provideBuffers) {}
+
+    ~Loop() {
+        invariant(!_thread.joinable());
+        if (_wakeFd >= 0) {
+            close(_wakeFd);
+        }
+    }
+
+    Status start() {
+        _wakeFd = eventfd(0, EFD_CLOEXEC);
+        if (_wakeFd < 0) {
+            return {ErrorCodes::SocketException,
+                    str::stream() << "Failed to create an eventfd: " << errnoWithDescription()};
+        }
+
+        // The ring must be created on the thread which will submit to it.
+        auto pf = makePromiseFuture<void>();
+        _thread = stdx::thread([this, promise = std::move(pf.promise)]() mutable {
+            _run(std::move(promise));
+        });
+        auto status = pf.future.getNoThrow();
+        if (!status.isOK()) {
+            _thread.join();
+        }
+        return status;
+    }
+
+    /**
+     * Shuts down every connection registered with the loop, waits for everything in flight on the
+     * ring to finish and then joins the loop thread.
+     */
+    void stop();
+
+    void post(Task task) {
+        {
+            stdx::unique_lock<Latch> lk(_mutex);
+            if (_stopped) {
+                lk.unlock();
+                task(TransportLayer::ShutdownStatus);
+                return;
+            }
+            _tasks.push_back(std::move(task));
+        }
+
+        // Pairs with the loop storing true to _sleeping before its final check for tasks: either
+        // the loop sees this task or this sees that the loop is about to sleep and wakes it.
+        if (_sleeping.load() && _sleeping.swap(false)) {
+            const uint64_t one = 1;
+            if (write(_wakeFd, &one, sizeof(one)) < 0) {
+                const auto ewd = errnoWithDescription();
+                severe() << "Failed to wake io_uring loop " << _name << ": " << ewd;
+                fassertFailed(4840008);
+            }
+        }
+    }
+
+    void registerConnection(Connection* conn) {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _connections.insert(conn);
+    }
+
+    void unregisterConnection(Connection* conn) {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _connections.erase(conn);
+    }
+
+    bool stopping() const {
+        return _stopping;
+    }
+
+    IOUringBufferGroup* buffers() const {
+        return _buffers.get();
+    }
+
+    /**
+     * Returns the next submission queue entry, submitting what's queued so far to make room if
+     * the ring is full. If 'linked' is true, also makes sure that there is room for one more entry
+     * after it, so that the two are submitted together.
+     */
+    io_uring_sqe* getSqe(bool linked = false) {
+        while (true) {
+            if (_ring->spaceLeft() >= (linked ? 2 : 1)) {
+                return _ring->getSqe();
+            }
+
+            fassert(4840009, _ring->submit());
+            if (_ring->spaceLeft() < (linked ? 2 : 1)) {
+                // The kernel won't take any more submissions until completions are reaped. Set
+                // them aside, to be handled once the work at hand is done.
+                _ring->reap([&](const io_uring_cqe& cqe) { _completions.push_back(cqe); });
+            }
+        }
+    }
+
+    void recycleBuffer(uint16_t bufferId) {
+        auto sqe = getSqe();
+        _buffers->prepareRecycle(sqe, bufferId);
+        sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+        sqe->user_data = kIgnoredUserData;
+    }
+
+    void cancel(uint64_t userData) {
+        auto sqe = getSqe();
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = userData;
+        sqe->flags = IOSQE_CQE_SKIP_SUCCESS;
+        sqe->user_data = kIgnoredUserData;
+    }
+
+    /**
+     * Operations call these as they arm their first submission and handle their last completion,
+     * so that the loop only exits once nothing is in flight.
+     */
+    void operationStarted() {
+        ++_numOperations;
+    }
+
+    void operationFinished() {
+        invariant(_numOperations > 0);
+        --_numOperations;
+    }
+
+private:
+    /**
+     * A read of the loop's eventfd, which completes when post() wakes the loop.
+     */
+    class WakeOperation final : public Operation {
+    public:
+        explicit WakeOperation(Loop* loop) : _loop(loop) {}
+
+        void arm() {
+            auto sqe = _loop->getSqe();
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = _loop->_wakeFd;
+            sqe->addr = reinterpret_cast<uint64_t>(&_value);
+            sqe->len = sizeof(_value);
+            sqe->user_data = userData();
+            _loop->operationStarted();
+            armed = true;
+        }
+
+        void complete(const io_uring_cqe& cqe) override {
+            armed = false;
+            _loop->operationFinished();
+            if (!_loop->_stopping) {
+                arm();
+            }
+        }
+
+        bool armed = false;
+        bool canceled = false;
+
+    private:
+        Loop* const _loop;
+        uint64_t _value = 0;
+    };
+
+    void _run(Promise<void> started) {
+        setThreadName(_name);
+
+        auto swRing = IOUring::make(kRingEntries, kRingFlags);
+        if (!swRing.isOK()) {
+            _markStopped();
+            started.setError(swRing.getStatus());
+            return;
+        }
+        _ring = std::move(swRing.getValue());
+
+        if (_provideBuffers) {
+            auto swBuffers = IOUringBufferGroup::make(kBufferGroupId, kNumBuffers, kBufferSize);
+            if (!swBuffers.isOK()) {
+                _ring.reset();
+                _markStopped();
+                started.setError(swBuffers.getStatus());
+                return;
+            }
+            _buffers = std::move(swBuffers.getValue());
+
+            auto sqe = getSqe();
+            _buffers->prepareProvideAll(sqe);
+            sqe->user_data = kIgnoredUserData;
+        }
+
+        _wakeOp.arm();
+        started.emplaceValue();
+
+        while (true) {
+            _runTasks();
+
+            if (_stopping) {
+                if (_numOperations == 1 && _wakeOp.armed && !_wakeOp.canceled) {
+                    _wakeOp.canceled = true;
+                    cancel(_wakeOp.userData());
+                }
+                if (_numOperations == 0) {
+                    break;
+                }
+            }
+
+            _sleeping.store(true);
+            bool hasTasks;
+            {
+                stdx::lock_guard<Latch> lk(_mutex);
+                hasTasks = !_tasks.empty();
+            }
+            if (hasTasks) {
+                _sleeping.store(false);
+                continue;
+            }
+
+            fassert(4840010, _ring->submit(_completions.empty() ? 1 : 0));
+            _sleeping.store(false);
+
+            _ring->reap([&](const io_uring_cqe& cqe) { _completions.push_back(cqe); });
+            // Handling a completion may set more completions aside, see getSqe().
+            for (size_t i = 0; i < _completions.size(); ++i) {
+                const auto cqe = _completions[i];
+                if (cqe.user_data == kIgnoredUserData) {
+                    if (cqe.res < 0 && cqe.res != -ENOENT && cqe.res != -EALREADY &&
+                        cqe.res != -ETIME && cqe.res != -ECANCELED) {
+                        LOG(2) << "io_uring submission on " << _name
+                               << " failed: " << errnoWithDescription(-cqe.res);
+                    }
+                    continue;
+                }
+                reinterpret_cast<Operation*>(cqe.user_data)->complete(cqe);
+            }
+            _completions.clear();
+        }
+
+        // Anything posted from here on is run inline by post().
+        _markStopped();
+        std::vector<Task> tasks;
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            tasks.swap(_tasks);
+        }
+        for (auto& task : tasks) {
+            task(TransportLayer::ShutdownStatus);
+        }
+
+        _buffers.reset();
+        _ring.reset();
+    }
+
+    void _runTasks() {
+        std::vector<Task> tasks;
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            tasks.swap(_tasks);
+        }
+        for (auto& task : tasks) {
+            task(Status::OK());
+        }
+    }
+
+    void _markStopped() {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _stopped = true;
+    }
+
+    const std::string _name;
+    const bool _provideBuffers;
+
+    int _wakeFd = -1;
+    stdx::thread _thread;
+
+    Mutex _mutex = MONGO_MAKE_LATCH("TransportLayerIOUring::Loop::_mutex");
+    std::vector<Task> _tasks;
+    stdx::unordered_set<Connection*> _connections;
+    bool _stopped = false;
+
+    // True while the loop may be about to block in the kernel, see post().
+    AtomicWord<bool> _sleeping{false};
+
+    // The rest is only used on the loop thread.
+    std::unique_ptr<IOUring> _ring;
+    std::unique_ptr<IOUringBufferGroup> _buffers;
+    std::vector<io_uring_cqe> _completions;
+    WakeOperation _wakeOp{this};
+    size_t _numOperations = 0;
+    bool _stopping = false;
+};
+
+/**
+ * The socket behind an IOUringSession, and everything in flight on it. The loop's operations hold
+ * a reference to the Connection while they are armed, so that it, and the socket, outlive the
+ * session for as long as the kernel may still complete them.
+ */
+class TransportLayerIOUring::Connection : public std::enable_shared_from_this<Connection> {
+    Connection(const Connection&) = delete;
+    Connection& operator=(const Connection&) = delete;
+
+public:
+    Connection(Loop* loop, ReactorHandle reactor, int fd)
+        : _loop(loop), _reactor(std::move(reactor)), _fd(fd) {
+        _loop->registerConnection(this);
+    }
+
+    ~Connection() {
+        _loop->unregisterConnection(this);
+        close(_fd);
+    }
+
+    int fd() const {
+        return _fd;
+    }
+
+    /**
+     * Arms the receive. Messages which arrive before the first call to sourceMessage() are queued.
+     */
+    void start() {
+        _loop->post([self = shared_from_this()](Status status) {
+            if (!status.isOK()) {
+                self->_failReceive(status);
+                return;
+            }
+            self->_armReceive();
+        });
+    }
+
+    /**
+     * Shuts the socket down, which ends whatever is in flight on it. May be called from any thread.
+     */
+    void end() {
+        if (_ended.swap(true)) {
+            return;
+        }
+        if (::shutdown(_fd, SHUT_RDWR) != 0 && errno != ENOTCONN) {
+            error() << "Error shutting down socket: " << errnoWithDescription();
+        }
+    }
+
+    StatusWith<Message> sourceMessage(boost::optional<Milliseconds> timeout) {
+        stdx::unique_lock<Latch> lk(_mutex);
+        auto hasResult = [&] { return !_queue.empty() || !_receiveStatus.isOK(); };
+        if (!timeout) {
+            _queueCv.wait(lk, hasResult);
+        } else if (!_queueCv.wait_for(lk, timeout->toSystemDuration(), hasResult)) {
+            return kTimedOutStatus;
+        }
+        return _popMessage(std::move(lk));
+    }
+
+    Future<Message> asyncSourceMessage() {
+        stdx::unique_lock<Latch> lk(_mutex);
+        if (!_queue.empty() || !_receiveStatus.isOK()) {
+            return Future<Message>::makeReady(_popMessage(std::move(lk)));
+        }
+
+        invariant(!_sourcePromise);
+        auto pf = makePromiseFuture<Message>();
+        _sourcePromise.emplace(std::move(pf.promise));
+        return std::move(pf.future);
+    }
+
+    Future<void> asyncSinkMessage(Message message, boost::optional<Milliseconds> timeout) {
+        // Write as much as the socket takes right away. A small reply almost always fits in the
+        // socket's send buffer, in which case this is the only system call it costs.
+        size_t sent = 0;
+        while (sent < message.size()) {
+            const auto ret = ::send(
+                _fd, message.buf() + sent, message.size() - sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (ret >= 0) {
+                sent += ret;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            } else if (errno != EINTR) {
+                return Future<void>::makeReady(errnoToStatus(errno));
+            }
+        }
+
+        if (sent == message.size()) {
+            networkCounter.hitPhysicalOut(message.size());
+            return Future<void>::makeReady();
+        }
+
+        auto pf = makePromiseFuture<void>();
+        _loop->post([self = shared_from_this(),
+                     message = std::move(message),
+                     sent,
+                     timeout,
+                     promise = std::move(pf.promise)](Status status) mutable {
+            if (!status.isOK()) {
+                promise.setError(status);
+                return;
+            }
+            self->_startSend(std::move(message), sent, timeout, std::move(promise));
+        });
+        return std::move(pf.future);
+    }
+
+    void cancelAsyncOperations() {
+        boost::optional<Promise<Message>> sourcePromise;
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            sourcePromise.swap(_sourcePromise);
+        }
+        if (sourcePromise) {
+            _fulfill(std::move(*sourcePromise), StatusWith<Message>(kCanceledStatus));
+        }
+
+        _loop->post([self = shared_from_this()](Status status) {
+            if (status.isOK() && self->_sendPromise) {
+                self->_sendCanceled = true;
+                self->_loop->cancel(self->_sendOp.userData());
+            }
+        });
+    }
+
+    bool isConnected() {
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            if (!_queue.empty()) {
+                return true;
+            }
+            if (!_receiveStatus.isOK()) {
+                return false;
+            }
+        }
+
+        // The receive consumes everything the peer sends, so unlike TransportLayerASIO this can't
+        // peek at the socket. Instead, look for the peer having hung up.
+        pollfd pfd = {_fd, POLLRDHUP, 0};
+        if (::poll(&pfd, 1, 0) < 0) {
+            warning() << "Failed to poll socket for connectivity check: " << errnoWithDescription();
+            return false;
+        }
+        return !(pfd.revents & (POLLRDHUP | POLLHUP | POLLERR | POLLNVAL));
+    }
+
+private:
+    class ReceiveOperation final : public Operation {
+    public:
+        explicit ReceiveOperation(Connection* conn) : _conn(conn) {}
+
+        void complete(const io_uring_cqe& cqe) override {
+            _conn->_onReceive(cqe);
+        }
+
+    private:
+        Connection* const _conn;
+    };
+
+    class SendOperation final : public Operation {
+    public:
+        explicit SendOperation(Connection* conn) : _conn(conn) {}
+
+        void complete(const io_uring_cqe& cqe) override {
+            _conn->_onSend(cqe);
+        }
+
+    private:
+        Connection* const _conn;
+    };
+
+    /**
+     * Fulfills 'promise' with 'result'. If there is a reactor, which is the case with the adaptive
+     * ServiceExecutor, that happens on one of the reactor's threads, so that the continuations of
+     * async operations, which go on to process the next request, don't run on the loop thread.
+     */
+    template <typename T, typename Result>
+    void _fulfill(Promise<T> promise, Result result) {
+        auto fulfill = [promise = std::move(promise), result = std::move(result)](Status) mutable {
+            promise.setWith([&] { return std::move(result); });
+        };
+        if (_reactor) {
+            _reactor->schedule(std::move(fulfill));
+        } else {
+            fulfill(Status::OK());
+        }
+    }
+
+    StatusWith<Message> _popMessage(stdx::unique_lock<Latch> lk) {
+        if (_queue.empty()) {
+            return _receiveStatus;
+        }
+
+        auto message = std::move(_queue.front());
+        _queue.pop_front();
+        _queuedBytes -= message.size();
+
+        const bool resume = _receivePaused && !_resumePosted && _queuedBytes <= kMaxQueuedBytes / 2;
+        _resumePosted |= resume;
+        lk.unlock();
+
+        if (resume) {
+            _loop->post([self = shared_from_this()](Status status) {
+                if (status.isOK()) {
+                    self->_resumeReceive();
+                }
+            });
+        }
+        return {std::move(message)};
+    }
+
+    // The rest is only called on the loop thread.
+
+    void _armReceive() {
+        if (_loop->stopping()) {
+            _failReceive(TransportLayer::ShutdownStatus);
+            return;
+        }
+
+        auto sqe = _loop->getSqe();
+        sqe->opcode = IORING_OP_RECV;
+        sqe->fd = _fd;
+        sqe->ioprio = IORING_RECV_MULTISHOT;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = _loop->buffers()->groupId();
+        sqe->user_data = _receiveOp.userData();
+
+        _receiveAnchor = shared_from_this();
+        _loop->operationStarted();
+    }
+
+    void _onReceive(const io_uring_cqe& cqe) {
+        if (cqe.res > 0) {
+            invariant(cqe.flags & IORING_CQE_F_BUFFER);
+            const uint16_t bufferId = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+            _consume(_loop->buffers()->data(bufferId), cqe.res);
+            _loop->recycleBuffer(bufferId);
+        }
+
+        if (cqe.flags & IORING_CQE_F_MORE) {
+            return;
+        }
+
+        // The receive is over. Unless the connection is done for, arm another one.
+        auto anchor = std::move(_receiveAnchor);
+        _loop->operationFinished();
+
+        if (cqe.res == 0) {
+            _failReceive({ErrorCodes::HostUnreachable, "Connection closed by peer"});
+        } else if (cqe.res == -ECANCELED) {
+            stdx::lock_guard<Latch> lk(_mutex);
+            if (_receivePaused) {
+                _receiveParked = true;
+                return;
+            }
+        } else if (cqe.res < 0 && cqe.res != -ENOBUFS) {
+            _failReceive(errnoToStatus(-cqe.res));
+        }
+
+        // The kernel ends a multishot receive early when it runs out of buffers (which are handed
+        // back ahead of the new receive in the same submission) or of room for completions.
+        if (!_receiveFailed) {
+            _armReceive();
+        }
+    }
+
+    void _resumeReceive() {
+        bool rearm;
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            rearm = _receiveParked;
+            _receivePaused = _receiveParked = _resumePosted = false;
+        }
+        if (rearm && !_receiveFailed) {
+            _armReceive();
+        }
+    }
+
+    /**
+     * Splits the bytes received into messages.
+     */
+    void _consume(const char* data, size_t size) {
+        while (size && !_receiveFailed) {
+            if (!_partial) {
+                const auto n = std::min(size, kHeaderSize - _headerBytes);
+                memcpy(_header + _headerBytes, data, n);
+                _headerBytes += n;
+                data += n;
+                size -= n;
+                if (_headerBytes < kHeaderSize) {
+                    return;
+                }
+
+                if (StringData(_header, 4) == "GET "_sd) {
+                    _sendHTTPResponse();
+                    return;
+                }
+
+                const auto msgLen = size_t(MSGHEADER::View(_header).getMessageLength());
+                if (msgLen < kHeaderSize || msgLen > MaxMessageSizeBytes) {
+                    StringBuilder sb;
+                    sb << "recv(): message msgLen " << msgLen << " is invalid. "
+                       << "Min " << kHeaderSize << " Max: " << MaxMessageSizeBytes;
+                    const auto str = sb.str();
+                    LOG(0) << str;
+                    _failReceive({ErrorCodes::ProtocolError, str});
+                    return;
+                }
+
+                _partial = SharedBuffer::allocate(msgLen);
+                memcpy(_partial.get(), _header, kHeaderSize);
+                _partialBytes = kHeaderSize;
+                _headerBytes = 0;
+            }
+
+            const auto msgLen = size_t(MSGHEADER::View(_partial.get()).getMessageLength());
+            const auto n = std::min(size, msgLen - _partialBytes);
+            memcpy(_partial.get() + _partialBytes, data, n);
+            _partialBytes += n;
+            data += n;
+            size -= n;
+
+            if (_partialBytes == msgLen) {
+                networkCounter.hitPhysicalIn(msgLen);
+                _deliver(Message(std::move(_partial)));
+            }
+        }
+    }
+
+    void _deliver(Message message) {
+        boost::optional<Promise<Message>> promise;
+        bool pause = false;
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            if (_sourcePromise) {
+                promise.swap(_sourcePromise);
+            } else {
+                _queuedBytes += message.size();
+                _queue.push_back(std::move(message));
+                _queueCv.notify_one();
+
+                pause = !_receivePaused && _queuedBytes > kMaxQueuedBytes;
+                _receivePaused |= pause;
+            }
+        }
+
+        if (promise) {
+            _fulfill(std::move(*promise), StatusWith<Message>(std::move(message)));
+        }
+        if (pause) {
+            _loop->cancel(_receiveOp.userData());
+        }
+    }
+
+    void _failReceive(Status status) {
+        invariant(!status.isOK());
+        _receiveFailed = true;
+
+        boost::optional<Promise<Message>> promise;
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            if (_receiveStatus.isOK()) {
+                _receiveStatus = status;
+            }
+            promise.swap(_sourcePromise);
+            _queueCv.notify_all();
+        }
+        if (promise) {
+            _fulfill(std::move(*promise), StatusWith<Message>(status));
+        }
+    }
+
+    // Sends a plain text reply to a client that's trying to use HTTP over a native MongoDB port,
+    // and fails the receive.
+    void _sendHTTPResponse() {
+        constexpr auto userMsg =
+            "It looks like you are trying to access MongoDB over HTTP"
+            " on the native driver port.\r\n"_sd;
+
+        static const std::string httpResp = str::stream() << "HTTP/1.0 200 OK\r\n"
+                                                             "Connection: close\r\n"
+                                                             "Content-Type: text/plain\r\n"
+                                                             "Content-Length: "
+                                                          << userMsg.size() << "\r\n\r\n"
+                                                          << userMsg;
+
+        // Best effort: the response is tiny, and the connection is about to be closed anyway.
+        ::send(_fd, httpResp.data(), httpResp.size(), MSG_DONTWAIT | MSG_NOSIGNAL);
+        _failReceive({ErrorCodes::ProtocolError,
+                      "Client sent an HTTP request over a native MongoDB connection"});
+    }
+
+    void _startSend(Message message,
+                    size_t sent,
+                    boost::optional<Milliseconds> timeout,
+                    Promise<void> promise) {
+        invariant(!_sendPromise);
+        _sendMessage = std::move(message);
+        _sendOffset = sent;
+        _sendTimeout = timeout;
+        _sendCanceled = false;
+        _sendPromise.emplace(std::move(promise));
+
+        _sendAnchor = shared_from_this();
+        _loop->operationStarted();
+        _armSend();
+    }
+
+    void _armSend() {
+        auto sqe = _loop->getSqe(bool(_sendTimeout));
+        sqe->opcode = IORING_OP_SEND;
+        sqe->fd = _fd;
+        sqe->addr = reinterpret_cast<uint64_t>(_sendMessage.buf() + _sendOffset);
+        sqe->len = _sendMessage.size() - _sendOffset;
+        sqe->msg_flags = MSG_NOSIGNAL;
+        sqe->user_data = _sendOp.userData();
+
+        if (_sendTimeout) {
+            // The send is canceled if it hasn't completed by the time this times out.
+            sqe->flags |= IOSQE_IO_LINK;
+            _sendTimespec.tv_sec = durationCount<Seconds>(*_sendTimeout);
+            _sendTimespec.tv_nsec =
+                durationCount<Nanoseconds>(*_sendTimeout - Seconds(_sendTimespec.tv_sec));
+
+            auto timeoutSqe = _loop->getSqe();
+            timeoutSqe->opcode = IORING_OP_LINK_TIMEOUT;
+            timeoutSqe->addr = reinterpret_cast<uint64_t>(&_sendTimespec);
+            timeoutSqe->len = 1;
+            timeoutSqe->user_data = kIgnoredUserData;
+        }
+    }
+
+    void _onSend(const io_uring_cqe& cqe) {
+        if (cqe.res > 0) {
+            _sendOffset += cqe.res;
+            if (_sendOffset < _sendMessage.size()) {
+                _armSend();
+                return;
+            }
+        }
+
+        auto anchor = std::move(_sendAnchor);
+        _loop->operationFinished();
+
+        auto promise = std::move(*_sendPromise);
+        _sendPromise.reset();
+
+        Status status = Status::OK();
+        if (cqe.res == -ECANCELED) {
+            status = (_sendTimeout && !_sendCanceled) ? kTimedOutStatus : kCanceledStatus;
+        } else if (cqe.res < 0) {
+            status = errnoToStatus(-cqe.res);
+        } else if (_sendOffset < _sendMessage.size()) {
+            status = {ErrorCodes::SocketException, "Socket closed while sending"};
+        } else {
+            networkCounter.hitPhysicalOut(_sendMessage.size());
+        }
+        _sendMessage.reset();
+
+        _fulfill(std::move(promise), status);
+    }
+
+    Loop* const _loop;
+    const ReactorHandle _reactor;
+    const int _fd;
+
+    AtomicWord<bool> _ended{false};
+
+    Mutex _mutex = MONGO_MAKE_LATCH("TransportLayerIOUring::Connection::_mutex");
+    stdx::condition_variable _queueCv;
+
+    // Complete messages which haven't been picked up yet.
+    std::deque<Message> _queue;
+    size_t _queuedBytes = 0;
+
+    // Set once the receive has failed. Messages queued before that are still handed out first.
+    Status _receiveStatus = Status::OK();
+
+    // Set while asyncSourceMessage() is waiting for a message.
+    boost::optional<Promise<Message>> _sourcePromise;
+
+    // Set by the loop when too many bytes are queued. '_receiveParked' is set once the receive has
+    // actually stopped, and '_resumePosted' once a consumer has asked the loop to start it again.
+    bool _receivePaused = false;
+    bool _receiveParked = false;
+    bool _resumePosted = false;
+
+    // The rest is only used on the loop thread.
+    ReceiveOperation _receiveOp{this};
+    std::shared_ptr<Connection> _receiveAnchor;
+    bool _receiveFailed = false;
+
+    // The message being received: its header, until that is complete, and then all of it.
+    char _header[kHeaderSize];
+    size_t _headerBytes = 0;
+    SharedBuffer _partial;
+    size_t _partialBytes = 0;
+
+    SendOperation _sendOp{this};
+    std::shared_ptr<Connection> _sendAnchor;
+    Message _sendMessage;
+    size_t _sendOffset = 0;
+    boost::optional<Milliseconds> _sendTimeout;
+    __kernel_timespec _sendTimespec;
+    bool _sendCanceled = false;
+    boost::optional<Promise<void>> _sendPromise;
+};
+
+void TransportLayerIOUring::Loop::stop() {
+    if (!_thread.joinable()) {
+        return;
+    }
+
+    post([this](Status status) {
+        if (!status.isOK()) {
+            return;
+        }
+        _stopping = true;
+        stdx::lock_guard<Latch> lk(_mutex);
+        for (auto conn : _connections) {
+            conn->end();
+        }
+    });
+    _thread.join();
+}
+
+class TransportLayerIOUring::IOUringSession final : public Session {
+    IOUringSession(const IOUringSession&) = delete;
+    IOUringSession& operator=(const IOUringSession&) = delete;
+
+public:
+    IOUringSession(TransportLayerIOUring* tl, std::shared_ptr<Connection> conn)
+        : _tl(tl), _conn(std::move(conn)) {
+        const int fd = _conn->fd();
+        _localAddr = sockAddrFromSocket(fd, false);
+        _remoteAddr = sockAddrFromSocket(fd, true);
+
+        const auto family = _localAddr.getType();
+        if (family == AF_INET || family == AF_INET6) {
+            const int on = 1;
+            if (setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)) != 0 ||
+                setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on)) != 0) {
+                uasserted(ErrorCodes::SocketException, errnoWithDescription());
+            }
+            setSocketKeepAliveParams(fd);
+        }
+
+        _local = HostAndPort(_localAddr.toString(true));
+        _remote = HostAndPort(_remoteAddr.toString(true));
+    }
+
+    ~IOUringSession() {
+        end();
+    }
+
+    TransportLayer* getTransportLayer() const override {
+        return _tl;
+    }
+
+    const HostAndPort& remote() const override {
+        return _remote;
+    }
+
+    const HostAndPort& local() const override {
+        return _local;
+    }
+
+    const SockAddr& remoteAddr() const override {
+        return _remoteAddr;
+    }
+
+    const SockAddr& localAddr() const override {
+        return _localAddr;
+    }
+
+    void end() override {
+        _conn->end();
+    }
+
+    StatusWith<Message> sourceMessage() override {
+        return _conn->sourceMessage(_timeout);
+    }
+
+    Future<Message> asyncSourceMessage(const BatonHandle& baton = nullptr) override {
+        // As with TransportLayerASIO, timeouts only apply to synchronous operations.
+        invariant(!_timeout);
+        return _conn->asyncSourceMessage();
+    }
+
+    Status sinkMessage(Message message) override {
+        return _conn->asyncSinkMessage(std::move(message), _timeout).getNoThrow();
+    }
+
+    Future<void> asyncSinkMessage(Message message, const BatonHandle& baton = nullptr) override {
+        invariant(!_timeout);
+        return _conn->asyncSinkMessage(std::move(message), boost::none);
+    }
+
+    void cancelAsyncOperations(const BatonHandle& baton = nullptr) override {
+        LOG(3) << "Cancelling outstanding I/O operations on connection to " << _remote;
+        _conn->cancelAsyncOperations();
+    }
+
+    void setTimeout(boost::optional<Milliseconds> timeout) override {
+        invariant(!timeout || timeout->count() > 0);
+        _timeout = timeout;
+    }
+
+    bool isConnected() override {
+        return _conn->isConnected();
+    }
+
+private:
+    TransportLayerIOUring* const _tl;
+    const std::shared_ptr<Connection> _conn;
+
+    HostAndPort _remote;
+    HostAndPort _local;
+    SockAddr _remoteAddr;
+    SockAddr _localAddr;
+
+    boost::optional<Milliseconds> _timeout;
+};
+
+/**
+ * A listening socket and the multishot accept armed on it.
+ */
+class TransportLayerIOUring::Listener final : public Operation {
+    Listener(const Listener&) = delete;
+    Listener& operator=(const Listener&) = delete;
+
+public:
+    Listener(TransportLayerIOUring* tl, SockAddr addr, int fd)
+        : _tl(tl), _addr(std::move(addr)), _fd(fd) {}
+
+    ~Listener() {
+        close(_fd);
+    }
+
+    const SockAddr& addr() const {
+        return _addr;
+    }
+
+    int fd() const {
+        return _fd;
+    }
+
+    void arm(Loop* loop) {
+        _loop = loop;
+        auto sqe = _loop->getSqe();
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = _fd;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->accept_flags = SOCK_CLOEXEC;
+        sqe->user_data = userData();
+        _loop->operationStarted();
+    }
+
+    void cancel() {
+        _canceled = true;
+        _loop->cancel(userData());
+    }
+
+    void complete(const io_uring_cqe& cqe) override {
+        if (cqe.res >= 0) {
+            _tl->_onAccept(cqe.res);
+        } else if (cqe.res != -ECANCELED) {
+            log() << "Error accepting new connection on " << _addr.toString()
+                  << ": " << errnoWithDescription(-cqe.res);
+        }
+
+        if (!(cqe.flags & IORING_CQE_F_MORE)) {
+            _loop->operationFinished();
+            if (!_canceled) {
+                arm(_loop);
+            }
+        }
+    }
+
+private:
+    TransportLayerIOUring* const _tl;
+    const SockAddr _addr;
+    const int _fd;
+
+    // Only used on the listener thread.
+    Loop* _loop = nullptr;
+    bool _canceled = false;
+};
+
+TransportLayerIOUring::TransportLayerIOUring(const Options& opts,
+                                             ServiceEntryPoint* sep,
+                                             ReactorHandle reactor)
+    : _options(opts), _sep(sep), _reactor(std::move(reactor)) {
+    invariant(_options.isIngress());
+}
+
+TransportLayerIOUring::~TransportLayerIOUring() {
+    shutdown();
+    for (auto&& loop : _loops) {
+        loop->stop();
+    }
+}
+
+Status TransportLayerIOUring::checkSupported() {
+#ifdef MONGO_CONFIG_SSL
+    if (sslGlobalParams.sslMode.load() != SSLParams::SSLMode_disabled) {
+        return {ErrorCodes::InvalidOptions, "The io_uring transport layer does not support TLS"};
+    }
+#endif
+
+    auto swRing = IOUring::make(8, kRingFlags);
+    if (!swRing.isOK()) {
+        return swRing.getStatus().withContext("io_uring is not available");
+    }
+
+    if (!swRing.getValue()->supportsOpcodes({IORING_OP_ACCEPT,
+                                              IORING_OP_RECV,
+                                              IORING_OP_SEND,
+                                              IORING_OP_READ,
+                                              IORING_OP_ASYNC_CANCEL,
+                                              IORING_OP_LINK_TIMEOUT,
+                                              IORING_OP_PROVIDE_BUFFERS})) {
+        return {ErrorCodes::InvalidOptions,
+                "io_uring on this kernel lacks operations required by the transport layer"};
+    }
+
+    return Status::OK();
+}
+
+StatusWith<SessionHandle> TransportLayerIOUring::connect(HostAndPort peer,
+                                                         ConnectSSLMode sslMode,
+                                                         Milliseconds timeout) {
+    return {ErrorCodes::IllegalOperation,
+            "The io_uring transport layer does not support egress connections"};
+}
+
+Future<SessionHandle> TransportLayerIOUring::asyncConnect(HostAndPort peer,
+                                                          ConnectSSLMode sslMode,
+                                                          const ReactorHandle& reactor,
+                                                          Milliseconds timeout) {
+    return Status(ErrorCodes::IllegalOperation,
+                  "The io_uring transport layer does not support egress connections");
+}
+
+ReactorHandle TransportLayerIOUring::getReactor(WhichReactor which) {
+    return nullptr;
+}
+
+Status TransportLayerIOUring::setup() {
+    std::vector<std::string> listenAddrs;
+    if (_options.ipList.empty()) {
+        listenAddrs = {"127.0.0.1"};
+        if (_options.enableIPv6) {
+            listenAddrs.emplace_back("::1");
+        }
+    } else {
+        listenAddrs = _options.ipList;
+    }
+
+    if (_options.useUnixSockets) {
+        listenAddrs.emplace_back(makeUnixSockPath(_options.port));
+    }
+
+    _listenerPort = _options.port;
+
+    // Self-deduplicating list of unique endpoint addresses.
+    std::set<SockAddr> addrs;
+    for (auto& ip : listenAddrs) {
+        if (ip.empty()) {
+            warning() << "Skipping empty bind address";
+            continue;
+        }
+
+        auto resolved =
+            SockAddr::createAll(ip, _listenerPort, _options.enableIPv6 ? AF_UNSPEC : AF_INET);
+        if (resolved.empty()) {
+            warning() << "Found no addresses for " << ip;
+            continue;
+        }
+        addrs.insert(resolved.begin(), resolved.end());
+    }
+
+    for (auto& addr : addrs) {
+        const auto family = addr.getType();
+        if (family == AF_UNIX) {
+            if (::unlink(addr.toString().c_str()) == -1 && errno != ENOENT) {
+                return {ErrorCodes::SocketException,
+                        str::stream() << "Failed to unlink socket file " << addr.toString() << " "
+                                      << errnoWithDescription()};
+            }
+        }
+        if (family == AF_INET6 && !_options.enableIPv6) {
+            return {ErrorCodes::BadValue, "Specified ipv6 bind address, but ipv6 is disabled"};
+        }
+
+        const int fd = ::socket(family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return {ErrorCodes::SocketException, errnoWithDescription()};
+        }
+        auto listener = std::make_unique<Listener>(this, addr, fd);
+
+        const int on = 1;
+        if (family != AF_UNIX &&
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0) {
+            return {ErrorCodes::SocketException, errnoWithDescription()};
+        }
+        if (family == AF_INET6 &&
+            ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &on, sizeof(on)) != 0) {
+            return {ErrorCodes::SocketException, errnoWithDescription()};
+        }
+
+        if (::bind(fd, addr.raw(), addr.addressSize) != 0) {
+            return {ErrorCodes::SocketException,
+                    str::stream() << "Failed to bind to " << addr.toString() << ": "
+                                  << errnoWithDescription()};
+        }
+
+        if (family == AF_UNIX &&
+            ::chmod(addr.toString().c_str(), serverGlobalParams.unixSocketPermissions) == -1) {
+            return {ErrorCodes::SocketException,
+                    str::stream() << "Failed to chmod socket file " << addr.toString() << " "
+                                  << errnoWithDescription()};
+        }
+
+        if (_options.port == 0 && (family == AF_INET || family == AF_INET6)) {
+            if (_listenerPort != _options.port) {
+                return Status(ErrorCodes::BadValue,
+                              "Port 0 (ephemeral port) is not allowed when"
+                              " listening on multiple IP interfaces");
+            }
+            try {
+                _listenerPort = sockAddrFromSocket(fd, false).getPort();
+            } catch (const DBException& ex) {
+                return ex.toStatus();
+            }
+        }
+
+        _listeners.push_back(std::move(listener));
+    }
+
+    if (_listeners.empty()) {
+        return Status(ErrorCodes::SocketException, "No available addresses/ports to bind to");
+    }
+
+    return Status::OK();
+}
+
+Status TransportLayerIOUring::start() {
+    stdx::lock_guard<Latch> lk(_mutex);
+
+    auto numLoops = ioUringLoopThreads;
+    if (numLoops == -1) {
+        numLoops = std::max(1, static_cast<int>(ProcessInfo::getNumCores() / 4));
+    }
+    for (int i = 0; i < numLoops; ++i) {
+        auto loop = std::make_unique<Loop>(str::stream() << "iouring-" << i, true);
+        auto status = loop->start();
+        if (!status.isOK()) {
+            return status;
+        }
+        _loops.push_back(std::move(loop));
+    }
+
+    for (auto& listener : _listeners) {
+        if (::listen(listener->fd(), serverGlobalParams.listenBacklog) != 0) {
+            const auto ewd = errnoWithDescription();
+            severe() << "Error listening for new connections on " << listener->addr().toString()
+                     << ": " << ewd;
+            fassertFailed(4840011);
+        }
+    }
+
+    _listenerLoop = std::make_unique<Loop>("listener", false);
+    auto status = _listenerLoop->start();
+    if (!status.isOK()) {
+        return status;
+    }
+
+    _running = true;
+    _listenerLoop->post([this](Status status) {
+        if (!status.isOK()) {
+            return;
+        }
+        for (auto& listener : _listeners) {
+            listener->arm(_listenerLoop.get());
+            log() << "Listening on " << listener->addr().getAddr();
+        }
+    });
+
+    log() << "waiting for connections on port " << _listenerPort << " (io_uring, " << numLoops
+          << " I/O threads)";
+    return Status::OK();
+}
+
+void TransportLayerIOUring::shutdown() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (!_running) {
+        return;
+    }
+    _running = false;
+
+    // Stop accepting new connections. Connections which are already open are served until the
+    // transport layer is destroyed, so that the ServiceEntryPoint can drain them.
+    _listenerLoop->post([this](Status status) {
+        if (!status.isOK()) {
+            return;
+        }
+        for (auto& listener : _listeners) {
+            listener->cancel();
+        }
+    });
+    _listenerLoop->stop();
+
+    for (auto& listener : _listeners) {
+        auto& addr = listener->addr();
+        if (addr.getType() == AF_UNIX && !addr.isAnonymousUNIXSocket()) {
+            auto path = addr.getAddr();
+            log() << "removing socket file: " << path;
+            if (::unlink(path.c_str()) != 0) {
+                const auto ewd = errnoWithDescription();
+                warning() << "Unable to remove UNIX socket " << path << ": " << ewd;
+            }
+        }
+    }
+    _listeners.clear();
+}
+
+void TransportLayerIOUring::_onAccept(int fd) {
+    auto loop = _loops[_nextLoop++ % _loops.size()].get();
+    // The Connection owns the socket from here on, and closes it if anything below fails.
+    auto conn = std::make_shared<Connection>(loop, _reactor, fd);
+
+    try {
+        auto session = std::make_shared<IOUringSession>(this, conn);
+        conn->start();
+        _sep->startSession(std::move(session));
+    } catch (const DBException& e) {
+        warning() << "Error accepting new connection " << e;
+    }
+}
+
+}  // namespace transport
+}  // namespace mongo
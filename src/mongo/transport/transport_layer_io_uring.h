@@ -0,0 +1,144 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "mongo/platform/mutex.h"
+#include "mongo/transport/transport_layer.h"
+#include "mongo/transport/transport_layer_asio.h"
+
+namespace mongo {
+
+class ServiceEntryPoint;
+
+namespace transport {
+
+/**
+ * Validation callback for setParameter 'ioUringLoopThreads', which must be -1 or at least 1.
+ */
+Status validateIOUringLoopThreads(const int& value);
+
+/**
+ * An ingress-only TransportLayer for Linux, built on io_uring.
+ *
+ * Each listening socket has a single multishot accept armed on a ring driven by a listener
+ * thread. Accepted connections are spread round-robin across a small, fixed number of I/O loops,
+ * each of which is a thread driving its own ring. A connection keeps one multishot receive armed
+ * for its whole lifetime, and the kernel fills it from a group of buffers provided to the loop's
+ * ring, so idle connections pin no receive buffer of their own and reading a request costs no
+ * system call on the thread which serves the connection: the loop reassembles whole messages and
+ * queues them on the session until sourceMessage() or asyncSourceMessage() picks them up. Replies
+ * are written straight to the socket when it has room for them, which is almost always the case
+ * for small replies, and are otherwise handed to the loop as a send. A loop hands all of the
+ * submissions which accumulated since it last went to sleep to the kernel, and waits for the next
+ * completions, with a single io_uring_enter(2).
+ *
+ * Sessions work with both the synchronous and the adaptive ServiceExecutor. TLS and egress
+ * networking are not supported: TransportLayerManager::createWithConfig() pairs this transport
+ * layer with an egress-only TransportLayerASIO.
+ */
+class TransportLayerIOUring final : public TransportLayer {
+public:
+    /**
+     * Only the ingress-related options are used.
+     */
+    using Options = TransportLayerASIO::Options;
+
+    /**
+     * If 'reactor' is set, async operations complete on it rather than on the I/O loop threads.
+     * It must be set when sessions are driven by the adaptive ServiceExecutor, which expects to
+     * run everything on the threads that run its reactor.
+     */
+    TransportLayerIOUring(const Options& opts,
+                          ServiceEntryPoint* sep,
+                          ReactorHandle reactor = nullptr);
+
+    ~TransportLayerIOUring() override;
+
+    /**
+     * Returns OK if both the kernel and the server's configuration allow this transport layer to be
+     * used, and otherwise an error saying why not.
+     */
+    static Status checkSupported();
+
+    StatusWith<SessionHandle> connect(HostAndPort peer,
+                                      ConnectSSLMode sslMode,
+                                      Milliseconds timeout) override;
+
+    Future<SessionHandle> asyncConnect(HostAndPort peer,
+                                       ConnectSSLMode sslMode,
+                                       const ReactorHandle& reactor,
+                                       Milliseconds timeout) override;
+
+    Status setup() override;
+    Status start() override;
+    void shutdown() override;
+
+    /**
+     * This transport layer has no Reactor: it always returns null.
+     */
+    ReactorHandle getReactor(WhichReactor which) override;
+
+    int listenerPort() const {
+        return _listenerPort;
+    }
+
+private:
+    class Loop;
+    class Operation;
+    class Connection;
+    class Listener;
+    class IOUringSession;
+
+    // Called on the listener thread with each newly accepted socket.
+    void _onAccept(int fd);
+
+    const Options _options;
+    ServiceEntryPoint* const _sep;
+    const ReactorHandle _reactor;
+
+    int _listenerPort = 0;
+
+    Mutex _mutex = MONGO_MAKE_LATCH("TransportLayerIOUring::_mutex");
+    bool _running = false;
+
+    std::vector<std::unique_ptr<Listener>> _listeners;
+    std::unique_ptr<Loop> _listenerLoop;
+    std::vector<std::unique_ptr<Loop>> _loops;
+
+    // Only used on the listener thread.
+    size_t _nextLoop = 0;
+};
+
+}  // namespace transport
+}  // namespace mongo
@@ -0,0 +1,300 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+
+#include "mongo/db/server_options.h"
+#include "mongo/rpc/op_msg.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/transport/service_entry_point.h"
+#include "mongo/transport/transport_layer_asio.h"
+#include "mongo/transport/transport_layer_io_uring.h"
+#include "mongo/util/assert_util.h"
+
+namespace mongo {
+namespace {
+
+constexpr size_t kNumClientThreads = 8;
+
+/**
+ * Answers every request with a small {ok: 1} reply, on a thread per session as the synchronous
+ * ServiceExecutor does, so that the benchmark measures the transport layer rather than command
+ * execution.
+ */
+class ReplyServiceEntryPoint : public ServiceEntryPoint {
+public:
+    ~ReplyServiceEntryPoint() override {
+        shutdown(Milliseconds::max());
+    }
+
+    void startSession(transport::SessionHandle session) override {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _sessions.push_back(session);
+        _threads.emplace_back([session = std::move(session)] {
+            const auto body = BSON("ok" << 1);
+            while (true) {
+                auto swMsg = session->sourceMessage();
+                if (!swMsg.isOK()) {
+                    break;
+                }
+                auto reply = OpMsg{body}.serialize();
+                reply.header().setId(nextMessageId());
+                reply.header().setResponseToMsgId(swMsg.getValue().header().getId());
+                if (!session->sinkMessage(std::move(reply)).isOK()) {
+                    break;
+                }
+            }
+        });
+    }
+
+    void endAllSessions(transport::Session::TagMask tags) override {
+        std::vector<transport::SessionHandle> sessions;
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            sessions.swap(_sessions);
+        }
+        for (auto& session : sessions) {
+            session->end();
+        }
+    }
+
+    Status start() override {
+        return Status::OK();
+    }
+
+    bool shutdown(Milliseconds timeout) override {
+        endAllSessions({});
+        std::vector<stdx::thread> threads;
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            threads.swap(_threads);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        return true;
+    }
+
+    void appendStats(BSONObjBuilder*) const override {}
+
+    size_t numOpenSessions() const override {
+        stdx::lock_guard<Latch> lk(_mutex);
+        return _sessions.size();
+    }
+
+    DbResponse handleRequest(OperationContext* opCtx, const Message& request) override {
+        MONGO_UNREACHABLE;
+    }
+
+private:
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("ReplyServiceEntryPoint::_mutex");
+    std::vector<transport::SessionHandle> _sessions;
+    std::vector<stdx::thread> _threads;
+};
+
+enum class Op { kFind, kInsert };
+
+Message makeRequest(Op op) {
+    auto body = op == Op::kFind
+        ? BSON("find"
+               << "coll"
+               << "filter" << BSON("_id" << 1) << "limit" << 1 << "singleBatch" << true)
+        : BSON("insert"
+               << "coll"
+               << "documents" << BSON_ARRAY(BSON("_id" << 1 << "x" << std::string(64, 'x'))));
+    return OpMsgRequest::fromDBAndBody("test", std::move(body)).serialize();
+}
+
+void sendAll(int fd, const char* data, size_t size) {
+    while (size) {
+        const auto ret = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        invariant(ret > 0);
+        data += ret;
+        size -= ret;
+    }
+}
+
+void recvAll(int fd, char* data, size_t size) {
+    while (size) {
+        const auto ret = ::recv(fd, data, size, 0);
+        if (ret < 0 && errno == EINTR) {
+            continue;
+        }
+        invariant(ret > 0);
+        data += ret;
+        size -= ret;
+    }
+}
+
+int connectTo(int port) {
+    const int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    invariant(fd >= 0);
+    const int on = 1;
+    invariant(::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on)) == 0);
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    invariant(::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+    return fd;
+}
+
+/**
+ * Raises the soft limit on open files so that both ends of 'numConnections' connections fit.
+ */
+bool ensureFileLimit(size_t numConnections) {
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        return false;
+    }
+    const rlim_t needed = 2 * numConnections + 1024;
+    if (limit.rlim_cur >= needed) {
+        return true;
+    }
+    if (limit.rlim_max < needed) {
+        return false;
+    }
+    limit.rlim_cur = needed;
+    return setrlimit(RLIMIT_NOFILE, &limit) == 0;
+}
+
+std::unique_ptr<transport::TransportLayer> makeTransportLayer(
+    const transport::TransportLayerASIO::Options& opts, ServiceEntryPoint* sep, bool ioUring) {
+    if (ioUring) {
+        return std::make_unique<transport::TransportLayerIOUring>(opts, sep);
+    }
+    return std::make_unique<transport::TransportLayerASIO>(opts, sep);
+}
+
+int listenerPort(transport::TransportLayer* tl, bool ioUring) {
+    return ioUring ? static_cast<transport::TransportLayerIOUring*>(tl)->listenerPort()
+                   : static_cast<transport::TransportLayerASIO*>(tl)->listenerPort();
+}
+
+/**
+ * Opens state.range(1) connections and, on every iteration, sends one small find or insert on each
+ * of them, spread across a few client threads, and waits for all of the replies. Each iteration
+ * therefore costs the server one receive and one send per connection, which is where the time goes
+ * with this many mostly idle connections and requests this small.
+ */
+void BM_SmallOpRoundTrips(benchmark::State& state, bool ioUring) {
+    const auto op = static_cast<Op>(state.range(0));
+    const auto numConnections = static_cast<size_t>(state.range(1));
+    state.SetLabel(op == Op::kFind ? "find" : "insert");
+
+    if (ioUring) {
+        auto status = transport::TransportLayerIOUring::checkSupported();
+        if (!status.isOK()) {
+            state.SkipWithError(status.reason().c_str());
+            return;
+        }
+    }
+    if (!ensureFileLimit(numConnections)) {
+        state.SkipWithError("Not allowed to open enough files for this many connections");
+        return;
+    }
+
+    ServerGlobalParams params;
+    params.noUnixSocket = true;
+    transport::TransportLayerASIO::Options opts(&params);
+    opts.mode = transport::TransportLayerASIO::Options::kIngress;
+    opts.port = 0;
+
+    ReplyServiceEntryPoint sep;
+    auto tl = makeTransportLayer(opts, &sep, ioUring);
+    invariant(tl->setup());
+    invariant(tl->start());
+    const int port = listenerPort(tl.get(), ioUring);
+
+    std::vector<int> fds;
+    fds.reserve(numConnections);
+    for (size_t i = 0; i < numConnections; ++i) {
+        fds.push_back(connectTo(port));
+    }
+
+    const auto request = makeRequest(op);
+    auto roundTrip = [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            sendAll(fds[i], request.buf(), request.size());
+        }
+
+        std::vector<char> reply;
+        for (size_t i = first; i < last; ++i) {
+            constexpr auto kHeaderSize = sizeof(MSGHEADER::Value);
+            reply.resize(kHeaderSize);
+            recvAll(fds[i], reply.data(), kHeaderSize);
+            const auto len = size_t(MSGHEADER::View(reply.data()).getMessageLength());
+            reply.resize(len);
+            recvAll(fds[i], reply.data() + kHeaderSize, len - kHeaderSize);
+        }
+    };
+
+    const auto perThread = (numConnections + kNumClientThreads - 1) / kNumClientThreads;
+    for (auto _ : state) {
+        std::vector<stdx::thread> clients;
+        for (size_t first = 0; first < numConnections; first += perThread) {
+            clients.emplace_back(roundTrip, first, std::min(first + perThread, numConnections));
+        }
+        for (auto& client : clients) {
+            client.join();
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * numConnections);
+
+    for (auto fd : fds) {
+        ::close(fd);
+    }
+    tl->shutdown();
+    sep.shutdown(Milliseconds::max());
+}
+
+void connectionCounts(benchmark::internal::Benchmark* b) {
+    for (auto op : {Op::kFind, Op::kInsert}) {
+        for (auto numConnections : {1000, 10000, 20000}) {
+            b->Args({static_cast<int>(op), numConnections});
+        }
+    }
+}
+
+BENCHMARK_CAPTURE(BM_SmallOpRoundTrips, asio, false)->Apply(connectionCounts)->UseRealTime();
+BENCHMARK_CAPTURE(BM_SmallOpRoundTrips, iouring, true)->Apply(connectionCounts)->UseRealTime();
+
+}  // namespace
+}  // namespace mongo
@@ -0,0 +1,240 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/transport_layer_io_uring.h"
+
+#include "mongo/db/server_options.h"
+#include "mongo/rpc/op_msg.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/transport/service_entry_point.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/sock.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Echoes every message it receives on a session back to the client, on a thread per session, and
+ * records the status that ended each session.
+ */
+class EchoServiceEntryPoint : public ServiceEntryPoint {
+public:
+    ~EchoServiceEntryPoint() override {
+        shutdown(Milliseconds::max());
+    }
+
+    void startSession(transport::SessionHandle session) override {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _threads.emplace_back([this, session = std::move(session)] {
+            Status status = Status::OK();
+            while (true) {
+                auto swMsg = session->sourceMessage();
+                if (!swMsg.isOK()) {
+                    status = swMsg.getStatus();
+                    break;
+                }
+                status = session->sinkMessage(swMsg.getValue());
+                if (!status.isOK()) {
+                    break;
+                }
+            }
+            session->end();
+
+            stdx::lock_guard<Latch> lk(_mutex);
+            _endStatuses.push_back(status);
+            _cv.notify_all();
+        });
+    }
+
+    void endAllSessions(transport::Session::TagMask tags) override {
+        MONGO_UNREACHABLE;
+    }
+
+    Status start() override {
+        return Status::OK();
+    }
+
+    bool shutdown(Milliseconds timeout) override {
+        std::vector<stdx::thread> threads;
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            threads.swap(_threads);
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        return true;
+    }
+
+    void appendStats(BSONObjBuilder*) const override {}
+
+    size_t numOpenSessions() const override {
+        return 0;
+    }
+
+    DbResponse handleRequest(OperationContext* opCtx, const Message& request) override {
+        MONGO_UNREACHABLE;
+    }
+
+    Status waitForSessionEnd() {
+        stdx::unique_lock<Latch> lk(_mutex);
+        _cv.wait(lk, [&] { return !_endStatuses.empty(); });
+        return _endStatuses.front();
+    }
+
+private:
+    Mutex _mutex = MONGO_MAKE_LATCH("EchoServiceEntryPoint::_mutex");
+    stdx::condition_variable _cv;
+    std::vector<stdx::thread> _threads;
+    std::vector<Status> _endStatuses;
+};
+
+class TransportLayerIOUringTest : public unittest::Test {
+public:
+    void setUp() override {
+        auto status = transport::TransportLayerIOUring::checkSupported();
+        if (!status.isOK()) {
+            log() << "Skipping test, io_uring transport layer is not supported: " << status;
+            return;
+        }
+
+        ServerGlobalParams params;
+        params.noUnixSocket = true;
+        transport::TransportLayerIOUring::Options opts(&params);
+        opts.port = 0;
+
+        _tl = std::make_unique<transport::TransportLayerIOUring>(opts, &_sep);
+        ASSERT_OK(_tl->setup());
+        ASSERT_OK(_tl->start());
+        ASSERT_GT(_tl->listenerPort(), 0);
+    }
+
+    void tearDown() override {
+        if (_tl) {
+            _tl->shutdown();
+        }
+    }
+
+    bool supported() const {
+        return bool(_tl);
+    }
+
+    std::unique_ptr<Socket> connect() {
+        auto socket = std::make_unique<Socket>();
+        SockAddr sa{"localhost", _tl->listenerPort(), AF_INET};
+        ASSERT_TRUE(socket->connect(sa));
+        return socket;
+    }
+
+    EchoServiceEntryPoint& sep() {
+        return _sep;
+    }
+
+private:
+    EchoServiceEntryPoint _sep;
+    std::unique_ptr<transport::TransportLayerIOUring> _tl;
+};
+
+TEST_F(TransportLayerIOUringTest, EchoRoundTrip) {
+    if (!supported()) {
+        return;
+    }
+
+    auto socket = connect();
+    for (int i = 0; i < 10; ++i) {
+        auto request =
+            OpMsgRequest::fromDBAndBody("test", BSON("ping" << 1 << "i" << i)).serialize();
+        socket->send(request.buf(), request.size(), "echo request");
+
+        std::vector<char> reply(request.size());
+        socket->recv(reply.data(), reply.size());
+        ASSERT_EQ(0, memcmp(reply.data(), request.buf(), reply.size()));
+    }
+}
+
+TEST_F(TransportLayerIOUringTest, LargeMessageSpanningBuffers) {
+    if (!supported()) {
+        return;
+    }
+
+    auto socket = connect();
+    auto request =
+        OpMsgRequest::fromDBAndBody("test", BSON("data" << std::string(1024 * 1024, 'x')))
+            .serialize();
+    socket->send(request.buf(), request.size(), "large request");
+
+    std::vector<char> reply(request.size());
+    socket->recv(reply.data(), reply.size());
+    ASSERT_EQ(0, memcmp(reply.data(), request.buf(), reply.size()));
+}
+
+TEST_F(TransportLayerIOUringTest, PeerCloseEndsSession) {
+    if (!supported()) {
+        return;
+    }
+
+    connect()->close();
+    ASSERT_EQ(sep().waitForSessionEnd(), ErrorCodes::HostUnreachable);
+}
+
+TEST_F(TransportLayerIOUringTest, InvalidMessageLengthEndsSession) {
+    if (!supported()) {
+        return;
+    }
+
+    auto socket = connect();
+    std::vector<char> buf(MsgData::MsgDataHeaderSize);
+    MsgData::View(buf.data()).setLen(3);
+    socket->send(buf.data(), buf.size(), "invalid request");
+    ASSERT_EQ(sep().waitForSessionEnd(), ErrorCodes::ProtocolError);
+}
+
+TEST_F(TransportLayerIOUringTest, HttpRequestGetsHttpResponse) {
+    if (!supported()) {
+        return;
+    }
+
+    auto socket = connect();
+    constexpr auto request = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n"_sd;
+    socket->send(request.rawData(), request.size(), "http request");
+
+    constexpr auto expected = "HTTP/1.0 200 OK"_sd;
+    std::vector<char> reply(expected.size());
+    socket->recv(reply.data(), reply.size());
+    ASSERT_EQ(StringData(reply.data(), reply.size()), expected);
+    ASSERT_EQ(sep().waitForSessionEnd(), ErrorCodes::ProtocolError);
+}
+
+}  // namespace
+}  // namespace mongo
@@ -27,6 +27,8 @@
  *    it in the license file.
  */
 
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetwork
+
 #include "mongo/platform/basic.h"
 
 #include "mongo/transport/transport_layer_manager.h"
@@ -36,12 +38,20 @@
 #include <memory>
 
 #include "mongo/base/status.h"
+#include "mongo/config.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/service_context.h"
 #include "mongo/transport/service_executor_adaptive.h"
+#ifdef __linux__
+#include "mongo/transport/service_executor_coroutine.h"
+#endif
 #include "mongo/transport/service_executor_synchronous.h"
 #include "mongo/transport/session.h"
 #include "mongo/transport/transport_layer_asio.h"
+#ifdef MONGO_CONFIG_IO_URING
+#include "mongo/transport/transport_layer_io_uring.h"
+#endif
+#include "mongo/util/log.h"
 #include "mongo/util/net/ssl_types.h"
 #include "mongo/util/time_support.h"
 
@@ -134,7 +144,7 @@ std::unique_ptr<TransportLayer> TransportLayerManager::createWithConfig(
     auto sep = ctx->getServiceEntryPoint();
 
     transport::TransportLayerASIO::Options opts(config);
-    if (config->serviceExecutor == "adaptive") {
+    if (config->serviceExecutor == "adaptive" || config->serviceExecutor == "coroutine") {
         opts.transportMode = transport::Mode::kAsynchronous;
     } else if (config->serviceExecutor == "synchronous") {
         opts.transportMode = transport::Mode::kSynchronous;
@@ -142,18 +152,55 @@ std::unique_ptr<TransportLayer> TransportLayerManager::createWithConfig(
         MONGO_UNREACHABLE;
     }
 
-    auto transportLayerASIO = std::make_unique<transport::TransportLayerASIO>(opts, sep);
+    bool useIOUring = false;
+#ifdef MONGO_CONFIG_IO_URING
+    if (config->transportLayer == "iouring") {
+        auto status = TransportLayerIOUring::checkSupported();
+        if (status.isOK()) {
+            useIOUring = true;
+        } else {
+            warning() << "Not using the io_uring transport layer, falling back to asio: "
+                      << status;
+        }
+    }
+#endif
+
+    // When io_uring serves ingress connections, asio is only used for egress.
+    auto asioOpts = opts;
+    if (useIOUring) {
+        asioOpts.mode = transport::TransportLayerASIO::Options::kEgress;
+        asioOpts.ipList.clear();
+    }
+    auto transportLayerASIO =
+        std::make_unique<transport::TransportLayerASIO>(asioOpts, useIOUring ? nullptr : sep);
 
+    ReactorHandle ingressReactor;
     if (config->serviceExecutor == "adaptive") {
-        auto reactor = transportLayerASIO->getReactor(TransportLayer::kIngress);
-        ctx->setServiceExecutor(std::make_unique<ServiceExecutorAdaptive>(ctx, std::move(reactor)));
+        ingressReactor = transportLayerASIO->getReactor(TransportLayer::kIngress);
+        ctx->setServiceExecutor(std::make_unique<ServiceExecutorAdaptive>(ctx, ingressReactor));
     } else if (config->serviceExecutor == "synchronous") {
         ctx->setServiceExecutor(std::make_unique<ServiceExecutorSynchronous>(ctx));
     }
+#ifdef __linux__
+    else if (config->serviceExecutor == "coroutine") {
+        // The io_uring loops complete network futures themselves, which resumes the waiting
+        // coroutines directly. Only asio needs its ingress reactor run on the executor's behalf.
+        ctx->setServiceExecutor(std::make_unique<ServiceExecutorCoroutine>(
+            ctx,
+            useIOUring ? nullptr : transportLayerASIO->getReactor(TransportLayer::kIngress)));
+    }
+#endif
     transportLayer = std::move(transportLayerASIO);
 
     std::vector<std::unique_ptr<TransportLayer>> retVector;
     retVector.emplace_back(std::move(transportLayer));
+#ifdef MONGO_CONFIG_IO_URING
+    if (useIOUring) {
+        opts.mode = transport::TransportLayerASIO::Options::kIngress;
+        retVector.emplace_back(
+            std::make_unique<TransportLayerIOUring>(opts, sep, std::move(ingressReactor)));
+    }
+#endif
     return std::make_unique<TransportLayerManager>(std::move(retVector));
 }
 
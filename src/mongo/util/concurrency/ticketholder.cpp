@@ -27,19 +27,160 @@
  *    it in the license file.
  */
 
+
 #define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kDefault
 
 #include "mongo/platform/basic.h"
 
 #include "mongo/util/concurrency/ticketholder.h"
 
+#include <algorithm>
 #include <iostream>
 
 #include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/str.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
 
+bool TicketHolder::tryAcquire() {
+    // Queued operations and pending retirements have the first claim on any ticket which becomes
+    // available.
+    if (_numWaiters.load() > 0 || _pendingRetire.load() > 0 || !_tryAcquireTicket()) {
+        return false;
+    }
+    _acquired.fetchAndAddRelaxed(1);
+    return true;
+}
+
+void TicketHolder::waitForTicket(OperationContext* opCtx) {
+    waitForTicketUntil(opCtx, Date_t::max());
+}
+
+bool TicketHolder::waitForTicketUntil(OperationContext* opCtx, Date_t until) {
+    // Only waits which actually queue pay for reading the clock.
+    if (tryAcquire()) {
+        return true;
+    }
+
+    Timer timer;
+    _queued.fetchAndAddRelaxed(1);
+    ON_BLOCK_EXIT([&] { _queuedMicros.fetchAndAddRelaxed(timer.micros()); });
+
+    const auto priority = opCtx ? opCtx->getAdmissionPriority() : AdmissionPriority::kNormal;
+    auto& queue = _queues[static_cast<size_t>(priority)];
+    Interruptible* interruptible = opCtx ? opCtx : Interruptible::notInterruptible();
+
+    Waiter waiter;
+    stdx::unique_lock<Latch> lk(_queueMutex);
+    _numWaiters.fetchAndAdd(1);
+    ON_BLOCK_EXIT([&] { _numWaiters.fetchAndSubtract(1); });
+    queue.push_back(&waiter);
+
+    // A ticket released before this waiter was counted went back to the pool, so the waiter must
+    // look there itself rather than wait for the release to hand the ticket over.
+    _grantTickets(lk);
+
+    auto removeWaiter = [&] { queue.erase(std::find(queue.begin(), queue.end(), &waiter)); };
+    try {
+        if (!interruptible->waitForConditionOrInterruptUntil(
+                waiter.cv, lk, until, [&] { return waiter.granted; })) {
+            removeWaiter();
+            return false;
+        }
+    } catch (const DBException&) {
+        if (waiter.granted) {
+            // The ticket was handed over just as the operation was interrupted, so pass it on.
+            _releaseTicket();
+            _grantTickets(lk);
+        } else {
+            removeWaiter();
+        }
+        throw;
+    }
+
+    _acquired.fetchAndAddRelaxed(1);
+    return true;
+}
+
+void TicketHolder::release() {
+    _releaseTicket();
+
+    // Any waiter or retirement counted before the ticket went back to the pool is handed it here.
+    // Any counted afterwards finds it in the pool when it is counted.
+    if (_numWaiters.load() > 0 || _pendingRetire.load() > 0) {
+        stdx::lock_guard<Latch> lk(_queueMutex);
+        _grantTickets(lk);
+    }
+}
+
+Status TicketHolder::resize(int newSize) {
+    stdx::lock_guard<Latch> lk(_queueMutex);
+    auto status = _resize(lk, newSize);
+    if (status.isOK()) {
+        _grantTickets(lk);
+    }
+    return status;
+}
+
+TicketHolder::Stats TicketHolder::getStats() const {
+    Stats stats;
+    stats.acquired = _acquired.loadRelaxed();
+    stats.queued = _queued.loadRelaxed();
+    stats.queuedMicros = _queuedMicros.loadRelaxed();
+    return stats;
+}
+
+void TicketHolder::_grantTickets(WithLock lk) {
+    // The tickets taken back by a shrink are not handed out to operations, so they bypass the
+    // queue and the Stats.
+    while (_pendingRetire.load() > 0 && _tryAcquireTicket()) {
+        _pendingRetire.subtractAndFetch(1);
+    }
+
+    while (std::any_of(_queues.begin(), _queues.end(), [](auto&& q) { return !q.empty(); }) &&
+           _tryAcquireTicket()) {
+        Waiter* waiter = _popNextWaiter(lk);
+        waiter->granted = true;
+        waiter->cv.notify_one();
+    }
+}
+
+TicketHolder::Waiter* TicketHolder::_popNextWaiter(WithLock) {
+    // A priority whose waiters have been passed over too often goes first, lowest priority first
+    // since it has been passed over by every other.
+    boost::optional<size_t> next;
+    for (size_t priority = 0; priority < kNumPriorities; ++priority) {
+        if (!_queues[priority].empty() && _admissionsAhead[priority] >= kMaxAdmissionsAhead) {
+            next = priority;
+            break;
+        }
+    }
+
+    // Otherwise the highest priority with anyone waiting.
+    if (!next) {
+        for (size_t priority = kNumPriorities; priority-- > 0;) {
+            if (!_queues[priority].empty()) {
+                next = priority;
+                break;
+            }
+        }
+    }
+    invariant(next);
+
+    for (size_t priority = 0; priority < *next; ++priority) {
+        if (!_queues[priority].empty()) {
+            ++_admissionsAhead[priority];
+        }
+    }
+    _admissionsAhead[*next] = 0;
+
+    Waiter* waiter = _queues[*next].front();
+    _queues[*next].pop_front();
+    return waiter;
+}
+
 #if defined(__linux__)
 namespace {
 
@@ -60,14 +201,6 @@ void check(int ret) {
         return;
     failWithErrno(errno);
 }
-
-/**
- * Takes a Date_t deadline and sets the appropriate values in a timespec structure.
- */
-void tsFromDate(const Date_t& deadline, struct timespec& ts) {
-    ts.tv_sec = deadline.toTimeT();
-    ts.tv_nsec = (deadline.toMillisSinceEpoch() % 1000) * 1'000'000;
-}
 }  // namespace
 
 TicketHolder::TicketHolder(int num) : _outof(num) {
@@ -78,7 +211,7 @@ TicketHolder::~TicketHolder() {
     check(sem_destroy(&_sem));
 }
 
-bool TicketHolder::tryAcquire() {
+bool TicketHolder::_tryAcquireTicket() {
     while (0 != sem_trywait(&_sem)) {
         if (errno == EAGAIN)
             return false;
@@ -88,48 +221,11 @@ bool TicketHolder::tryAcquire() {
     return true;
 }
 
-void TicketHolder::waitForTicket(OperationContext* opCtx) {
-    waitForTicketUntil(opCtx, Date_t::max());
-}
-
-bool TicketHolder::waitForTicketUntil(OperationContext* opCtx, Date_t until) {
-    const Milliseconds intervalMs(500);
-    struct timespec ts;
-
-    // To support interrupting ticket acquisition while still benefiting from semaphores, we do a
-    // timed wait on an interval to periodically check for interrupts.
-    // The wait period interval is the smaller of the default interval and the provided
-    // deadline.
-    Date_t deadline = std::min(until, Date_t::now() + intervalMs);
-    tsFromDate(deadline, ts);
-
-    while (0 != sem_timedwait(&_sem, &ts)) {
-        if (errno == ETIMEDOUT) {
-            // If we reached the deadline without being interrupted, we have completely timed out.
-            if (deadline == until)
-                return false;
-
-            deadline = std::min(until, Date_t::now() + intervalMs);
-            tsFromDate(deadline, ts);
-        } else if (errno != EINTR) {
-            failWithErrno(errno);
-        }
-
-        // To correctly handle errors from sem_timedwait, we should check for interrupts last.
-        // It is possible to unset 'errno' after a call to checkForInterrupt().
-        if (opCtx)
-            opCtx->checkForInterrupt();
-    }
-    return true;
-}
-
-void TicketHolder::release() {
+void TicketHolder::_releaseTicket() {
     check(sem_post(&_sem));
 }
 
-Status TicketHolder::resize(int newSize) {
-    stdx::lock_guard<Latch> lk(_resizeMutex);
-
+Status TicketHolder::_resize(WithLock, int newSize) {
     if (newSize < 5)
         return Status(ErrorCodes::BadValue,
                       str::stream() << "Minimum value for semaphore is 5; given " << newSize);
@@ -139,13 +235,22 @@ Status TicketHolder::resize(int newSize) {
                       str::stream() << "Maximum value for semaphore is " << SEM_VALUE_MAX
                                     << "; given " << newSize);
 
+    // Growing first cancels retirements still pending from an earlier shrink, leaving those
+    // tickets in circulation.
     while (_outof.load() < newSize) {
-        release();
+        if (_pendingRetire.load() > 0) {
+            _pendingRetire.subtractAndFetch(1);
+        } else {
+            _releaseTicket();
+        }
         _outof.fetchAndAdd(1);
     }
 
+    // Waiting here for tickets to come back would compete with the queued operations for them, so
+    // a shrink only records what it is owed. The caller then retires whatever is in the pool, and
+    // release() retires the rest as operations give their tickets back.
     while (_outof.load() > newSize) {
-        waitForTicket();
+        _pendingRetire.fetchAndAdd(1);
         _outof.subtractAndFetch(1);
     }
 
@@ -160,7 +265,7 @@ int TicketHolder::available() const {
 }
 
 int TicketHolder::used() const {
-    return outof() - available();
+    return outof() + _pendingRetire.load() - available();
 }
 
 int TicketHolder::outof() const {
@@ -173,42 +278,17 @@ TicketHolder::TicketHolder(int num) : _outof(num), _num(num) {}
 
 TicketHolder::~TicketHolder() = default;
 
-bool TicketHolder::tryAcquire() {
+bool TicketHolder::_tryAcquireTicket() {
     stdx::lock_guard<Latch> lk(_mutex);
     return _tryAcquire();
 }
 
-void TicketHolder::waitForTicket(OperationContext* opCtx) {
-    stdx::unique_lock<Latch> lk(_mutex);
-
-    if (opCtx) {
-        opCtx->waitForConditionOrInterrupt(_newTicket, lk, [this] { return _tryAcquire(); });
-    } else {
-        _newTicket.wait(lk, [this] { return _tryAcquire(); });
-    }
-}
-
-bool TicketHolder::waitForTicketUntil(OperationContext* opCtx, Date_t until) {
-    stdx::unique_lock<Latch> lk(_mutex);
-
-    if (opCtx) {
-        return opCtx->waitForConditionOrInterruptUntil(
-            _newTicket, lk, until, [this] { return _tryAcquire(); });
-    } else {
-        return _newTicket.wait_until(
-            lk, until.toSystemTimePoint(), [this] { return _tryAcquire(); });
-    }
-}
-
-void TicketHolder::release() {
-    {
-        stdx::lock_guard<Latch> lk(_mutex);
-        _num++;
-    }
-    _newTicket.notify_one();
+void TicketHolder::_releaseTicket() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    _num++;
 }
 
-Status TicketHolder::resize(int newSize) {
+Status TicketHolder::_resize(WithLock, int newSize) {
     stdx::lock_guard<Latch> lk(_mutex);
 
     int used = _outof.load() - _num;
@@ -224,9 +304,6 @@ Status TicketHolder::resize(int newSize) {
 
     _outof.store(newSize);
     _num = _outof.load() - used;
-
-    // Potentially wasteful, but easier to see is correct
-    _newTicket.notify_all();
     return Status::OK();
 }
 
@@ -32,22 +32,47 @@
 #include <semaphore.h>
 #endif
 
+#include <array>
+#include <deque>
+
 #include "mongo/db/operation_context.h"
 #include "mongo/platform/mutex.h"
 #include "mongo/stdx/condition_variable.h"
 #include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/with_lock.h"
 #include "mongo/util/time_support.h"
 
 namespace mongo {
 
+/**
+ * Hands out a bounded number of tickets.
+ *
+ * Operations which find no ticket available queue for one, and released tickets are handed to
+ * queued operations directly, highest AdmissionPriority first and in FIFO order within a priority.
+ * To keep a steady stream of higher priority operations from starving lower priority ones, a
+ * waiter is passed over at most kMaxAdmissionsAhead times before it is admitted regardless.
+ * Operations waiting without an OperationContext are queued at normal priority.
+ *
+ * Shrinking the holder never waits for tickets to come back. Tickets which are in use at the time
+ * are retired as they are released, ahead of any queued operation.
+ */
 class TicketHolder {
     TicketHolder(const TicketHolder&) = delete;
     TicketHolder& operator=(const TicketHolder&) = delete;
 
 public:
+    /**
+     * The number of tickets which may be handed to higher priority waiters ahead of the oldest
+     * waiter of a lower priority, before that waiter is admitted first.
+     */
+    static constexpr int kMaxAdmissionsAhead = 16;
+
     explicit TicketHolder(int num);
     ~TicketHolder();
 
+    /**
+     * Acquires a ticket if one is available and no other operation is queued for one.
+     */
     bool tryAcquire();
 
     /**
@@ -81,20 +106,91 @@ public:
 
     int outof() const;
 
+    /**
+     * Returns the number of operations currently queued for a ticket.
+     */
+    int queued() const {
+        return _numWaiters.load();
+    }
+
+    /**
+     * Cumulative counts of how tickets were handed out since the holder was created. Tickets
+     * obtained without waiting only count towards 'acquired'. Waits which timed out or were
+     * interrupted still count towards 'queued' and 'queuedMicros'.
+     */
+    struct Stats {
+        long long acquired = 0;
+        long long queued = 0;
+        long long queuedMicros = 0;
+    };
+
+    Stats getStats() const;
+
 private:
+    static constexpr size_t kNumPriorities = 3;
+
+    /**
+     * An operation queued for a ticket. Lives on the stack of the waiting thread.
+     */
+    struct Waiter {
+        stdx::condition_variable cv;
+
+        // Set when a ticket is handed to the waiter, which then owns it.
+        bool granted = false;
+    };
+
+    /**
+     * Platform specific primitives over the pool of available tickets, which neither update the
+     * Stats nor look at the queue.
+     */
+    bool _tryAcquireTicket();
+    void _releaseTicket();
+    Status _resize(WithLock, int newSize);
+
+    /**
+     * Retires available tickets owed to a shrink, then hands the rest to queued waiters until
+     * either runs out.
+     */
+    void _grantTickets(WithLock);
+
+    /**
+     * Removes and returns the waiter to admit next. The queue must not be empty.
+     */
+    Waiter* _popNextWaiter(WithLock);
+
+    AtomicWord<long long> _acquired{0};
+    AtomicWord<long long> _queued{0};
+    AtomicWord<long long> _queuedMicros{0};
+
+    // The number of operations queued for a ticket, readable without '_queueMutex' so that
+    // releasing a ticket only takes it when there is someone to hand the ticket to.
+    AtomicWord<int> _numWaiters{0};
+
+    // The number of tickets a shrink has taken out of '_outof' which were in use at the time, and
+    // must be taken out of the pool as they are released. Only changed under '_queueMutex', but
+    // readable without it for the same reason as '_numWaiters'.
+    AtomicWord<int> _pendingRetire{0};
+
+    Mutex _queueMutex = MONGO_MAKE_LATCH("TicketHolder::_queueMutex");
+
+    // Waiters indexed by AdmissionPriority, each in FIFO order.
+    std::array<std::deque<Waiter*>, kNumPriorities> _queues;
+
+    // For each priority, the number of tickets handed to higher priority waiters while its queue
+    // was not empty, since a waiter of that priority was last admitted.
+    std::array<int, kNumPriorities> _admissionsAhead{};
+
 #if defined(__linux__)
     mutable sem_t _sem;
 
-    // You can read _outof without a lock, but have to hold _resizeMutex to change.
+    // You can read _outof without a lock, but have to hold _queueMutex to change.
     AtomicWord<int> _outof;
-    Mutex _resizeMutex = MONGO_MAKE_LATCH("TicketHolder::_resizeMutex");
 #else
     bool _tryAcquire();
 
     AtomicWord<int> _outof;
     int _num;
     Mutex _mutex = MONGO_MAKE_LATCH("TicketHolder::_mutex");
-    stdx::condition_variable _newTicket;
 #endif
 };
 
@@ -32,8 +32,16 @@
 
 #include "mongo/platform/basic.h"
 
+#include <string>
+#include <vector>
+
+#include "mongo/db/client.h"
+#include "mongo/db/service_context_test_fixture.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/concurrency/ticketholder_tuner.h"
+#include "mongo/util/time_support.h"
 
 namespace {
 using namespace mongo;
@@ -72,4 +80,216 @@ TEST(TicketholderTest, BasicTimeout) {
     holder.release();
     ASSERT_EQ(holder.used(), 0);
 }
+
+TEST(TicketholderTest, StatsCountAcquiredAndQueuedTickets) {
+    TicketHolder holder(1);
+    ASSERT(holder.tryAcquire());
+    ASSERT_FALSE(holder.tryAcquire());
+    ASSERT_FALSE(holder.waitForTicketUntil(Date_t::now() + Milliseconds(5)));
+
+    auto stats = holder.getStats();
+    ASSERT_EQ(stats.acquired, 1);
+    ASSERT_EQ(stats.queued, 1);
+    ASSERT_GT(stats.queuedMicros, 0);
+
+    holder.release();
+    ASSERT(holder.waitForTicketUntil(Date_t::now() + Milliseconds(5)));
+    holder.release();
+    stats = holder.getStats();
+    ASSERT_EQ(stats.acquired, 2);
+    ASSERT_EQ(stats.queued, 1);
+}
+
+class TicketholderAdmissionTest : public ServiceContextTest {
+protected:
+    /**
+     * Starts a thread which queues for a ticket from 'holder' at 'priority', records 'name' once
+     * it is admitted and gives the ticket straight back. Returns once the thread is queued.
+     */
+    void queueWaiter(TicketHolder* holder, AdmissionPriority priority, std::string name) {
+        const int queuedBefore = holder->queued();
+        _threads.emplace_back([this, holder, priority, name] {
+            ThreadClient tc(getServiceContext());
+            auto opCtx = tc->makeOperationContext();
+            opCtx->setAdmissionPriority(priority);
+            holder->waitForTicket(opCtx.get());
+            {
+                stdx::lock_guard<Latch> lk(_mutex);
+                _admitted.push_back(name);
+            }
+            holder->release();
+        });
+        while (holder->queued() == queuedBefore) {
+            sleepmillis(1);
+        }
+    }
+
+    /**
+     * Waits for every waiter to be admitted, and returns their names in order of admission.
+     */
+    std::vector<std::string> joinWaiters() {
+        for (auto&& thread : _threads) {
+            thread.join();
+        }
+        _threads.clear();
+        return _admitted;
+    }
+
+private:
+    Mutex _mutex = MONGO_MAKE_LATCH("TicketholderAdmissionTest::_mutex");
+    std::vector<std::string> _admitted;
+    std::vector<stdx::thread> _threads;
+};
+
+TEST_F(TicketholderAdmissionTest, QueuedOperationsAreAdmittedByPriority) {
+    TicketHolder holder(1);
+    ASSERT(holder.tryAcquire());
+
+    queueWaiter(&holder, AdmissionPriority::kBackground, "background");
+    queueWaiter(&holder, AdmissionPriority::kNormal, "normal1");
+    queueWaiter(&holder, AdmissionPriority::kLatencySensitive, "latencySensitive");
+    queueWaiter(&holder, AdmissionPriority::kNormal, "normal2");
+
+    // Nobody may jump the queue while operations wait in it.
+    ASSERT_FALSE(holder.tryAcquire());
+
+    holder.release();
+    const std::vector<std::string> expected{"latencySensitive", "normal1", "normal2", "background"};
+    ASSERT(joinWaiters() == expected);
+    ASSERT_EQ(holder.used(), 0);
+}
+
+TEST_F(TicketholderAdmissionTest, LowPriorityWaitersAreNotStarved) {
+    TicketHolder holder(1);
+    ASSERT(holder.tryAcquire());
+
+    queueWaiter(&holder, AdmissionPriority::kBackground, "background");
+    const int numNormal = TicketHolder::kMaxAdmissionsAhead + 4;
+    for (int i = 0; i < numNormal; ++i) {
+        queueWaiter(&holder, AdmissionPriority::kNormal, "normal" + std::to_string(i));
+    }
+
+    holder.release();
+    auto admitted = joinWaiters();
+    ASSERT_EQ(admitted.size(), size_t(numNormal + 1));
+    ASSERT_EQ(admitted[TicketHolder::kMaxAdmissionsAhead], "background");
+}
+
+TEST_F(TicketholderAdmissionTest, TimedOutWaiterLeavesTheQueue) {
+    TicketHolder holder(1);
+    ASSERT(holder.tryAcquire());
+
+    auto opCtx = makeOperationContext();
+    opCtx->setAdmissionPriority(AdmissionPriority::kLatencySensitive);
+    ASSERT_FALSE(holder.waitForTicketUntil(opCtx.get(), Date_t::now() + Milliseconds(5)));
+    ASSERT_EQ(holder.queued(), 0);
+
+    holder.release();
+    ASSERT(holder.tryAcquire());
+    holder.release();
+}
+
+#if defined(__linux__)
+TEST_F(TicketholderAdmissionTest, ShrinkRetiresTicketsInUseAheadOfWaiters) {
+    TicketHolder holder(6);
+    for (int i = 0; i < 6; ++i) {
+        ASSERT(holder.tryAcquire());
+    }
+    queueWaiter(&holder, AdmissionPriority::kLatencySensitive, "waiter");
+
+    // Every ticket is in use, so the shrink must return without waiting for one.
+    ASSERT_OK(holder.resize(5));
+    ASSERT_EQ(holder.outof(), 5);
+    ASSERT_EQ(holder.used(), 6);
+
+    // The first ticket back is retired rather than handed to the waiter.
+    holder.release();
+    ASSERT_EQ(holder.queued(), 1);
+    ASSERT_EQ(holder.used(), 5);
+
+    holder.release();
+    ASSERT(joinWaiters() == std::vector<std::string>{"waiter"});
+    for (int i = 0; i < 4; ++i) {
+        holder.release();
+    }
+    ASSERT_EQ(holder.used(), 0);
+    ASSERT_EQ(holder.available(), 5);
+}
+#endif
+
+/**
+ * Returns 'stats' advanced by 'acquired' tickets, each having queued for 'queueDelayMicros'.
+ */
+TicketHolder::Stats advance(TicketHolder::Stats stats,
+                            long long acquired,
+                            long long queueDelayMicros) {
+    stats.acquired += acquired;
+    stats.queued += acquired;
+    stats.queuedMicros += acquired * queueDelayMicros;
+    return stats;
+}
+
+TEST(TicketholderTest, TunerLeavesUncontendedHolderAlone) {
+    TicketHolder holder(10);
+    TicketHolderTuner tuner(&holder);
+    TicketHolderTuner::Options options;
+
+    auto stats = holder.getStats();
+    for (int i = 0; i < 5; ++i) {
+        stats = advance(stats, 1000, 10);
+        tuner.adjust(stats, options);
+    }
+    ASSERT_EQ(holder.outof(), 10);
+}
+
+TEST(TicketholderTest, TunerGrowsWhileThroughputImprovesThenBacksOff) {
+    TicketHolder holder(20);
+    TicketHolderTuner tuner(&holder);
+    TicketHolderTuner::Options options;
+    options.minTickets = 10;
+    options.maxTickets = 100;
+
+    // Contended, and throughput keeps improving: keep growing.
+    auto stats = holder.getStats();
+    stats = advance(stats, 1000, 5000);
+    tuner.adjust(stats, options);
+    ASSERT_EQ(holder.outof(), 22);
+    stats = advance(stats, 1100, 5000);
+    tuner.adjust(stats, options);
+    ASSERT_EQ(holder.outof(), 24);
+
+    // Throughput collapses with the extra tickets: shrink instead.
+    stats = advance(stats, 500, 5000);
+    tuner.adjust(stats, options);
+    ASSERT_EQ(holder.outof(), 22);
+    stats = advance(stats, 600, 5000);
+    tuner.adjust(stats, options);
+    ASSERT_EQ(holder.outof(), 20);
+
+    BSONObjBuilder builder;
+    tuner.appendStats(&builder);
+    auto obj = builder.obj();
+    ASSERT_EQ(obj["increases"].numberLong(), 2);
+    ASSERT_EQ(obj["decreases"].numberLong(), 2);
+    ASSERT_EQ(obj["lastQueueDelayMicros"].numberLong(), 5000);
+    ASSERT_EQ(obj["lastAcquired"].numberLong(), 600);
+}
+
+TEST(TicketholderTest, TunerKeepsHolderWithinBounds) {
+    TicketHolder holder(200);
+    TicketHolderTuner tuner(&holder);
+    TicketHolderTuner::Options options;
+    options.minTickets = 10;
+    options.maxTickets = 100;
+
+    // An out of bounds size is corrected even without contention.
+    auto stats = holder.getStats();
+    tuner.adjust(stats, options);
+    ASSERT_EQ(holder.outof(), 100);
+
+    // Growing stops at the maximum.
+    stats = advance(stats, 1000, 5000);
+    tuner.adjust(stats, options);
+    ASSERT_EQ(holder.outof(), 100);
+}
 }  // namespace
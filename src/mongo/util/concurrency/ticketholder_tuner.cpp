@@ -0,0 +1,110 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/util/concurrency/ticketholder_tuner.h"
+
+#include <algorithm>
+
+#include "mongo/util/log.h"
+
+namespace mongo {
+
+TicketHolderTuner::TicketHolderTuner(TicketHolder* holder)
+    : _holder(holder), _lastStats(holder->getStats()) {}
+
+void TicketHolderTuner::adjust(const Options& options) {
+    adjust(_holder->getStats(), options);
+}
+
+void TicketHolderTuner::adjust(const TicketHolder::Stats& stats, const Options& options) {
+    const long long acquired = stats.acquired - _lastStats.acquired;
+    const long long queuedMicros = stats.queuedMicros - _lastStats.queuedMicros;
+    _lastStats = stats;
+
+    const long long queueDelayMicros = acquired > 0 ? queuedMicros / acquired : 0;
+    _lastQueueDelayMicros.store(queueDelayMicros);
+    _lastAcquired.store(acquired);
+
+    // The bounds may have changed since the last sample, so the size is brought back within them
+    // even when there is no contention.
+    const int outof = _holder->outof();
+    int newSize = std::min(std::max(outof, options.minTickets), options.maxTickets);
+
+    if (acquired > 0 && queueDelayMicros > durationCount<Microseconds>(options.targetQueueDelay)) {
+        // Samples are taken at a fixed interval, so the number of tickets acquired since the last
+        // one stands in for throughput.
+        if (_lastThroughput > 0 && acquired < _lastThroughput * (1 - kThroughputTolerance)) {
+            _growing = !_growing;
+        }
+        _lastThroughput = acquired;
+
+        const int step = std::max(1, static_cast<int>(newSize * kStepFraction));
+        newSize = _growing ? std::min(newSize + step, options.maxTickets)
+                           : std::max(newSize - step, options.minTickets);
+    } else {
+        // Nothing is learned about throughput without contention. The next contended sample
+        // starts a fresh climb upwards.
+        _lastThroughput = 0;
+        _growing = true;
+    }
+
+    if (newSize == outof) {
+        return;
+    }
+
+    Status status = _holder->resize(newSize);
+    if (!status.isOK()) {
+        LOG(1) << "Unable to resize ticket holder from " << outof << " to " << newSize
+               << " tickets: " << status;
+        return;
+    }
+
+    if (newSize > outof) {
+        _numIncreases.fetchAndAdd(1);
+    } else {
+        _numDecreases.fetchAndAdd(1);
+    }
+    LOG(1) << "Resized ticket holder from " << outof << " to " << newSize
+           << " tickets. Average queueing delay was " << queueDelayMicros << "us over "
+           << acquired << " acquired tickets";
+}
+
+void TicketHolderTuner::appendStats(BSONObjBuilder* builder) const {
+    builder->append("increases", _numIncreases.load());
+    builder->append("decreases", _numDecreases.load());
+    builder->append("lastQueueDelayMicros", _lastQueueDelayMicros.load());
+    builder->append("lastAcquired", _lastAcquired.load());
+}
+
+}  // namespace mongo
@@ -0,0 +1,115 @@
+/**
+ *    Copyright (C) 2019-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/duration.h"
+
+namespace mongo {
+
+/**
+ * Sizes a TicketHolder from a feedback loop on how long operations queue for its tickets and how
+ * many tickets it hands out.
+ *
+ * Each call to adjust() looks at the holder's Stats since the previous call. While the average
+ * queueing delay stays under the target, more concurrency can't help and the size is left alone.
+ * Once operations queue for longer, the tuner hill climbs on throughput: it keeps stepping the size
+ * in the same direction as long as throughput holds up, and turns around when it drops. Adding
+ * tickets to an I/O bound workload thus keeps paying off, whereas under cache pressure the extra
+ * tickets cost throughput and the size is brought back down.
+ *
+ * Resizes go through TicketHolder::resize(). adjust() must not be called concurrently with itself,
+ * but appendStats() may be called from any thread.
+ */
+class TicketHolderTuner {
+    TicketHolderTuner(const TicketHolderTuner&) = delete;
+    TicketHolderTuner& operator=(const TicketHolderTuner&) = delete;
+
+public:
+    struct Options {
+        int minTickets = 5;
+        int maxTickets = 1024;
+
+        // The average queueing delay per acquired ticket above which the holder counts as
+        // contended.
+        Microseconds targetQueueDelay{1000};
+    };
+
+    /**
+     * Throughput may drop by this fraction between two samples before the tuner reverses the
+     * direction in which it resizes.
+     */
+    static constexpr double kThroughputTolerance = 0.05;
+
+    /**
+     * Each adjustment moves the size by this fraction of the current size, and by at least one
+     * ticket.
+     */
+    static constexpr double kStepFraction = 0.1;
+
+    /**
+     * 'holder' is not owned and must outlive the tuner.
+     */
+    explicit TicketHolderTuner(TicketHolder* holder);
+
+    /**
+     * Samples the holder's Stats and resizes it if called for.
+     */
+    void adjust(const Options& options);
+
+    /**
+     * As above, but with the cumulative Stats to use for this sample given explicitly.
+     */
+    void adjust(const TicketHolder::Stats& stats, const Options& options);
+
+    /**
+     * Appends the tuner's counters and the most recent sample to 'builder'.
+     */
+    void appendStats(BSONObjBuilder* builder) const;
+
+private:
+    TicketHolder* const _holder;
+
+    // Only accessed by adjust().
+    TicketHolder::Stats _lastStats;
+    long long _lastThroughput = 0;
+    bool _growing = true;
+
+    // Surfaced by appendStats().
+    AtomicWord<long long> _numIncreases{0};
+    AtomicWord<long long> _numDecreases{0};
+    AtomicWord<long long> _lastQueueDelayMicros{0};
+    AtomicWord<long long> _lastAcquired{0};
+};
+
+}  // namespace mongo